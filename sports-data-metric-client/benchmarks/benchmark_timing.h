@@ -0,0 +1,60 @@
+// Timing helpers shared by the benchmarks.
+//
+// A measurement runs its body once to warm up, then repeats it and keeps the
+// fastest of several rounds, which is the least disturbed by the rest of the
+// machine.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+
+namespace benchmark_timing {
+
+/**
+ * @brief Keeps the compiler from discarding a result that is otherwise unused.
+ */
+template <typename T>
+inline void keep(const T& value)
+{
+    static const void* volatile sink = nullptr;
+    sink = &value;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+/**
+ * @brief Fastest time of one call to @p body, in nanoseconds, over @p rounds rounds of @p iterations calls.
+ */
+template <typename Body>
+double nanosecondsPerCall(Body&& body, int iterations, int rounds = 5)
+{
+    body();
+
+    double best = std::numeric_limits<double>::max();
+    for (int round = 0; round < rounds; ++round) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            body();
+        }
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count() / iterations);
+    }
+    return best;
+}
+
+/**
+ * @brief Prints one result line: a label and its time per call.
+ */
+inline void report(const char* label, double nanoseconds)
+{
+    if (nanoseconds >= 10000.0) {
+        std::printf("  %-44s %10.2f us\n", label, nanoseconds / 1000.0);
+    } else {
+        std::printf("  %-44s %10.1f ns\n", label, nanoseconds);
+    }
+}
+
+} // namespace benchmark_timing
@@ -0,0 +1,106 @@
+// Metric kernels, one implementation against another.
+//
+// Times every kernel of the scalar, SSE4.1 and AVX2 builds this CPU supports
+// on batches of random rotations and motions, and reports the time per asset.
+// Small batches show what the scalar tails cost; large ones the throughput of
+// the vector loops.
+//
+// Usage: metric_kernels_benchmark
+
+#include "benchmark_timing.h"
+#include "metric_kernels.h"
+
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace metric_kernels;
+
+constexpr size_t kMaxAssets = 1024;
+constexpr int kAssetsPerCall = 1 << 16;     // Assets computed per timed round, whatever the batch size
+
+/**
+ * @brief Random columns, eight of them: two quaternions or two three-component vectors and spares.
+ */
+ColumnBuffer makeInputs()
+{
+    std::mt19937 rng(1);
+    std::normal_distribution<float> gaussian(0.0f, 1.0f);
+
+    ColumnBuffer columns;
+    columns.reserve(8, kMaxAssets);
+    for (int column = 0; column < 8; ++column) {
+        float* values = columns.column(column);
+        for (size_t i = 0; i < kMaxAssets; ++i) {
+            values[i] = gaussian(rng);
+        }
+    }
+    return columns;
+}
+
+/**
+ * @brief Time of @p kernel per asset in batches of @p n, in nanoseconds.
+ */
+template <typename Kernel>
+double nanosecondsPerAsset(Kernel&& kernel, size_t n)
+{
+    const int calls = static_cast<int>(kAssetsPerCall / n);
+    return benchmark_timing::nanosecondsPerCall(kernel, calls) / static_cast<double>(n);
+}
+
+void benchmarkKernels(const std::vector<const Kernels*>& builds, size_t n)
+{
+    ColumnBuffer inputs = makeInputs();
+    std::vector<float> out(kMaxAssets);
+    const QuatColumns a = inputs.quat(0);
+    const QuatColumns b = inputs.quat(4);
+    const Vec3Columns velocity = inputs.vec3(0);
+    const Vec3Columns acceleration = inputs.vec3(3);
+
+    std::printf("Batches of %zu assets, ns per asset\n", n);
+    std::printf("  %-28s", "");
+    for (const Kernels* kernels : builds) {
+        std::printf(" %10s", kernels->name);
+    }
+    std::printf("\n");
+
+    auto row = [&](const char* label, auto run) {
+        std::printf("  %-28s", label);
+        for (const Kernels* kernels : builds) {
+            const double ns = nanosecondsPerAsset([&] {
+                run(*kernels);
+                benchmark_timing::keep(out);
+            }, n);
+            std::printf(" %10.2f", ns);
+        }
+        std::printf("\n");
+    };
+
+    row("jointAngles", [&](const Kernels& k) { k.jointAngles(a, b, out.data(), n); });
+    row("tilts", [&](const Kernels& k) { k.tilts(a, out.data(), n); });
+    row("horizontalDistances", [&](const Kernels& k) { k.horizontalDistances(velocity, acceleration, out.data(), n); });
+    row("speeds", [&](const Kernels& k) { k.speeds(velocity, out.data(), n); });
+    row("tangentialAccelerations", [&](const Kernels& k) {
+        k.tangentialAccelerations(velocity, acceleration, out.data(), n);
+    });
+}
+
+} // namespace
+
+int main()
+{
+    std::vector<const Kernels*> builds = { &scalar() };
+    if (sse4()) {
+        builds.push_back(sse4());
+    }
+    if (avx2()) {
+        builds.push_back(avx2());
+    }
+    std::printf("Metric kernels; best() is %s\n", best().name);
+
+    for (size_t n : { size_t(4), size_t(13), size_t(64), kMaxAssets }) {
+        benchmarkKernels(builds, n);
+    }
+    return 0;
+}
@@ -0,0 +1,399 @@
+// Per-frame cost of the metrics path, before and after compiling the metric
+// settings into a MetricPlan.
+//
+// "Before" is the loop the client ran until the settings were compiled: for
+// every frame it walked the sport's QJsonArray, converted each entry with
+// toObject(), compared the class names as strings and inserted the values into
+// a QHash keyed by label. Its per-frame qDebug() dumps are left out, so the
+// comparison is with the cheapest form of the old loop. "After" is
+// RigidBodyMetrics and SkeletonMetrics as DataProcessor drives them: a pose
+// pushed into the history, then the plan evaluated into MetricsData slots.
+//
+// The metric settings are those of a sport of src/config/sports.json. The
+// skeleton metrics resolve their bones from the "ids" of the settings, as the
+// joint configuration is a resource of the application.
+//
+// Last, batches of rigid bodies and of skeletons are split into shards and
+// computed on a QThreadPool the way DataProcessor::computeMetricsBatch() does.
+// The pool hand-off and the cost of each kind of asset are the figures behind
+// DataProcessor::kMinShardCostNs and the initial per-asset cost estimates.
+//
+// Usage: metrics_path_benchmark [sport]
+
+#include "benchmark_timing.h"
+#include "rigid_body_metrics.h"
+#include "skeleton_metrics.h"
+
+#include <QFile>
+#include <QHash>
+#include <QJsonDocument>
+#include <QThread>
+#include <QThreadPool>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+constexpr int kRigidBodies = 4;
+constexpr int kSkeletons = 2;
+constexpr int kBones = 21;
+constexpr int kFrames = 240;            // Frames cycled through, one second of a 240 Hz stream
+constexpr int kIterations = 20000;
+constexpr int kBatchRigidBodies = 1024; // Largest batches timed
+constexpr int kBatchSkeletons = 256;
+constexpr int kBatchFrames = 8;
+
+// Values of a frame as the client published them before the plan: one hash entry per label
+struct LegacyMetricsData {
+    int id = -1;
+    QHash<QString, qreal> metrics;
+};
+
+// The rigid body loop before the plan, reading the two previous frames for the motion metrics
+LegacyMetricsData legacyRigidBodyMetrics(const QJsonArray& settings, int selectedAsset, const FrameData& current,
+                                         const FrameData& previous, const FrameData& secondPrevious)
+{
+    LegacyMetricsData data;
+
+    for (size_t i = 0; i < current.rigidBodies.size(); ++i) {
+        const RigidBodyData& curr = current.rigidBodies[i];
+        const RigidBodyData& prev = previous.rigidBodies[i];
+        const RigidBodyData& secPrev = secondPrevious.rigidBodies[i];
+        if (curr.id != selectedAsset) {
+            continue;
+        }
+
+        data.id = current.frameNumber;
+        const QVector3D orientation = curr.orientation.toEulerAngles();
+        const double dt = current.timestamp - previous.timestamp;
+        const double prevDt = previous.timestamp - secondPrevious.timestamp;
+
+        for (const QJsonValue& val : settings) {
+            QJsonObject metricObj = val.toObject();
+            QString metricClass = metricObj["class"].toString();
+            QJsonArray labels = metricObj["labels"].toArray();
+
+            if (metricClass == "tilt") {
+                const qreal tilt = std::sqrt(orientation.x() * orientation.x() + orientation.z() * orientation.z());
+                if (!labels.isEmpty())
+                    data.metrics.insert(labels[0].toString(), tilt);
+            } else if (metricClass == "velocity") {
+                const qreal velocity = dt > 0.0 ? (curr.position - prev.position).length() / dt : 0.0;
+                if (!labels.isEmpty())
+                    data.metrics.insert(labels[0].toString(), velocity);
+            } else if (metricClass == "acceleration") {
+                const qreal speed = dt > 0.0 ? (curr.position - prev.position).length() / dt : 0.0;
+                const qreal prevSpeed = prevDt > 0.0 ? (prev.position - secPrev.position).length() / prevDt : 0.0;
+                if (!labels.isEmpty())
+                    data.metrics.insert(labels[0].toString(), dt > 0.0 ? (speed - prevSpeed) / dt : 0.0);
+            } else if (metricClass == "position") {
+                for (int j = 0; j < labels.size() && j < 3; ++j) {
+                    data.metrics.insert(labels[j].toString(), curr.position[j]);
+                }
+            } else if (metricClass == "orientation") {
+                for (int j = 0; j < labels.size() && j < 3; ++j) {
+                    data.metrics.insert(labels[j].toString(), orientation[j]);
+                }
+            }
+        }
+        return data;
+    }
+    return data;
+}
+
+// The skeleton loop before the plan; bones were indexed by the IDs of the settings
+LegacyMetricsData legacySkeletonMetrics(const QJsonArray& settings, int selectedAsset, const FrameData& current)
+{
+    LegacyMetricsData data;
+
+    for (const SkeletonData& skeleton : current.skeletons) {
+        if (skeleton.id != selectedAsset || skeleton.bones.empty()) {
+            continue;
+        }
+
+        data.id = current.frameNumber;
+        const int boneCount = static_cast<int>(skeleton.bones.size());
+
+        for (const QJsonValue& val : settings) {
+            QJsonObject metricObj = val.toObject();
+            QString metricClass = metricObj["class"].toString();
+            QJsonArray ids = metricObj["ids"].toArray();
+            QJsonArray labels = metricObj["labels"].toArray();
+            if (ids.size() < 2 || labels.isEmpty()) {
+                continue;
+            }
+
+            const int id1 = ids[0].toInt();
+            const int id2 = ids[1].toInt();
+            if (id1 < 0 || id1 >= boneCount || id2 < 0 || id2 >= boneCount) {
+                continue;
+            }
+
+            if (metricClass == "angle") {
+                QQuaternion relative = skeleton.bones[id1].orientation.conjugated() * skeleton.bones[id2].orientation;
+                relative.normalize();
+                data.metrics.insert(labels[0].toString(), qRadiansToDegrees(2.0f * qAcos(relative.scalar())));
+            } else if (metricClass == "distance") {
+                const QVector3D& a = skeleton.bones[id1].position;
+                const QVector3D& b = skeleton.bones[id2].position;
+                const float dx = b.x() - a.x();
+                const float dz = b.z() - a.z();
+                data.metrics.insert(labels[0].toString(), std::sqrt(dx * dx + dz * dz) * 100.0f);
+            }
+        }
+        return data;
+    }
+    return data;
+}
+
+/**
+ * @brief @p frameCount frames of @p rigidBodies rigid bodies and @p skeletons skeletons in motion.
+ */
+std::vector<FrameData> makeFrames(const std::shared_ptr<const AssetSlotMap>& slotMap, int frameCount,
+                                  int rigidBodies, int skeletons)
+{
+    std::vector<FrameData> frames(frameCount);
+    for (int f = 0; f < frameCount; ++f) {
+        FrameData& frame = frames[f];
+        frame.frameNumber = f + 1;
+        frame.timestamp = f / 240.0;
+        frame.slotMap = slotMap;
+
+        const float phase = 0.05f * f;
+        for (int i = 0; i < rigidBodies; ++i) {
+            RigidBodyData body;
+            body.id = 100 + i;
+            body.position = QVector3D(std::sin(phase + i), 1.0f, std::cos(phase));
+            body.orientation = QQuaternion::fromEulerAngles(10.0f * std::sin(phase), 5.0f * i, 3.0f);
+            frame.rigidBodies.push_back(body);
+        }
+
+        for (int s = 0; s < skeletons; ++s) {
+            SkeletonData skeleton;
+            skeleton.id = 1 + s;
+            for (int b = 0; b < kBones; ++b) {
+                RigidBodyData bone;
+                bone.id = 1 + b;
+                bone.position = QVector3D(0.1f * b, 0.05f * b + std::sin(phase), 0.02f * b);
+                bone.orientation = QQuaternion::fromEulerAngles(2.0f * b * std::sin(phase), 0.0f, 1.0f * b);
+                skeleton.bones.push_back(bone);
+            }
+            frame.skeletons.push_back(skeleton);
+        }
+    }
+    return frames;
+}
+
+/**
+ * @brief Metrics of @p rigidBodies rigid bodies and @p skeletons skeletons, as a connection sets them up.
+ */
+struct Scene {
+    Scene(int rigidBodies, int skeletons, int frameCount, const QJsonArray& rigidSettings,
+          const QJsonArray& bodySettings)
+    {
+        auto slotMap = std::make_shared<AssetSlotMap>();
+        std::unordered_map<int, std::string> rigidBodyNames;
+        std::unordered_map<int, std::string> skeletonNames;
+        std::unordered_map<int, std::unordered_map<int, std::string>> boneNames;
+        for (int i = 0; i < rigidBodies; ++i) {
+            slotMap->addRigidBody(100 + i);
+            rigidBodyNames[100 + i] = "Body" + std::to_string(i);
+        }
+        for (int s = 0; s < skeletons; ++s) {
+            const int slot = slotMap->addSkeleton(1 + s);
+            std::vector<int> boneIds;
+            for (int b = 0; b < kBones; ++b) {
+                boneIds.push_back(1 + b);
+                boneNames[1 + s][1 + b] = "Skeleton" + std::to_string(s) + "_Bone" + std::to_string(b);
+            }
+            slotMap->setSkeletonBones(slot, boneIds);
+            skeletonNames[1 + s] = "Skeleton" + std::to_string(s);
+        }
+        frames = makeFrames(slotMap, frameCount, rigidBodies, skeletons);
+
+        rigidBodyMetrics.setRigidBodyMap(rigidBodyNames);
+        rigidBodyMetrics.createInverseMaps();
+        rigidBodyMetrics.setAsset(QStringLiteral("Body0"));
+        rigidBodyMetrics.setMetricSettings(rigidSettings);
+
+        skeletonMetrics.setSkeletonMap(skeletonNames);
+        skeletonMetrics.setBoneMap(boneNames);
+        skeletonMetrics.createInverseMaps();
+        skeletonMetrics.setAsset(QStringLiteral("Skeleton0"));
+        skeletonMetrics.setMetricSettings(bodySettings);
+        skeletonMetrics.setSlotMap(slotMap);
+    }
+
+    std::vector<FrameData> frames;
+    RigidBodyMetrics rigidBodyMetrics;
+    SkeletonMetrics skeletonMetrics;
+};
+
+/**
+ * @brief Computes @p count assets in @p shardCount shards, the first on this thread and the rest on @p pool.
+ *
+ * The split follows DataProcessor::computeMetricsBatch(): contiguous runs of
+ * assets, each shard writing its own entries.
+ */
+template <typename Metrics>
+void computeSharded(const Metrics& metrics, std::vector<AssetMetrics>& assets, int shardCount,
+                    const FrameData& frame, QThreadPool& pool)
+{
+    const int count = static_cast<int>(assets.size());
+    auto computeShard = [&](int shard) {
+        const int first = count * shard / shardCount;
+        const int last = count * (shard + 1) / shardCount;
+        metrics.computeMetricsForAssets(assets.data() + first, last - first, frame);
+    };
+
+    for (int shard = 1; shard < shardCount; ++shard) {
+        pool.start([&computeShard, shard] { computeShard(shard); });
+    }
+    computeShard(0);
+    pool.waitForDone();
+}
+
+/**
+ * @brief Times batches of every size in @p counts, in one shard and split into two and four.
+ *
+ * Returns the time per asset of the largest batch in one shard, in nanoseconds.
+ */
+template <typename Metrics>
+double benchmarkShards(const char* kind, const Metrics& metrics, const std::vector<FrameData>& frames,
+                       std::vector<int> counts, int firstId, QThreadPool& pool)
+{
+    double nsPerAsset = 0.0;
+
+    std::printf("%s batches, us per batch by shards\n", kind);
+    std::printf("  %-28s %10s %10s %10s\n", "", "1", "2", "4");
+
+    for (int count : counts) {
+        std::vector<AssetMetrics> assets;
+        for (int i = 0; i < count; ++i) {
+            assets.push_back(AssetMetrics{firstId + i, MetricsData()});
+        }
+
+        char label[64];
+        std::snprintf(label, sizeof(label), "%d assets", count);
+        std::printf("  %-28s", label);
+        for (int shardCount : { 1, 2, 4 }) {
+            if (shardCount > pool.maxThreadCount() + 1) {
+                std::printf(" %10s", "-");
+                continue;
+            }
+            int frame = 0;
+            const double ns = benchmark_timing::nanosecondsPerCall([&] {
+                frame = (frame + 1) % static_cast<int>(frames.size());
+                computeSharded(metrics, assets, shardCount, frames[frame], pool);
+                benchmark_timing::keep(assets);
+            }, 2000);
+            std::printf(" %10.2f", ns / 1000.0);
+            if (shardCount == 1) {
+                nsPerAsset = ns / count;
+            }
+        }
+        std::printf("\n");
+    }
+    return nsPerAsset;
+}
+
+/**
+ * @brief The sport named @p name of sports.json; the first one if there is no such sport.
+ */
+QJsonObject loadSport(const QString& name)
+{
+    QFile file(QStringLiteral(CLIENT_SOURCE_DIR "/src/config/sports.json"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        std::fprintf(stderr, "cannot open sports.json\n");
+        return QJsonObject();
+    }
+
+    const QJsonArray sports = QJsonDocument::fromJson(file.readAll()).object()["sports"].toArray();
+    for (const QJsonValue& sport : sports) {
+        if (sport.toObject()["name"].toString() == name) {
+            return sport.toObject();
+        }
+    }
+    return sports.isEmpty() ? QJsonObject() : sports[0].toObject();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const QJsonObject sport = loadSport(argc > 1 ? QString::fromLocal8Bit(argv[1]) : QStringLiteral("Sample"));
+    const QJsonArray rigidSettings = sport["rigidMetrics"].toArray();
+    const QJsonArray bodySettings = sport["bodyMetrics"].toArray();
+
+    Scene scene(kRigidBodies, kSkeletons, kFrames, rigidSettings, bodySettings);
+    const std::vector<FrameData>& frames = scene.frames;
+    RigidBodyMetrics& rigidBodyMetrics = scene.rigidBodyMetrics;
+    const SkeletonMetrics& skeletonMetrics = scene.skeletonMetrics;
+
+    std::printf("Metrics path, sport \"%s\": %lld rigid body and %lld skeleton metrics, per frame\n",
+                qPrintable(sport["name"].toString()), static_cast<long long>(rigidSettings.size()),
+                static_cast<long long>(bodySettings.size()));
+
+    int frame = 0;
+    const double legacyRigid = benchmark_timing::nanosecondsPerCall([&] {
+        frame = (frame + 1) % kFrames;
+        const LegacyMetricsData data = legacyRigidBodyMetrics(rigidSettings, 100, frames[frame],
+                                                              frames[(frame + kFrames - 1) % kFrames],
+                                                              frames[(frame + kFrames - 2) % kFrames]);
+        benchmark_timing::keep(data);
+    }, kIterations);
+
+    const double planRigid = benchmark_timing::nanosecondsPerCall([&] {
+        frame = (frame + 1) % kFrames;
+        rigidBodyMetrics.pushFrame(frames[frame]);
+        const MetricsData data = rigidBodyMetrics.computeMetricsForFrame(frames[frame]);
+        benchmark_timing::keep(data);
+    }, kIterations);
+
+    const double legacySkeleton = benchmark_timing::nanosecondsPerCall([&] {
+        frame = (frame + 1) % kFrames;
+        const LegacyMetricsData data = legacySkeletonMetrics(bodySettings, 1, frames[frame]);
+        benchmark_timing::keep(data);
+    }, kIterations);
+
+    const double planSkeleton = benchmark_timing::nanosecondsPerCall([&] {
+        frame = (frame + 1) % kFrames;
+        const MetricsData data = skeletonMetrics.computeMetricsForFrame(frames[frame]);
+        benchmark_timing::keep(data);
+    }, kIterations);
+
+    benchmark_timing::report("rigid body, JSON settings (before)", legacyRigid);
+    benchmark_timing::report("rigid body, metric plan (after)", planRigid);
+    benchmark_timing::report("skeleton, JSON settings (before)", legacySkeleton);
+    benchmark_timing::report("skeleton, metric plan (after)", planSkeleton);
+    std::printf("  %-44s %10.1fx\n", "speedup, both", (legacyRigid + legacySkeleton) / (planRigid + planSkeleton));
+
+    // The pool as DataProcessor sizes it: the calling thread computes one shard itself
+    QThreadPool pool;
+    pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+
+    Scene batchScene(kBatchRigidBodies, kBatchSkeletons, kBatchFrames, rigidSettings, bodySettings);
+    for (const FrameData& batchFrame : batchScene.frames) {
+        batchScene.rigidBodyMetrics.pushFrame(batchFrame);
+    }
+    const double rigidBodyNs = benchmarkShards("Rigid body", batchScene.rigidBodyMetrics, batchScene.frames,
+                                               { 32, 96, 192, 384, 1024 }, 100, pool);
+    const double skeletonNs = benchmarkShards("Skeleton", batchScene.skeletonMetrics, batchScene.frames,
+                                              { 32, 96, 192, 256 }, 1, pool);
+
+    // A shard pays off once the assets it takes from the calling thread outweigh handing it to the pool
+    const double handOffNs = benchmark_timing::nanosecondsPerCall([&] {
+        pool.start([] {});
+        pool.waitForDone();
+    }, 2000);
+    std::printf("Sharding, %d pool threads\n", pool.maxThreadCount());
+    benchmark_timing::report("pool hand-off, one empty task", handOffNs);
+    benchmark_timing::report("rigid body, per asset", rigidBodyNs);
+    benchmark_timing::report("skeleton, per asset", skeletonNs);
+    std::printf("  %-44s %10.2f\n", "skeleton cost / rigid body cost", skeletonNs / rigidBodyNs);
+    std::printf("  %-44s %10.0f\n", "rigid bodies worth a shard (hand-off / cost)", handOffNs / rigidBodyNs);
+    std::printf("  %-44s %10.0f\n", "skeletons worth a shard (hand-off / cost)", handOffNs / skeletonNs);
+    return 0;
+}
@@ -0,0 +1,108 @@
+// Receive path of the built-in NatNet decoder.
+//
+// First parses one frame of a two-skeleton scene over and over, then streams
+// frames of that scene from a local NatNet server on the loopback interface
+// through NatNetUdpSource, as fast as the receiver keeps up, and reports the
+// throughput with the receive, staging and socket queue statistics.
+//
+// Usage: natnet_receive_benchmark [frames]
+
+#include "benchmark_timing.h"
+#include "natnet_packets.h"
+#include "natnet_udp_source.h"
+
+#include <cstdlib>
+#include <thread>
+
+using namespace natnet_packets;
+
+namespace {
+
+constexpr double kRateHz = 240.0;
+constexpr uint64_t kMaxInFlight = 32;   // Datagrams sent ahead of the receiver; half the staging queue
+
+void benchmarkParse(const NatNetScene& scene)
+{
+    const PacketWriter packet = buildFrame(scene, 1, 1.0 / kRateHz);
+    NatNetDepacketizer depacketizer;
+    StagedFrame frame;
+
+    std::printf("Depacketizer, %zu byte frame\n", packet.size());
+    const double ns = benchmark_timing::nanosecondsPerCall([&] {
+        depacketizer.parseFrame(packet.data(), packet.size(), frame, MAX_LABELED_MARKERS);
+        benchmark_timing::keep(frame);
+    }, 20000);
+    benchmark_timing::report("parseFrame", ns);
+    std::printf("  %-44s %10.0f MB/s\n", "throughput", packet.size() / ns * 1000.0);
+}
+
+void benchmarkLoopback(const NatNetScene& scene, int frameCount)
+{
+    LocalNatNetServer server(scene);
+    if (!server.start()) {
+        std::printf("Loopback: command port %u is in use, skipped\n", NatNetDepacketizer::kDefaultCommandPort);
+        return;
+    }
+
+    FrameRingBuffer<FrameData> frames(256);
+    NatNetUdpSource source(frames);
+    QString unicast = "Unicast";
+    source.setServerIP("127.0.0.1");
+    source.setClientIP("127.0.0.1");
+    source.setConnectionType(unicast);
+    if (!source.connect() || !server.waitForClient(std::chrono::milliseconds(2000))) {
+        std::printf("Loopback: unable to connect to the local server\n");
+        return;
+    }
+
+    // Messages are built up front so the sender does not slow the stream down
+    std::vector<std::vector<char>> messages;
+    messages.reserve(static_cast<size_t>(frameCount));
+    for (int i = 1; i <= frameCount; ++i) {
+        messages.push_back(server.frameMessage(i, kRateHz));
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t sent = 0;
+    for (const std::vector<char>& message : messages) {
+        while (sent - source.getReceiveStats().datagrams >= kMaxInFlight) {
+            std::this_thread::yield();
+        }
+        server.send(message);
+        ++sent;
+    }
+    while (source.getIngestStats().decoded + source.getIngestStats().dropped < sent
+           && std::chrono::steady_clock::now() - start < std::chrono::seconds(30)) {
+        std::this_thread::yield();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const UdpReceiveStats receive = source.getReceiveStats();
+    const IngestStats ingest = source.getIngestStats();
+    const DecodeStats decode = source.getDecodeStats();
+    source.disconnect();
+
+    std::printf("Loopback, %d frames of %zu bytes\n", frameCount, messages.front().size());
+    std::printf("  %-44s %10.0f frames/s\n", "throughput", ingest.decoded / elapsed.count());
+    std::printf("  %-44s %10.2f\n", "datagrams per receive call",
+                receive.batches > 0 ? static_cast<double>(receive.datagrams) / receive.batches : 0.0);
+    std::printf("  %-44s %10.2f us (max %.2f)\n", "parse and stage per frame", ingest.callbackMeanUs,
+                ingest.callbackMaxUs);
+    std::printf("  %-44s %10.2f us (max %.2f)\n", "decode per frame", decode.meanDecodeUs, decode.maxDecodeUs);
+    std::printf("  %-44s %10.2f us (max %.2f)\n", "socket queue", receive.socketQueueMeanUs,
+                receive.socketQueueMaxUs);
+    std::printf("  %-44s %10llu\n", "malformed", static_cast<unsigned long long>(receive.malformed));
+    std::printf("  %-44s %10llu\n", "dropped by the staging queue", static_cast<unsigned long long>(ingest.dropped));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int frameCount = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100000;
+
+    NatNetScene scene;
+    benchmarkParse(scene);
+    benchmarkLoopback(scene, frameCount);
+    return 0;
+}
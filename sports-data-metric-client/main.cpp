@@ -4,11 +4,14 @@
 #include <QCoreApplication>
 #include <QThread>
 #include <QStyleFactory>
+#include <QDebug>
 #include <QFile>
 #include <qjsonobject.h>
 
 #include "connection_controller.h"
 #include "replay_controller.h"
+#include "take_json.h"
+#include "take_recorder.h"
 #include "data_processor.h"
 #include "./src/controllers/metricsmanager.h"
 #include "./src/utils/fileutils.h"
@@ -33,7 +36,7 @@ ConnectionController* setupConnection()
 
 // Sets up the DataProcessor and thread.
 // Teturns a pointer to the created DataProcessor object.
-DataProcessor* setupProcessor(const std::vector<FrameData>& frames)
+DataProcessor* setupProcessor(const FrameRingBuffer<FrameData>& frames)
 {
     // Create processor and thread
     DataProcessor* processor = new DataProcessor(frames);
@@ -48,10 +51,54 @@ DataProcessor* setupProcessor(const std::vector<FrameData>& frames)
     return processor;
 }
 
+// Sets up the TakeRecorder and thread.
+// Returns a pointer to the created TakeRecorder object.
+TakeRecorder* setupRecorder(std::shared_ptr<FrameTap> tap)
+{
+    // Create recorder and thread
+    TakeRecorder* recorder = new TakeRecorder(std::move(tap));
+    QThread* recorderThread = new QThread;
+
+    // Move the recorder to the new thread
+    recorder->moveToThread(recorderThread);
+
+    // Start the thread
+    recorderThread->start();
+
+    return recorder;
+}
+
 int main(int argc, char *argv[])
 {
+    // Convert a take between the JSON and binary formats without opening the window,
+    // optionally quantizing the binary take: --quantize [position resolution in mm]
+    if (argc >= 4 && argc <= 6 && QString(argv[1]) == "--convert-take") {
+        QCoreApplication app(argc, argv);
+        TakeEncoding encoding;
+        if (argc >= 5) {
+            bool ok = QString(argv[4]) == "--quantize";
+            const double resolutionMm = argc == 6 ? QString(argv[5]).toDouble(&ok) : 0.0;
+            if (!ok) {
+                qWarning() << "Usage: --convert-take <input> <output> [--quantize [resolution_mm]]";
+                return 1;
+            }
+            encoding = argc == 6 ? TakeEncoding::quantized(resolutionMm / 1000.0) : TakeEncoding::quantized();
+        }
+        return convertTake(QString::fromLocal8Bit(argv[2]), QString::fromLocal8Bit(argv[3]), encoding) ? 0 : 1;
+    }
+
     // Create application
     QApplication a(argc, argv);
+
+    // Register shared frame handles for queued signal/slot connections
+    qRegisterMetaType<FramePtr>("FramePtr");
+    qRegisterMetaType<StreamStats>("StreamStats");
+    qRegisterMetaType<ReplayTimingStats>("ReplayTimingStats");
+    qRegisterMetaType<MetricsBatch>("MetricsBatch");
+    qRegisterMetaType<TakeMetrics>("TakeMetrics");
+    qRegisterMetaType<QVector<FramePtr>>("QVector<FramePtr>");
+    qRegisterMetaType<TakeFramesPtr>("TakeFramesPtr");
+    qRegisterMetaType<TakeHeader>("TakeHeader");
     MainWindow* w = new MainWindow();
 
     // Configure css
@@ -75,8 +122,8 @@ int main(int argc, char *argv[])
     // Set controller in main window for GLwidget
     w->setConnectionController(connectionController);
 
-    // Get frame data list
-    const std::vector<FrameData>& frames = connectionController->getFrames();
+    // Get frame history buffer
+    const FrameRingBuffer<FrameData>& frames = connectionController->getFrames();
 
     // Set up data processor
     DataProcessor* processor = setupProcessor(frames);
@@ -84,6 +131,9 @@ int main(int argc, char *argv[])
     // Pass data processor into replay controller for access to name maps and frame data
     replayController->setDataProcessor(processor);
 
+    // Set up take recorder for live streams
+    TakeRecorder* recorder = setupRecorder(connectionController->getRecordTap());
+
     // Connect new frame signal from ConnectionController to DataProcessor 
     QObject::connect(connectionController, &ConnectionController::sendMaps,
         processor, &DataProcessor::receiveMaps);
@@ -105,6 +155,18 @@ int main(int argc, char *argv[])
     QObject::connect(processor, &DataProcessor::metricsComputed,
                      bodyMetricsManager, &MetricsManager::onMetricsComputed);
 
+    // Connect analyzed take signal from DataProcessor to both MetricsManagers
+    QObject::connect(processor, &DataProcessor::takeAnalyzed,
+                     rigidMetricsManager, &MetricsManager::onTakeAnalyzed);
+    QObject::connect(processor, &DataProcessor::takeAnalyzed,
+                     bodyMetricsManager, &MetricsManager::onTakeAnalyzed);
+
+    // Connect batch metrics signal from DataProcessor to both MetricsManagers
+    QObject::connect(processor, &DataProcessor::metricsBatchComputed,
+                     rigidMetricsManager, &MetricsManager::onMetricsBatchComputed);
+    QObject::connect(processor, &DataProcessor::metricsBatchComputed,
+                     bodyMetricsManager, &MetricsManager::onMetricsBatchComputed);
+
     // Fetch streamingController
     StreamingController* streamingController = w->getStreamingController();
     ConfigureController* configureController = w->getConfigureController();
@@ -133,6 +195,14 @@ int main(int argc, char *argv[])
         QObject::connect(streamingController, &StreamingController::runTake,
             replayController, &ReplayController::startReplay);  
 
+    // Connect analyze take signal from StreamingController to ReplayController
+        QObject::connect(streamingController, &StreamingController::analyzeTake,
+            replayController, &ReplayController::analyzeTake);
+
+    // Connect analyze frames signal from ReplayController to DataProcessor
+        QObject::connect(replayController, &ReplayController::analyzeFrames,
+            processor, &DataProcessor::analyzeTake);
+
     // Connect connection signal from StreamingController to ConnectionController
     QObject::connect(streamingController, &StreamingController::streamingConnect,
         connectionController, &ConnectionController::startConnection);
@@ -149,10 +219,24 @@ int main(int argc, char *argv[])
     QObject::connect(connectionController, &ConnectionController::connectionStatus,
                      streamingController, &StreamingController::onConnectionStatus);
 
+    // Connect stream statistics signal from ConnectionController to StreamingController
+    QObject::connect(connectionController, &ConnectionController::streamStats,
+                     streamingController, &StreamingController::onStreamStats);
+
+    // Connect replay timing signal from ReplayController to StreamingController
+    QObject::connect(replayController, &ReplayController::replayTiming,
+                     streamingController, &StreamingController::onReplayTiming);
+
     // Connect asset send signal from DataProcessor to StreamingController
     QObject::connect(processor, &DataProcessor::sendAssets,
                      configureController, &ConfigureController::onSendAssets);
 
+    // Connect asset send signal from DataProcessor to both MetricsManagers, which name the batch rows
+    QObject::connect(processor, &DataProcessor::sendAssets,
+                     rigidMetricsManager, &MetricsManager::onSendAssets);
+    QObject::connect(processor, &DataProcessor::sendAssets,
+                     bodyMetricsManager, &MetricsManager::onSendAssets);
+
     // Connect asset selection signal from StreamingController to DataProcessor 
     QObject::connect(configureController, &ConfigureController::assetSelected,
         processor, &DataProcessor::receiveAssets);
@@ -161,6 +245,16 @@ int main(int argc, char *argv[])
     QObject::connect(configureController, &ConfigureController::assetSelected,
         w->getOpenGLWidget(), &GLWidget::selectAsset);
 
+    // Connect asset selection signal from ConfigureController to both MetricsManagers
+    QObject::connect(configureController, &ConfigureController::assetSelected,
+        rigidMetricsManager, &MetricsManager::onAssetSelected);
+    QObject::connect(configureController, &ConfigureController::assetSelected,
+        bodyMetricsManager, &MetricsManager::onAssetSelected);
+
+    // Connect asset selection signal from ConfigureController to ConnectionController to filter decoding
+    QObject::connect(configureController, &ConfigureController::assetSelected,
+        connectionController, &ConnectionController::selectAssets);
+
     // Connect metric settings signal from MainWindow to DataProcessor
     QObject::connect(configureController, &ConfigureController::updatedMetricSettings,
         processor, &DataProcessor::receiveMetricSettings);
@@ -181,6 +275,20 @@ int main(int argc, char *argv[])
     QObject::connect(streamingController, &StreamingController::stopTake,
         replayController, &ReplayController::saveReplay);
 
+    // Connect stream recording signals from ReplayController to TakeRecorder
+    QObject::connect(replayController, &ReplayController::startStreamRecording,
+        recorder, &TakeRecorder::startRecording);
+    QObject::connect(replayController, &ReplayController::stopStreamRecording,
+        recorder, &TakeRecorder::stopRecording);
+
+    // Connect recording saved signal from TakeRecorder to ReplayController
+    QObject::connect(recorder, &TakeRecorder::recordingSaved,
+        replayController, &ReplayController::onStreamRecordingSaved);
+
+    // Connect name maps signal from ConnectionController to TakeRecorder
+    QObject::connect(connectionController, &ConnectionController::sendMaps,
+        recorder, &TakeRecorder::receiveMaps);
+
     // Connect new take signal from ReplayController to StreamingController 
     QObject::connect(replayController, &ReplayController::newSavedTake,
         streamingController, &StreamingController::onNewSavedTake);
@@ -3,70 +3,249 @@
 ConnectionController::ConnectionController(QObject* parent)
     : QObject(parent)
 {
+    FrameSource* live = liveSource(false);
+    source.store(live ? live : &synthetic);
+
+    for (FrameSource* each : allSources()) {
+        each->setFrameTap(recordTap);
+    }
+
+    // Parented so it follows the controller onto its thread
+    streamStatsTimer = new QTimer(this);
+    streamStatsTimer->setInterval(kStreamStatsIntervalMs);
+    connect(streamStatsTimer, &QTimer::timeout, this, &ConnectionController::publishStreamStats);
 }
 
 void ConnectionController::startConnection(ConnectionSettings connectionSettings) {
+    FrameSource* selected = &synthetic;
+    if (connectionSettings.connectionType != "Synthetic") {
+        selected = liveSource(connectionSettings.nativeReceiver);
+        if (!selected) {
+            qWarning() << "ConnectionController: built without a NatNet receiver, using the synthetic source";
+            selected = &synthetic;
+        }
+    }
+    source.store(selected);
+    FrameSource& connection = *selected;
+
+    SyntheticConfig syntheticConfig;
+    syntheticConfig.rateHz = connectionSettings.syntheticRateHz;
+    syntheticConfig.rigidBodyCount = connectionSettings.syntheticRigidBodies;
+    syntheticConfig.skeletonCount = connectionSettings.syntheticSkeletons;
+    syntheticConfig.bonesPerSkeleton = connectionSettings.syntheticBonesPerSkeleton;
+    synthetic.setConfig(syntheticConfig);
+
     connection.setServerIP(connectionSettings.serverIP);
     connection.setClientIP(connectionSettings.clientIP);
     connection.setConnectionType(connectionSettings.connectionType);
     connection.setNamingConvention(connectionSettings.namingConvention);
+    frames.reset(static_cast<size_t>(connectionSettings.frameHistoryDepth));
+    connection.setMarkerCap(static_cast<size_t>(connectionSettings.maxMarkersPerFrame));
+    mailbox.reset();
+    frameDelivery = connectionSettings.deliverEveryFrame ? FrameMailbox::Delivery::EveryFrame
+                                                         : FrameMailbox::Delivery::LatestOnly;
 
-    // Sets a callback in NatNetConnection to emit the framesUpdated() signal whenever new frame data is received.
+    // Sets a callback in the source to schedule framesUpdated() whenever new frame data is received.
+    // Only one wakeup is queued at a time; frames arriving meanwhile are picked up by that wakeup.
     connection.setFrameUpdateCallback([this]() {
-        QMetaObject::invokeMethod(this, [this]() {
-            FrameData latestFrame = connection.getLatestFrame();
-            emit framesUpdated(latestFrame);
-        }, Qt::QueuedConnection);
+        if (mailbox.post()) {
+            QMetaObject::invokeMethod(this, &ConnectionController::deliverFrames, Qt::QueuedConnection);
+        }
     });
 
-    // Sets a callback in NatNetConnection to emit the sendMaps() signal whenever new frame data is received.
+    // Sets a callback in the source to emit the sendMaps() signal whenever new frame data is received.
     connection.setAssetUpdateCallback([this]() {
         QMetaObject::invokeMethod(this, [this]() {
-            const std::unordered_map<int, std::string> rigidBodiesMap = connection.getRigidBodyIdToName();
-            const std::unordered_map<int, std::string> skeletonsMap = connection.getSkeletonIdToName();
-            const std::unordered_map<int, std::unordered_map<int, std::string>> bonesMap = connection.getBoneIdToName();
+            const std::unordered_map<int, std::string> rigidBodiesMap = activeSource().getRigidBodyIdToName();
+            const std::unordered_map<int, std::string> skeletonsMap = activeSource().getSkeletonIdToName();
+            const std::unordered_map<int, std::unordered_map<int, std::string>> bonesMap = activeSource().getBoneIdToName();
             emit sendMaps(rigidBodiesMap, skeletonsMap, bonesMap);
+
+            // Skeleton IDs may have changed with the new descriptions
+            updateDecodeSubscriptions();
         }, Qt::QueuedConnection);
     });
 
-    connection.connect();
-    qDebug() << "ConnetionController: connect status signal sent" << connection.getConnectionStatus();
-    emit connectionStatus(connection.getConnectionStatus());
+    const bool started = connection.connect();
+    if (!started) {
+        qWarning() << "ConnectionController: unable to start the" << connectionSettings.connectionType << "source";
+    }
+    qDebug() << "ConnetionController: connect status signal sent" << started;
+    emit connectionStatus(started);
+
+    if (started) {
+        streamStatsTimer->start();
+    }
 }
 
 void ConnectionController::stopConnection() {
-    connection.disconnect();
+    streamStatsTimer->stop();
+
+    FrameSource& connection = activeSource();
+
+    const StreamStats streamStats = connection.getStreamStats();
+    qDebug() << "ConnectionController: frames" << streamStats.frames << "gaps" << streamStats.gaps
+             << "missing" << streamStats.missingFrames << "duplicates" << streamStats.duplicates
+             << "out of order" << streamStats.outOfOrder << "restarts" << streamStats.discontinuities
+             << "latency p50" << streamStats.totalLatency.p50Ms << "ms p99" << streamStats.totalLatency.p99Ms
+             << "ms max" << streamStats.totalLatency.maxMs << "ms";
+
+    const FrameMailbox::Stats stats = mailbox.getStats();
+    qDebug() << "ConnectionController: frames posted" << stats.posted << "delivered" << stats.delivered
+             << "coalesced" << stats.coalesced << "skipped" << stats.skipped << "wakeups" << stats.wakeups;
+
+    if (!connection.disconnect()) {
+        qWarning() << "ConnectionController: the source did not stop cleanly";
+    }
     qDebug() << "ConnetionController: disconnect status signal sent" << connection.getConnectionStatus();
     emit connectionStatus(connection.getConnectionStatus());
 }
 
-const std::vector<FrameData>& ConnectionController::getFrames() const
+FrameSource& ConnectionController::activeSource() const
 {
-    return connection.getFrames();
+    return *source.load();
+}
+
+FrameSource* ConnectionController::liveSource(bool preferNative)
+{
+#ifdef HAVE_NATNET_UDP
+    if (preferNative) {
+        return &natnetUdp;
+    }
+#else
+    Q_UNUSED(preferNative);
+#endif
+#if defined(HAVE_NATNET)
+    return &natnet;
+#elif defined(HAVE_NATNET_UDP)
+    return &natnetUdp;
+#else
+    return nullptr;
+#endif
+}
+
+std::vector<FrameSource*> ConnectionController::allSources()
+{
+    std::vector<FrameSource*> sources{&synthetic};
+#ifdef HAVE_NATNET
+    sources.push_back(&natnet);
+#endif
+#ifdef HAVE_NATNET_UDP
+    sources.push_back(&natnetUdp);
+#endif
+    return sources;
+}
+
+const FrameRingBuffer<FrameData>& ConnectionController::getFrames() const
+{
+    return frames;
+}
+
+std::shared_ptr<FrameTap> ConnectionController::getRecordTap() const
+{
+    return recordTap;
 }
 
 const std::unordered_map<int, std::string>& ConnectionController::getRigidBodyIdToName() const
 {
-    return connection.getRigidBodyIdToName();
+    return activeSource().getRigidBodyIdToName();
 }
 
 const std::unordered_map<int, std::string>& ConnectionController::getSkeletonIdToName() const
 {
-    return connection.getSkeletonIdToName();
+    return activeSource().getSkeletonIdToName();
 }
 
 const std::unordered_map<int, std::unordered_map<int, std::string>>& ConnectionController::getBoneIdToName() const
 {
-    return connection.getBoneIdToName();
+    return activeSource().getBoneIdToName();
 }
 
 sDataDescriptions* ConnectionController::getDataDescriptions()
 {
-    return connection.getDataDescriptions();
+    return activeSource().getDataDescriptions();
+}
+
+FrameMailbox::Stats ConnectionController::getDeliveryStats() const
+{
+    return mailbox.getStats();
+}
+
+IngestStats ConnectionController::getIngestStats() const
+{
+    return activeSource().getIngestStats();
+}
+
+StreamStats ConnectionController::getStreamStats() const
+{
+    return activeSource().getStreamStats();
+}
+
+DecodeStats ConnectionController::getDecodeStats() const
+{
+    return activeSource().getDecodeStats();
+}
+
+void ConnectionController::subscribeDecode(DecodeFilter::Subscriber subscriber, DecodeFilter::Subscription subscription)
+{
+    // Every source keeps the subscription so switching sources does not lose it
+    for (FrameSource* frameSource : allSources()) {
+        frameSource->subscribeDecode(subscriber, subscription);
+    }
+}
+
+void ConnectionController::selectAssets(AssetSettings assetSettings)
+{
+    selectedAssets = assetSettings;
+    updateDecodeSubscriptions();
+}
+
+void ConnectionController::updateDecodeSubscriptions()
+{
+    const std::string skeletonName = selectedAssets.skeleton.toStdString();
+    const bool batchListed = selectedAssets.batchMetrics
+        && selectedAssets.batchScope == AssetSettings::BatchScope::Listed;
+    const bool allBatchSkeletons = selectedAssets.batchMetrics && !batchListed;
+
+    std::vector<int> selectedIds;
+    std::vector<int> metricIds;
+    for (const auto& [id, name] : activeSource().getSkeletonIdToName()) {
+        if (name == skeletonName) {
+            selectedIds.push_back(id);
+            metricIds.push_back(id);
+        } else if (batchListed && selectedAssets.batchSkeletons.contains(QString::fromStdString(name))) {
+            metricIds.push_back(id);
+        }
+    }
+
+    // Batch metrics over every skeleton need every skeleton decoded
+    subscribeDecode(DecodeFilter::Subscriber::Metrics, allBatchSkeletons
+        ? DecodeFilter::Subscription::all() : DecodeFilter::Subscription::only(std::move(metricIds)));
+
+    // The 3D view draws every skeleton unless it is set to draw the selected one
+    subscribeDecode(DecodeFilter::Subscriber::Renderer, selectedAssets.drawSelectedOnly
+        ? DecodeFilter::Subscription::only(std::move(selectedIds)) : DecodeFilter::Subscription::all());
+}
+
+void ConnectionController::publishStreamStats()
+{
+    emit streamStats(activeSource().getStreamStats());
+}
+
+void ConnectionController::setFrameDelivery(FrameMailbox::Delivery delivery)
+{
+    frameDelivery = delivery;
+}
+
+void ConnectionController::deliverFrames()
+{
+    for (const FrameMailbox::Pointer& frame : mailbox.take(frameDelivery)) {
+        emit framesUpdated(frame);
+    }
 }
 
-void ConnectionController::replayFrame(FrameData frame)
+void ConnectionController::replayFrame(FramePtr frame)
 {
     emit framesUpdated(frame);
-    qDebug() << "ConnectionController: replay frame emit framesUpdated" << frame.frameNumber;
+    qDebug() << "ConnectionController: replay frame emit framesUpdated" << frame->frameNumber;
 }
\ No newline at end of file
@@ -1,11 +1,24 @@
-// QObject wrapper class for NatNetConnection.
+// QObject wrapper class for the frame sources.
 // Manages connection control from a separate thread and provides access to motion capture data.
+// Owns the frame history shared by the NatNet source and the synthetic generator; the
+// connection type chosen in the settings selects which one feeds it.
 
 #pragma once
 
 #include <QObject>
+#include <QTimer>
+#include <atomic>
+#include "frame_source.h"
+#include "synthetic_frame_source.h"
+#ifdef HAVE_NATNET
 #include "natnet_connection.h"
+#endif
+#ifdef HAVE_NATNET_UDP
+#include "natnet_udp_source.h"
+#endif
+#include "frame_mailbox.h"
 #include "../controllers/streamingcontroller.h"
+#include "../controllers/configurecontroller.h"
 
 class ConnectionController : public QObject {
     Q_OBJECT
@@ -18,10 +31,16 @@ public:
     explicit ConnectionController(QObject* parent = nullptr);
 
     /**
-     * @brief Gets the list of captured motion frames.
-     * @return A constant reference to the vector of FrameData.
+     * @brief Gets the bounded history of captured motion frames.
+     * @return A constant reference to the frame ring buffer.
      */
-    const std::vector<FrameData>& getFrames() const;
+    const FrameRingBuffer<FrameData>& getFrames() const;
+
+    /**
+     * @brief Gets the tap that hands every frame of the active source to the recorder.
+     * @return The tap, shared with every source.
+     */
+    std::shared_ptr<FrameTap> getRecordTap() const;
 
     /**
      * @brief Gets the mapping from rigid body IDs to their corresponding names.
@@ -47,21 +66,113 @@ public:
      */
     sDataDescriptions* getDataDescriptions();
 
+    /**
+     * @brief Gets the counters of delivered, coalesced and skipped live frames.
+     * @return A copy of the frame mailbox statistics.
+     */
+    FrameMailbox::Stats getDeliveryStats() const;
+
+    /**
+     * @brief Gets the staging queue depth and SDK callback timings of the ingest path.
+     * @return A snapshot of the ingest statistics.
+     */
+    IngestStats getIngestStats() const;
+
+    /**
+     * @brief Gets the frame gaps, duplicates, reordering and latency percentiles of the live stream.
+     * @return A snapshot of the stream statistics.
+     */
+    StreamStats getStreamStats() const;
+
+    /**
+     * @brief Gets the per-frame decode time and the skeletons decoded and skipped.
+     * @return A snapshot of the decode statistics.
+     */
+    DecodeStats getDecodeStats() const;
+
+    /**
+     * @brief Sets which skeletons @p subscriber needs decoded, on every source. Thread safe.
+     * @param subscriber The consumer whose subscription is replaced.
+     * @param subscription Skeleton IDs to decode, or all skeletons.
+     */
+    void subscribeDecode(DecodeFilter::Subscriber subscriber, DecodeFilter::Subscription subscription);
+
 public slots:
     /**
-     * @brief Starts the NatNet server connection.
+     * @brief Starts the source selected by the connection type: the NatNet server or the synthetic generator.
      */
     void startConnection(ConnectionSettings connectionSettings);
 
     /**
-     * @brief Stops the NatNet server connection.
+     * @brief Stops the active frame source.
      */
     void stopConnection();
 
-    void replayFrame(FrameData frame);
+    void replayFrame(FramePtr frame);
+
+    /**
+     * @brief Chooses whether live frames are delivered as latest-only or every frame.
+     * @param delivery The delivery mode used from the next wakeup on.
+     */
+    void setFrameDelivery(FrameMailbox::Delivery delivery);
+
+    /**
+     * @brief Subscribes the metrics and the 3D view to the skeletons they use, so only those are decoded.
+     * @param assetSettings The assets selected for metric computation and drawing.
+     */
+    void selectAssets(AssetSettings assetSettings);
+
+private slots:
+    /**
+     * @brief Drains the frame mailbox and emits framesUpdated() for the frames taken.
+     */
+    void deliverFrames();
+
+    /**
+     * @brief Emits streamStats() with the current stream statistics.
+     */
+    void publishStreamStats();
+
+    /**
+     * @brief Resolves the selected skeleton names to IDs and updates the decode subscriptions.
+     */
+    void updateDecodeSubscriptions();
 
 private:
-    NatNetConnection connection;  // Underlying NatNet connection object
+    /**
+     * @brief The source currently feeding the history.
+     */
+    FrameSource& activeSource() const;
+
+    /**
+     * @brief The source receiving from Motive, or nullptr if none was built.
+     * @param preferNative Use the built-in NatNet decoder even when the SDK is available.
+     */
+    FrameSource* liveSource(bool preferNative);
+
+    /**
+     * @brief Every source built into the client.
+     */
+    std::vector<FrameSource*> allSources();
+
+    FrameRingBuffer<FrameData> frames;                                      // Bounded history shared by all sources
+#ifdef HAVE_NATNET
+    NatNetConnection natnet{frames};                                        // Live frames from Motive
+#endif
+#ifdef HAVE_NATNET_UDP
+    NatNetUdpSource natnetUdp{frames};                                      // Live frames from Motive, without the SDK
+#endif
+    SyntheticFrameSource synthetic{frames};                                 // Generated frames for load tests
+    std::atomic<FrameSource*> source{nullptr};                              // Active source; read from any thread
+    FrameMailbox mailbox{frames};                                           // Coalesces frame notifications
+    FrameMailbox::Delivery frameDelivery = FrameMailbox::Delivery::LatestOnly;  // Current delivery mode
+    QTimer* streamStatsTimer = nullptr;                                     // Publishes stream statistics while connected
+    AssetSettings selectedAssets;                                           // Assets selected for metrics and drawing
+
+    static constexpr int kStreamStatsIntervalMs = 1000;     // Period of streamStats() while connected
+    static constexpr size_t kRecordTapDepth = 512;          // Frames the recorder can fall behind; 0.25 s at the synthetic source's 2000 Hz
+
+    std::shared_ptr<FrameTap> recordTap = std::make_shared<FrameTap>(kRecordTapDepth);     // Every published frame, for the recorder
 
 signals:
     /**
@@ -70,9 +181,9 @@ signals:
      * This signal delivers the latest processed FrameData to any connected components,
      * such as data processors or rendering systems.
      *
-     * @param latestFrame A copy of the most recent FrameData received from the NatNet server.
+     * @param latestFrame A shared handle to the most recent FrameData received from the NatNet server.
      */
-    void framesUpdated(FrameData latestFrame);
+    void framesUpdated(FramePtr latestFrame);
 
     /**
      * @brief Signal emitted when updated asset maps are available.
@@ -94,4 +205,11 @@ signals:
      * @param connectionStatus True if connected, false otherwise.
      */  
     void connectionStatus(bool connectionStatus);
+
+    /**
+     * @brief Signal emitted periodically while connected with the live stream statistics.
+     *
+     * @param stats Frame sequencing counters and latency percentiles since connecting.
+     */
+    void streamStats(StreamStats stats);
 };
\ No newline at end of file
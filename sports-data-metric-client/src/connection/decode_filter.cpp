@@ -0,0 +1,43 @@
+#include "decode_filter.h"
+
+#include <QMutexLocker>
+
+void DecodeFilter::subscribe(Subscriber subscriber, Subscription subscription)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_subscriptions[static_cast<size_t>(subscriber)] = std::move(subscription);
+
+    Selection& selection = m_selection;
+    selection.m_allSkeletons = false;
+    selection.m_skeletonIds.clear();
+    for (const Subscription& current : m_subscriptions) {
+        if (current.allSkeletons) {
+            selection.m_allSkeletons = true;
+            selection.m_skeletonIds.clear();
+            break;
+        }
+        selection.m_skeletonIds.insert(selection.m_skeletonIds.end(),
+                                       current.skeletonIds.begin(), current.skeletonIds.end());
+    }
+
+    std::sort(selection.m_skeletonIds.begin(), selection.m_skeletonIds.end());
+    selection.m_skeletonIds.erase(std::unique(selection.m_skeletonIds.begin(), selection.m_skeletonIds.end()),
+                                  selection.m_skeletonIds.end());
+
+    m_version.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t DecodeFilter::version() const
+{
+    return m_version.load(std::memory_order_acquire);
+}
+
+uint64_t DecodeFilter::read(Selection& selection) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    selection.m_allSkeletons = m_selection.m_allSkeletons;
+    selection.m_skeletonIds.assign(m_selection.m_skeletonIds.begin(), m_selection.m_skeletonIds.end());
+    return m_version.load(std::memory_order_relaxed);
+}
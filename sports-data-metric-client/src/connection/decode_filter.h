@@ -0,0 +1,93 @@
+// Subscription filter deciding which skeletons the ingest worker decodes.
+//
+// Converting every bone of every skeleton into Qt types dominates the decode
+// cost in venues with many performers, while the metrics and the 3D view often
+// need only a few of them. Each consumer (the metrics and the renderer)
+// subscribes to the skeleton IDs it needs; the worker fully decodes the union
+// and leaves the bones of every other skeleton empty. Subscriptions can change
+// from any thread: each change bumps a version, and the worker copies the new
+// selection only when the version it last read is stale, so the per-frame check
+// is a single atomic load.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include <QMutex>
+
+class DecodeFilter {
+public:
+    /**
+     * @brief Consumers that subscribe to decoded assets.
+     */
+    enum class Subscriber {
+        Metrics,        // Skeletons selected for metric computation
+        Renderer,       // Skeletons drawn by the 3D view
+        Count
+    };
+
+    /**
+     * @brief Skeleton IDs one subscriber needs fully decoded.
+     */
+    struct Subscription {
+        bool allSkeletons = true;       // Every skeleton, regardless of skeletonIds
+        std::vector<int> skeletonIds;   // Skeletons needed when allSkeletons is false
+
+        static Subscription all() { return Subscription(); }
+        static Subscription only(std::vector<int> ids) { return Subscription{false, std::move(ids)}; }
+    };
+
+    /**
+     * @brief Union of all subscriptions, as read by the decoder.
+     */
+    class Selection {
+    public:
+        /**
+         * @brief True if the bones of skeleton @p id must be decoded.
+         */
+        bool wantsSkeleton(int id) const
+        {
+            return m_allSkeletons || std::binary_search(m_skeletonIds.begin(), m_skeletonIds.end(), id);
+        }
+
+        /**
+         * @brief True if every skeleton is decoded.
+         */
+        bool wantsAllSkeletons() const { return m_allSkeletons; }
+
+    private:
+        friend class DecodeFilter;
+
+        bool m_allSkeletons = true;
+        std::vector<int> m_skeletonIds;     // Sorted, unique
+    };
+
+    /**
+     * @brief Replaces the subscription of @p subscriber and publishes the new selection.
+     */
+    void subscribe(Subscriber subscriber, Subscription subscription);
+
+    /**
+     * @brief Version of the selection, bumped by every subscribe(); 0 until the first one.
+     *
+     * Cheap enough to call once per frame.
+     */
+    uint64_t version() const;
+
+    /**
+     * @brief Copies the current selection into @p selection.
+     *
+     * Reuses the capacity of @p selection, so it only allocates when the selection grows.
+     * @return The version of the selection copied.
+     */
+    uint64_t read(Selection& selection) const;
+
+private:
+    mutable QMutex m_mutex;                                                 // Guards the subscriptions and the selection
+    std::array<Subscription, static_cast<size_t>(Subscriber::Count)> m_subscriptions;
+    Selection m_selection;                                                  // Union of m_subscriptions
+    std::atomic<uint64_t> m_version{0};                                     // Bumped after m_selection changes
+};
@@ -0,0 +1,84 @@
+#include "frame_mailbox.h"
+
+FrameMailbox::FrameMailbox(const FrameRingBuffer<FrameData>& history)
+    : m_history(history)
+{
+}
+
+bool FrameMailbox::post()
+{
+    m_posted.fetch_add(1, std::memory_order_relaxed);
+
+    // Only the transition from idle to pending needs a wakeup
+    if (m_pending.exchange(true, std::memory_order_acq_rel)) {
+        return false;
+    }
+
+    m_wakeups.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+std::vector<FrameMailbox::Pointer> FrameMailbox::take(Delivery delivery)
+{
+    m_pending.store(false, std::memory_order_release);
+
+    std::vector<Pointer> frames;
+
+    if (delivery == Delivery::LatestOnly) {
+        // The frame and its sequence come from one read, so a frame the producer
+        // publishes meanwhile is left for the next wakeup rather than delivered twice
+        uint64_t sequence = 0;
+        Pointer latest = m_history.latest(&sequence);
+        if (!latest || sequence < m_nextSequence) {
+            // History was reset underneath us, or nothing new since the last wakeup
+            m_nextSequence = latest ? sequence + 1 : 0;
+            return frames;
+        }
+
+        frames.push_back(std::move(latest));
+        m_coalesced.fetch_add(sequence - m_nextSequence, std::memory_order_relaxed);
+        m_nextSequence = sequence + 1;
+    } else {
+        const uint64_t head = m_history.totalPushed();
+        if (head <= m_nextSequence) {
+            // History was reset underneath us, or nothing new since the last wakeup
+            m_nextSequence = head;
+            return frames;
+        }
+
+        const FrameRingBuffer<FrameData>::Snapshot pending = m_history.snapshotSince(m_nextSequence);
+
+        frames.reserve(pending.size());
+        for (size_t i = 0; i < pending.size(); ++i) {
+            frames.push_back(pending.pointerAt(i));
+        }
+        m_skipped.fetch_add(pending.firstSequence() - m_nextSequence, std::memory_order_relaxed);
+        m_nextSequence = pending.firstSequence() + pending.size();
+    }
+
+    m_delivered.fetch_add(frames.size(), std::memory_order_relaxed);
+    return frames;
+}
+
+void FrameMailbox::reset()
+{
+    m_nextSequence = 0;
+    m_pending.store(false, std::memory_order_release);
+
+    m_posted.store(0, std::memory_order_relaxed);
+    m_delivered.store(0, std::memory_order_relaxed);
+    m_coalesced.store(0, std::memory_order_relaxed);
+    m_skipped.store(0, std::memory_order_relaxed);
+    m_wakeups.store(0, std::memory_order_relaxed);
+}
+
+FrameMailbox::Stats FrameMailbox::getStats() const
+{
+    Stats stats;
+    stats.posted = m_posted.load(std::memory_order_relaxed);
+    stats.delivered = m_delivered.load(std::memory_order_relaxed);
+    stats.coalesced = m_coalesced.load(std::memory_order_relaxed);
+    stats.skipped = m_skipped.load(std::memory_order_relaxed);
+    stats.wakeups = m_wakeups.load(std::memory_order_relaxed);
+    return stats;
+}
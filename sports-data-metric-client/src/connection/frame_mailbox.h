@@ -0,0 +1,85 @@
+// Coalescing hand-off between the frame producer and the Qt event loop.
+//
+// The producer publishes frames into the frame history and then posts to the
+// mailbox. Only the first post after the consumer has drained the mailbox asks
+// for a wakeup, so at most one notification is ever queued no matter how far
+// the consumer falls behind. When woken, the consumer takes either the latest
+// frame or every frame it has not seen yet that is still held by the history.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "frame_data.h"
+#include "frame_ring_buffer.h"
+
+class FrameMailbox {
+public:
+    using Pointer = FramePtr;
+
+    /**
+     * @brief How frames are handed to the consumer on each wakeup.
+     */
+    enum class Delivery {
+        LatestOnly,     // Only the newest frame; older pending frames are coalesced
+        EveryFrame      // Every pending frame still held by the history, oldest first
+    };
+
+    /**
+     * @brief Delivery counters, readable from any thread.
+     */
+    struct Stats {
+        uint64_t posted = 0;        // Frames announced by the producer
+        uint64_t delivered = 0;     // Frames handed to the consumer
+        uint64_t coalesced = 0;     // Frames superseded by a newer one (LatestOnly)
+        uint64_t skipped = 0;       // Frames evicted from the history before delivery (EveryFrame)
+        uint64_t wakeups = 0;       // Notifications requested by post()
+    };
+
+    /**
+     * @brief Constructs a mailbox reading frames from @p history.
+     */
+    explicit FrameMailbox(const FrameRingBuffer<FrameData>& history);
+
+    /**
+     * @brief Announces that a new frame has been pushed into the history.
+     *
+     * Called by the producer after every push.
+     * @return True if the caller must schedule a wakeup of the consumer.
+     */
+    bool post();
+
+    /**
+     * @brief Drains the mailbox and returns the frames to deliver.
+     *
+     * Called by the consumer when woken. Re-arms notifications before reading so
+     * that a frame posted concurrently always triggers a further wakeup.
+     * @param delivery Whether to return only the latest frame or every pending one.
+     * @return Frames to deliver, oldest first; empty if nothing new arrived.
+     */
+    std::vector<Pointer> take(Delivery delivery);
+
+    /**
+     * @brief Forgets delivery progress; call after the history has been reset.
+     */
+    void reset();
+
+    /**
+     * @brief Returns a copy of the delivery counters.
+     */
+    Stats getStats() const;
+
+private:
+    const FrameRingBuffer<FrameData>& m_history;    // Frames to deliver from
+
+    std::atomic<bool> m_pending{false};             // True while a wakeup is in flight
+    uint64_t m_nextSequence = 0;                    // Sequence of the first undelivered frame (consumer only)
+
+    std::atomic<uint64_t> m_posted{0};
+    std::atomic<uint64_t> m_delivered{0};
+    std::atomic<uint64_t> m_coalesced{0};
+    std::atomic<uint64_t> m_skipped{0};
+    std::atomic<uint64_t> m_wakeups{0};
+};
@@ -0,0 +1,573 @@
+#include "frame_source.h"
+
+#include <algorithm>
+#include <chrono>
+#include <QDebug>
+
+FrameSource::FrameSource(FrameRingBuffer<FrameData>& frames)
+    : frames(frames)
+{
+}
+
+FrameSource::~FrameSource()
+{
+    stopIngest();
+}
+
+void FrameSource::startIngest()
+{
+    stopIngest();
+
+    // Size the staging slots for the described scene, so the callback does not allocate while warming up
+    const FrameLayout layout = framePool.layout();
+    size_t boneCount = 0;
+    for (int bones : layout.skeletonBoneCounts) {
+        boneCount += static_cast<size_t>(bones);
+    }
+    staging.reset();
+    staging.reserve(static_cast<size_t>(layout.rigidBodyCount), boneCount, staging.markerCap());
+
+    callbackCount.store(0, std::memory_order_relaxed);
+    callbackTotalNs.store(0, std::memory_order_relaxed);
+    callbackMaxNs.store(0, std::memory_order_relaxed);
+    decodedFrames.store(0, std::memory_order_relaxed);
+    streamTracker.reset();
+    for (std::atomic<uint64_t>* counter : {&decodeTotalNs, &decodeLastNs, &decodeMaxNs, &filteredFrames,
+                                           &filteredDecodeTotalNs, &skeletonsDecoded, &skeletonsSkipped,
+                                           &bonesDecoded, &bonesSkipped, &undescribedAssets}) {
+        counter->store(0, std::memory_order_relaxed);
+    }
+
+    ingestRunning.store(true);
+    ingestThread = std::thread(&FrameSource::ingestLoop, this);
+}
+
+void FrameSource::stopIngest()
+{
+    if (!ingestThread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(ingestMutex);
+        ingestRunning.store(false);
+    }
+    ingestWake.notify_one();
+    ingestThread.join();
+}
+
+void FrameSource::ingestLoop()
+{
+    qDebug() << "FrameSource: ingest worker started";
+
+    while (true)
+    {
+        // Drain everything staged so far
+        while (const StagedFrame* staged = staging.front())
+        {
+            processFrameData(*staged);
+            staging.pop();
+        }
+
+        if (!ingestRunning.load()) {
+            break;
+        }
+
+        // Announce that we are about to sleep, then re-check the queue so a frame
+        // staged before the callback saw the flag is not left waiting.
+        std::unique_lock<std::mutex> lock(ingestMutex);
+        ingestWaiting.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        ingestWake.wait(lock, [this]() {
+            return staging.size() > 0 || !ingestRunning.load();
+        });
+        ingestWaiting.store(false);
+    }
+
+    qDebug() << "FrameSource: ingest worker stopped";
+}
+
+void FrameSource::stageFrameData(sFrameOfMocapData* data)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    // Arrival latencies depend on when the frame reached us, so take them here
+    double transitLatencyMs = -1.0;
+    double totalLatencyMs = -1.0;
+    if (data->TransmitTimestamp != 0) {
+        const double seconds = secondsSinceHostTimestamp(data->TransmitTimestamp);
+        transitLatencyMs = seconds >= 0.0 ? seconds * 1000.0 : -1.0;
+    }
+    if (data->CameraMidExposureTimestamp != 0) {
+        const double seconds = secondsSinceHostTimestamp(data->CameraMidExposureTimestamp);
+        totalLatencyMs = seconds >= 0.0 ? seconds * 1000.0 : -1.0;
+    }
+
+    if (staging.stage(*data, transitLatencyMs, totalLatencyMs)) {
+        wakeIngest();
+    }
+
+    recordStagingTime(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+}
+
+StagedFrame* FrameSource::claimStagedFrame()
+{
+    return staging.claim();
+}
+
+void FrameSource::commitStagedFrame()
+{
+    staging.commit();
+    wakeIngest();
+}
+
+size_t FrameSource::stagingMarkerCap() const
+{
+    return staging.markerCap();
+}
+
+void FrameSource::recordStagingTime(uint64_t elapsedNs)
+{
+    callbackCount.fetch_add(1, std::memory_order_relaxed);
+    callbackTotalNs.fetch_add(elapsedNs, std::memory_order_relaxed);
+    if (elapsedNs > callbackMaxNs.load(std::memory_order_relaxed)) {
+        callbackMaxNs.store(elapsedNs, std::memory_order_relaxed);
+    }
+}
+
+void FrameSource::wakeIngest()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (ingestWaiting.load())
+    {
+        // Only wake the worker when it is asleep; otherwise it picks the frame up on its own
+        {
+            std::lock_guard<std::mutex> lock(ingestMutex);
+        }
+        ingestWake.notify_one();
+    }
+}
+
+double FrameSource::secondsSinceHostTimestamp(uint64_t /*hostTimestamp*/) const
+{
+    // Sources without a clock shared with the server cannot measure arrival latency
+    return -1.0;
+}
+
+void FrameSource::setHostClockFrequency(uint64_t ticksPerSecond)
+{
+    hostTicksPerMs.store(ticksPerSecond / 1000.0);
+}
+
+void FrameSource::logStats() const
+{
+    const FramePoolStats poolStats = framePool.getStats();
+    qDebug() << "Frame pool: acquired" << poolStats.acquired << "recycled" << poolStats.recycled
+             << "exhausted" << poolStats.exhausted << "grown" << poolStats.grown;
+
+    const IngestStats ingestStats = getIngestStats();
+    qDebug() << "Ingest: staged" << ingestStats.staged << "dropped" << ingestStats.dropped
+             << "decoded" << ingestStats.decoded << "max queue depth" << ingestStats.maxQueueDepth
+             << "callback mean" << ingestStats.callbackMeanUs << "us max" << ingestStats.callbackMaxUs << "us";
+
+    const DecodeStats decodeStats = getDecodeStats();
+    qDebug() << "Decode: mean" << decodeStats.meanDecodeUs << "us max" << decodeStats.maxDecodeUs << "us"
+             << "full" << decodeStats.meanFullDecodeUs << "us filtered" << decodeStats.meanFilteredDecodeUs << "us over"
+             << decodeStats.filteredFrames << "frames"
+             << "skeletons decoded" << decodeStats.skeletonsDecoded << "skipped" << decodeStats.skeletonsSkipped
+             << "bones decoded" << decodeStats.bonesDecoded << "skipped" << decodeStats.bonesSkipped
+             << "undescribed assets" << decodeStats.undescribedAssets;
+}
+
+void FrameSource::processDataDescriptions(sDataDescriptions* pDataDefs)
+{
+    FrameLayout layout;
+    int rigidBodyMarkers = 0;
+    int boneCount = 0;
+    auto slotMap = std::make_shared<AssetSlotMap>();
+
+    // Descriptions replace whatever the previous session announced
+    rigidBodyIdToName.clear();
+    skeletonIdToName.clear();
+    boneIdToName.clear();
+
+    for (int i = 0; i < pDataDefs->nDataDescriptions; i++)
+    {
+        if (pDataDefs->arrDataDescriptions[i].type == Descriptor_RigidBody)
+        {
+            // RigidBody
+            sRigidBodyDescription* pRB = pDataDefs->arrDataDescriptions[i].Data.RigidBodyDescription;
+
+            // Save to rigid body name map
+            rigidBodyIdToName[pRB->ID] = pRB->szName;
+            slotMap->addRigidBody(pRB->ID);
+
+            layout.rigidBodyCount++;
+            rigidBodyMarkers += pRB->nMarkers;
+        }
+        else if (pDataDefs->arrDataDescriptions[i].type == Descriptor_Skeleton)
+        {
+            // Skeleton
+            sSkeletonDescription* pSK = pDataDefs->arrDataDescriptions[i].Data.SkeletonDescription;
+
+            // Save to skeleton name map
+            skeletonIdToName[pSK->skeletonID] = pSK->szName;
+            const int skeletonSlot = slotMap->addSkeleton(pSK->skeletonID);
+
+            layout.skeletonBoneCounts.push_back(pSK->nRigidBodies);
+            boneCount += pSK->nRigidBodies;
+
+            // Save each bone under this skeleton
+            std::vector<int> boneIds;
+            boneIds.reserve(static_cast<size_t>(pSK->nRigidBodies));
+            for (int j = 0; j < pSK->nRigidBodies; j++)
+            {
+                sRigidBodyDescription* pRB = &pSK->RigidBodies[j];
+
+                // Save to bone name nested map
+                boneIdToName[pSK->skeletonID][pRB->ID] = pRB->szName;
+                boneIds.push_back(pRB->ID);
+            }
+
+            // Bones are streamed in description order
+            slotMap->setSkeletonBones(skeletonSlot, std::move(boneIds));
+        }
+        else if (pDataDefs->arrDataDescriptions[i].type == Descriptor_MarkerSet)
+        {
+            // MarkerSet; the "all" set lists every labeled marker of the scene
+            sMarkerSetDescription* pMS = pDataDefs->arrDataDescriptions[i].Data.MarkerSetDescription;
+
+            layout.markerCount = std::max(layout.markerCount, pMS->nMarkers);
+        }
+    }
+
+    // Frames hold one slot per described asset, in description order
+    layout.rigidBodyCount = slotMap->rigidBodyCount();
+    layout.markerCount = std::min(std::max(layout.markerCount, rigidBodyMarkers), static_cast<int>(stagingMarkerCap()));
+    qInfo() << "FrameSource:" << pDataDefs->nDataDescriptions << "data descriptions," << layout.rigidBodyCount
+            << "rigid bodies," << layout.skeletonBoneCounts.size() << "skeletons with" << boneCount << "bones,"
+            << layout.markerCount << "markers";
+    std::atomic_store_explicit(&assetSlots, std::shared_ptr<const AssetSlotMap>(std::move(slotMap)),
+                               std::memory_order_release);
+
+    // Preallocate enough frames to fill the history and the tap plus those still held by consumers
+    framePool.configure(layout, frames.capacity() + (frameTap ? frameTap->capacity() : 0) + kInFlightFrames);
+
+    // Invokes callback signal when new frames are available
+    if (assetCallback) {
+        assetCallback(); 
+    }
+}
+
+void FrameSource::processFrameData(const StagedFrame& staged)
+{
+    // Server-side latency from exposure to transmit, in the server's clock
+    const double ticksPerMs = hostTicksPerMs.load(std::memory_order_relaxed);
+    double systemLatencyMs = -1.0;
+    if (ticksPerMs > 0.0 && staged.cameraMidExposureTimestamp != 0
+        && staged.transmitTimestamp >= staged.cameraMidExposureTimestamp) {
+        systemLatencyMs = (staged.transmitTimestamp - staged.cameraMidExposureTimestamp) / ticksPerMs;
+    }
+    streamTracker.recordLatency(systemLatencyMs, staged.transitLatencyMs, staged.totalLatencyMs);
+
+    // Repeats of the previous frame carry nothing new
+    if (streamTracker.recordFrame(staged.frameNumber, staged.timestamp) == StreamTracker::Arrival::Duplicate) {
+        return;
+    }
+
+    const auto decodeStart = std::chrono::steady_clock::now();
+    uint64_t frameSkeletonsDecoded = 0;
+    uint64_t frameSkeletonsSkipped = 0;
+    uint64_t frameBonesDecoded = 0;
+    uint64_t frameBonesSkipped = 0;
+
+    // Pick up subscription changes; the recorder needs every skeleton while it records
+    if (decodeFilter.version() != decodeSelectionVersion) {
+        decodeSelectionVersion = decodeFilter.read(decodeSelection);
+    }
+    const bool decodeAll = decodeSelection.wantsAllSkeletons() || (frameTap && frameTap->isEnabled());
+
+    // Decode into a recycled frame; within the described layout this never allocates
+    std::shared_ptr<FrameData> framePtr = framePool.acquire();
+    FrameData& frame = *framePtr;
+    frame.frameNumber = staged.frameNumber;
+    frame.timestamp = staged.timestamp;
+
+    // Lay assets out by slot so each keeps its index across frames, whatever the stream order
+    frame.slotMap = std::atomic_load_explicit(&assetSlots, std::memory_order_acquire);
+    const AssetSlotMap& slotMap = *frame.slotMap;
+    uint64_t frameUndescribed = 0;
+
+    // Parse rigid bodies data
+    const size_t rigidBodySlots = static_cast<size_t>(slotMap.rigidBodyCount());
+    if (frame.rigidBodies.capacity() < rigidBodySlots) {
+        framePool.noteGrowth();
+    }
+    frame.rigidBodies.resize(rigidBodySlots);
+
+    // Described rigid bodies missing from this frame keep their slot untracked
+    for (size_t k = 0; k < rigidBodySlots; k++)
+    {
+        frame.rigidBodies[k].id = slotMap.rigidBodyId(static_cast<int>(k));
+        frame.rigidBodies[k].tracked = false;
+    }
+
+    for (size_t i = 0; i < staged.rigidBodies.size(); i++)
+    {
+        // Extract rigid body data from the staged NatNet data
+        const sRigidBodyData& rb = staged.rigidBodies[i];
+        const int slot = slotMap.rigidBodySlot(rb.ID);
+        if (slot < 0) {
+            frameUndescribed++;
+            continue;
+        }
+
+        // Overwrite rigid body struct in place
+        RigidBodyData& rbData = frame.rigidBodies[static_cast<size_t>(slot)];
+        rbData.parentId = -1;
+        rbData.position = QVector3D(rb.x, rb.y, rb.z);
+        rbData.orientation = QQuaternion(rb.qw, rb.qx, rb.qy, rb.qz);
+        rbData.tracked = true;
+    }
+
+    // Parse skeletons data
+    const size_t skeletonSlots = static_cast<size_t>(slotMap.skeletonCount());
+    if (frame.skeletons.capacity() < skeletonSlots) {
+        framePool.noteGrowth();
+    }
+    frame.skeletons.resize(skeletonSlots);
+
+    // Described skeletons missing from this frame keep their slot and ID but carry no bones
+    for (size_t k = 0; k < skeletonSlots; k++)
+    {
+        frame.skeletons[k].id = slotMap.skeletonId(static_cast<int>(k));
+        frame.skeletons[k].bones.clear();
+    }
+
+    const size_t skeletonCount = staged.skeletons.size();
+    for (size_t i = 0; i < skeletonCount; i++)
+    {
+        // Extract skeleton data from the staged NatNet data
+        const StagedSkeleton& skel = staged.skeletons[i];
+        const int slot = slotMap.skeletonSlot(skel.id);
+        if (slot < 0) {
+            frameUndescribed++;
+            continue;
+        }
+
+        // Unsubscribed skeletons keep their slot and ID but carry no bones
+        if (!decodeAll && !decodeSelection.wantsSkeleton(skel.id)) {
+            frameSkeletonsSkipped++;
+            frameBonesSkipped += static_cast<uint64_t>(skel.boneCount);
+            continue;
+        }
+
+        // Overwrite skeleton struct in place
+        SkeletonData& skelData = frame.skeletons[static_cast<size_t>(slot)];
+
+        const size_t boneCount = static_cast<size_t>(skel.boneCount);
+        frameSkeletonsDecoded++;
+        frameBonesDecoded += boneCount;
+        if (skelData.bones.capacity() < boneCount) {
+            framePool.noteGrowth();
+        }
+        skelData.bones.resize(boneCount);
+
+        // Parse bones (rigid bodies inside skel)
+        for (size_t j = 0; j < boneCount; j++)
+        {
+            // Extract bones data from the staged NatNet data
+            const sRigidBodyData& bone = staged.bones[static_cast<size_t>(skel.firstBone) + j];
+
+            // Overwrite bone rigid body struct in place
+            RigidBodyData& boneData = skelData.bones[j];
+            boneData.id = bone.ID;
+            boneData.parentId = -1;
+            boneData.position = QVector3D(bone.x, bone.y, bone.z);
+            boneData.orientation = QQuaternion(bone.qw, bone.qx, bone.qy, bone.qz);
+            boneData.tracked = true;
+        }
+    }
+
+    // Parse labeled markers into the structure-of-arrays buffer
+    MarkerBuffer& labeled = frame.labeledMarkers;
+    if (labeled.capacity() < staged.labeledMarkers.size()) {
+        framePool.noteGrowth();
+    }
+    labeled.resize(staged.labeledMarkers.size());
+    labeled.setTruncated(static_cast<uint32_t>(staged.labeledMarkerTotal - staged.labeledMarkers.size()));
+
+    for (size_t i = 0; i < staged.labeledMarkers.size(); i++)
+    {
+        const sMarker& marker = staged.labeledMarkers[i];
+        labeled.set(i, marker.ID, marker.x, marker.y, marker.z, marker.size, marker.params);
+    }
+
+    // Parse unlabeled markers; IDs are -1 for servers that only stream their positions
+    MarkerBuffer& unlabeled = frame.unlabeledMarkers;
+    if (unlabeled.capacity() < staged.unlabeledMarkers.size()) {
+        framePool.noteGrowth();
+    }
+    unlabeled.resize(staged.unlabeledMarkers.size());
+    unlabeled.setTruncated(static_cast<uint32_t>(staged.unlabeledMarkerTotal - staged.unlabeledMarkers.size()));
+
+    for (size_t i = 0; i < staged.unlabeledMarkers.size(); i++)
+    {
+        const sMarker& marker = staged.unlabeledMarkers[i];
+        unlabeled.set(i, marker.ID, marker.x, marker.y, marker.z, marker.size, marker.params);
+    }
+
+    const uint64_t decodeNs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - decodeStart).count());
+    decodeTotalNs.fetch_add(decodeNs, std::memory_order_relaxed);
+    decodeLastNs.store(decodeNs, std::memory_order_relaxed);
+    if (decodeNs > decodeMaxNs.load(std::memory_order_relaxed)) {
+        decodeMaxNs.store(decodeNs, std::memory_order_relaxed);
+    }
+    if (frameSkeletonsSkipped > 0) {
+        filteredFrames.fetch_add(1, std::memory_order_relaxed);
+        filteredDecodeTotalNs.fetch_add(decodeNs, std::memory_order_relaxed);
+    }
+    skeletonsDecoded.fetch_add(frameSkeletonsDecoded, std::memory_order_relaxed);
+    skeletonsSkipped.fetch_add(frameSkeletonsSkipped, std::memory_order_relaxed);
+    bonesDecoded.fetch_add(frameBonesDecoded, std::memory_order_relaxed);
+    bonesSkipped.fetch_add(frameBonesSkipped, std::memory_order_relaxed);
+    undescribedAssets.fetch_add(frameUndescribed, std::memory_order_relaxed);
+
+    // Publish frame, evicting the oldest once the history is full. Only complete frames reach
+    // the tap; a filtered one was decoded just before the recorder enabled it and predates the take
+    if (frameTap && frameSkeletonsSkipped == 0) {
+        frameTap->push(framePtr);
+    }
+    frames.push(std::move(framePtr));
+    decodedFrames.fetch_add(1, std::memory_order_relaxed);
+
+    // Invokes callback signal when new frames are available
+    if (frameCallback) {
+        frameCallback(); 
+    }
+}
+
+const FrameRingBuffer<FrameData>& FrameSource::getFrames() const
+{
+    return frames;
+}
+
+FramePoolStats FrameSource::getFramePoolStats() const
+{
+    return framePool.getStats();
+}
+
+void FrameSource::setMarkerCap(size_t cap)
+{
+    staging.setMarkerCap(cap);
+}
+
+IngestStats FrameSource::getIngestStats() const
+{
+    IngestStats stats;
+    stats.dropped = staging.dropped();
+    stats.queueDepth = staging.size();
+    stats.maxQueueDepth = staging.maxSize();
+    stats.decoded = decodedFrames.load(std::memory_order_relaxed);
+
+    const uint64_t count = callbackCount.load(std::memory_order_relaxed);
+    stats.staged = count - stats.dropped;
+    stats.callbackMeanUs = count > 0 ? callbackTotalNs.load(std::memory_order_relaxed) / 1000.0 / count : 0.0;
+    stats.callbackMaxUs = callbackMaxNs.load(std::memory_order_relaxed) / 1000.0;
+    return stats;
+}
+
+StreamStats FrameSource::getStreamStats() const
+{
+    return streamTracker.getStats();
+}
+
+void FrameSource::subscribeDecode(DecodeFilter::Subscriber subscriber, DecodeFilter::Subscription subscription)
+{
+    decodeFilter.subscribe(subscriber, std::move(subscription));
+}
+
+DecodeStats FrameSource::getDecodeStats() const
+{
+    DecodeStats stats;
+    stats.frames = decodedFrames.load(std::memory_order_relaxed);
+    stats.lastDecodeUs = decodeLastNs.load(std::memory_order_relaxed) / 1000.0;
+    stats.meanDecodeUs = stats.frames > 0 ? decodeTotalNs.load(std::memory_order_relaxed) / 1000.0 / stats.frames : 0.0;
+    stats.maxDecodeUs = decodeMaxNs.load(std::memory_order_relaxed) / 1000.0;
+    const uint64_t decodeTotal = decodeTotalNs.load(std::memory_order_relaxed);
+    const uint64_t filteredTotal = filteredDecodeTotalNs.load(std::memory_order_relaxed);
+    stats.filteredFrames = filteredFrames.load(std::memory_order_relaxed);
+    const uint64_t fullFrames = stats.frames > stats.filteredFrames ? stats.frames - stats.filteredFrames : 0;
+    stats.meanFilteredDecodeUs = stats.filteredFrames > 0 ? filteredTotal / 1000.0 / stats.filteredFrames : 0.0;
+    stats.meanFullDecodeUs = fullFrames > 0 && decodeTotal >= filteredTotal
+        ? (decodeTotal - filteredTotal) / 1000.0 / fullFrames : 0.0;
+    stats.skeletonsDecoded = skeletonsDecoded.load(std::memory_order_relaxed);
+    stats.skeletonsSkipped = skeletonsSkipped.load(std::memory_order_relaxed);
+    stats.bonesDecoded = bonesDecoded.load(std::memory_order_relaxed);
+    stats.bonesSkipped = bonesSkipped.load(std::memory_order_relaxed);
+    stats.undescribedAssets = undescribedAssets.load(std::memory_order_relaxed);
+    return stats;
+}
+
+FrameData FrameSource::getLatestFrame() const {
+    const FrameRingBuffer<FrameData>::Pointer latest = frames.latest();
+    return latest ? *latest : FrameData{};
+}
+
+const std::unordered_map<int, std::string>& FrameSource::getRigidBodyIdToName() const
+{
+    return rigidBodyIdToName;
+}
+
+const std::unordered_map<int, std::string>& FrameSource::getSkeletonIdToName() const
+{
+    return skeletonIdToName;
+}
+
+const std::unordered_map<int, std::unordered_map<int, std::string>>& FrameSource::getBoneIdToName() const
+{
+    return boneIdToName;
+}
+
+void FrameSource::setFrameUpdateCallback(std::function<void()> callback) 
+{
+    frameCallback = std::move(callback);
+}
+
+void FrameSource::setFrameTap(std::shared_ptr<FrameTap> tap)
+{
+    frameTap = std::move(tap);
+}
+
+void FrameSource::setAssetUpdateCallback(std::function<void()> callback) 
+{
+    assetCallback = std::move(callback);
+}
+
+void FrameSource::setServerIP(const QString& ip) 
+{
+    m_serverIP = ip;
+}
+
+void FrameSource::setClientIP(const QString& ip) 
+{
+    m_clientIP = ip;
+}
+
+void FrameSource::setConnectionType(QString& type) 
+{
+    m_connectionType = type;
+}
+
+void FrameSource::setNamingConvention(const QString& convention) 
+{
+    m_namingConvention = convention;
+}
+
+bool FrameSource::getConnectionStatus()
+{
+    return connected;
+}
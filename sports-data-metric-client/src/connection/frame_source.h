@@ -0,0 +1,337 @@
+// Base class for the sources of motion capture frames.
+//
+// A source receives raw sFrameOfMocapData frames on its own thread and hands
+// them to stageFrameData(); everything downstream of that call is shared:
+// the staging queue, the ingest worker that decodes into pooled frames, the
+// decode filter, the stream tracker and the asset name maps. Subclasses only
+// implement how frames and data descriptions are obtained (the NatNet SDK, a
+// synthetic generator, ...).
+
+#pragma once
+
+#include "decode_filter.h"
+#include "frame_data.h"
+#include "frame_ring_buffer.h"
+#include "frame_pool.h"
+#include "frame_staging.h"
+#include "frame_tap.h"
+#include "stream_tracker.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include "NatNetTypes.h"
+#include <functional>
+#include <QString>
+
+class FrameSource {
+public:
+    /**
+     * @brief Constructs a source that publishes decoded frames into @p frames.
+     * @param frames History shared by every source; it must outlive the source.
+     */
+    explicit FrameSource(FrameRingBuffer<FrameData>& frames);
+
+    /**
+     * @brief Stops the ingest worker if it is still running.
+     */
+    virtual ~FrameSource();
+
+    FrameSource(const FrameSource&) = delete;
+    FrameSource& operator=(const FrameSource&) = delete;
+
+    /**
+     * @brief Starts receiving frames.
+     * @return True if the source started, false otherwise.
+     */
+    virtual bool connect() = 0;
+
+    /**
+     * @brief Stops receiving frames and cleans up resources.
+     * @return True once the source is stopped.
+     */
+    virtual bool disconnect() = 0;
+
+    /**
+     * @brief Gets the data descriptions of the assets in the scene.
+     * @return The data descriptions object, or nullptr if none are available.
+     */
+    virtual sDataDescriptions* getDataDescriptions() = 0;
+
+    /**
+     * @brief Copies a new motion capture frame into the staging queue and wakes the ingest worker.
+     *
+     * Called on the source's receive thread; does no decoding and takes no lock
+     * unless the worker is asleep.
+     * @param data Pointer to the received frame data.
+     */
+    void stageFrameData(sFrameOfMocapData* data);
+
+    /**
+     * @brief Gets the bounded history of captured motion frames.
+     * @return A constant reference to the frame ring buffer; take a snapshot() to read it.
+     */
+    const FrameRingBuffer<FrameData>& getFrames() const;
+
+    /**
+     * @brief Sets how many labeled and how many unlabeled markers are kept per frame.
+     *
+     * Caps the marker memory of every pooled frame; extra markers are counted
+     * in MarkerBuffer::truncated() and discarded.
+     * @param cap Maximum markers of each kind per frame.
+     */
+    void setMarkerCap(size_t cap);
+
+    /**
+     * @brief Gets the counters of the pooled frames used by the decoder.
+     * @return A copy of the frame pool statistics.
+     */
+    FramePoolStats getFramePoolStats() const;
+
+    /**
+     * @brief Gets the counters of the staging queue and the SDK callback timings.
+     * @return A snapshot of the ingest statistics.
+     */
+    IngestStats getIngestStats() const;
+
+    /**
+     * @brief Gets the frame sequencing counters and latency percentiles of the live stream.
+     * @return A snapshot of the stream statistics.
+     */
+    StreamStats getStreamStats() const;
+
+    /**
+     * @brief Gets the per-frame decode time and the assets decoded and skipped.
+     * @return A snapshot of the decode statistics.
+     */
+    DecodeStats getDecodeStats() const;
+
+    /**
+     * @brief Sets which skeletons @p subscriber needs decoded. Thread safe.
+     *
+     * Skeletons no subscriber wants keep their slot in the published frames but
+     * carry no bones, except while the frame tap is enabled: the recorder needs
+     * complete frames, so every skeleton is decoded then.
+     * @param subscriber The consumer whose subscription is replaced.
+     * @param subscription Skeleton IDs to decode, or all skeletons.
+     */
+    void subscribeDecode(DecodeFilter::Subscriber subscriber, DecodeFilter::Subscription subscription);
+
+    /**
+     * @brief Retrieves a thread-safe copy of the latest frame.
+     * @return A copy of the most recent FrameData.
+     */
+    FrameData getLatestFrame() const;
+
+    /**
+     * @brief Gets the mapping from rigid body IDs to their corresponding names.
+     * @return A constant reference to the rigid body ID-to-name map.
+     */
+    const std::unordered_map<int, std::string>& getRigidBodyIdToName() const;
+
+    /**
+     * @brief Gets the mapping from skeleton IDs to their corresponding names.
+     * @return A constant reference to the skeleton ID-to-name map.
+     */
+    const std::unordered_map<int, std::string>& getSkeletonIdToName() const;
+
+    /**
+     * @brief Gets the mapping from skeleton and bone IDs to their corresponding names.
+     * @return A constant reference to the nested skeleton-to-bone ID-to-name map.
+     */
+    const std::unordered_map<int, std::unordered_map<int, std::string>>& getBoneIdToName() const;
+
+    /**
+     * @brief Sets the callback function to be called when new frame data is received.
+     * @param callback A function with no arguments and no return value to execute when frames update.
+     */
+    void setFrameUpdateCallback(std::function<void()> callback);
+
+    /**
+     * @brief Also hands every frame published to the history to @p tap.
+     *
+     * Must be set before connect(); the pool then keeps enough frames to fill the tap as well.
+     * @param tap Tap shared with its consumer, or nullptr for none.
+     */
+    void setFrameTap(std::shared_ptr<FrameTap> tap);
+
+    /**
+     * @brief Sets the callback function to be called when new asset map is received.
+     * @param callback A function with no arguments and no return value to execute when new assets update.
+     */
+    void setAssetUpdateCallback(std::function<void()> callback);
+
+    /**
+     * @brief Sets the IP address of the streaming server.
+     * 
+     * This IP will be used when establishing the connection.
+     * @param ip The server's IP address as a QString.
+     */
+    void setServerIP(const QString& ip);
+
+    /**
+     * @brief Sets the IP address of the local client.
+     * 
+     * This IP is used for the local network interface to receive data from the server.
+     * @param ip The client's IP address as a QString.
+     */
+    void setClientIP(const QString& ip);
+
+    /**
+     * @brief Sets the connection type (Unicast or Multicast).
+     * 
+     * Determines how the server streams data to this client.
+     * @param type The connection type name as shown in the settings.
+     */
+    void setConnectionType(QString& type);
+
+    /**
+     * @brief Sets the naming convention to use for bones, skeletons, etc.
+     * 
+     * This can be used to support custom naming styles.
+     * @param convention A QString identifier for the naming style.
+     */
+    void setNamingConvention(const QString& convention);
+
+    /**
+     * @brief Checks whether the source is currently started.
+     * @return True if connected, false otherwise.
+     */
+    bool getConnectionStatus();
+
+protected:
+    /**
+     * @brief Seconds elapsed since a host clock timestamp of the source.
+     *
+     * Used by stageFrameData() to measure transit and total latency on arrival.
+     * @param hostTimestamp Timestamp in host clock ticks.
+     * @return Elapsed seconds, or a negative value if the source cannot tell.
+     */
+    virtual double secondsSinceHostTimestamp(uint64_t hostTimestamp) const;
+
+    /**
+     * @brief Sets the host clock rate the frame timestamps are expressed in.
+     * @param ticksPerSecond Host clock ticks per second.
+     */
+    void setHostClockFrequency(uint64_t ticksPerSecond);
+
+    /**
+     * @brief Logs the frame pool, ingest and decode counters of the session.
+     */
+    void logStats() const;
+
+    /**
+     * @brief Claims the next staging slot, for sources that parse frames straight into it.
+     *
+     * Receive thread only. Fill every field of the slot, then call commitStagedFrame();
+     * a slot that is not committed is reused by the next claim.
+     * @return The slot to fill, or nullptr if the queue is full and the frame is dropped.
+     */
+    StagedFrame* claimStagedFrame();
+
+    /**
+     * @brief Publishes the slot filled after claimStagedFrame() and wakes the ingest worker.
+     */
+    void commitStagedFrame();
+
+    /**
+     * @brief Number of labeled and of unlabeled markers a staged frame may hold.
+     */
+    size_t stagingMarkerCap() const;
+
+    /**
+     * @brief Adds the time the receive thread spent staging one frame to the ingest statistics.
+     * @param elapsedNs Staging time in nanoseconds.
+     */
+    void recordStagingTime(uint64_t elapsedNs);
+
+    /**
+     * @brief Starts the ingest worker thread; call before the first stageFrameData().
+     *
+     * Call after processDataDescriptions(): the staging slots are reserved for
+     * the described scene and the marker cap.
+     */
+    void startIngest();
+
+    /**
+     * @brief Stops the ingest worker thread and waits for it to finish.
+     */
+    void stopIngest();
+
+    /**
+     * @brief Populates ID-to-name maps from the data descriptions and notifies the asset callback.
+     * @param pDataDefs Pointer to the NatNet sDataDescriptions structure.
+     */
+    void processDataDescriptions(sDataDescriptions* pDataDefs);
+
+    bool connected = false;                      // Indicates whether the connection is currently active
+
+    QString m_serverIP = "127.0.0.1";                               // IP address of the NatNet server
+    QString m_clientIP = "127.0.0.1";                               // IP address of the client (local machine)
+    QString m_connectionType = "Multicast";                         // Network mode for receiving data
+    QString m_namingConvention = "default";                         // Naming convention for asset names
+
+private:
+    /**
+     * @brief Ingest worker loop: decodes staged frames and publishes them until stopped.
+     */
+    void ingestLoop();
+
+    /**
+     * @brief Wakes the ingest worker if it is asleep; called after a frame was staged.
+     */
+    void wakeIngest();
+
+    /**
+     * @brief Decodes a staged frame into a pooled FrameData and publishes it.
+     * @param staged Raw frame fields copied by the source's receive thread.
+     */
+    void processFrameData(const StagedFrame& staged);
+
+    FrameRingBuffer<FrameData>& frames; // Bounded history of motion capture frames, owned by the controller
+    FramePool framePool;                // Preallocated frames recycled by processFrameData
+    std::shared_ptr<FrameTap> frameTap; // Consumer that sees every published frame, if any
+    DecodeFilter decodeFilter;          // Skeletons the consumers subscribed to
+    DecodeFilter::Selection decodeSelection;    // Ingest worker's copy of the filter's selection
+    uint64_t decodeSelectionVersion = 0;        // Filter version decodeSelection was read at
+    std::shared_ptr<const AssetSlotMap> assetSlots = std::make_shared<const AssetSlotMap>(); // Slot of each described asset; swapped atomically, shared by the frames decoded with it
+
+    static constexpr size_t kInFlightFrames = 64;   // Pooled frames beyond the history depth, for consumers still holding frames
+    static constexpr size_t kStagingDepth = 64;     // Raw frames the callback can get ahead of the ingest worker
+
+    FrameStagingQueue staging{kStagingDepth};   // Raw frames handed from the SDK callback to the ingest worker
+    std::thread ingestThread;                   // Decodes staged frames and publishes them
+    std::atomic<bool> ingestRunning{false};     // Cleared to ask the ingest worker to exit
+    std::atomic<bool> ingestWaiting{false};     // Set while the ingest worker is (about to be) asleep
+    std::mutex ingestMutex;                     // Pairs with ingestWake; only taken around sleeping
+    std::condition_variable ingestWake;         // Signalled by the callback when the worker is asleep
+
+    std::atomic<uint64_t> callbackCount{0};     // SDK callbacks timed
+    std::atomic<uint64_t> callbackTotalNs{0};   // Total time spent in SDK callbacks
+    std::atomic<uint64_t> callbackMaxNs{0};     // Longest SDK callback
+    std::atomic<uint64_t> decodedFrames{0};     // Frames published by the ingest worker
+
+    StreamTracker streamTracker;                // Gaps, duplicates, reordering and latency of staged frames
+
+    std::atomic<uint64_t> decodeTotalNs{0};     // Total time spent decoding frames
+    std::atomic<uint64_t> decodeLastNs{0};      // Decode time of the most recent frame
+    std::atomic<uint64_t> decodeMaxNs{0};       // Longest frame decode
+    std::atomic<uint64_t> filteredFrames{0};    // Frames where the filter skipped a skeleton
+    std::atomic<uint64_t> filteredDecodeTotalNs{0}; // Total time spent decoding those frames
+    std::atomic<uint64_t> skeletonsDecoded{0};  // Skeletons whose bones were decoded
+    std::atomic<uint64_t> skeletonsSkipped{0};  // Skeletons left undecoded by the filter
+    std::atomic<uint64_t> bonesDecoded{0};      // Bones decoded
+    std::atomic<uint64_t> bonesSkipped{0};      // Bones left undecoded by the filter
+    std::atomic<uint64_t> undescribedAssets{0}; // Streamed assets with no slot, dropped
+    std::atomic<double> hostTicksPerMs{0.0};    // Server high resolution clock rate, for server-side latency
+
+    std::unordered_map<int, std::string> rigidBodyIdToName;                     // Map rigid body ID -> name
+    std::unordered_map<int, std::string> skeletonIdToName;                      // Map skeleton ID -> skeleton name
+    std::unordered_map<int, std::unordered_map<int, std::string>> boneIdToName;  // Map bone ID -> name within each skeleton
+
+    std::function<void()> frameCallback;  // store the callback function for frames signal
+    std::function<void()> assetCallback;  // store the callback function for assets signal
+};
@@ -0,0 +1,185 @@
+#include "frame_staging.h"
+
+#include <algorithm>
+
+FrameStagingQueue::FrameStagingQueue(size_t capacity)
+    : m_slots(std::max<size_t>(capacity, 1))
+{
+    for (StagedFrame& slot : m_slots) {
+        slot.skeletons.reserve(MAX_SKELETONS);
+    }
+}
+
+bool FrameStagingQueue::stage(const sFrameOfMocapData& data, double transitLatencyMs, double totalLatencyMs)
+{
+    StagedFrame* slot = claim();
+    if (!slot) {
+        return false;
+    }
+
+    copyFrame(data, *slot, markerCap());
+    slot->transitLatencyMs = transitLatencyMs;
+    slot->totalLatencyMs = totalLatencyMs;
+    commit();
+    return true;
+}
+
+StagedFrame* FrameStagingQueue::claim()
+{
+    const uint64_t head = m_head.load(std::memory_order_relaxed);
+    const uint64_t tail = m_tail.load(std::memory_order_acquire);
+
+    if (head - tail >= m_slots.size()) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    return &m_slots[head % m_slots.size()];
+}
+
+void FrameStagingQueue::commit()
+{
+    const uint64_t head = m_head.load(std::memory_order_relaxed);
+    const uint64_t tail = m_tail.load(std::memory_order_acquire);
+    m_head.store(head + 1, std::memory_order_release);
+
+    const size_t depth = static_cast<size_t>(head + 1 - tail);
+    if (depth > m_maxSize.load(std::memory_order_relaxed)) {
+        m_maxSize.store(depth, std::memory_order_relaxed);
+    }
+}
+
+size_t FrameStagingQueue::markerCap() const
+{
+    return std::min<size_t>(m_markerCap.load(std::memory_order_relaxed), MAX_LABELED_MARKERS);
+}
+
+const StagedFrame* FrameStagingQueue::front() const
+{
+    const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail == m_head.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    return &m_slots[tail % m_slots.size()];
+}
+
+void FrameStagingQueue::pop()
+{
+    m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+size_t FrameStagingQueue::size() const
+{
+    const uint64_t tail = m_tail.load(std::memory_order_acquire);
+    const uint64_t head = m_head.load(std::memory_order_acquire);
+    return head > tail ? static_cast<size_t>(head - tail) : 0;
+}
+
+size_t FrameStagingQueue::maxSize() const
+{
+    return m_maxSize.load(std::memory_order_relaxed);
+}
+
+uint64_t FrameStagingQueue::dropped() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+void FrameStagingQueue::setMarkerCap(size_t cap)
+{
+    m_markerCap.store(cap, std::memory_order_relaxed);
+}
+
+void FrameStagingQueue::clearMarkers(StagedFrame& frame)
+{
+    frame.labeledMarkers.clear();
+    frame.unlabeledMarkers.clear();
+    frame.labeledMarkerTotal = 0;
+    frame.unlabeledMarkerTotal = 0;
+}
+
+void FrameStagingQueue::addMarker(StagedFrame& frame, const sMarker& marker, size_t markerCap)
+{
+    const bool unlabeled = (marker.params & kMarkerParamUnlabeled) != 0;
+    std::vector<sMarker>& markers = unlabeled ? frame.unlabeledMarkers : frame.labeledMarkers;
+    int32_t& total = unlabeled ? frame.unlabeledMarkerTotal : frame.labeledMarkerTotal;
+
+    ++total;
+    if (markers.size() < markerCap) {
+        markers.push_back(marker);
+    }
+}
+
+void FrameStagingQueue::reserve(size_t rigidBodies, size_t bones, size_t markers)
+{
+    for (StagedFrame& slot : m_slots) {
+        slot.rigidBodies.reserve(rigidBodies);
+        slot.bones.reserve(bones);
+        slot.labeledMarkers.reserve(markers);
+        slot.unlabeledMarkers.reserve(markers);
+    }
+}
+
+void FrameStagingQueue::reset()
+{
+    m_head.store(0, std::memory_order_relaxed);
+    m_tail.store(0, std::memory_order_relaxed);
+    m_maxSize.store(0, std::memory_order_relaxed);
+    m_dropped.store(0, std::memory_order_relaxed);
+}
+
+void FrameStagingQueue::copyFrame(const sFrameOfMocapData& data, StagedFrame& frame, size_t markerCap)
+{
+    frame.frameNumber = data.iFrame;
+    frame.timestamp = data.fTimestamp;
+    frame.cameraMidExposureTimestamp = data.CameraMidExposureTimestamp;
+    frame.cameraDataReceivedTimestamp = data.CameraDataReceivedTimestamp;
+    frame.transmitTimestamp = data.TransmitTimestamp;
+    frame.params = data.params;
+
+    // Plain element copies; assign() only allocates while the slot is still growing
+    const int32_t rigidBodyCount = std::clamp<int32_t>(data.nRigidBodies, 0, MAX_RIGIDBODIES);
+    frame.rigidBodies.assign(data.RigidBodies, data.RigidBodies + rigidBodyCount);
+
+    const int32_t skeletonCount = std::clamp<int32_t>(data.nSkeletons, 0, MAX_SKELETONS);
+    frame.skeletons.resize(static_cast<size_t>(skeletonCount));
+    frame.bones.clear();
+
+    for (int32_t i = 0; i < skeletonCount; ++i) {
+        const sSkeletonData& skel = data.Skeletons[i];
+        const int32_t boneCount = skel.RigidBodyData ? std::clamp<int32_t>(skel.nRigidBodies, 0, MAX_SKELRIGIDBODIES) : 0;
+
+        StagedSkeleton& staged = frame.skeletons[i];
+        staged.id = skel.skeletonID;
+        staged.firstBone = static_cast<int32_t>(frame.bones.size());
+        staged.boneCount = boneCount;
+
+        frame.bones.insert(frame.bones.end(), skel.RigidBodyData, skel.RigidBodyData + boneCount);
+    }
+
+    // The marker list holds labeled and unlabeled markers; those beyond the cap are counted but not copied
+    clearMarkers(frame);
+    const int32_t markerCount = std::clamp<int32_t>(data.nLabeledMarkers, 0, MAX_LABELED_MARKERS);
+    for (int32_t i = 0; i < markerCount; ++i) {
+        addMarker(frame, data.LabeledMarkers[i], markerCap);
+    }
+
+    // Servers older than NatNet 3 only list unlabeled markers in OtherMarkers
+    if (frame.unlabeledMarkerTotal == 0 && data.OtherMarkers) {
+        const int32_t otherCount = std::clamp<int32_t>(data.nOtherMarkers, 0, MAX_UNLABELED_MARKERS);
+        for (int32_t i = 0; i < otherCount; ++i) {
+            addMarker(frame, legacyMarker(data.OtherMarkers[i]), markerCap);
+        }
+    }
+}
+
+sMarker FrameStagingQueue::legacyMarker(const float* position)
+{
+    sMarker marker{};
+    marker.ID = -1;
+    marker.x = position[0];
+    marker.y = position[1];
+    marker.z = position[2];
+    marker.params = kMarkerParamUnlabeled;
+    return marker;
+}
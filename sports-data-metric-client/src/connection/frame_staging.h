@@ -0,0 +1,222 @@
+// Staging queue between the NatNet SDK callback and the ingest worker.
+//
+// The SDK calls back on its network thread, where any delay risks dropping
+// packets. The callback therefore only copies the raw sFrameOfMocapData fields
+// the client uses into a preallocated slot of a single-producer/single-consumer
+// queue; decoding into FrameData and publishing happen on the ingest worker.
+// Sources that parse the wire format themselves write straight into a claimed
+// slot instead, skipping the sFrameOfMocapData copy.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "NatNetTypes.h"
+
+/**
+ * @brief Bit of sMarker::params flagging an unlabeled marker.
+ *
+ * NatNet 3 and later stream unlabeled markers in the labeled marker list with
+ * this bit set; the separate OtherMarkers list is deprecated.
+ */
+constexpr int16_t kMarkerParamUnlabeled = 0x10;
+
+/**
+ * @brief Skeleton header of a staged frame; its bones live in StagedFrame::bones.
+ */
+struct StagedSkeleton {
+    int32_t id = 0;             // Skeleton ID
+    int32_t firstBone = 0;      // Index of the skeleton's first bone in StagedFrame::bones
+    int32_t boneCount = 0;      // Number of bones of the skeleton
+};
+
+/**
+ * @brief Raw copy of the parts of one sFrameOfMocapData the client decodes.
+ *
+ * Slots are reused; the vectors keep their capacity, so once they have grown to
+ * the size of the streamed scene staging a frame performs no heap allocation.
+ */
+struct StagedFrame {
+    int32_t frameNumber = 0;                    // Host defined frame number
+    double timestamp = 0.0;                     // Software timestamp since Motive start
+    uint64_t cameraMidExposureTimestamp = 0;    // Host ticks at mid camera exposure
+    uint64_t cameraDataReceivedTimestamp = 0;   // Host ticks when camera data was received
+    uint64_t transmitTimestamp = 0;             // Host ticks when the frame was sent
+    int16_t params = 0;                         // Frame flags (recording, model list changed, ...)
+    double transitLatencyMs = -1.0;             // Transmit to arrival, measured in the callback; < 0 if unknown
+    double totalLatencyMs = -1.0;               // Mid exposure to arrival, measured in the callback; < 0 if unknown
+
+    std::vector<sRigidBodyData> rigidBodies;    // Rigid bodies, in stream order
+    std::vector<StagedSkeleton> skeletons;      // Skeletons, in stream order
+    std::vector<sRigidBodyData> bones;          // Bones of all skeletons, back to back
+
+    std::vector<sMarker> labeledMarkers;                    // Labeled markers, up to the marker cap
+    std::vector<sMarker> unlabeledMarkers;                  // Unlabeled markers, up to the marker cap
+    int32_t labeledMarkerTotal = 0;                         // Labeled markers streamed, before the cap
+    int32_t unlabeledMarkerTotal = 0;                       // Unlabeled markers streamed, before the cap
+};
+
+/**
+ * @brief Counters describing the two-stage ingest path.
+ */
+struct IngestStats {
+    uint64_t staged = 0;            // Frames copied into the staging queue by the callback
+    uint64_t dropped = 0;           // Frames discarded because the staging queue was full
+    uint64_t decoded = 0;           // Frames decoded and published by the ingest worker
+    size_t queueDepth = 0;          // Frames currently waiting for the worker
+    size_t maxQueueDepth = 0;       // Highest queue depth observed since the last reset
+    double callbackMeanUs = 0.0;    // Mean time spent inside the SDK callback, in microseconds
+    double callbackMaxUs = 0.0;     // Longest time spent inside the SDK callback, in microseconds
+};
+
+/**
+ * @brief Per-frame cost of decoding staged frames into FrameData, and how much the decode filter saved.
+ *
+ * Frames where the filter skipped at least one skeleton are timed apart from
+ * the frames decoded in full, so the two means compare the filtered and the
+ * unfiltered cost of the same stream.
+ */
+struct DecodeStats {
+    uint64_t frames = 0;                // Frames decoded
+    double lastDecodeUs = 0.0;          // Decode time of the most recent frame, in microseconds
+    double meanDecodeUs = 0.0;          // Mean decode time per frame, in microseconds
+    double maxDecodeUs = 0.0;           // Longest decode time of a frame, in microseconds
+    uint64_t filteredFrames = 0;        // Frames where the filter skipped at least one skeleton
+    double meanFilteredDecodeUs = 0.0;  // Mean decode time of the filtered frames, in microseconds
+    double meanFullDecodeUs = 0.0;      // Mean decode time of the frames decoded in full, in microseconds
+    uint64_t skeletonsDecoded = 0;      // Skeletons whose bones were decoded
+    uint64_t skeletonsSkipped = 0;      // Skeletons left undecoded by the filter
+    uint64_t bonesDecoded = 0;          // Bones decoded
+    uint64_t bonesSkipped = 0;          // Bones left undecoded by the filter
+    uint64_t undescribedAssets = 0;     // Streamed rigid bodies and skeletons missing from the descriptions, dropped
+};
+
+class FrameStagingQueue {
+public:
+    /**
+     * @brief Constructs a queue holding at most @p capacity staged frames.
+     */
+    explicit FrameStagingQueue(size_t capacity);
+
+    FrameStagingQueue(const FrameStagingQueue&) = delete;
+    FrameStagingQueue& operator=(const FrameStagingQueue&) = delete;
+
+    /**
+     * @brief Copies the fields used by the decoder out of @p data into the next free slot.
+     *
+     * Producer only. The latencies are measured by the caller at arrival time,
+     * since they depend on when the frame reached the client.
+     * @return False if the queue is full and the frame was dropped.
+     */
+    bool stage(const sFrameOfMocapData& data, double transitLatencyMs, double totalLatencyMs);
+
+    /**
+     * @brief Returns the next free slot for the producer to fill in place.
+     *
+     * Producer only. The slot is published by commit(); claiming again without
+     * committing returns the same slot, so a frame that fails to parse is simply
+     * abandoned.
+     * @return The slot to fill, or nullptr if the queue is full and the frame was dropped.
+     */
+    StagedFrame* claim();
+
+    /**
+     * @brief Publishes the slot returned by the last claim() to the consumer.
+     *
+     * Producer only.
+     */
+    void commit();
+
+    /**
+     * @brief Number of labeled and of unlabeled markers kept per frame.
+     */
+    size_t markerCap() const;
+
+    /**
+     * @brief Returns the oldest staged frame, or nullptr if the queue is empty.
+     *
+     * Consumer only; the frame stays valid until pop().
+     */
+    const StagedFrame* front() const;
+
+    /**
+     * @brief Releases the slot returned by front() back to the producer.
+     *
+     * Consumer only.
+     */
+    void pop();
+
+    /**
+     * @brief Number of frames waiting to be consumed.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Highest number of frames that were waiting at once.
+     */
+    size_t maxSize() const;
+
+    /**
+     * @brief Number of frames dropped because the queue was full.
+     */
+    uint64_t dropped() const;
+
+    /**
+     * @brief Limits how many labeled and unlabeled markers are copied per frame.
+     *
+     * May be called while frames are being staged; applies from the next frame.
+     */
+    void setMarkerCap(size_t cap);
+
+    /**
+     * @brief Empties the marker lists of @p frame, before its markers are added with addMarker().
+     */
+    static void clearMarkers(StagedFrame& frame);
+
+    /**
+     * @brief Adds a marker of the streamed marker list to the labeled or unlabeled markers of @p frame.
+     *
+     * The list is split by kMarkerParamUnlabeled; markers beyond @p markerCap of
+     * their kind are counted in the totals but not kept.
+     */
+    static void addMarker(StagedFrame& frame, const sMarker& marker, size_t markerCap);
+
+    /**
+     * @brief An unlabeled marker from the legacy OtherMarkers list, which only carries positions.
+     * @param position The marker's x, y and z.
+     */
+    static sMarker legacyMarker(const float* position);
+
+    /**
+     * @brief Reserves every slot for a scene of the given size, so staging its frames never allocates.
+     *
+     * Must not race with stage() or claim(); frames larger than reserved still
+     * fit, growing the slot once.
+     * @param rigidBodies Rigid bodies per frame.
+     * @param bones Bones of all skeletons per frame.
+     * @param markers Labeled and unlabeled markers per frame, each.
+     */
+    void reserve(size_t rigidBodies, size_t bones, size_t markers);
+
+    /**
+     * @brief Drops pending frames and clears the counters.
+     *
+     * Must not race with stage() or front()/pop().
+     */
+    void reset();
+
+private:
+    static void copyFrame(const sFrameOfMocapData& data, StagedFrame& frame, size_t markerCap);
+
+    std::vector<StagedFrame> m_slots;                   // Preallocated frame slots
+
+    alignas(64) std::atomic<uint64_t> m_head{0};        // Next slot to write (producer)
+    alignas(64) std::atomic<uint64_t> m_tail{0};        // Next slot to read (consumer)
+
+    alignas(64) std::atomic<size_t> m_maxSize{0};
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<size_t> m_markerCap{MAX_LABELED_MARKERS};   // Markers of each kind copied per frame
+};
@@ -0,0 +1,59 @@
+#include "frame_tap.h"
+
+#include <algorithm>
+
+FrameTap::FrameTap(size_t capacity)
+    : m_slots(std::max<size_t>(capacity, 1))
+{
+}
+
+void FrameTap::setEnabled(bool enabled)
+{
+    m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool FrameTap::isEnabled() const
+{
+    return m_enabled.load(std::memory_order_relaxed);
+}
+
+bool FrameTap::push(const FramePtr& frame)
+{
+    if (!isEnabled()) {
+        return false;
+    }
+
+    const uint64_t head = m_head.load(std::memory_order_relaxed);
+    const uint64_t tail = m_tail.load(std::memory_order_acquire);
+    if (head - tail >= m_slots.size()) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    m_slots[head % m_slots.size()] = frame;
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+size_t FrameTap::drain(std::vector<FramePtr>& out)
+{
+    const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    const uint64_t head = m_head.load(std::memory_order_acquire);
+
+    // Moving out clears the slot, so the producer never holds on to a drained frame
+    for (uint64_t i = tail; i < head; ++i) {
+        out.push_back(std::move(m_slots[i % m_slots.size()]));
+    }
+    m_tail.store(head, std::memory_order_release);
+    return static_cast<size_t>(head - tail);
+}
+
+size_t FrameTap::capacity() const
+{
+    return m_slots.size();
+}
+
+uint64_t FrameTap::dropped() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,75 @@
+// Tap on the ingest stream for consumers that must see every decoded frame.
+//
+// The frame history keeps only the most recent frames and is read with
+// snapshots, so a consumer that falls behind, or reads across a history reset,
+// silently misses frames. The tap instead hands each frame the ingest worker
+// publishes to one consumer through a bounded single-producer/single-consumer
+// queue of frame pointers; while it is disabled the worker skips it, and when
+// the consumer falls behind the frames that do not fit are counted as dropped.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "frame_data.h"
+
+class FrameTap {
+public:
+    /**
+     * @brief Constructs a disabled tap holding at most @p capacity frames.
+     */
+    explicit FrameTap(size_t capacity);
+
+    FrameTap(const FrameTap&) = delete;
+    FrameTap& operator=(const FrameTap&) = delete;
+
+    /**
+     * @brief Starts or stops handing frames to the consumer.
+     *
+     * Any thread. Frames already queued stay there until drained.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * @brief Whether frames are being handed to the consumer.
+     */
+    bool isEnabled() const;
+
+    /**
+     * @brief Queues @p frame for the consumer, if the tap is enabled.
+     *
+     * Producer only. Takes a reference; the frame returns to its pool once drained.
+     * @return False if the tap is disabled, or full and the frame was dropped.
+     */
+    bool push(const FramePtr& frame);
+
+    /**
+     * @brief Moves every queued frame, oldest first, to the end of @p out.
+     *
+     * Consumer only.
+     * @return Number of frames moved.
+     */
+    size_t drain(std::vector<FramePtr>& out);
+
+    /**
+     * @brief Maximum number of frames queued at once.
+     */
+    size_t capacity() const;
+
+    /**
+     * @brief Number of frames dropped because the tap was full, since construction.
+     */
+    uint64_t dropped() const;
+
+private:
+    std::vector<FramePtr> m_slots;                      // Queued frames; a slot is owned by whichever side the indices give it to
+
+    alignas(64) std::atomic<uint64_t> m_head{0};        // Next slot to write (producer)
+    alignas(64) std::atomic<uint64_t> m_tail{0};        // Next slot to read (consumer)
+
+    alignas(64) std::atomic<bool> m_enabled{false};
+    std::atomic<uint64_t> m_dropped{0};
+};
@@ -0,0 +1,505 @@
+#include "natnet_depacketizer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief Bounds checked cursor over a message payload.
+ *
+ * A read past the end marks the reader as failed and returns zeros, so a parser
+ * can read a whole section and check ok() once.
+ */
+class PacketReader {
+public:
+    PacketReader(const char* data, size_t size)
+        : m_pos(data), m_end(data + size)
+    {
+    }
+
+    template <typename T>
+    T read()
+    {
+        T value{};
+        if (!require(sizeof(T))) {
+            return value;
+        }
+        std::memcpy(&value, m_pos, sizeof(T));
+        m_pos += sizeof(T);
+        return value;
+    }
+
+    /**
+     * @brief Reads a count prefix and checks it against @p limit.
+     */
+    int32_t readCount(int32_t limit)
+    {
+        const int32_t count = read<int32_t>();
+        if (count < 0 || count > limit) {
+            fail();
+            return 0;
+        }
+        return count;
+    }
+
+    void skip(int64_t bytes)
+    {
+        if (bytes < 0 || !require(static_cast<size_t>(bytes))) {
+            return;
+        }
+        m_pos += bytes;
+    }
+
+    /**
+     * @brief Reads a null-terminated string, truncated to fit @p out of @p outSize bytes.
+     */
+    void readString(char* out, size_t outSize)
+    {
+        const char* terminator = m_ok ? static_cast<const char*>(std::memchr(m_pos, '\0', m_end - m_pos)) : nullptr;
+        if (!terminator) {
+            m_ok = false;
+            if (outSize > 0) {
+                out[0] = '\0';
+            }
+            return;
+        }
+
+        const size_t length = std::min<size_t>(terminator - m_pos, outSize - 1);
+        std::memcpy(out, m_pos, length);
+        out[length] = '\0';
+        m_pos = terminator + 1;
+    }
+
+    void skipString()
+    {
+        const char* terminator = m_ok ? static_cast<const char*>(std::memchr(m_pos, '\0', m_end - m_pos)) : nullptr;
+        if (!terminator) {
+            m_ok = false;
+            return;
+        }
+        m_pos = terminator + 1;
+    }
+
+    const char* position() const { return m_pos; }
+    size_t remaining() const { return m_ok ? static_cast<size_t>(m_end - m_pos) : 0; }
+
+    /**
+     * @brief Moves to @p position, which must lie within the payload.
+     */
+    void seek(const char* position)
+    {
+        if (position > m_end) {
+            m_ok = false;
+            return;
+        }
+        m_pos = position;
+    }
+
+    /**
+     * @brief Marks the payload as malformed.
+     */
+    void fail() { m_ok = false; }
+
+    bool ok() const { return m_ok; }
+
+private:
+    bool require(size_t bytes)
+    {
+        if (!m_ok || static_cast<size_t>(m_end - m_pos) < bytes) {
+            m_ok = false;
+        }
+        return m_ok;
+    }
+
+    const char* m_pos;
+    const char* m_end;
+    bool m_ok = true;
+};
+
+constexpr int64_t kMarkerPositionBytes = 3 * sizeof(float);                             // Legacy marker: x y z
+
+void readRigidBody(PacketReader& in, sRigidBodyData& body)
+{
+    body.ID = in.read<int32_t>();
+    body.x = in.read<float>();
+    body.y = in.read<float>();
+    body.z = in.read<float>();
+    body.qx = in.read<float>();
+    body.qy = in.read<float>();
+    body.qz = in.read<float>();
+    body.qw = in.read<float>();
+    body.MeanError = in.read<float>();
+    body.params = in.read<int16_t>();
+}
+
+/**
+ * @brief Skips a force plate or device section of a bitstream without section sizes.
+ */
+void skipAnalogDevices(PacketReader& in, int32_t count)
+{
+    for (int32_t i = 0; i < count && in.ok(); i++)
+    {
+        in.read<int32_t>();     // ID
+        const int32_t channels = in.readCount(MAX_ANALOG_CHANNELS);
+        for (int32_t c = 0; c < channels && in.ok(); c++)
+        {
+            const int32_t subframes = in.read<int32_t>();
+            in.skip(static_cast<int64_t>(subframes) * sizeof(float));
+        }
+    }
+}
+
+void readRigidBodyDescription(PacketReader& in, sRigidBodyDescription& body, NatNetModelDefinitions& definitions,
+                              bool markerNames)
+{
+    in.readString(body.szName, MAX_NAMELENGTH);
+    body.ID = in.read<int32_t>();
+    body.parentID = in.read<int32_t>();
+    body.offsetx = in.read<float>();
+    body.offsety = in.read<float>();
+    body.offsetz = in.read<float>();
+    body.offsetqw = 1.0f;
+
+    // Each marker takes at least a position and a required label
+    const int32_t markerCount = in.read<int32_t>();
+    if (markerCount < 0 || static_cast<size_t>(markerCount) > in.remaining() / 16) {
+        in.fail();
+        return;
+    }
+
+    body.nMarkers = markerCount;
+    body.MarkerPositions = markerCount > 0 ? definitions.addMarkerPositions(static_cast<size_t>(markerCount)) : nullptr;
+    for (int32_t m = 0; m < markerCount; m++)
+    {
+        body.MarkerPositions[m][0] = in.read<float>();
+        body.MarkerPositions[m][1] = in.read<float>();
+        body.MarkerPositions[m][2] = in.read<float>();
+    }
+
+    // Required active labels and (4.0+) marker names are not used by the client
+    in.skip(static_cast<int64_t>(markerCount) * sizeof(int32_t));
+    if (markerNames) {
+        for (int32_t m = 0; m < markerCount && in.ok(); m++) {
+            in.skipString();
+        }
+    }
+}
+
+} // namespace
+
+NatNetModelDefinitions::NatNetModelDefinitions()
+    : m_descriptions(std::make_unique<sDataDescriptions>())
+{
+    std::memset(m_descriptions.get(), 0, sizeof(sDataDescriptions));
+}
+
+sRigidBodyDescription* NatNetModelDefinitions::addRigidBody()
+{
+    if (m_descriptions->nDataDescriptions >= MAX_MODELS) {
+        return nullptr;
+    }
+
+    sRigidBodyDescription& body = m_rigidBodies.emplace_back();
+    std::memset(&body, 0, sizeof(body));
+
+    sDataDescription& description = m_descriptions->arrDataDescriptions[m_descriptions->nDataDescriptions++];
+    description.type = Descriptor_RigidBody;
+    description.Data.RigidBodyDescription = &body;
+    return &body;
+}
+
+sSkeletonDescription* NatNetModelDefinitions::addSkeleton()
+{
+    if (m_descriptions->nDataDescriptions >= MAX_MODELS) {
+        return nullptr;
+    }
+
+    sSkeletonDescription& skeleton = m_skeletons.emplace_back();
+    std::memset(&skeleton, 0, sizeof(skeleton));
+
+    sDataDescription& description = m_descriptions->arrDataDescriptions[m_descriptions->nDataDescriptions++];
+    description.type = Descriptor_Skeleton;
+    description.Data.SkeletonDescription = &skeleton;
+    return &skeleton;
+}
+
+MarkerData* NatNetModelDefinitions::addMarkerPositions(size_t count)
+{
+    std::vector<float>& positions = m_markerPositions.emplace_back(count * 3, 0.0f);
+    return reinterpret_cast<MarkerData*>(positions.data());
+}
+
+bool NatNetDepacketizer::setVersion(int major, int minor)
+{
+    if (major < 3) {
+        return false;
+    }
+
+    m_major = major;
+    m_minor = minor;
+    return true;
+}
+
+bool NatNetDepacketizer::readHeader(const char* data, size_t size, uint16_t& messageId,
+                                    const char*& payload, size_t& payloadSize)
+{
+    if (size < kHeaderSize) {
+        return false;
+    }
+
+    uint16_t payloadBytes = 0;
+    std::memcpy(&messageId, data, sizeof(uint16_t));
+    std::memcpy(&payloadBytes, data + sizeof(uint16_t), sizeof(uint16_t));
+
+    // A message always fits in one datagram; anything after the payload is padding
+    if (payloadBytes > size - kHeaderSize) {
+        return false;
+    }
+    payload = data + kHeaderSize;
+    payloadSize = payloadBytes;
+    return true;
+}
+
+size_t NatNetDepacketizer::writeRequest(uint16_t messageId, const void* payload, size_t payloadSize,
+                                        char* out, size_t outSize)
+{
+    if (payloadSize > MAX_PACKETSIZE || outSize < kHeaderSize + payloadSize) {
+        return 0;
+    }
+
+    const uint16_t payloadBytes = static_cast<uint16_t>(payloadSize);
+    std::memcpy(out, &messageId, sizeof(uint16_t));
+    std::memcpy(out + sizeof(uint16_t), &payloadBytes, sizeof(uint16_t));
+    if (payloadSize > 0) {
+        std::memcpy(out + kHeaderSize, payload, payloadSize);
+    }
+    return kHeaderSize + payloadSize;
+}
+
+size_t NatNetDepacketizer::writeConnectRequest(char* out, size_t outSize)
+{
+    // Sender description followed by the connection options; a zero bitstream
+    // version asks the server to keep its configured version.
+    char payload[sizeof(sSender) + sizeof(sConnectionOptions)] = {};
+    std::strncpy(payload, "Ping", MAX_NAMELENGTH - 1);
+
+    const sConnectionOptions options;
+    std::memcpy(payload + sizeof(sSender), &options, sizeof(options));
+
+    return writeRequest(NAT_CONNECT, payload, sizeof(payload), out, outSize);
+}
+
+bool NatNetDepacketizer::parseServerInfo(const char* payload, size_t size, NatNetServerInfo& info)
+{
+    if (size < sizeof(sSender)) {
+        return false;
+    }
+
+    // Older servers send only the common sender part
+    sSender_Server server;
+    std::memset(&server, 0, sizeof(server));
+    std::memcpy(&server, payload, std::min(size, sizeof(server)));
+
+    server.Common.szName[MAX_NAMELENGTH - 1] = '\0';
+    info.hostApp = server.Common.szName;
+    std::memcpy(info.hostVersion, server.Common.Version, sizeof(info.hostVersion));
+    std::memcpy(info.natNetVersion, server.Common.NatNetVersion, sizeof(info.natNetVersion));
+
+    if (size >= sizeof(sSender_Server)) {
+        info.highResClockFrequency = server.HighResClockFrequency;
+        info.dataPort = server.DataPort;
+        info.multicast = server.IsMulticast;
+        std::memcpy(info.multicastGroup, server.MulticastGroupAddress, sizeof(info.multicastGroup));
+    }
+    return true;
+}
+
+bool NatNetDepacketizer::parseFrame(const char* payload, size_t size, StagedFrame& frame, size_t markerCap) const
+{
+    PacketReader in(payload, size);
+    const bool sections = hasSectionSizes();
+    const size_t cap = std::min<size_t>(markerCap, MAX_LABELED_MARKERS);
+
+    frame.frameNumber = in.read<int32_t>();
+    frame.transitLatencyMs = -1.0;
+    frame.totalLatencyMs = -1.0;
+
+    // Marker sets: positions duplicated by the labeled markers, not used
+    const int32_t markerSetCount = in.read<int32_t>();
+    if (sections) {
+        in.skip(in.read<int32_t>());
+    } else {
+        for (int32_t i = 0; i < markerSetCount && in.ok(); i++)
+        {
+            in.skipString();
+            in.skip(in.read<int32_t>() * kMarkerPositionBytes);
+        }
+    }
+
+    // Legacy unlabeled markers, replaced below if the labeled marker list carries unlabeled ones
+    FrameStagingQueue::clearMarkers(frame);
+    const int32_t otherMarkerCount = in.readCount(MAX_UNLABELED_MARKERS);
+    if (sections) {
+        in.read<int32_t>();
+    }
+    for (int32_t i = 0; i < otherMarkerCount && in.ok(); i++)
+    {
+        float position[3];
+        position[0] = in.read<float>();
+        position[1] = in.read<float>();
+        position[2] = in.read<float>();
+        FrameStagingQueue::addMarker(frame, FrameStagingQueue::legacyMarker(position), cap);
+    }
+
+    // Rigid bodies
+    const int32_t rigidBodyCount = in.readCount(MAX_RIGIDBODIES);
+    if (sections) {
+        in.read<int32_t>();
+    }
+    frame.rigidBodies.resize(static_cast<size_t>(rigidBodyCount));
+    for (sRigidBodyData& body : frame.rigidBodies) {
+        readRigidBody(in, body);
+    }
+
+    // Skeletons, with their bones back to back
+    const int32_t skeletonCount = in.readCount(MAX_SKELETONS);
+    if (sections) {
+        in.read<int32_t>();
+    }
+    frame.skeletons.resize(static_cast<size_t>(skeletonCount));
+    frame.bones.clear();
+    for (StagedSkeleton& skeleton : frame.skeletons)
+    {
+        skeleton.id = in.read<int32_t>();
+        skeleton.boneCount = in.readCount(MAX_SKELRIGIDBODIES);
+        skeleton.firstBone = static_cast<int32_t>(frame.bones.size());
+        if (!in.ok()) {
+            return false;
+        }
+
+        frame.bones.resize(frame.bones.size() + static_cast<size_t>(skeleton.boneCount));
+        for (int32_t b = 0; b < skeleton.boneCount; b++) {
+            readRigidBody(in, frame.bones[static_cast<size_t>(skeleton.firstBone + b)]);
+        }
+    }
+
+    // Trained markerset assets (4.1+), not used
+    if (sections) {
+        in.read<int32_t>();
+        in.skip(in.read<int32_t>());
+    }
+
+    // Labeled markers; NatNet 3+ lists the unlabeled markers here too, flagged in params
+    const int32_t labeledCount = in.readCount(MAX_LABELED_MARKERS);
+    if (sections) {
+        in.read<int32_t>();
+    }
+    bool listsUnlabeled = false;
+    for (int32_t i = 0; i < labeledCount && in.ok(); i++)
+    {
+        sMarker marker;
+        marker.ID = in.read<int32_t>();
+        marker.x = in.read<float>();
+        marker.y = in.read<float>();
+        marker.z = in.read<float>();
+        marker.size = in.read<float>();
+        marker.params = in.read<int16_t>();
+        marker.residual = in.read<float>();
+
+        // The first flagged marker supersedes the legacy list, which repeats them
+        if ((marker.params & kMarkerParamUnlabeled) && !listsUnlabeled) {
+            listsUnlabeled = true;
+            frame.unlabeledMarkers.clear();
+            frame.unlabeledMarkerTotal = 0;
+        }
+        FrameStagingQueue::addMarker(frame, marker, cap);
+    }
+
+    // Force plates and devices, not used
+    for (const int32_t deviceLimit : {MAX_FORCEPLATES, MAX_DEVICES})
+    {
+        const int32_t deviceCount = in.readCount(deviceLimit);
+        if (sections) {
+            in.skip(in.read<int32_t>());
+        } else {
+            skipAnalogDevices(in, deviceCount);
+        }
+    }
+
+    // Frame suffix
+    in.read<uint32_t>();    // Timecode
+    in.read<uint32_t>();    // Timecode subframe
+    frame.timestamp = in.read<double>();
+    frame.cameraMidExposureTimestamp = in.read<uint64_t>();
+    frame.cameraDataReceivedTimestamp = in.read<uint64_t>();
+    frame.transmitTimestamp = in.read<uint64_t>();
+    if (sections) {
+        in.read<uint32_t>();    // Precision timestamp, seconds
+        in.read<uint32_t>();    // Precision timestamp, fractional seconds
+    }
+    frame.params = in.read<int16_t>();
+
+    return in.ok();
+}
+
+bool NatNetDepacketizer::parseModelDefinitions(const char* payload, size_t size,
+                                               NatNetModelDefinitions& definitions) const
+{
+    PacketReader in(payload, size);
+    const bool sections = hasSectionSizes();
+    const bool markerNames = m_major >= 4;
+
+    const int32_t descriptionCount = in.readCount(MAX_MODELS);
+    for (int32_t i = 0; i < descriptionCount && in.ok(); i++)
+    {
+        const int32_t type = in.read<int32_t>();
+        const int32_t descriptionBytes = sections ? in.read<int32_t>() : -1;
+        const char* descriptionStart = in.position();
+        if (sections && (descriptionBytes < 0 || static_cast<size_t>(descriptionBytes) > in.remaining())) {
+            return false;
+        }
+
+        if (type == Descriptor_RigidBody)
+        {
+            if (sRigidBodyDescription* body = definitions.addRigidBody()) {
+                readRigidBodyDescription(in, *body, definitions, markerNames);
+            }
+        }
+        else if (type == Descriptor_Skeleton)
+        {
+            if (sSkeletonDescription* skeleton = definitions.addSkeleton())
+            {
+                in.readString(skeleton->szName, MAX_NAMELENGTH);
+                skeleton->skeletonID = in.read<int32_t>();
+                skeleton->nRigidBodies = in.readCount(MAX_SKELRIGIDBODIES);
+                for (int32_t b = 0; b < skeleton->nRigidBodies && in.ok(); b++) {
+                    readRigidBodyDescription(in, skeleton->RigidBodies[b], definitions, markerNames);
+                }
+            }
+        }
+        else if (!sections)
+        {
+            if (type != Descriptor_MarkerSet) {
+                // No size to skip by; keep what was decoded so far
+                break;
+            }
+
+            in.skipString();
+            const int32_t markerCount = in.read<int32_t>();
+            for (int32_t m = 0; m < markerCount && in.ok(); m++) {
+                in.skipString();
+            }
+        }
+
+        // Sized descriptions may carry fields newer than this decoder; resume after them
+        if (sections) {
+            if (static_cast<size_t>(in.position() - descriptionStart) > static_cast<size_t>(descriptionBytes)) {
+                return false;
+            }
+            in.seek(descriptionStart + descriptionBytes);
+        }
+    }
+
+    return in.ok();
+}
@@ -0,0 +1,145 @@
+// Decoder for the NatNet wire protocol, bitstream versions 3.0 to 4.x.
+//
+// Parses the UDP messages Motive sends on its command and data ports without
+// the NatNet SDK. Frames of data are decoded straight into a StagedFrame slot
+// of the ingest path, with no intermediate sFrameOfMocapData; model definitions
+// are decoded into sDataDescriptions owned by a NatNetModelDefinitions so the
+// rest of the client can use them like the SDK's. All reads are bounds checked
+// and a malformed message is rejected as a whole. Multi-byte values are
+// little-endian on the wire, as on every host the client runs on.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "NatNetTypes.h"
+#include "frame_staging.h"
+
+/**
+ * @brief Server description carried by a NAT_SERVERINFO reply.
+ */
+struct NatNetServerInfo {
+    std::string hostApp;                    // Name of the host application, e.g. "Motive"
+    uint8_t hostVersion[4] = {};            // Host application version
+    uint8_t natNetVersion[4] = {};          // Bitstream version the server streams
+    uint64_t highResClockFrequency = 0;     // Host clock ticks per second
+    uint16_t dataPort = 0;                  // Port the server streams frames to
+    bool multicast = true;                  // Streaming to a multicast group rather than unicast
+    uint8_t multicastGroup[4] = {};         // Multicast group address
+};
+
+/**
+ * @brief Data descriptions decoded from a NAT_MODELDEF message, with the storage they point into.
+ */
+class NatNetModelDefinitions {
+public:
+    NatNetModelDefinitions();
+
+    NatNetModelDefinitions(const NatNetModelDefinitions&) = delete;
+    NatNetModelDefinitions& operator=(const NatNetModelDefinitions&) = delete;
+
+    /**
+     * @brief The decoded descriptions; valid for the lifetime of this object.
+     */
+    sDataDescriptions* descriptions() { return m_descriptions.get(); }
+
+    /**
+     * @brief Appends a zeroed rigid body description; nullptr once MAX_MODELS is reached.
+     */
+    sRigidBodyDescription* addRigidBody();
+
+    /**
+     * @brief Appends a zeroed skeleton description; nullptr once MAX_MODELS is reached.
+     */
+    sSkeletonDescription* addSkeleton();
+
+    /**
+     * @brief Allocates storage for @p count marker positions owned by these definitions.
+     */
+    MarkerData* addMarkerPositions(size_t count);
+
+private:
+    std::unique_ptr<sDataDescriptions> m_descriptions;          // Points into the storage below
+    std::deque<sRigidBodyDescription> m_rigidBodies;            // Deques keep element addresses stable
+    std::deque<sSkeletonDescription> m_skeletons;
+    std::deque<std::vector<float>> m_markerPositions;           // x y z per marker
+};
+
+class NatNetDepacketizer {
+public:
+    static constexpr uint16_t kDefaultCommandPort = 1510;               // Motive's command port
+    static constexpr uint16_t kDefaultDataPort = 1511;                  // Motive's data port
+    static constexpr const char* kDefaultMulticastGroup = "239.255.42.99";
+    static constexpr size_t kHeaderSize = 4;                            // Message ID and payload size
+    static constexpr size_t kMaxMessageSize = kHeaderSize + MAX_PACKETSIZE;
+
+    /**
+     * @brief Sets the bitstream version used to decode frames and model definitions.
+     *
+     * Taken from the server info; versions older than 3.0 are not supported.
+     * @return False if the version is not supported; the previous version is kept.
+     */
+    bool setVersion(int major, int minor);
+
+    int versionMajor() const { return m_major; }
+    int versionMinor() const { return m_minor; }
+
+    /**
+     * @brief Splits a datagram into its message ID and payload.
+     * @return False if the datagram is shorter than its header announces.
+     */
+    static bool readHeader(const char* data, size_t size, uint16_t& messageId,
+                           const char*& payload, size_t& payloadSize);
+
+    /**
+     * @brief Writes a request message with an optional payload into @p out.
+     * @return The number of bytes written, or 0 if @p out is too small.
+     */
+    static size_t writeRequest(uint16_t messageId, const void* payload, size_t payloadSize,
+                               char* out, size_t outSize);
+
+    /**
+     * @brief Writes the NAT_CONNECT request announcing this client into @p out.
+     * @return The number of bytes written, or 0 if @p out is too small.
+     */
+    static size_t writeConnectRequest(char* out, size_t outSize);
+
+    /**
+     * @brief Decodes a NAT_SERVERINFO payload.
+     */
+    static bool parseServerInfo(const char* payload, size_t size, NatNetServerInfo& info);
+
+    /**
+     * @brief Decodes a NAT_FRAMEOFDATA payload into @p frame.
+     *
+     * Rigid bodies, skeletons, labeled markers, legacy unlabeled markers and the
+     * frame suffix are kept; marker sets, assets, force plates and devices are
+     * skipped. At most @p markerCap markers of each kind are stored, the totals
+     * count all of them. Arrival latencies are left unknown.
+     * @return False if the payload is malformed; @p frame is then unspecified.
+     */
+    bool parseFrame(const char* payload, size_t size, StagedFrame& frame, size_t markerCap) const;
+
+    /**
+     * @brief Decodes the rigid body and skeleton descriptions of a NAT_MODELDEF payload.
+     *
+     * Other description types are skipped. Before bitstream 4.1 descriptions carry
+     * no size, so decoding stops at the first type that cannot be skipped.
+     * @return False if the payload is malformed.
+     */
+    bool parseModelDefinitions(const char* payload, size_t size, NatNetModelDefinitions& definitions) const;
+
+private:
+    /**
+     * @brief True if the bitstream prefixes each section with its size in bytes (4.1 and later).
+     */
+    bool hasSectionSizes() const { return m_major > 4 || (m_major == 4 && m_minor >= 1); }
+
+    int m_major = 4;
+    int m_minor = 1;
+};
@@ -0,0 +1,418 @@
+#include "natnet_udp_source.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <QDebug>
+
+namespace {
+
+constexpr int kPollIntervalMs = 100;    // Upper bound on how long the receive thread takes to notice a stop
+
+int64_t realtimeNs()
+{
+    timespec now{};
+    clock_gettime(CLOCK_REALTIME, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief Parses a dotted IPv4 address; falls back to @p fallback if it is empty or invalid.
+ */
+in_addr toAddress(const QString& ip, in_addr_t fallback)
+{
+    in_addr address{};
+    if (ip.isEmpty() || inet_pton(AF_INET, ip.toStdString().c_str(), &address) != 1) {
+        address.s_addr = fallback;
+    }
+    return address;
+}
+
+/**
+ * @brief Kernel receive time carried by the control messages of @p message, or 0 if absent.
+ */
+int64_t kernelTimestampNs(msghdr& message)
+{
+#ifdef SO_TIMESTAMPNS
+    for (cmsghdr* control = CMSG_FIRSTHDR(&message); control; control = CMSG_NXTHDR(&message, control)) {
+        if (control->cmsg_level == SOL_SOCKET && control->cmsg_type == SCM_TIMESTAMPNS) {
+            timespec stamp{};
+            std::memcpy(&stamp, CMSG_DATA(control), sizeof(stamp));
+            return static_cast<int64_t>(stamp.tv_sec) * 1000000000LL + stamp.tv_nsec;
+        }
+    }
+#else
+    (void)message;
+#endif
+    return 0;
+}
+
+} // namespace
+
+NatNetUdpSource::NatNetUdpSource(FrameRingBuffer<FrameData>& frames)
+    : FrameSource(frames)
+{
+}
+
+NatNetUdpSource::~NatNetUdpSource()
+{
+    disconnect();
+}
+
+bool NatNetUdpSource::connect()
+{
+    disconnect();
+
+    for (std::atomic<uint64_t>* counter : {&m_datagrams, &m_batches, &m_frames, &m_malformed, &m_modelChanges,
+                                           &m_queueSamples, &m_queueTotalNs, &m_queueMaxNs}) {
+        counter->store(0, std::memory_order_relaxed);
+    }
+
+    // Command socket on the client interface; the server replies to its address
+    m_commandSocket = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_addr = toAddress(m_clientIP, htonl(INADDR_ANY));
+    if (m_commandSocket < 0 || bind(m_commandSocket, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+        qWarning() << "NatNetUdpSource: unable to open the command socket:" << std::strerror(errno);
+        closeSockets();
+        return false;
+    }
+
+    m_serverAddress = sockaddr_in{};
+    m_serverAddress.sin_family = AF_INET;
+    m_serverAddress.sin_port = htons(NatNetDepacketizer::kDefaultCommandPort);
+    m_serverAddress.sin_addr = toAddress(m_serverIP, htonl(INADDR_LOOPBACK));
+
+    // Server description: bitstream version, clock rate and where frames are streamed
+    char connectMessage[NatNetDepacketizer::kHeaderSize + sizeof(sSender) + sizeof(sConnectionOptions)];
+    const size_t connectSize = NatNetDepacketizer::writeConnectRequest(connectMessage, sizeof(connectMessage));
+    const std::vector<char> serverReply = request(NAT_CONNECT, connectMessage, connectSize, NAT_SERVERINFO,
+                                                  kRequestTimeout);
+
+    NatNetServerInfo server;
+    if (serverReply.empty() || !NatNetDepacketizer::parseServerInfo(serverReply.data(), serverReply.size(), server)) {
+        qInfo() << "NatNetUdpSource: no server info from" << m_serverIP;
+        closeSockets();
+        return false;
+    }
+    if (!m_depacketizer.setVersion(server.natNetVersion[0], server.natNetVersion[1])) {
+        qWarning() << "NatNetUdpSource: unsupported NatNet bitstream" << server.natNetVersion[0] << "."
+                   << server.natNetVersion[1];
+        closeSockets();
+        return false;
+    }
+
+    qInfo().nospace() << "NatNetUdpSource: connected to " << server.hostApp.c_str() << " " << server.hostVersion[0] << "."
+                      << server.hostVersion[1] << "." << server.hostVersion[2] << "." << server.hostVersion[3]
+                      << ", NatNet " << server.natNetVersion[0] << "." << server.natNetVersion[1];
+
+    // The connection type chosen by the user wins over what the server announces
+    m_unicast = m_connectionType == "Unicast";
+    server.multicast = !m_unicast;
+    if (!openDataSocket(server)) {
+        closeSockets();
+        return false;
+    }
+    setHostClockFrequency(server.highResClockFrequency);
+
+    // Model definitions size the frame pool and name the assets
+    char modelRequest[NatNetDepacketizer::kHeaderSize];
+    const size_t modelRequestSize = NatNetDepacketizer::writeRequest(NAT_REQUEST_MODELDEF, nullptr, 0,
+                                                                     modelRequest, sizeof(modelRequest));
+    const std::vector<char> modelReply = request(NAT_REQUEST_MODELDEF, modelRequest, modelRequestSize, NAT_MODELDEF,
+                                                 kRequestTimeout);
+
+    m_definitions = std::make_unique<NatNetModelDefinitions>();
+    if (modelReply.empty() || !m_depacketizer.parseModelDefinitions(modelReply.data(), modelReply.size(), *m_definitions)) {
+        qWarning() << "NatNetUdpSource: no model definitions from" << m_serverIP;
+        closeSockets();
+        return false;
+    }
+    processDataDescriptions(m_definitions->descriptions());
+
+    // Start the ingest worker before frames can arrive
+    startIngest();
+    connected = true;
+
+    if (m_unicast) {
+        sendKeepAlive();
+    }
+
+    m_receiving.store(true);
+    m_receiveThread = std::thread(&NatNetUdpSource::receiveLoop, this);
+    return true;
+}
+
+bool NatNetUdpSource::disconnect()
+{
+    if (!m_receiveThread.joinable()) {
+        closeSockets();
+        return true;
+    }
+
+    qDebug() << "NatNetUdpSource: disconnecting";
+    connected = false;
+
+    m_receiving.store(false);
+    m_receiveThread.join();
+
+    // No more frames can be staged; let the worker finish and exit
+    stopIngest();
+
+    if (m_unicast && m_commandSocket >= 0) {
+        char message[NatNetDepacketizer::kHeaderSize];
+        const size_t size = NatNetDepacketizer::writeRequest(NAT_DISCONNECT, nullptr, 0, message, sizeof(message));
+        sendto(m_commandSocket, message, size, 0, reinterpret_cast<sockaddr*>(&m_serverAddress), sizeof(m_serverAddress));
+    }
+    closeSockets();
+
+    logStats();
+
+    const UdpReceiveStats stats = getReceiveStats();
+    qDebug() << "UDP receive: datagrams" << stats.datagrams << "batches" << stats.batches << "frames" << stats.frames
+             << "malformed" << stats.malformed << "model changes" << stats.modelChanges
+             << "socket queue mean" << stats.socketQueueMeanUs << "us max" << stats.socketQueueMaxUs << "us";
+
+    return true;
+}
+
+sDataDescriptions* NatNetUdpSource::getDataDescriptions()
+{
+    return m_definitions ? m_definitions->descriptions() : nullptr;
+}
+
+UdpReceiveStats NatNetUdpSource::getReceiveStats() const
+{
+    UdpReceiveStats stats;
+    stats.datagrams = m_datagrams.load(std::memory_order_relaxed);
+    stats.batches = m_batches.load(std::memory_order_relaxed);
+    stats.frames = m_frames.load(std::memory_order_relaxed);
+    stats.malformed = m_malformed.load(std::memory_order_relaxed);
+    stats.modelChanges = m_modelChanges.load(std::memory_order_relaxed);
+
+    const uint64_t samples = m_queueSamples.load(std::memory_order_relaxed);
+    if (samples > 0) {
+        stats.socketQueueMeanUs = m_queueTotalNs.load(std::memory_order_relaxed) / 1000.0 / samples;
+        stats.socketQueueMaxUs = m_queueMaxNs.load(std::memory_order_relaxed) / 1000.0;
+    }
+    return stats;
+}
+
+std::vector<char> NatNetUdpSource::request(uint16_t messageId, const char* message, size_t messageSize,
+                                           uint16_t replyId, std::chrono::milliseconds timeout)
+{
+    if (messageSize == 0 || sendto(m_commandSocket, message, messageSize, 0,
+                                   reinterpret_cast<sockaddr*>(&m_serverAddress), sizeof(m_serverAddress)) < 0) {
+        qWarning() << "NatNetUdpSource: unable to send request" << messageId << ":" << std::strerror(errno);
+        return {};
+    }
+
+    std::vector<char> datagram(NatNetDepacketizer::kMaxMessageSize);
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while (true)
+    {
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            return {};
+        }
+
+        pollfd command{m_commandSocket, POLLIN, 0};
+        if (poll(&command, 1, static_cast<int>(remaining.count())) <= 0) {
+            continue;
+        }
+
+        const ssize_t received = recv(m_commandSocket, datagram.data(), datagram.size(), 0);
+        uint16_t receivedId = 0;
+        const char* payload = nullptr;
+        size_t payloadSize = 0;
+        if (received > 0
+            && NatNetDepacketizer::readHeader(datagram.data(), static_cast<size_t>(received), receivedId, payload, payloadSize)
+            && receivedId == replyId) {
+            return std::vector<char>(payload, payload + payloadSize);
+        }
+        // Anything else (message strings, stale replies) is ignored
+    }
+}
+
+bool NatNetUdpSource::openDataSocket(const NatNetServerInfo& server)
+{
+    m_dataSocket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (m_dataSocket < 0) {
+        qWarning() << "NatNetUdpSource: unable to open the data socket:" << std::strerror(errno);
+        return false;
+    }
+
+    const int enable = 1;
+    setsockopt(m_dataSocket, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    setsockopt(m_dataSocket, SOL_SOCKET, SO_RCVBUF, &kReceiveBufferBytes, sizeof(kReceiveBufferBytes));
+#ifdef SO_TIMESTAMPNS
+    setsockopt(m_dataSocket, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable));
+#endif
+
+    const in_addr clientAddress = toAddress(m_clientIP, htonl(INADDR_ANY));
+
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    if (server.multicast) {
+        // Every client on the host shares the group's port
+        local.sin_addr.s_addr = htonl(INADDR_ANY);
+        local.sin_port = htons(server.dataPort != 0 ? server.dataPort : NatNetDepacketizer::kDefaultDataPort);
+    } else {
+        // The server streams to wherever the keep-alives come from
+        local.sin_addr = clientAddress;
+        local.sin_port = 0;
+    }
+
+    if (bind(m_dataSocket, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+        qWarning() << "NatNetUdpSource: unable to bind the data socket:" << std::strerror(errno);
+        return false;
+    }
+
+    if (server.multicast) {
+        ip_mreq membership{};
+        membership.imr_interface = clientAddress;
+        std::memcpy(&membership.imr_multiaddr, server.multicastGroup, sizeof(server.multicastGroup));
+        if (membership.imr_multiaddr.s_addr == 0) {
+            inet_pton(AF_INET, NatNetDepacketizer::kDefaultMulticastGroup, &membership.imr_multiaddr);
+        }
+
+        if (setsockopt(m_dataSocket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0) {
+            qWarning() << "NatNetUdpSource: unable to join the multicast group:" << std::strerror(errno);
+            return false;
+        }
+    }
+    return true;
+}
+
+void NatNetUdpSource::closeSockets()
+{
+    for (int* fd : {&m_dataSocket, &m_commandSocket}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void NatNetUdpSource::sendKeepAlive()
+{
+    char message[NatNetDepacketizer::kHeaderSize];
+    const size_t size = NatNetDepacketizer::writeRequest(NAT_KEEPALIVE, nullptr, 0, message, sizeof(message));
+    sendto(m_dataSocket, message, size, 0, reinterpret_cast<sockaddr*>(&m_serverAddress), sizeof(m_serverAddress));
+}
+
+void NatNetUdpSource::receiveLoop()
+{
+    qDebug() << "NatNetUdpSource: receive thread started";
+
+    // One full-size buffer per datagram of a batch, allocated once
+    std::vector<char> buffers(kBatchSize * NatNetDepacketizer::kMaxMessageSize);
+    std::vector<iovec> vectors(kBatchSize);
+    std::vector<char> controls(kBatchSize * CMSG_SPACE(sizeof(timespec)));
+    std::vector<mmsghdr> messages(kBatchSize);
+
+    auto nextKeepAlive = std::chrono::steady_clock::now() + kKeepAliveInterval;
+
+    while (m_receiving.load())
+    {
+        if (m_unicast && std::chrono::steady_clock::now() >= nextKeepAlive) {
+            sendKeepAlive();
+            nextKeepAlive += kKeepAliveInterval;
+        }
+
+        pollfd data{m_dataSocket, POLLIN, 0};
+        if (poll(&data, 1, kPollIntervalMs) <= 0) {
+            continue;
+        }
+
+        // Buffers and control space must be re-armed before every call
+        for (size_t i = 0; i < kBatchSize; i++) {
+            vectors[i].iov_base = buffers.data() + i * NatNetDepacketizer::kMaxMessageSize;
+            vectors[i].iov_len = NatNetDepacketizer::kMaxMessageSize;
+            messages[i] = mmsghdr{};
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            messages[i].msg_hdr.msg_control = controls.data() + i * CMSG_SPACE(sizeof(timespec));
+            messages[i].msg_hdr.msg_controllen = CMSG_SPACE(sizeof(timespec));
+        }
+
+#ifdef __linux__
+        const int count = recvmmsg(m_dataSocket, messages.data(), static_cast<unsigned int>(kBatchSize),
+                                   MSG_DONTWAIT, nullptr);
+#else
+        // No batched receive; one datagram per call
+        const ssize_t received = recvmsg(m_dataSocket, &messages[0].msg_hdr, MSG_DONTWAIT);
+        const int count = received >= 0 ? 1 : -1;
+        if (received >= 0) {
+            messages[0].msg_len = static_cast<unsigned int>(received);
+        }
+#endif
+        if (count <= 0) {
+            continue;
+        }
+
+        m_batches.fetch_add(1, std::memory_order_relaxed);
+        m_datagrams.fetch_add(static_cast<uint64_t>(count), std::memory_order_relaxed);
+        for (int i = 0; i < count; i++) {
+            handleDatagram(static_cast<const char*>(vectors[i].iov_base), messages[i].msg_len,
+                           kernelTimestampNs(messages[i].msg_hdr));
+        }
+    }
+
+    qDebug() << "NatNetUdpSource: receive thread stopped";
+}
+
+void NatNetUdpSource::handleDatagram(const char* data, size_t size, int64_t kernelReceiveNs)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    if (kernelReceiveNs > 0) {
+        const int64_t queuedNs = std::max<int64_t>(realtimeNs() - kernelReceiveNs, 0);
+        m_queueSamples.fetch_add(1, std::memory_order_relaxed);
+        m_queueTotalNs.fetch_add(static_cast<uint64_t>(queuedNs), std::memory_order_relaxed);
+        if (static_cast<uint64_t>(queuedNs) > m_queueMaxNs.load(std::memory_order_relaxed)) {
+            m_queueMaxNs.store(static_cast<uint64_t>(queuedNs), std::memory_order_relaxed);
+        }
+    }
+
+    uint16_t messageId = 0;
+    const char* payload = nullptr;
+    size_t payloadSize = 0;
+    if (!NatNetDepacketizer::readHeader(data, size, messageId, payload, payloadSize)) {
+        m_malformed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (messageId != NAT_FRAMEOFDATA) {
+        return;
+    }
+
+    // Parse straight into the staging slot; a full queue drops the frame
+    StagedFrame* frame = claimStagedFrame();
+    if (!frame) {
+        return;
+    }
+    if (!m_depacketizer.parseFrame(payload, payloadSize, *frame, stagingMarkerCap())) {
+        m_malformed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Assets added or removed in Motive only take effect on the next connect
+    if (frame->params & 0x02) {
+        if (m_modelChanges.fetch_add(1, std::memory_order_relaxed) == 0) {
+            qWarning() << "NatNetUdpSource: the model list changed; reconnect to pick up the new assets";
+        }
+    }
+
+    commitStagedFrame();
+    m_frames.fetch_add(1, std::memory_order_relaxed);
+
+    recordStagingTime(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+}
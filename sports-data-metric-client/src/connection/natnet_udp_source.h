@@ -0,0 +1,129 @@
+// Frame source that receives NatNet UDP streams directly, without the NatNet SDK.
+//
+// Performs the command port handshake (server info and model definitions) and
+// then receives frames on the data port, multicast or unicast, on its own
+// thread. Datagrams are read in batches with recvmmsg() where available, and
+// the kernel receive timestamps measure how long frames waited in the socket.
+// Frames are parsed by NatNetDepacketizer straight into staging slots of the
+// ingest path. POSIX only; Windows builds use the SDK.
+
+#pragma once
+
+#include "frame_source.h"
+#include "natnet_depacketizer.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+
+/**
+ * @brief Counters of the UDP receive thread.
+ */
+struct UdpReceiveStats {
+    uint64_t datagrams = 0;         // Datagrams received on the data and command ports
+    uint64_t batches = 0;           // Receive calls that returned data
+    uint64_t frames = 0;            // Frames parsed and staged
+    uint64_t malformed = 0;         // Datagrams rejected by the depacketizer
+    uint64_t modelChanges = 0;      // Frames flagging a changed model list
+    double socketQueueMeanUs = 0.0; // Mean time from kernel receive to parsing, in microseconds; 0 without timestamps
+    double socketQueueMaxUs = 0.0;  // Longest time from kernel receive to parsing, in microseconds
+};
+
+class NatNetUdpSource : public FrameSource {
+public:
+    /**
+     * @brief Constructs a UDP source publishing into @p frames.
+     * @param frames History shared by every source.
+     */
+    explicit NatNetUdpSource(FrameRingBuffer<FrameData>& frames);
+
+    /**
+     * @brief Stops receiving if still connected.
+     */
+    ~NatNetUdpSource() override;
+
+    /**
+     * @brief Queries the server on its command port, fetches the model definitions and starts receiving.
+     * @return True if connected, false otherwise.
+     */
+    bool connect() override;
+
+    /**
+     * @brief Stops the receive thread and the ingest worker and closes the sockets.
+     * @return True once the source is stopped.
+     */
+    bool disconnect() override;
+
+    /**
+     * @brief Gets the descriptions decoded from the server's model definitions.
+     * @return The data descriptions, or nullptr before the first connect().
+     */
+    sDataDescriptions* getDataDescriptions() override;
+
+    /**
+     * @brief Gets the counters of the receive thread.
+     * @return A snapshot of the receive statistics.
+     */
+    UdpReceiveStats getReceiveStats() const;
+
+private:
+    /**
+     * @brief Sends a request on the command socket and waits for the reply with @p replyId.
+     * @return The reply payload, empty if none arrived within @p timeout.
+     */
+    std::vector<char> request(uint16_t messageId, const char* message, size_t messageSize, uint16_t replyId,
+                              std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Opens and binds the data socket for the stream announced in @p server.
+     */
+    bool openDataSocket(const NatNetServerInfo& server);
+
+    /**
+     * @brief Closes both sockets.
+     */
+    void closeSockets();
+
+    /**
+     * @brief Receive thread: reads datagram batches and stages the frames they carry.
+     */
+    void receiveLoop();
+
+    /**
+     * @brief Parses one datagram from the data port into a staging slot.
+     * @param kernelReceiveNs Kernel receive time on the realtime clock, or 0 if unknown.
+     */
+    void handleDatagram(const char* data, size_t size, int64_t kernelReceiveNs);
+
+    /**
+     * @brief Sends NAT_KEEPALIVE from the data socket so a unicast server keeps streaming to it.
+     */
+    void sendKeepAlive();
+
+    NatNetDepacketizer m_depacketizer;                                      // Decoder for the negotiated bitstream
+    std::unique_ptr<NatNetModelDefinitions> m_definitions;                  // Model definitions of the session
+    bool m_unicast = false;                                                 // Unicast stream; needs keep-alives
+
+    int m_commandSocket = -1;               // Talks to the server's command port
+    int m_dataSocket = -1;                  // Receives frames
+    sockaddr_in m_serverAddress{};          // Server's command port
+
+    std::thread m_receiveThread;            // Runs receiveLoop()
+    std::atomic<bool> m_receiving{false};   // Cleared to stop the receive thread
+
+    std::atomic<uint64_t> m_datagrams{0};
+    std::atomic<uint64_t> m_batches{0};
+    std::atomic<uint64_t> m_frames{0};
+    std::atomic<uint64_t> m_malformed{0};
+    std::atomic<uint64_t> m_modelChanges{0};
+    std::atomic<uint64_t> m_queueSamples{0};        // Datagrams with a kernel timestamp
+    std::atomic<uint64_t> m_queueTotalNs{0};        // Total socket queueing time
+    std::atomic<uint64_t> m_queueMaxNs{0};          // Longest socket queueing time
+
+    static constexpr size_t kBatchSize = 16;                                // Datagrams read per recvmmsg()
+    static constexpr int kReceiveBufferBytes = 8 * 1024 * 1024;             // Socket buffer; rides out decode stalls
+    static constexpr std::chrono::milliseconds kRequestTimeout{2000};       // Wait for command replies
+    static constexpr std::chrono::milliseconds kKeepAliveInterval{1000};    // Unicast keep-alive period
+};
@@ -0,0 +1,150 @@
+#include "stream_tracker.h"
+
+#include <algorithm>
+#include <cmath>
+
+void LatencyHistogram::record(double latencyMs)
+{
+    const double clamped = std::max(latencyMs, 0.0);
+    const size_t bin = std::min(static_cast<size_t>(clamped / kBinWidthMs), kBinCount - 1);
+
+    m_bins[bin].fetch_add(1, std::memory_order_relaxed);
+
+    // Single writer, so a plain compare-then-store is enough
+    if (clamped > m_maxMs.load(std::memory_order_relaxed)) {
+        m_maxMs.store(clamped, std::memory_order_relaxed);
+    }
+}
+
+LatencySummary LatencyHistogram::summary() const
+{
+    LatencySummary summary;
+
+    uint64_t total = 0;
+    for (const std::atomic<uint64_t>& bin : m_bins) {
+        total += bin.load(std::memory_order_relaxed);
+    }
+
+    summary.samples = total;
+    summary.maxMs = m_maxMs.load(std::memory_order_relaxed);
+    if (total == 0) {
+        return summary;
+    }
+
+    // Percentiles come from the bins, so they are never reported above the true maximum
+    summary.p50Ms = std::min(percentile(0.50, total), summary.maxMs);
+    summary.p99Ms = std::min(percentile(0.99, total), summary.maxMs);
+    return summary;
+}
+
+double LatencyHistogram::percentile(double fraction, uint64_t total) const
+{
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * total)));
+
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < kBinCount; ++i) {
+        cumulative += m_bins[i].load(std::memory_order_relaxed);
+        if (cumulative >= rank) {
+            // Report the upper edge of the bin the rank falls into
+            return (i + 1) * kBinWidthMs;
+        }
+    }
+    return kBinCount * kBinWidthMs;
+}
+
+void LatencyHistogram::reset()
+{
+    for (std::atomic<uint64_t>& bin : m_bins) {
+        bin.store(0, std::memory_order_relaxed);
+    }
+    m_maxMs.store(0.0, std::memory_order_relaxed);
+}
+
+StreamTracker::Arrival StreamTracker::recordFrame(int32_t frameNumber, double timestamp)
+{
+    m_frames.fetch_add(1, std::memory_order_relaxed);
+
+    if (!m_hasFrame) {
+        m_hasFrame = true;
+        m_lastFrameNumber = frameNumber;
+        m_lastTimestamp = timestamp;
+        return Arrival::InOrder;
+    }
+
+    const int64_t delta = static_cast<int64_t>(frameNumber) - m_lastFrameNumber;
+
+    // Too far back to be reordering: the server restarted its count
+    if (delta < -kMaxReorderFrames || timestamp < m_lastTimestamp - kMaxReorderSeconds) {
+        m_discontinuities.fetch_add(1, std::memory_order_relaxed);
+        m_lastFrameNumber = frameNumber;
+        m_lastTimestamp = timestamp;
+        return Arrival::Discontinuity;
+    }
+
+    if (delta == 0) {
+        m_duplicates.fetch_add(1, std::memory_order_relaxed);
+        return Arrival::Duplicate;
+    }
+
+    if (delta < 0) {
+        m_outOfOrder.fetch_add(1, std::memory_order_relaxed);
+        return Arrival::OutOfOrder;
+    }
+
+    m_lastFrameNumber = frameNumber;
+    m_lastTimestamp = timestamp;
+    if (delta == 1) {
+        return Arrival::InOrder;
+    }
+
+    m_gaps.fetch_add(1, std::memory_order_relaxed);
+    m_missingFrames.fetch_add(static_cast<uint64_t>(delta - 1), std::memory_order_relaxed);
+    return Arrival::AfterGap;
+}
+
+void StreamTracker::recordLatency(double systemMs, double transitMs, double totalMs)
+{
+    if (systemMs >= 0.0) {
+        m_systemLatency.record(systemMs);
+    }
+    if (transitMs >= 0.0) {
+        m_transitLatency.record(transitMs);
+    }
+    if (totalMs >= 0.0) {
+        m_totalLatency.record(totalMs);
+    }
+}
+
+StreamStats StreamTracker::getStats() const
+{
+    StreamStats stats;
+    stats.frames = m_frames.load(std::memory_order_relaxed);
+    stats.gaps = m_gaps.load(std::memory_order_relaxed);
+    stats.missingFrames = m_missingFrames.load(std::memory_order_relaxed);
+    stats.duplicates = m_duplicates.load(std::memory_order_relaxed);
+    stats.outOfOrder = m_outOfOrder.load(std::memory_order_relaxed);
+    stats.discontinuities = m_discontinuities.load(std::memory_order_relaxed);
+
+    stats.systemLatency = m_systemLatency.summary();
+    stats.transitLatency = m_transitLatency.summary();
+    stats.totalLatency = m_totalLatency.summary();
+    return stats;
+}
+
+void StreamTracker::reset()
+{
+    m_hasFrame = false;
+    m_lastFrameNumber = 0;
+    m_lastTimestamp = 0.0;
+
+    m_frames.store(0, std::memory_order_relaxed);
+    m_gaps.store(0, std::memory_order_relaxed);
+    m_missingFrames.store(0, std::memory_order_relaxed);
+    m_duplicates.store(0, std::memory_order_relaxed);
+    m_outOfOrder.store(0, std::memory_order_relaxed);
+    m_discontinuities.store(0, std::memory_order_relaxed);
+
+    m_systemLatency.reset();
+    m_transitLatency.reset();
+    m_totalLatency.reset();
+}
@@ -0,0 +1,135 @@
+// Sequencing and latency bookkeeping for the live NatNet stream.
+//
+// The ingest worker reports every staged frame to the tracker, which classifies
+// it against the previous frame number (in order, after a gap, duplicate or out
+// of order) and adds its latencies to fixed-bin histograms. A frame number far
+// behind the newest one, or a timestamp that steps back by more than reordering
+// explains, means the server restarted its count (a take looped, Motive
+// restarted); the tracker resyncs on it instead of reporting every following
+// frame as out of order. Counters and bins are
+// atomics, so the summary can be read from any thread while frames are recorded.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <QMetaType>
+
+/**
+ * @brief Percentiles of one latency histogram, in milliseconds.
+ */
+struct LatencySummary {
+    double p50Ms = 0.0;         // Median latency
+    double p99Ms = 0.0;         // 99th percentile latency
+    double maxMs = 0.0;         // Largest latency observed
+    uint64_t samples = 0;       // Frames that carried this latency
+};
+
+/**
+ * @brief Sequencing counters and latency percentiles of the live stream.
+ */
+struct StreamStats {
+    uint64_t frames = 0;            // Frames received
+    uint64_t gaps = 0;              // Times one or more frame numbers were skipped
+    uint64_t missingFrames = 0;     // Frame numbers skipped in total
+    uint64_t duplicates = 0;        // Frames repeating the previous frame number
+    uint64_t outOfOrder = 0;        // Frames older than the previous frame number
+    uint64_t discontinuities = 0;   // Times the frame numbers or timestamps restarted and the tracker resynced
+
+    LatencySummary systemLatency;   // Mid camera exposure to transmit, measured by the server
+    LatencySummary transitLatency;  // Transmit to arrival at this client
+    LatencySummary totalLatency;    // Mid camera exposure to arrival at this client
+};
+
+Q_DECLARE_METATYPE(StreamStats)
+
+/**
+ * @brief Fixed-bin latency histogram safe to read while it is written by one thread.
+ */
+class LatencyHistogram {
+public:
+    static constexpr double kBinWidthMs = 0.1;      // Resolution of the reported percentiles
+    static constexpr size_t kBinCount = 1000;       // Bins cover [0, 100) ms; slower frames land in the last bin
+
+    /**
+     * @brief Adds one latency sample; negative samples are clamped to zero.
+     */
+    void record(double latencyMs);
+
+    /**
+     * @brief Computes the percentiles of the samples recorded so far.
+     */
+    LatencySummary summary() const;
+
+    /**
+     * @brief Clears all samples. Must not race with record().
+     */
+    void reset();
+
+private:
+    double percentile(double fraction, uint64_t total) const;
+
+    std::array<std::atomic<uint64_t>, kBinCount> m_bins{};
+    std::atomic<double> m_maxMs{0.0};
+};
+
+class StreamTracker {
+public:
+    /**
+     * @brief How a frame relates to the one received before it.
+     */
+    enum class Arrival {
+        InOrder,        // Next frame number, or the first frame
+        AfterGap,       // Newer frame with one or more frame numbers missing before it
+        Duplicate,      // Same frame number as the previous frame
+        OutOfOrder,     // Older frame number than the previous frame
+        Discontinuity   // Frame number or timestamp restarted; the sequence resumes from this frame
+    };
+
+    static constexpr int64_t kMaxReorderFrames = 120;    // Older frames further back than this restart the sequence
+    static constexpr double kMaxReorderSeconds = 1.0;    // Timestamps stepping back further than this restart the sequence
+
+    /**
+     * @brief Classifies a frame by its number and timestamp and updates the sequencing counters.
+     *
+     * Only the newest frame number seen advances the sequence, so a late frame
+     * does not make the frames after it look like gaps; a discontinuity
+     * restarts the sequence from this frame.
+     * @param frameNumber Host defined frame number.
+     * @param timestamp Frame timestamp in seconds.
+     */
+    Arrival recordFrame(int32_t frameNumber, double timestamp);
+
+    /**
+     * @brief Adds the latencies of one frame; pass a negative value for any that is unavailable.
+     */
+    void recordLatency(double systemMs, double transitMs, double totalMs);
+
+    /**
+     * @brief Returns the sequencing counters and latency percentiles so far.
+     */
+    StreamStats getStats() const;
+
+    /**
+     * @brief Forgets the sequence and clears all counters. Must not race with the record calls.
+     */
+    void reset();
+
+private:
+    bool m_hasFrame = false;                // True once a first frame has been recorded (recording thread only)
+    int32_t m_lastFrameNumber = 0;          // Newest frame number seen (recording thread only)
+    double m_lastTimestamp = 0.0;           // Timestamp of the newest frame (recording thread only)
+
+    std::atomic<uint64_t> m_frames{0};
+    std::atomic<uint64_t> m_gaps{0};
+    std::atomic<uint64_t> m_missingFrames{0};
+    std::atomic<uint64_t> m_duplicates{0};
+    std::atomic<uint64_t> m_outOfOrder{0};
+    std::atomic<uint64_t> m_discontinuities{0};
+
+    LatencyHistogram m_systemLatency;
+    LatencyHistogram m_transitLatency;
+    LatencyHistogram m_totalLatency;
+};
@@ -0,0 +1,289 @@
+#include "synthetic_frame_source.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <QDebug>
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr float kBoneLength = 0.1f;         // Spacing of chained bones, in meters
+constexpr float kMarkerRadius = 0.05f;      // Distance of rigid body markers from their body, in meters
+
+/**
+ * @brief ID of bone @p index of skeleton @p skeletonId: the skeleton in the high word, the 1-based bone in the low.
+ */
+int boneId(int skeletonId, int index)
+{
+    return (skeletonId << 16) | (index + 1);
+}
+
+/**
+ * @brief Writes a rotation of @p angle radians about the vertical (Y) axis.
+ */
+void setYaw(sRigidBodyData& body, double angle)
+{
+    body.qx = 0.0f;
+    body.qy = static_cast<float>(std::sin(angle * 0.5));
+    body.qz = 0.0f;
+    body.qw = static_cast<float>(std::cos(angle * 0.5));
+}
+
+} // namespace
+
+SyntheticFrameSource::SyntheticFrameSource(FrameRingBuffer<FrameData>& frames)
+    : FrameSource(frames)
+{
+}
+
+SyntheticFrameSource::~SyntheticFrameSource()
+{
+    disconnect();
+}
+
+void SyntheticFrameSource::setConfig(const SyntheticConfig& config)
+{
+    m_config.rateHz = std::clamp(config.rateHz, SyntheticConfig::kMinRateHz, SyntheticConfig::kMaxRateHz);
+    m_config.rigidBodyCount = std::clamp(config.rigidBodyCount, 0, MAX_RIGIDBODIES);
+    m_config.skeletonCount = std::clamp(config.skeletonCount, 0, MAX_SKELETONS);
+    m_config.bonesPerSkeleton = std::clamp(config.bonesPerSkeleton, 1, MAX_SKELRIGIDBODIES);
+
+    // All rigid body markers must fit in one frame
+    const int markerLimit = m_config.rigidBodyCount > 0 ? MAX_LABELED_MARKERS / m_config.rigidBodyCount : 0;
+    m_config.markersPerRigidBody = std::clamp(config.markersPerRigidBody, 0, markerLimit);
+}
+
+bool SyntheticFrameSource::connect()
+{
+    disconnect();
+
+    buildDescriptions();
+
+    m_frame = std::make_unique<sFrameOfMocapData>();
+    m_boneData.assign(static_cast<size_t>(m_config.skeletonCount * m_config.bonesPerSkeleton), sRigidBodyData());
+
+    // Timestamps are steady clock nanoseconds
+    setHostClockFrequency(1000000000ULL);
+    processDataDescriptions(m_descriptions.get());
+
+    startIngest();
+    connected = true;
+
+    m_generating.store(true);
+    m_generatorThread = std::thread(&SyntheticFrameSource::generateLoop, this);
+
+    qInfo() << "Synthetic source started:" << m_config.rateHz << "Hz," << m_config.rigidBodyCount << "rigid bodies,"
+            << m_config.skeletonCount << "skeletons of" << m_config.bonesPerSkeleton << "bones";
+    return true;
+}
+
+bool SyntheticFrameSource::disconnect()
+{
+    if (!m_generatorThread.joinable()) {
+        return true;
+    }
+
+    qDebug() << "Synthetic source: stopping";
+    connected = false;
+
+    m_generating.store(false);
+    m_generatorThread.join();
+
+    // No more frames can be staged; let the worker finish and exit
+    stopIngest();
+
+    logStats();
+
+    return true;
+}
+
+sDataDescriptions* SyntheticFrameSource::getDataDescriptions()
+{
+    return m_descriptions.get();
+}
+
+double SyntheticFrameSource::secondsSinceHostTimestamp(uint64_t hostTimestamp) const
+{
+    const uint64_t now = nowNs();
+    return now >= hostTimestamp ? (now - hostTimestamp) / 1e9 : 0.0;
+}
+
+uint64_t SyntheticFrameSource::nowNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void SyntheticFrameSource::buildDescriptions()
+{
+    const int rigidBodyCount = m_config.rigidBodyCount;
+    const int skeletonCount = m_config.skeletonCount;
+    const int markerCount = m_config.markersPerRigidBody;
+
+    // Sized up front: the descriptions hold pointers into these vectors
+    m_rigidBodyDescriptions.assign(static_cast<size_t>(rigidBodyCount), sRigidBodyDescription());
+    m_skeletonDescriptions.assign(static_cast<size_t>(skeletonCount), sSkeletonDescription());
+    m_markerPositions.assign(static_cast<size_t>(rigidBodyCount * markerCount * 3), 0.0f);
+
+    m_descriptions = std::make_unique<sDataDescriptions>();
+    std::memset(m_descriptions.get(), 0, sizeof(sDataDescriptions));
+
+    for (int i = 0; i < rigidBodyCount && m_descriptions->nDataDescriptions < MAX_MODELS; i++)
+    {
+        sRigidBodyDescription& rb = m_rigidBodyDescriptions[i];
+        std::memset(&rb, 0, sizeof(rb));
+        std::snprintf(rb.szName, MAX_NAMELENGTH, "RigidBody%d", i + 1);
+        rb.ID = i + 1;
+        rb.parentID = -1;
+        rb.offsetqw = 1.0f;
+
+        // Markers evenly spaced on a horizontal circle around the body
+        float* markers = m_markerPositions.data() + static_cast<size_t>(i * markerCount * 3);
+        for (int m = 0; m < markerCount; m++)
+        {
+            const double angle = 2.0 * kPi * m / markerCount;
+            markers[m * 3 + 0] = kMarkerRadius * static_cast<float>(std::cos(angle));
+            markers[m * 3 + 1] = 0.0f;
+            markers[m * 3 + 2] = kMarkerRadius * static_cast<float>(std::sin(angle));
+        }
+        rb.nMarkers = markerCount;
+        rb.MarkerPositions = markerCount > 0 ? reinterpret_cast<MarkerData*>(markers) : nullptr;
+
+        sDataDescription& description = m_descriptions->arrDataDescriptions[m_descriptions->nDataDescriptions++];
+        description.type = Descriptor_RigidBody;
+        description.Data.RigidBodyDescription = &rb;
+    }
+
+    for (int s = 0; s < skeletonCount && m_descriptions->nDataDescriptions < MAX_MODELS; s++)
+    {
+        sSkeletonDescription& skel = m_skeletonDescriptions[s];
+        std::memset(&skel, 0, sizeof(skel));
+        std::snprintf(skel.szName, MAX_NAMELENGTH, "Skeleton%d", s + 1);
+        skel.skeletonID = s + 1;
+        skel.nRigidBodies = m_config.bonesPerSkeleton;
+
+        // A single chain: each bone hangs off the previous one. Described with the
+        // IDs the bones are streamed with, so frames resolve against the descriptions
+        for (int b = 0; b < skel.nRigidBodies; b++)
+        {
+            sRigidBodyDescription& bone = skel.RigidBodies[b];
+            std::snprintf(bone.szName, MAX_NAMELENGTH, "Bone%d", b + 1);
+            bone.ID = boneId(skel.skeletonID, b);
+            bone.parentID = b == 0 ? -1 : boneId(skel.skeletonID, b - 1);
+            bone.offsety = b == 0 ? 0.0f : kBoneLength;
+            bone.offsetqw = 1.0f;
+        }
+
+        sDataDescription& description = m_descriptions->arrDataDescriptions[m_descriptions->nDataDescriptions++];
+        description.type = Descriptor_Skeleton;
+        description.Data.SkeletonDescription = &skel;
+    }
+}
+
+void SyntheticFrameSource::generateLoop()
+{
+    qDebug() << "Synthetic source: generator started";
+
+    using Clock = std::chrono::steady_clock;
+    const auto period = std::chrono::nanoseconds(1000000000LL / m_config.rateHz);
+    const auto start = Clock::now();
+
+    for (int32_t frameNumber = 1; m_generating.load(); frameNumber++)
+    {
+        // Scheduled from the start so sleep overshoot does not accumulate
+        const auto due = start + period * frameNumber;
+        std::this_thread::sleep_until(due);
+
+        fillFrame(*m_frame, frameNumber);
+
+        // Exposure is the scheduled instant; transmit is when the frame actually leaves
+        m_frame->CameraMidExposureTimestamp = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(due.time_since_epoch()).count());
+        m_frame->CameraDataReceivedTimestamp = m_frame->CameraMidExposureTimestamp;
+        m_frame->TransmitTimestamp = nowNs();
+
+        stageFrameData(m_frame.get());
+    }
+
+    qDebug() << "Synthetic source: generator stopped";
+}
+
+void SyntheticFrameSource::fillFrame(sFrameOfMocapData& frame, int32_t frameNumber)
+{
+    const double t = static_cast<double>(frameNumber) / m_config.rateHz;
+
+    frame.iFrame = frameNumber;
+    frame.fTimestamp = t;
+    frame.params = 0;
+
+    // Rigid bodies circle the origin at different radii, heights and speeds
+    frame.nRigidBodies = m_config.rigidBodyCount;
+    frame.nLabeledMarkers = 0;
+    for (int i = 0; i < m_config.rigidBodyCount; i++)
+    {
+        const double radius = 1.0 + 0.1 * i;
+        const double angle = (0.5 + 0.05 * i) * 2.0 * kPi * t;
+
+        sRigidBodyData& rb = frame.RigidBodies[i];
+        rb.ID = i + 1;
+        rb.x = static_cast<float>(radius * std::cos(angle));
+        rb.y = static_cast<float>(1.0 + 0.1 * std::sin(angle * 2.0));
+        rb.z = static_cast<float>(radius * std::sin(angle));
+        setYaw(rb, angle);
+        rb.MeanError = 0.0f;
+        rb.params = 0x01;   // Tracking valid
+
+        // Markers follow their body; the yaw is ignored, which is enough for load tests
+        const float* offsets = m_markerPositions.data() + static_cast<size_t>(i * m_config.markersPerRigidBody * 3);
+        for (int m = 0; m < m_config.markersPerRigidBody; m++)
+        {
+            sMarker& marker = frame.LabeledMarkers[frame.nLabeledMarkers++];
+            marker.ID = ((i + 1) << 16) | (m + 1);
+            marker.x = rb.x + offsets[m * 3 + 0];
+            marker.y = rb.y + offsets[m * 3 + 1];
+            marker.z = rb.z + offsets[m * 3 + 2];
+            marker.size = 0.014f;
+            marker.params = 0;
+            marker.residual = 0.0f;
+        }
+    }
+
+    // Skeletons walk a circle with their bone chain stacked upward and swaying
+    frame.nSkeletons = m_config.skeletonCount;
+    for (int s = 0; s < m_config.skeletonCount; s++)
+    {
+        sSkeletonData& skel = frame.Skeletons[s];
+        skel.skeletonID = s + 1;
+        skel.nRigidBodies = m_config.bonesPerSkeleton;
+        skel.RigidBodyData = m_boneData.data() + static_cast<size_t>(s * m_config.bonesPerSkeleton);
+
+        const double angle = 0.25 * 2.0 * kPi * t + 2.0 * kPi * s / std::max(m_config.skeletonCount, 1);
+        const double radius = 2.0 + 0.5 * s;
+        const float rootX = static_cast<float>(radius * std::cos(angle));
+        const float rootZ = static_cast<float>(radius * std::sin(angle));
+
+        for (int b = 0; b < skel.nRigidBodies; b++)
+        {
+            const double sway = 0.02 * std::sin(2.0 * kPi * (t + 0.05 * b));
+
+            sRigidBodyData& bone = skel.RigidBodyData[b];
+            bone.ID = boneId(skel.skeletonID, b);
+            bone.x = rootX + static_cast<float>(sway);
+            bone.y = 0.9f + kBoneLength * b;
+            bone.z = rootZ;
+            setYaw(bone, angle);
+            bone.MeanError = 0.0f;
+            bone.params = 0x01;
+        }
+    }
+
+    frame.nOtherMarkers = 0;
+    frame.OtherMarkers = nullptr;
+    frame.nMarkerSets = 0;
+    frame.nAssets = 0;
+    frame.nForcePlates = 0;
+    frame.nDevices = 0;
+}
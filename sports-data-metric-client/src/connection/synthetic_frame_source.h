@@ -0,0 +1,110 @@
+// Deterministic frame source that synthesizes motion capture data without Motive.
+//
+// A generator thread emits frames at a fixed rate, paced on the steady clock,
+// with a configurable number of rigid bodies, skeletons and bones. Every pose
+// is a pure function of the frame number, so two runs with the same settings
+// produce identical streams; data descriptions matching the generated assets
+// are published on connect. Used to exercise and profile the pipeline on hosts
+// without the NatNet SDK.
+
+#pragma once
+
+#include "frame_source.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Shape and rate of the synthetic stream.
+ */
+struct SyntheticConfig {
+    int rateHz = 240;                   // Frames per second, clamped to [kMinRateHz, kMaxRateHz]
+    int rigidBodyCount = 4;             // Rigid bodies per frame
+    int skeletonCount = 1;              // Skeletons per frame
+    int bonesPerSkeleton = 21;          // Bones of each skeleton, chained root to tip
+    int markersPerRigidBody = 4;        // Labeled markers streamed around each rigid body
+
+    static constexpr int kMinRateHz = 120;
+    static constexpr int kMaxRateHz = 2000;
+};
+
+class SyntheticFrameSource : public FrameSource {
+public:
+    /**
+     * @brief Constructs a synthetic source publishing into @p frames.
+     * @param frames History shared by every source.
+     */
+    explicit SyntheticFrameSource(FrameRingBuffer<FrameData>& frames);
+
+    /**
+     * @brief Stops the generator if it is still running.
+     */
+    ~SyntheticFrameSource() override;
+
+    /**
+     * @brief Sets the rate and asset counts used from the next connect().
+     *
+     * Values are clamped to the rate range and the NatNet frame limits.
+     * @param config Requested stream shape.
+     */
+    void setConfig(const SyntheticConfig& config);
+
+    /**
+     * @brief Publishes the data descriptions and starts the generator thread.
+     * @return True once the generator runs.
+     */
+    bool connect() override;
+
+    /**
+     * @brief Stops the generator thread and the ingest worker.
+     * @return True once the generator is stopped.
+     */
+    bool disconnect() override;
+
+    /**
+     * @brief Gets the descriptions of the generated assets.
+     * @return The data descriptions, or nullptr before the first connect().
+     */
+    sDataDescriptions* getDataDescriptions() override;
+
+protected:
+    /**
+     * @brief Seconds since a steady clock timestamp in nanoseconds.
+     */
+    double secondsSinceHostTimestamp(uint64_t hostTimestamp) const override;
+
+private:
+    /**
+     * @brief Builds the rigid body and skeleton descriptions for the current config.
+     */
+    void buildDescriptions();
+
+    /**
+     * @brief Generator loop: fills and stages one frame per period until stopped.
+     */
+    void generateLoop();
+
+    /**
+     * @brief Fills @p frame with the deterministic poses of frame @p frameNumber.
+     */
+    void fillFrame(sFrameOfMocapData& frame, int32_t frameNumber);
+
+    /**
+     * @brief Current steady clock time in nanoseconds, the host clock of this source.
+     */
+    static uint64_t nowNs();
+
+    SyntheticConfig m_config;                                       // Clamped stream shape
+
+    std::unique_ptr<sDataDescriptions> m_descriptions;              // Points into the storage below
+    std::vector<sRigidBodyDescription> m_rigidBodyDescriptions;     // One per rigid body
+    std::vector<sSkeletonDescription> m_skeletonDescriptions;       // One per skeleton, bones inline
+    std::vector<float> m_markerPositions;                           // Rigid body marker offsets, x y z per marker
+
+    std::unique_ptr<sFrameOfMocapData> m_frame;                     // Reused frame; too large for the stack
+    std::vector<sRigidBodyData> m_boneData;                         // Bone poses of all skeletons
+
+    std::thread m_generatorThread;                                  // Emits frames at the configured rate
+    std::atomic<bool> m_generating{false};                          // Cleared to stop the generator
+};
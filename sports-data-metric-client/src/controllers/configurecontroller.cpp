@@ -34,6 +34,8 @@ void ConfigureController::onAssetSelectionChange(int row, QString assetValue)
     {
     case 0: assetSettings.skeleton = assetValue; break;
     case 1: assetSettings.rigidBody = assetValue; break;
+    case 2: updateBatchAssets(); break;
+    case 3: assetSettings.drawSelectedOnly = (assetValue == "Selected Skeleton"); break;
     }
 
     emit assetSelected(assetSettings);
@@ -51,6 +53,7 @@ void ConfigureController::onSendAssets(const QMap<QString, int>& skeletons, cons
 
     addSkeletonAssets(skeletons);
     addRigidBodyAssets(rigidBodies);
+    addBatchAssets(skeletons, rigidBodies);
 }
 
 void ConfigureController::setupSportsWidgets()
@@ -78,6 +81,12 @@ void ConfigureController::setupSignalSlots()
             });
         };
     };
+
+    // Checking or unchecking a listed asset changes the batch
+    connect(assetWidgets->batchAssets, &QListWidget::itemChanged, this, [=]() {
+        updateBatchAssets();
+        emit assetSelected(assetSettings);
+    });
 }
 
 void ConfigureController::addSkeletonAssets(const QMap<QString, int>& skeletons)
@@ -93,3 +102,51 @@ void ConfigureController::addRigidBodyAssets(const QMap<QString, int>& rigidBodi
         assetWidgets->rigidBodyTypes->addItem(it.key());
     }
 }
+
+void ConfigureController::addBatchAssets(const QMap<QString, int>& skeletons, const QMap<QString, int>& rigidBodies)
+{
+    // Assets that stay in the scene keep their check state
+    QStringList checked = assetSettings.batchSkeletons + assetSettings.batchRigidBodies;
+
+    QSignalBlocker blocker(assetWidgets->batchAssets);
+    assetWidgets->batchAssets->clear();
+
+    auto addItems = [&](const QMap<QString, int>& assets, const QString& type) {
+        for (auto it = assets.constBegin(); it != assets.constEnd(); ++it) {
+            QListWidgetItem *item = new QListWidgetItem(it.key(), assetWidgets->batchAssets);
+            item->setData(Qt::UserRole, type);
+            item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+            item->setCheckState(checked.contains(it.key()) ? Qt::Checked : Qt::Unchecked);
+        }
+    };
+    addItems(skeletons, "skeleton");
+    addItems(rigidBodies, "rigidBody");
+
+    updateBatchAssets();
+}
+
+void ConfigureController::updateBatchAssets()
+{
+    const QString scope = assetWidgets->metricScopes->currentText();
+    const bool listed = (scope == "Listed Assets");
+    assetWidgets->batchAssets->setVisible(listed);
+
+    // The checked assets are kept whatever the scope, so switching back to "Listed Assets" restores them
+    assetSettings.batchScope = listed ? AssetSettings::BatchScope::Listed : AssetSettings::BatchScope::All;
+    assetSettings.batchSkeletons.clear();
+    assetSettings.batchRigidBodies.clear();
+    for (int i = 0; i < assetWidgets->batchAssets->count(); ++i) {
+        QListWidgetItem *item = assetWidgets->batchAssets->item(i);
+        if (item->checkState() != Qt::Checked) {
+            continue;
+        }
+        if (item->data(Qt::UserRole).toString() == "skeleton") {
+            assetSettings.batchSkeletons.append(item->text());
+        } else {
+            assetSettings.batchRigidBodies.append(item->text());
+        }
+    }
+
+    const bool anyListed = !assetSettings.batchSkeletons.isEmpty() || !assetSettings.batchRigidBodies.isEmpty();
+    assetSettings.batchMetrics = (scope == "All Assets") || (listed && anyListed);
+}
@@ -18,8 +18,18 @@
 #pragma once
 
 struct AssetSettings {
+    enum class BatchScope {
+        All,        // Every asset of the frame
+        Listed      // Only the listed assets; an empty list means none of that kind
+    };
+
     QString skeleton;
     QString rigidBody;
+    bool batchMetrics = false;      // Also compute metrics for a batch of assets, in parallel
+    BatchScope batchScope = BatchScope::All;    // Which assets the batch covers
+    QStringList batchSkeletons;     // Skeletons checked for a listed batch
+    QStringList batchRigidBodies;   // Rigid bodies checked for a listed batch
+    bool drawSelectedOnly = false;  // Draw only the selected skeleton in the 3D view
 };
 
 class ConfigureController : public QObject {
@@ -58,6 +68,8 @@ private:
     void setupSignalSlots();
     void addSkeletonAssets(const QMap<QString, int>& skeletons);
     void addRigidBodyAssets(const QMap<QString, int>& rigidBodies);
+    void addBatchAssets(const QMap<QString, int>& skeletons, const QMap<QString, int>& rigidBodies);
+    void updateBatchAssets();
 };
 
 #endif // CONFIGURECONTROLLER_H
@@ -1,19 +1,19 @@
 #include "metricscontroller.h"
 
-MetricController::MetricController(MetricWidgets *metricWidgets)
-    : m_metricWidgets(metricWidgets) {}
+MetricController::MetricController(MetricWidgets *metricWidgets, QVector<int> valueSlots)
+    : m_metricWidgets(metricWidgets), m_slots(valueSlots) {}
 
-void MetricController::addData(qreal id, QHash<QString, qreal> metrics)
+void MetricController::addData(qreal id, const MetricsData &metrics)
 {
     QVector<QLabel*> *dataLabels = m_metricWidgets->dataLabels;
     QVector<GraphWidget*> *metricGraphs = m_metricWidgets->metricGraphs;
 
     for (int i = 0; i < dataLabels->count(); ++i ) {
         QLabel* dataLabel = dataLabels->at(i);
-        QString key = dataLabel->objectName().remove("DataLabel");
+        int slot = m_slots.value(i, -1);
 
-        if (metrics.contains(key)) {
-            qreal value = metrics.value(key);
+        if (slot >= 0 && slot < metrics.count) {
+            qreal value = metrics.values[slot];
             dataLabel->setText(QString::number(value, 'f', 1) + " " + m_metricWidgets->units);
 
             GraphWidget* metricGraph = metricGraphs->at(i);
@@ -24,6 +24,37 @@ void MetricController::addData(qreal id, QHash<QString, qreal> metrics)
     }
 }
 
+void MetricController::setSeries(const std::vector<MetricsData> &series)
+{
+    QVector<QLabel*> *dataLabels = m_metricWidgets->dataLabels;
+    QVector<GraphWidget*> *metricGraphs = m_metricWidgets->metricGraphs;
+
+    for (int i = 0; i < dataLabels->count(); ++i ) {
+        int slot = m_slots.value(i, -1);
+        if (slot < 0) {
+            continue;
+        }
+
+        // Frames where the asset had no values leave a gap
+        QVector<qreal> ids, values;
+        for (const MetricsData &metrics : series) {
+            if (slot < metrics.count) {
+                ids.append(metrics.id);
+                values.append(metrics.values[slot]);
+            }
+        }
+
+        if (!values.isEmpty()) {
+            dataLabels->at(i)->setText(QString::number(values.last(), 'f', 1) + " " + m_metricWidgets->units);
+        }
+
+        GraphWidget* metricGraph = metricGraphs->at(i);
+        if (metricGraph) {
+            metricGraph->setData(ids, values);
+        }
+    }
+}
+
 MetricWidgets* MetricController::getMetricWidgets()
 {
     return m_metricWidgets;
@@ -9,20 +9,28 @@
 #include <QString>
 #include <QGroupBox>
 #include <QLabel>
-#include <QHash>
+#include <QVector>
+#include <vector>
 
 #include <uifactory.h>
+#include "metrics_data.h"
 
 class MetricController : public QObject {
     Q_OBJECT
 
 public:
-    MetricController(MetricWidgets *metricWidgets);
-    void addData(qreal id, QHash<QString, qreal> metrics);
+    /**
+     * @brief Constructs a controller showing metric values in @p metricWidgets.
+     * @param valueSlots MetricSchema slot shown by each data label, -1 for none.
+     */
+    MetricController(MetricWidgets *metricWidgets, QVector<int> valueSlots);
+    void addData(qreal id, const MetricsData &metrics);
+    void setSeries(const std::vector<MetricsData> &series);
     MetricWidgets *getMetricWidgets();
     QList<QVector<qreal>>getGraphData(int i);
 
 private:
     MetricWidgets *m_metricWidgets;
+    QVector<int> m_slots;   // Slot of each data label, bound when the sport is selected
 };
 #endif // METRICSCONTROLLER_H
@@ -5,6 +5,7 @@ MetricsManager::MetricsManager(QWidget* parent, QString managerType)
 {
     if (managerType == "rigidMetricsManager" || managerType == "bodyMetricsManager") {
         m_managerType = managerType;
+        m_rigidManager = managerType == "rigidMetricsManager";
     } else {
         qWarning() << "MetricsManager: Invalid manager type" << managerType;
         throw std::invalid_argument("Invalid manager type: " + managerType.toStdString());
@@ -16,7 +17,13 @@ void MetricsManager::addMetricController(const QString name, const QString units
     MetricWidgets *metricWidgets = uiFactory.createMetricWidgets(name, units, labels, descriptions, graphs);
     addGroupBoxToUI(m_parent, metricWidgets->groupBox);
 
-    MetricController* metricController = new MetricController(metricWidgets);
+    // Bind each label to its value slot once, rather than looking it up per frame
+    QVector<int> valueSlots;
+    for (const QString &label : labels) {
+        valueSlots.append(metricSchema.slotOf(label));
+    }
+
+    MetricController* metricController = new MetricController(metricWidgets, valueSlots);
     metricControllers.insert(metricWidgets->name, metricController);
 }
 
@@ -45,8 +52,10 @@ void MetricsManager::setMetricSettings(QJsonArray newMetricSettings)
     if (metricControllers.size() > 0) {
         deleteMetricControllers();
     }
+    deleteBatchWidgets();
 
     metricSettings = newMetricSettings;
+    metricSchema = MetricPlan::compile(metricSettings).schema();
 
     for (int i = 0; i < metricSettings.count(); ++i) {
         QJsonObject currentMetric = metricSettings[i].toObject();
@@ -75,14 +84,42 @@ void MetricsManager::setMetricSettings(QJsonArray newMetricSettings)
 
         addMetricController(name, units, labels, descriptions, graphs);
     }
+
+    setupBatchWidgets();
 }
 
 void MetricsManager::onMetricsComputed(MetricsData rigidBodyMetrics, MetricsData skeletonMetrics)
 {
-    if (m_managerType == "rigidMetricsManager") {
-        updateMetricControllers(rigidBodyMetrics.id, rigidBodyMetrics.metrics);
-    } else {
-        updateMetricControllers(skeletonMetrics.id, skeletonMetrics.metrics);
+    const MetricsData &metrics = m_rigidManager ? rigidBodyMetrics : skeletonMetrics;
+
+    // Values computed for another sport, or none at all
+    if (metrics.schemaVersion == 0 || metrics.schemaVersion != metricSchema.version()) {
+        return;
+    }
+
+    updateMetricControllers(metrics);
+}
+
+void MetricsManager::onTakeAnalyzed(TakeMetrics take)
+{
+    const std::vector<AssetSeries> &assets = m_rigidManager ? take.rigidBodies : take.skeletons;
+    const int selected = m_rigidManager ? take.selectedRigidBody : take.selectedSkeleton;
+    if (selected < 0) {
+        return;
+    }
+
+    // Keep only values computed for the current sport
+    const std::vector<MetricsData> &series = assets[static_cast<size_t>(selected)].frames;
+    std::vector<MetricsData> current;
+    current.reserve(series.size());
+    for (const MetricsData &metrics : series) {
+        if (metrics.schemaVersion != 0 && metrics.schemaVersion == metricSchema.version()) {
+            current.push_back(metrics);
+        }
+    }
+
+    for (auto it = metricControllers.begin(); it != metricControllers.end(); ++it) {
+        it.value()->setSeries(current);
     }
 }
 
@@ -95,9 +132,102 @@ void MetricsManager::onUpdatedMetricSettings(QJsonArray rigidMetricSettings, QJs
     }
 }
 
-void MetricsManager::updateMetricControllers(qreal id, QHash<QString, qreal> metrics)
+void MetricsManager::updateMetricControllers(const MetricsData &metrics)
 {
     for (auto it = metricControllers.begin(); it != metricControllers.end(); ++it) {
-        it.value()->addData(id, metrics);
+        it.value()->addData(metrics.id, metrics);
+    }
+}
+
+void MetricsManager::onMetricsBatchComputed(MetricsBatch batch)
+{
+    if (!batchWidgets || !batchWidgets->groupBox->isChecked()) {
+        return;
     }
+
+    // A batch arrives with every frame; the table only needs to keep up with the eye
+    if (batchRefresh.isValid() && batchRefresh.elapsed() < kBatchRefreshMs) {
+        return;
+    }
+    batchRefresh.start();
+
+    const std::vector<AssetMetrics> &assets = m_rigidManager ? batch.rigidBodies : batch.skeletons;
+    QTableWidget *table = batchWidgets->tableWidget;
+    const int columns = table->columnCount();
+
+    table->setRowCount(static_cast<int>(assets.size()));
+    for (int row = 0; row < static_cast<int>(assets.size()); ++row) {
+        const AssetMetrics &asset = assets[static_cast<size_t>(row)];
+        table->setVerticalHeaderItem(row, new QTableWidgetItem(assetNames.value(asset.assetId, QString::number(asset.assetId))));
+
+        // Values computed for another sport are not shown
+        const bool current = asset.metrics.schemaVersion != 0 && asset.metrics.schemaVersion == metricSchema.version();
+        for (int column = 0; column < columns; ++column) {
+            const int slot = column < asset.metrics.count ? column : -1;
+            QString text = (current && slot >= 0) ? QString::number(asset.metrics.values[slot], 'f', 2) : "-";
+
+            if (QTableWidgetItem *item = table->item(row, column)) {
+                item->setText(text);
+            } else {
+                table->setItem(row, column, new QTableWidgetItem(text));
+            }
+        }
+    }
+
+    // The slowest shard bounds the batch; the rest is dispatch and waiting on the pool
+    int assetCount = 0;
+    double slowestUs = 0.0;
+    for (const ShardTiming &shard : batch.shards) {
+        assetCount += shard.assets;
+        slowestUs = qMax(slowestUs, shard.computeUs);
+    }
+    batchWidgets->timingLabel->setText(QString("%1 assets in %2 shards, %3 us (slowest shard %4 us)")
+                                           .arg(assetCount)
+                                           .arg(batch.shards.size())
+                                           .arg(batch.wallUs, 0, 'f', 1)
+                                           .arg(slowestUs, 0, 'f', 1));
+}
+
+void MetricsManager::onSendAssets(const QMap<QString, int>& skeletons, const QMap<QString, int>& rigidBodies)
+{
+    const QMap<QString, int> &assets = m_rigidManager ? rigidBodies : skeletons;
+
+    assetNames.clear();
+    for (auto it = assets.constBegin(); it != assets.constEnd(); ++it) {
+        assetNames.insert(it.value(), it.key());
+    }
+}
+
+void MetricsManager::onAssetSelected(AssetSettings assetSettings)
+{
+    batchVisible = assetSettings.batchMetrics;
+    if (batchWidgets) {
+        batchWidgets->groupBox->setVisible(batchVisible);
+    }
+}
+
+void MetricsManager::setupBatchWidgets()
+{
+    // Columns follow the schema's slots, which is the order the values are stored in
+    QString title = m_rigidManager ? "Batch Rigid Body Metrics" : "Batch Skeleton Metrics";
+    batchWidgets = uiFactory.createBatchWidgets(title, metricSchema.labels());
+    batchWidgets->groupBox->setVisible(batchVisible);
+    addGroupBoxToUI(m_parent, batchWidgets->groupBox);
+    batchRefresh.invalidate();
+}
+
+void MetricsManager::deleteBatchWidgets()
+{
+    if (!batchWidgets) {
+        return;
+    }
+
+    if (QVBoxLayout *layout = qobject_cast<QVBoxLayout*>(m_parent->layout())) {
+        layout->removeWidget(batchWidgets->groupBox);
+    }
+    batchWidgets->groupBox->setParent(nullptr);
+    batchWidgets->groupBox->deleteLater();
+
+    delete batchWidgets;
+    batchWidgets = nullptr;
 }
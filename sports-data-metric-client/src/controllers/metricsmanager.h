@@ -6,11 +6,16 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QHash>
+#include <QElapsedTimer>
 
 #include "rigid_body_metrics.h"
 #include "skeleton_metrics.h"
+#include "metric_plan.h"
+#include "take_metrics.h"
+#include "metrics_batch.h"
 #include "metricscontroller.h"
 #include "uifactory.h"
+#include "configurecontroller.h"
 #include "toggles.h"
 #include "./src/utils/uiutils.h"
 
@@ -18,6 +23,8 @@ class MetricsManager : public QObject {
     Q_OBJECT
 
 public:
+    static constexpr int kBatchRefreshMs = 200;    // Batch table refresh interval; batches arrive every frame
+
     MetricsManager(QWidget* parent, QString type);
     void addMetricController(const QString name, const QString units, QVector<QString> labels, QVector<QString> descriptions, QVector<bool> graphs);
     void deleteMetricControllers();
@@ -25,17 +32,30 @@ public:
 
 public slots:
     void onMetricsComputed(MetricsData rigidBodyMetrics, MetricsData skeletonMetrics);
+    void onTakeAnalyzed(TakeMetrics take);
     void onUpdatedMetricSettings(QJsonArray rigidMetricSettings, QJsonArray bodyMetricSettings);
+    void onMetricsBatchComputed(MetricsBatch batch);
+    void onSendAssets(const QMap<QString, int>& skeletons, const QMap<QString, int>& rigidBodies);
+    void onAssetSelected(AssetSettings assetSettings);
 
 private:
-    void updateMetricControllers(qreal id, QHash<QString, qreal> metrics);
+    void updateMetricControllers(const MetricsData &metrics);
+    void setupBatchWidgets();
+    void deleteBatchWidgets();
 
     QWidget* m_parent;
     QString m_managerType;
+    bool m_rigidManager = false;    // Shows rigid body rather than skeleton metrics
 
     UiFactory uiFactory;
     QMap<QString, MetricController*> metricControllers;
     QJsonArray metricSettings;
+    MetricSchema metricSchema;  // Slots of the values computed for the current sport
+
+    BatchWidgets *batchWidgets = nullptr;   // Metrics of every asset in the batch
+    QHash<int, QString> assetNames;         // Names of the rigid bodies or skeletons, by ID
+    bool batchVisible = false;              // Metrics are computed for more than the selected asset
+    QElapsedTimer batchRefresh;             // Time since the batch table was last refreshed
 };
 
 #endif // METRICSMANAGER_H
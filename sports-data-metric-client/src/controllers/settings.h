@@ -8,6 +8,14 @@ struct ConnectionSettings {
     QString clientIP = "127.0.0.1";
     QString connectionType = "Multicast";
     QString namingConvention = "FBX";
+    int frameHistoryDepth = 14400;  // Frames kept for recording, ~60 s at 240 Hz
+    bool deliverEveryFrame = false; // Deliver every live frame instead of only the latest
+    int maxMarkersPerFrame = 256;   // Labeled and unlabeled markers each kept per frame; at most ~13 KB of markers per frame
+    bool nativeReceiver = false;        // Receive Multicast/Unicast with the built-in NatNet decoder even when the SDK is available
+    int syntheticRateHz = 240;          // Frame rate of the "Synthetic" connection type, 120-2000 Hz
+    int syntheticRigidBodies = 4;       // Rigid bodies generated per synthetic frame
+    int syntheticSkeletons = 1;         // Skeletons generated per synthetic frame
+    int syntheticBonesPerSkeleton = 21; // Bones of each synthetic skeleton
 };
 
 #endif // SETTINGS_H
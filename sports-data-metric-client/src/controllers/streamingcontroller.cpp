@@ -66,6 +66,9 @@ void StreamingController::onCommonTakeRunButtonClick()
 {
     if (commonTakeWidgets->runButton->isChecked()) {
         startRunButtonState(commonTakeWidgets->runButton);
+        commonTakeWidgets->analyzeButton->setEnabled(false);
+        commonTakeWidgets->replayTiming->setText("-");
+        runningTakeWidgets = commonTakeWidgets;
         emit runTake(isRecording);
     } else {
         resetTakeWidgetState(commonTakeWidgets);
@@ -78,6 +81,9 @@ void StreamingController::onSavedTakeRunButtonClick()
 {
     if (savedTakeWidgets->runButton->isChecked()) {
         startRunButtonState(savedTakeWidgets->runButton);
+        savedTakeWidgets->analyzeButton->setEnabled(false);
+        savedTakeWidgets->replayTiming->setText("-");
+        runningTakeWidgets = savedTakeWidgets;
         emit runTake(isRecording);
     } else {
         resetTakeWidgetState(savedTakeWidgets);
@@ -86,6 +92,11 @@ void StreamingController::onSavedTakeRunButtonClick()
     }
 }
 
+void StreamingController::onTakeAnalyzeButtonClick()
+{
+    emit analyzeTake();
+}
+
 void StreamingController::onConnectionStatus(bool isConnected)
 {
     if (isConnected) {
@@ -97,6 +108,38 @@ void StreamingController::onConnectionStatus(bool isConnected)
     }
 }
 
+void StreamingController::onStreamStats(StreamStats stats)
+{
+    connectionWidgets->droppedFrames->setText(QString("%1 (%2 gaps)").arg(stats.missingFrames).arg(stats.gaps));
+    connectionWidgets->outOfOrderFrames->setText(QString("%1 (%2 duplicates, %3 restarts)")
+        .arg(stats.outOfOrder).arg(stats.duplicates).arg(stats.discontinuities));
+
+    if (stats.totalLatency.samples > 0) {
+        connectionWidgets->latency->setText(QString("%1 / %2 / %3 ms")
+            .arg(stats.totalLatency.p50Ms, 0, 'f', 1)
+            .arg(stats.totalLatency.p99Ms, 0, 'f', 1)
+            .arg(stats.totalLatency.maxMs, 0, 'f', 1));
+    } else {
+        connectionWidgets->latency->setText("-");
+    }
+}
+
+void StreamingController::onReplayTiming(ReplayTimingStats timing)
+{
+    if (!runningTakeWidgets) {
+        return;
+    }
+
+    QString text = QString("%1 frames, %2 dropped").arg(timing.frames).arg(timing.droppedFrames);
+    if (timing.lateness.samples > 0) {
+        text += QString(", late %1 / %2 / %3 ms")
+            .arg(timing.lateness.p50Ms, 0, 'f', 1)
+            .arg(timing.lateness.p99Ms, 0, 'f', 1)
+            .arg(timing.lateness.maxMs, 0, 'f', 1);
+    }
+    runningTakeWidgets->replayTiming->setText(text);
+}
+
 void StreamingController::onCommonTakeReadyStatus(bool isReady)
 {
     if (isReady) {
@@ -198,6 +241,10 @@ void StreamingController::setupSignalSlots()
 
     // Connect savedTakeWidget's runButton clicked signal to onRunButtonClick Slot
     connect(savedTakeWidgets->runButton, &QPushButton::clicked, this, &StreamingController::onSavedTakeRunButtonClick);
+
+    // Connect both takeWidgets' analyzeButton clicked signals to onTakeAnalyzeButtonClick Slot
+    connect(commonTakeWidgets->analyzeButton, &QPushButton::clicked, this, &StreamingController::onTakeAnalyzeButtonClick);
+    connect(savedTakeWidgets->analyzeButton, &QPushButton::clicked, this, &StreamingController::onTakeAnalyzeButtonClick);
 }
 
 void StreamingController::populateSavedTakes()
@@ -215,11 +262,16 @@ void StreamingController::resetConnectionWidgetState()
     enableGroupBoxWidgets(savedTakeWidgets->groupBox, true);
     commonTakeWidgets->runButton->setEnabled(false);
     savedTakeWidgets->runButton->setEnabled(false);
+    commonTakeWidgets->analyzeButton->setEnabled(false);
+    savedTakeWidgets->analyzeButton->setEnabled(false);
 }
 
 void StreamingController::setConnectionWidgetRunState()
 {
     connectionWidgets->connectedStatus->setText("Yes");
+    connectionWidgets->droppedFrames->setText("-");
+    connectionWidgets->outOfOrderFrames->setText("-");
+    connectionWidgets->latency->setText("-");
     connectionWidgets->connectButton->setText("Disconnect");
     connectionSettingsTableWidget->setEnabled(false);
     enableGroupBoxWidgets(commonTakeWidgets->groupBox, false);
@@ -233,15 +285,18 @@ void StreamingController::resetTakeWidgetState(TakeWidgets *takeWidgets)
     takeWidgets->listWidget->setEnabled(true);
     takeWidgets->playSpeed->setEnabled(true);
     takeWidgets->runButton->setEnabled(false);
+    takeWidgets->analyzeButton->setEnabled(false);
 
     enableGroupBoxWidgets(connectionWidgets->groupBox, true);
 
     if (takeWidgets->name == "Common Takes") {
         enableGroupBoxWidgets(savedTakeWidgets->groupBox, true);
         savedTakeWidgets->runButton->setEnabled(false);
+        savedTakeWidgets->analyzeButton->setEnabled(false);
     } else if (takeWidgets->name == "Saved Takes") {
         enableGroupBoxWidgets(commonTakeWidgets->groupBox, true);
         commonTakeWidgets->runButton->setEnabled(false);
+        commonTakeWidgets->analyzeButton->setEnabled(false);
     }
 }
 
@@ -255,6 +310,7 @@ void StreamingController::setTakeWidgetRunState(TakeWidgets *takeWidgets)
 {
     takeWidgets->loadButton->setText("Unload");
     takeWidgets->runButton->setEnabled(true);
+    takeWidgets->analyzeButton->setEnabled(true);
     enableGroupBoxWidgets(connectionWidgets->groupBox, false);
 
     if (takeWidgets->name == "Common Takes") {
@@ -10,6 +10,8 @@
 #include <QGroupBox>
 
 #include "settings.h"
+#include "replay_scheduler.h"
+#include "stream_tracker.h"
 #include "uifactory.h"
 #include "toggles.h"
 #include "./src/utils/uiutils.h"
@@ -33,8 +35,11 @@ public slots:
     void onSavedTakeLoadButtonClick(bool isChecked, const QString fileName, const QString playSpeed);
     void onCommonTakeRunButtonClick();
     void onSavedTakeRunButtonClick();
+    void onTakeAnalyzeButtonClick();
 
     void onConnectionStatus(bool isConnected);
+    void onStreamStats(StreamStats stats);
+    void onReplayTiming(ReplayTimingStats timing);
     void onCommonTakeReadyStatus(bool isReady);
     void onSavedTakeReadyStatus(bool isReady);
     void onNewSavedTake();
@@ -47,6 +52,7 @@ signals:
     void loadSavedTake(const QString fileName, const QString playSpeed);
     void runTake(bool isRecording);
     void stopTake();
+    void analyzeTake();
 
 private:
     QWidget* m_parent;
@@ -55,6 +61,7 @@ private:
     ConnectionWidgets *connectionWidgets = nullptr;
     TakeWidgets *commonTakeWidgets = nullptr;
     TakeWidgets *savedTakeWidgets = nullptr;
+    TakeWidgets *runningTakeWidgets = nullptr;
     ConnectionSettings connectionSettings;
 
     bool isRecording = false;
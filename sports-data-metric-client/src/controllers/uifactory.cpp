@@ -17,12 +17,13 @@ ConnectionWidgets* UiFactory::createConnectionWidgets(const QString name, Connec
 
     // Update tableWidget Settings
     connectionWidgets->tableWidget->setColumnCount(1);
-    connectionWidgets->tableWidget->setRowCount(5);
+    connectionWidgets->tableWidget->setRowCount(8);
     connectionWidgets->tableWidget->horizontalHeader()->setVisible(false);
     connectionWidgets->tableWidget->verticalHeader()->setVisible(true);
     connectionWidgets->tableWidget->horizontalHeader()->setStretchLastSection(true);
     connectionWidgets->tableWidget->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
-    connectionWidgets->tableWidget->setVerticalHeaderLabels({"Server IP:", "Client IP:", "Connection Type:", "Naming Convention:", "Connected:"});
+    connectionWidgets->tableWidget->setVerticalHeaderLabels({"Server IP:", "Client IP:", "Connection Type:", "Naming Convention:", "Connected:",
+                                                           "Dropped Frames:", "Out of Order:", "Latency p50/p99/max:"});
     connectionWidgets->tableWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
     connectionWidgets->tableWidget->setSelectionMode(QAbstractItemView::NoSelection);
     connectionWidgets->tableWidget->setEditTriggers(QAbstractItemView::EditTrigger::AllEditTriggers);
@@ -30,13 +31,17 @@ ConnectionWidgets* UiFactory::createConnectionWidgets(const QString name, Connec
     // Update connectionWidgets Settings
     connectionWidgets->serverIP->setText(connectionSettings.serverIP);
     connectionWidgets->clientIP->setText(connectionSettings.clientIP);
-    connectionWidgets->connectionTypes->addItems({"Multicast", "Unicast"});
+    connectionWidgets->connectionTypes->addItems({"Multicast", "Unicast", "Synthetic"});
     connectionWidgets->connectionTypes->setProperty("flat", true);
     connectionWidgets->namingConventions->addItems({"Motive", "FBX", "BVH", "UnrealEngine"});
     connectionWidgets->namingConventions->setCurrentIndex(1);
     connectionWidgets->namingConventions->setProperty("flat", true);
     connectionWidgets->connectedStatus->setText("No");
     connectionWidgets->connectedStatus->setFlags(connectionWidgets->connectedStatus->flags() & ~Qt::ItemIsEditable);
+    for (QTableWidgetItem* statsItem : {connectionWidgets->droppedFrames, connectionWidgets->outOfOrderFrames, connectionWidgets->latency}) {
+        statsItem->setText("-");
+        statsItem->setFlags(statsItem->flags() & ~Qt::ItemIsEditable);
+    }
     connectionWidgets->connectButton->setCheckable(true);
     connectionWidgets->connectButton->setText("Connect");
     connectionWidgets->connectButton->setProperty("connect", true);
@@ -47,6 +52,9 @@ ConnectionWidgets* UiFactory::createConnectionWidgets(const QString name, Connec
     connectionWidgets->tableWidget->setCellWidget(2, 0, connectionWidgets->connectionTypes);
     connectionWidgets->tableWidget->setCellWidget(3, 0, connectionWidgets->namingConventions);
     connectionWidgets->tableWidget->setItem(4, 0, connectionWidgets->connectedStatus);
+    connectionWidgets->tableWidget->setItem(5, 0, connectionWidgets->droppedFrames);
+    connectionWidgets->tableWidget->setItem(6, 0, connectionWidgets->outOfOrderFrames);
+    connectionWidgets->tableWidget->setItem(7, 0, connectionWidgets->latency);
 
     // Add widgets into layout
     layout->addWidget(connectionWidgets->tableWidget, 0);
@@ -80,7 +88,8 @@ TakeWidgets* UiFactory::createTakeWidgets(const QString name)
     takeWidgets->groupBox->setCheckable(true);
 
     // Update takeWidgets Settings
-    takeWidgets->playSpeed->addItems({"100%", "50%", "25%", "12.5%", "10%", "5%"});
+    takeWidgets->playSpeed->addItems({"Max", "1000%", "500%", "200%", "100%", "50%", "25%", "12.5%", "10%"});
+    takeWidgets->playSpeed->setCurrentText("100%");
     takeWidgets->playSpeed->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
     takeWidgets->playSpeed->setProperty("simple", true);
     takeWidgets->loadButton->setText("Load");
@@ -90,6 +99,11 @@ TakeWidgets* UiFactory::createTakeWidgets(const QString name)
     takeWidgets->runButton->setCheckable(true);
     takeWidgets->runButton->setEnabled(false);
     takeWidgets->runButton->setProperty("connect", true);
+    takeWidgets->analyzeButton->setText("Analyze");
+    takeWidgets->analyzeButton->setEnabled(false);
+    takeWidgets->analyzeButton->setToolTip("Compute the metrics of every frame at once");
+    takeWidgets->replayTiming->setText("-");
+    takeWidgets->replayTiming->setToolTip("Frames replayed and dropped, and lateness p50/p99/max");
 
     // Add widgets into layout
     settingsLayout->addWidget(takeWidgets->playSpeed);
@@ -99,6 +113,8 @@ TakeWidgets* UiFactory::createTakeWidgets(const QString name)
     layout->addWidget(takeWidgets->listWidget);
     layout->addWidget(takeSettingsContainer);
     layout->addWidget(takeWidgets->runButton);
+    layout->addWidget(takeWidgets->analyzeButton);
+    layout->addWidget(takeWidgets->replayTiming);
 
     // Set groupBox layout
     takeWidgets->groupBox->setLayout(layout);
@@ -147,12 +163,12 @@ AssetWidgets* UiFactory::createAssetWidgets(const QString name)
 
     // Update tableWidget Settings
     assetWidgets->tableWidget->setColumnCount(1);
-    assetWidgets->tableWidget->setRowCount(2);
+    assetWidgets->tableWidget->setRowCount(4);
     assetWidgets->tableWidget->horizontalHeader()->setVisible(false);
     assetWidgets->tableWidget->verticalHeader()->setVisible(true);
     assetWidgets->tableWidget->horizontalHeader()->setStretchLastSection(true);
     assetWidgets->tableWidget->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
-    assetWidgets->tableWidget->setVerticalHeaderLabels({"Skeleton:", "Bat:"});
+    assetWidgets->tableWidget->setVerticalHeaderLabels({"Skeleton:", "Bat:", "Metrics:", "Draw:"});
     assetWidgets->tableWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
     assetWidgets->tableWidget->setSelectionMode(QAbstractItemView::NoSelection);
     assetWidgets->tableWidget->setEditTriggers(QAbstractItemView::EditTrigger::AllEditTriggers);
@@ -160,13 +176,24 @@ AssetWidgets* UiFactory::createAssetWidgets(const QString name)
     // Update assetWidgets Settings
     assetWidgets->skeletonTypes->setProperty("flat", true);
     assetWidgets->rigidBodyTypes->setProperty("flat", true);
+    assetWidgets->metricScopes->setProperty("flat", true);
+    assetWidgets->metricScopes->addItems({"Selected Assets", "All Assets", "Listed Assets"});
+    assetWidgets->drawScopes->setProperty("flat", true);
+    assetWidgets->drawScopes->addItems({"All Skeletons", "Selected Skeleton"});
 
     // Add connectionWidgets into tableWidget
     assetWidgets->tableWidget->setCellWidget(0, 0, assetWidgets->skeletonTypes);
     assetWidgets->tableWidget->setCellWidget(1, 0, assetWidgets->rigidBodyTypes);
+    assetWidgets->tableWidget->setCellWidget(2, 0, assetWidgets->metricScopes);
+    assetWidgets->tableWidget->setCellWidget(3, 0, assetWidgets->drawScopes);
+
+    // Assets to compute metrics for with "Listed Assets", filled in as assets arrive
+    assetWidgets->batchAssets->setSelectionMode(QAbstractItemView::NoSelection);
+    assetWidgets->batchAssets->setVisible(false);
 
     // Add widgets into layout
     layout->addWidget(assetWidgets->tableWidget, 0);
+    layout->addWidget(assetWidgets->batchAssets, 0);
 
     // Set groupBox layout
     assetWidgets->groupBox->setLayout(layout);
@@ -225,3 +252,41 @@ MetricWidgets* UiFactory::createMetricWidgets(const QString name, const QString
 
     return metricWidgets;
 }
+
+BatchWidgets* UiFactory::createBatchWidgets(const QString name, QStringList labels) {
+
+    // Create new batchWidgets structure & layout
+    BatchWidgets *batchWidgets = new BatchWidgets();
+    QVBoxLayout *layout = new QVBoxLayout();
+
+    // Set name
+    batchWidgets->name = name;
+
+    // Set groupBox Settings
+    batchWidgets->groupBox->setTitle(name);
+    batchWidgets->groupBox->setCheckable(true);
+
+    // Rows are added as batches arrive, one per asset
+    batchWidgets->tableWidget->setColumnCount(static_cast<int>(labels.size()));
+    batchWidgets->tableWidget->setHorizontalHeaderLabels(labels);
+    batchWidgets->tableWidget->horizontalHeader()->setVisible(true);
+    batchWidgets->tableWidget->verticalHeader()->setVisible(true);
+    batchWidgets->tableWidget->horizontalHeader()->setStretchLastSection(true);
+    batchWidgets->tableWidget->setSelectionMode(QAbstractItemView::NoSelection);
+    batchWidgets->tableWidget->setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+    batchWidgets->timingLabel->setText("-");
+    batchWidgets->timingLabel->setAlignment(Qt::AlignRight);
+
+    // Add widgets into layout
+    layout->addWidget(batchWidgets->tableWidget);
+    layout->addWidget(batchWidgets->timingLabel);
+
+    // Set groupBox layout
+    batchWidgets->groupBox->setLayout(layout);
+
+    // Shown while metrics are computed for more than the selected assets
+    batchWidgets->groupBox->setVisible(false);
+
+    return batchWidgets;
+}
@@ -25,6 +25,9 @@ struct ConnectionWidgets {
     QComboBox *connectionTypes = new QComboBox();
     QComboBox *namingConventions = new QComboBox();
     QTableWidgetItem *connectedStatus = new QTableWidgetItem();
+    QTableWidgetItem *droppedFrames = new QTableWidgetItem();
+    QTableWidgetItem *outOfOrderFrames = new QTableWidgetItem();
+    QTableWidgetItem *latency = new QTableWidgetItem();
     QPushButton *connectButton = new QPushButton();
 };
 
@@ -35,6 +38,8 @@ struct TakeWidgets {
     QComboBox *playSpeed = new QComboBox();
     QPushButton *loadButton = new QPushButton();
     QPushButton *runButton = new QPushButton();
+    QPushButton *analyzeButton = new QPushButton();
+    QLabel *replayTiming = new QLabel();
 };
 
 struct SportsWidgets {
@@ -49,6 +54,9 @@ struct AssetWidgets {
     QTableWidget *tableWidget = new QTableWidget();
     QComboBox *skeletonTypes = new QComboBox();
     QComboBox *rigidBodyTypes = new QComboBox();
+    QComboBox *metricScopes = new QComboBox();
+    QComboBox *drawScopes = new QComboBox();
+    QListWidget *batchAssets = new QListWidget();    // Assets checked for "Listed Assets" metrics
 };
 
 struct MetricWidgets {
@@ -60,6 +68,13 @@ struct MetricWidgets {
     QVector<GraphWidget*> *metricGraphs = new QVector<GraphWidget*>();
 };
 
+struct BatchWidgets {
+    QString name = QString();
+    QGroupBox *groupBox = new QGroupBox();
+    QTableWidget *tableWidget = new QTableWidget();     // One row per asset, one column per metric label
+    QLabel *timingLabel = new QLabel();                 // Shard timing of the latest batch
+};
+
 class UiFactory : public QObject {
     Q_OBJECT
 
@@ -70,6 +85,7 @@ public:
     SportsWidgets *createSportsWidgets(const QString name);
     AssetWidgets *createAssetWidgets(const QString name);
     MetricWidgets *createMetricWidgets(const QString name, const QString units, QVector<QString> labels, QVector<QString> descriptions, QVector<bool> graphs);
+    BatchWidgets *createBatchWidgets(const QString name, QStringList labels);
 };
 
 #endif // UIFACTORY_H
@@ -0,0 +1,78 @@
+#include "asset_slot_map.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// NatNet packs the skeleton ID into the upper 16 bits of the bone IDs of a frame
+constexpr int kBoneIdMask = 0xFFFF;
+
+} // namespace
+
+int AssetSlotMap::Table::add(int id)
+{
+    const int existing = find(id);
+    if (existing != -1) {
+        return existing;
+    }
+
+    const int slot = static_cast<int>(ids.size());
+    ids.push_back(id);
+
+    if (id >= 0 && id < kMaxDenseId) {
+        if (static_cast<size_t>(id) >= dense.size()) {
+            dense.resize(static_cast<size_t>(id) + 1, -1);
+        }
+        dense[static_cast<size_t>(id)] = slot;
+    } else {
+        sparse[id] = slot;
+    }
+
+    return slot;
+}
+
+int AssetSlotMap::Table::find(int id) const
+{
+    if (id >= 0 && id < kMaxDenseId) {
+        return static_cast<size_t>(id) < dense.size() ? dense[static_cast<size_t>(id)] : -1;
+    }
+
+    const auto it = sparse.find(id);
+    return it != sparse.end() ? it->second : -1;
+}
+
+void AssetSlotMap::setSkeletonBones(int slot, std::vector<int> boneIds)
+{
+    if (slot < 0) {
+        return;
+    }
+
+    for (int& id : boneIds) {
+        id &= kBoneIdMask;
+    }
+
+    if (static_cast<size_t>(slot) >= m_boneIds.size()) {
+        m_boneIds.resize(static_cast<size_t>(slot) + 1);
+    }
+    m_boneIds[static_cast<size_t>(slot)] = std::move(boneIds);
+}
+
+int AssetSlotMap::boneIndex(int skeletonSlot, int boneId) const
+{
+    if (skeletonSlot < 0 || static_cast<size_t>(skeletonSlot) >= m_boneIds.size() || boneId < 0) {
+        return -1;
+    }
+
+    const std::vector<int>& ids = m_boneIds[static_cast<size_t>(skeletonSlot)];
+    const auto it = std::find(ids.begin(), ids.end(), boneId & kBoneIdMask);
+    return it != ids.end() ? static_cast<int>(it - ids.begin()) : -1;
+}
+
+int AssetSlotMap::boneCount(int skeletonSlot) const
+{
+    if (skeletonSlot < 0 || static_cast<size_t>(skeletonSlot) >= m_boneIds.size()) {
+        return 0;
+    }
+    return static_cast<int>(m_boneIds[static_cast<size_t>(skeletonSlot)].size());
+}
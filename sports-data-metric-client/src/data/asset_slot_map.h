@@ -0,0 +1,96 @@
+// Dense mapping from Motive asset IDs to their slots in a frame.
+//
+// Built once per session from the data descriptions: the k-th described rigid
+// body occupies FrameData::rigidBodies[k], and the k-th described skeleton
+// FrameData::skeletons[k], in every frame decoded for that session, whatever
+// order Motive streams them in and whether or not it streams them at all.
+// Consumers look an asset up with a bounds check and an array read instead of
+// searching each frame, and the same slot refers to the same asset in the
+// previous frames of the history.
+//
+// It also records the order of each skeleton's bones, which Motive streams in
+// description order, so bone IDs can be resolved to SkeletonData::bones indices.
+
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+class AssetSlotMap {
+public:
+    /**
+     * @brief Assigns the next rigid body slot to @p id.
+     * @return The slot; the existing one if @p id was already added.
+     */
+    int addRigidBody(int id) { return m_rigidBodies.add(id); }
+
+    /**
+     * @brief Assigns the next skeleton slot to @p id.
+     * @return The slot; the existing one if @p id was already added.
+     */
+    int addSkeleton(int id) { return m_skeletons.add(id); }
+
+    /**
+     * @brief Slot of the rigid body with @p id, or -1 if it was not described.
+     */
+    int rigidBodySlot(int id) const { return m_rigidBodies.find(id); }
+
+    /**
+     * @brief Slot of the skeleton with @p id, or -1 if it was not described.
+     */
+    int skeletonSlot(int id) const { return m_skeletons.find(id); }
+
+    /**
+     * @brief ID of the rigid body in @p slot.
+     */
+    int rigidBodyId(int slot) const { return m_rigidBodies.ids[slot]; }
+
+    /**
+     * @brief ID of the skeleton in @p slot.
+     */
+    int skeletonId(int slot) const { return m_skeletons.ids[slot]; }
+
+    /**
+     * @brief Records the bone IDs of the skeleton in @p slot, in the order its bones are streamed.
+     */
+    void setSkeletonBones(int slot, std::vector<int> boneIds);
+
+    /**
+     * @brief Index in SkeletonData::bones of the bone with @p boneId, or -1 if the skeleton has no such bone.
+     *
+     * Frames carry bone IDs encoded as skeleton ID << 16 | bone ID; only the
+     * bone part is compared, so either form may be passed.
+     */
+    int boneIndex(int skeletonSlot, int boneId) const;
+
+    /**
+     * @brief Number of bones recorded for the skeleton in @p slot.
+     */
+    int boneCount(int skeletonSlot) const;
+
+    int rigidBodyCount() const { return static_cast<int>(m_rigidBodies.ids.size()); }
+    int skeletonCount() const { return static_cast<int>(m_skeletons.ids.size()); }
+
+private:
+    /**
+     * @brief ID to slot table of one asset type.
+     *
+     * Motive assigns small IDs, which index a flat array; larger or negative
+     * IDs fall back to a hash map.
+     */
+    struct Table {
+        static constexpr int kMaxDenseId = 4096;
+
+        std::vector<int> dense;                 // Slot by ID, -1 if none
+        std::unordered_map<int, int> sparse;    // Slot of IDs outside the dense range
+        std::vector<int> ids;                   // ID by slot
+
+        int add(int id);
+        int find(int id) const;
+    };
+
+    Table m_rigidBodies;
+    Table m_skeletons;
+    std::vector<std::vector<int>> m_boneIds;    // Bone IDs by skeleton slot, in stream order
+};
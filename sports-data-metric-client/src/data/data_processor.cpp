@@ -2,45 +2,47 @@
 #include <QCoreApplication>
 #include <QThread>
 #include <QTimer>
+#include <algorithm>
+#include <chrono>
 
 #include "data_processor.h"
 
 DataProcessor::DataProcessor(
-    const std::vector<FrameData>& frames,
+    const FrameRingBuffer<FrameData>& frames,
     QObject* parent
 )
     : QObject(parent),
       m_frames(frames)
 {
     skeletonMetrics = std::make_unique<SkeletonMetrics>(this);
+
+    // The data thread computes one shard itself; together they use every core
+    m_metricsPool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
 }
 
 
-void DataProcessor::onFramesUpdated(const FrameData& signalFrame) 
+void DataProcessor::onFramesUpdated(FramePtr signalFrame)
 {
-    qDebug() << "DataProcessor: New frames signal received";
-
-    // Ensure there are enough frames to compute velocity and acceleration
-    if (!(m_previousFrame && m_secondPreviousFrame)) {
-        
-        qDebug() << "Not enough frames to compute metrics.";
+    // Resolves the skeleton metrics' bones once per session
+    skeletonMetrics->setSlotMap(signalFrame->slotMap);
 
-        m_secondPreviousFrame = m_previousFrame;
-        m_previousFrame = signalFrame; 
-
-        return;
-    }
+    // Record the poses velocity and acceleration are estimated from; the frame itself is not kept
+    rigidBodyMetrics.pushFrame(*signalFrame);
 
     // Compute rigid body metrics
-    MetricsData rbMetrics = rigidBodyMetrics.computeMetricsForFrame(signalFrame, *m_previousFrame, *m_secondPreviousFrame);
+    MetricsData rbMetrics = rigidBodyMetrics.computeMetricsForFrame(*signalFrame);
 
     // Compute skeleton metrics
-    MetricsData skelMetrics =  skeletonMetrics->computeMetricsForFrame(signalFrame);
+    MetricsData skelMetrics =  skeletonMetrics->computeMetricsForFrame(*signalFrame);
+
+    m_rigidBodyStatistics.add(rbMetrics);
+    m_skeletonStatistics.add(skelMetrics);
 
     emit metricsComputed(rbMetrics, skelMetrics);
 
-    m_secondPreviousFrame = m_previousFrame;
-    m_previousFrame = signalFrame; 
+    if (m_assetSettings.batchMetrics) {
+        emit metricsBatchComputed(computeMetricsBatch(*signalFrame));
+    }
 }
 
 void DataProcessor::receiveMaps(const std::unordered_map<int, std::string>& rigidBodies,
@@ -56,6 +58,8 @@ void DataProcessor::receiveMaps(const std::unordered_map<int, std::string>& rigi
             skeletonMetrics->setBoneMap(bones);
             skeletonMetrics->createInverseMaps();
 
+            resolveBatchAssets();
+
             qDebug() << "DataProcessor: maps set";
 
 
@@ -71,6 +75,193 @@ void DataProcessor::receiveAssets(AssetSettings assetSettings)
 
     QString rigidBodyAsset = assetSettings.rigidBody;
     rigidBodyMetrics.setAsset(rigidBodyAsset);
+
+    // Statistics describe one asset each
+    if (skeletonAsset != m_assetSettings.skeleton) {
+        m_skeletonStatistics.reset();
+    }
+    if (rigidBodyAsset != m_assetSettings.rigidBody) {
+        m_rigidBodyStatistics.reset();
+    }
+
+    m_assetSettings = assetSettings;
+    resolveBatchAssets();
+}
+
+void DataProcessor::resolveBatchAssets()
+{
+    m_batchRigidBodyIds.clear();
+    for (const QString& name : m_assetSettings.batchRigidBodies) {
+        const int id = rigidBodyMetrics.getRigidBodyNameToId().value(name, -1);
+        if (id != -1) {
+            m_batchRigidBodyIds.push_back(id);
+        }
+    }
+
+    m_batchSkeletonIds.clear();
+    for (const QString& name : m_assetSettings.batchSkeletons) {
+        const int id = skeletonMetrics->getSkeletonNameToId().value(name, -1);
+        if (id != -1) {
+            m_batchSkeletonIds.push_back(id);
+        }
+    }
+}
+
+MetricsBatch DataProcessor::computeMetricsBatch(const FrameData& current)
+{
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+
+    MetricsBatch batch;
+    batch.frameNumber = current.frameNumber;
+
+    // Every asset this frame carries data for, or only the listed ones
+    const bool allAssets = m_assetSettings.batchScope == AssetSettings::BatchScope::All;
+    if (allAssets) {
+        for (const RigidBodyData& rb : current.rigidBodies) {
+            if (rb.tracked) {
+                batch.rigidBodies.push_back(AssetMetrics{rb.id, MetricsData()});
+            }
+        }
+    } else {
+        for (int id : m_batchRigidBodyIds) {
+            batch.rigidBodies.push_back(AssetMetrics{id, MetricsData()});
+        }
+    }
+
+    if (allAssets) {
+        for (const SkeletonData& skeleton : current.skeletons) {
+            if (!skeleton.bones.empty()) {
+                batch.skeletons.push_back(AssetMetrics{skeleton.id, MetricsData()});
+            }
+        }
+    } else {
+        for (int id : m_batchSkeletonIds) {
+            batch.skeletons.push_back(AssetMetrics{id, MetricsData()});
+        }
+    }
+
+    const int rigidBodyCount = static_cast<int>(batch.rigidBodies.size());
+    const int assetCount = rigidBodyCount + static_cast<int>(batch.skeletons.size());
+    if (assetCount == 0) {
+        return batch;
+    }
+
+    // Contiguous shards of about equal estimated cost; each writes only its own entries, so no locking is needed
+    const double rigidBodyCost = rigidBodyCount * m_rigidBodyCostNs;
+    const double totalCost = rigidBodyCost + (assetCount - rigidBodyCount) * m_skeletonCostNs;
+    const int shardCount = std::clamp(static_cast<int>(totalCost / kMinShardCostNs), 1,
+                                      std::min(assetCount, m_metricsPool.maxThreadCount() + 1));
+    batch.shards.resize(static_cast<size_t>(shardCount));
+
+    // First asset of @p shard: rigid bodies come first, then the skeletons, each at its own cost
+    auto shardStart = [&](int shard) {
+        const double cost = totalCost * shard / shardCount;
+        const int index = cost <= rigidBodyCost
+            ? static_cast<int>(cost / m_rigidBodyCostNs + 0.5)
+            : rigidBodyCount + static_cast<int>((cost - rigidBodyCost) / m_skeletonCostNs + 0.5);
+        return shard == shardCount ? assetCount : std::min(index, assetCount);
+    };
+
+    auto computeShard = [&](int shard) {
+        const auto shardBegin = Clock::now();
+        const int first = shardStart(shard);
+        const int last = shardStart(shard + 1);
+        ShardTiming& timing = batch.shards[static_cast<size_t>(shard)];
+
+        // Each kind of asset is computed as one run, so the vector kernels see whole columns
+        const int rigidBodyFirst = std::min(first, rigidBodyCount);
+        const int rigidBodyLast = std::min(last, rigidBodyCount);
+        if (rigidBodyLast > rigidBodyFirst) {
+            rigidBodyMetrics.computeMetricsForAssets(batch.rigidBodies.data() + rigidBodyFirst,
+                                                     rigidBodyLast - rigidBodyFirst, current);
+        }
+        timing.rigidBodies = std::max(0, rigidBodyLast - rigidBodyFirst);
+        timing.rigidBodyUs = std::chrono::duration<double, std::micro>(Clock::now() - shardBegin).count();
+
+        const int skeletonFirst = std::max(first, rigidBodyCount) - rigidBodyCount;
+        const int skeletonLast = std::max(last, rigidBodyCount) - rigidBodyCount;
+        if (skeletonLast > skeletonFirst) {
+            skeletonMetrics->computeMetricsForAssets(batch.skeletons.data() + skeletonFirst,
+                                                     skeletonLast - skeletonFirst, current);
+        }
+
+        timing.assets = last - first;
+        timing.computeUs = std::chrono::duration<double, std::micro>(Clock::now() - shardBegin).count();
+    };
+
+    for (int shard = 1; shard < shardCount; ++shard) {
+        m_metricsPool.start([&computeShard, shard] { computeShard(shard); });
+    }
+    computeShard(0);
+    m_metricsPool.waitForDone();
+
+    // Refine the per-asset costs, slowly, so one preempted shard does not skew the split
+    double rigidBodyUs = 0.0;
+    double skeletonUs = 0.0;
+    for (const ShardTiming& timing : batch.shards) {
+        rigidBodyUs += timing.rigidBodyUs;
+        skeletonUs += timing.computeUs - timing.rigidBodyUs;
+    }
+    const int skeletonCount = assetCount - rigidBodyCount;
+    if (rigidBodyCount > 0) {
+        m_rigidBodyCostNs += kCostSmoothing * (rigidBodyUs * 1000.0 / rigidBodyCount - m_rigidBodyCostNs);
+    }
+    if (skeletonCount > 0) {
+        m_skeletonCostNs += kCostSmoothing * (skeletonUs * 1000.0 / skeletonCount - m_skeletonCostNs);
+    }
+
+    batch.wallUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    return batch;
+}
+
+void DataProcessor::analyzeTake(TakeFramesPtr frames)
+{
+    const int frameCount = frames ? frames->frameCount() : 0;
+
+    // The selected assets first, then the batch, each asset once
+    std::vector<int> rigidBodyIds;
+    std::vector<int> skeletonIds;
+    auto addAsset = [](std::vector<int>& ids, int id) {
+        if (id != -1 && std::find(ids.begin(), ids.end(), id) == ids.end()) {
+            ids.push_back(id);
+        }
+    };
+    addAsset(rigidBodyIds, rigidBodyMetrics.getRigidBodyNameToId().value(m_assetSettings.rigidBody, -1));
+    addAsset(skeletonIds, skeletonMetrics->getSkeletonNameToId().value(m_assetSettings.skeleton, -1));
+    const int selectedRigidBodies = static_cast<int>(rigidBodyIds.size());
+    const int selectedSkeletons = static_cast<int>(skeletonIds.size());
+
+    // Every asset of the take, unless the batch is narrowed to the listed ones
+    if (m_assetSettings.batchMetrics && m_assetSettings.batchScope == AssetSettings::BatchScope::Listed) {
+        for (int id : m_batchRigidBodyIds) {
+            addAsset(rigidBodyIds, id);
+        }
+        for (int id : m_batchSkeletonIds) {
+            addAsset(skeletonIds, id);
+        }
+    } else if (frameCount > 0) {
+        // A take's layout only grows, so the last frame's holds every asset of the take
+        const std::shared_ptr<const AssetSlotMap> layout = frames->frame(frameCount - 1)->slotMap;
+        for (int k = 0; layout && k < layout->rigidBodyCount(); ++k) {
+            addAsset(rigidBodyIds, layout->rigidBodyId(k));
+        }
+        for (int k = 0; layout && k < layout->skeletonCount(); ++k) {
+            addAsset(skeletonIds, layout->skeletonId(k));
+        }
+    }
+
+    const int chunks = std::clamp(frameCount / kMinFramesPerChunk, 1, m_metricsPool.maxThreadCount() + 1);
+    TakeMetrics take = frames ? TakeAnalyzer(rigidBodyMetrics, *skeletonMetrics, m_metricsPool)
+                                    .analyze(*frames, rigidBodyIds, skeletonIds, chunks)
+                              : TakeMetrics();
+    take.selectedRigidBody = selectedRigidBodies > 0 ? 0 : -1;
+    take.selectedSkeleton = selectedSkeletons > 0 ? 0 : -1;
+
+    qDebug() << "DataProcessor: analyzed" << frameCount << "frames of" << take.rigidBodies.size() << "rigid bodies and"
+             << take.skeletons.size() << "skeletons in" << take.chunks << "chunks," << take.wallUs / 1000.0 << "ms";
+
+    emit takeAnalyzed(take);
 }
 
 void DataProcessor::receiveNamingConvention(ConnectionSettings connectionSettings)
@@ -100,7 +291,16 @@ const std::unordered_map<int, std::unordered_map<int, std::string>>& DataProcess
     return skeletonMetrics->getBoneNameMap();
 }
 
-const std::vector<FrameData>& DataProcessor::getFrames()
+const FrameRingBuffer<FrameData>& DataProcessor::getFrames()
 {
     return m_frames;
-}
\ No newline at end of file
+}
+const MetricStatistics& DataProcessor::getRigidBodyStatistics() const
+{
+    return m_rigidBodyStatistics;
+}
+
+const MetricStatistics& DataProcessor::getSkeletonStatistics() const
+{
+    return m_skeletonStatistics;
+}
@@ -9,10 +9,16 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QStandardPaths>
+#include <QThreadPool>
 
 #include "skeleton_metrics.h"
 #include "rigid_body_metrics.h"
+#include "metrics_batch.h"
+#include "take_analyzer.h"
+#include "take_metrics.h"
+#include "metric_statistics.h"
 #include "frame_data.h"
+#include "frame_ring_buffer.h"
 #include "../controllers/streamingcontroller.h"
 #include "../controllers/configurecontroller.h"
 
@@ -21,7 +27,9 @@
  *
  * The DataProcessor coordinates rigid body and skeleton metric calculations.
  * It holds references to the current frame data and entity lookup tables,
- * and triggers metric computation when frames are updated.
+ * and triggers metric computation when frames are updated. Besides the
+ * selected assets, it can compute a batch of assets per frame, split into
+ * shards that run in parallel on a bounded worker pool.
  */
 class DataProcessor : public QObject {
     Q_OBJECT
@@ -34,7 +42,7 @@ public:
      * @param parent Optional parent QObject.
      */
     explicit DataProcessor(
-        const std::vector<FrameData>& frames,
+        const FrameRingBuffer<FrameData>& frames,
         QObject* parent = nullptr);  
 
 
@@ -64,8 +72,23 @@ public:
      * 
      * @return A reference to the frame history buffer.
      */
-    const std::vector<FrameData>& getFrames();
+    const FrameRingBuffer<FrameData>& getFrames();
 
+    /**
+     * @brief Running statistics of the selected rigid body's metrics.
+     *
+     * Reset when the asset selection changes. Safe to query from any thread
+     * through MetricStatistics::snapshot().
+     */
+    const MetricStatistics& getRigidBodyStatistics() const;
+
+    /**
+     * @brief Running statistics of the selected skeleton's metrics.
+     *
+     * Reset when the asset selection changes. Safe to query from any thread
+     * through MetricStatistics::snapshot().
+     */
+    const MetricStatistics& getSkeletonStatistics() const;
 
 public slots:
     /**
@@ -74,7 +97,7 @@ public slots:
      * Triggers computation of rigid body and skeleton metrics
      * for the latest frames.
      */
-    void onFramesUpdated(const FrameData& latestFrame);
+    void onFramesUpdated(FramePtr latestFrame);
 
     /**
      * @brief Slot to receive updated asset ID-to-name maps.
@@ -107,6 +130,19 @@ public slots:
      */
     void receiveNamingConvention(ConnectionSettings connectionSettings);
 
+    /**
+     * @brief Slot to compute every configured metric for every frame of a take at once.
+     *
+     * Computes the selected assets and every other asset of the take, or only
+     * the listed ones when the batch is narrowed to a list, with a TakeAnalyzer
+     * in parallel chunks on the worker pool. The live
+     * metrics and their statistics are left alone; the take's statistics come
+     * with its series.
+     *
+     * @param frames The frames of the take, read by each chunk as it needs them.
+     */
+    void analyzeTake(TakeFramesPtr frames);
+
     // void receiveTakeData(QVector<QVector<QPair<int, int>>> skeletonBones, int maxBones, int maxJoints);
 
 
@@ -118,6 +154,22 @@ signals:
      */
     void metricsComputed(MetricsData rigidBodyMetrics, MetricsData skeletonMetrics);
 
+    /**
+     * @brief Signal emitted with the metrics of every asset in the batch, once per frame.
+     *
+     * Only emitted while batch metrics are enabled in the asset settings.
+     *
+     * @param batch Metrics of each asset and the timing of each shard.
+     */
+    void metricsBatchComputed(MetricsBatch batch);
+
+    /**
+     * @brief Signal emitted with the metric time series of an analyzed take.
+     *
+     * @param take Metrics of the selected assets for every frame of the take.
+     */
+    void takeAnalyzed(TakeMetrics take);
+
     /**
      * @brief Signal emitted when rigid body and skeleton name-ID maps are ready.
      *
@@ -128,12 +180,41 @@ signals:
                      const QMap<QString, int>& rigidBodies);
 
 private:
+    /**
+     * @brief Computes the metrics of every asset in the batch for @p current.
+     *
+     * Assets are split into contiguous shards of about equal estimated cost, a
+     * skeleton weighing more than a rigid body as the sport's metrics make it;
+     * the calling thread computes the first and the pool the others, and the
+     * call returns once all are done. The shard timings refine the estimates.
+     */
+    MetricsBatch computeMetricsBatch(const FrameData& current);
+
+    /**
+     * @brief Resolves the batch asset names to IDs with the current name maps.
+     */
+    void resolveBatchAssets();
+
     std::unique_ptr<SkeletonMetrics> skeletonMetrics;         // Skeleton metric processor
     RigidBodyMetrics rigidBodyMetrics;                        // Rigid body metric processor
 
-    const std::vector<FrameData>& m_frames;     // Reference to frame history buffer
+    const FrameRingBuffer<FrameData>& m_frames;     // Reference to frame history buffer
+
+    MetricStatistics m_rigidBodyStatistics;         // Statistics of the selected rigid body's metrics
+    MetricStatistics m_skeletonStatistics;          // Statistics of the selected skeleton's metrics
+
+    static constexpr double kMinShardCostNs = 8000.0;   // About one pool hand-off (metrics_path_benchmark); a shard
+                                                        // is only split off for at least this much estimated work
+    static constexpr double kRigidBodyCostNs = 80.0;    // Initial estimates of the per-asset cost, from the same
+    static constexpr double kSkeletonCostNs = 100.0;    // benchmark; refined with the timings of every batch
+    static constexpr double kCostSmoothing = 0.05;      // Weight of each batch in the running cost estimates
+    static constexpr int kMinFramesPerChunk = 256;  // Shorter chunks spend too much of their time on halo frames
 
-    std::optional<FrameData> m_previousFrame;       // previous processed frame
-    std::optional<FrameData> m_secondPreviousFrame; // previous processed frame
+    QThreadPool m_metricsPool;              // Workers computing batch shards besides the data thread
+    AssetSettings m_assetSettings;          // Latest asset selection, including the batch
+    double m_rigidBodyCostNs = kRigidBodyCostNs;    // Running estimate of the batch cost of one rigid body
+    double m_skeletonCostNs = kSkeletonCostNs;      // Running estimate of the batch cost of one skeleton
+    std::vector<int> m_batchRigidBodyIds;   // Rigid bodies in a listed batch
+    std::vector<int> m_batchSkeletonIds;    // Skeletons in a listed batch
 };
 
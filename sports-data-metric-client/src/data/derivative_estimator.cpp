@@ -0,0 +1,82 @@
+#include "derivative_estimator.h"
+
+#include <algorithm>
+
+DerivativeEstimator::DerivativeEstimator(DerivativeMethod method, int window)
+    : m_method(method),
+      m_window(std::clamp(window | 1, kMinWindow, kMaxWindow))
+{
+    if (m_method != DerivativeMethod::SavitzkyGolay) {
+        return;
+    }
+
+    // Quadratic fit over offsets k = -m..m around the centre:
+    // first derivative  sum(k * x_k) / sum(k^2)
+    // second derivative 2 * sum((k^2 - c) * x_k) / sum((k^2 - c)^2), with c the mean of k^2
+    const int m = m_window / 2;
+    const double c = m * (m + 1) / 3.0;
+    double sumK2 = 0.0;
+    double sumQ2 = 0.0;
+    for (int k = -m; k <= m; ++k) {
+        sumK2 += k * k;
+        sumQ2 += (k * k - c) * (k * k - c);
+    }
+
+    m_firstWeights.resize(static_cast<size_t>(m_window));
+    m_secondWeights.resize(static_cast<size_t>(m_window));
+    for (int age = 0; age < m_window; ++age) {
+        const int k = m - age;
+        m_firstWeights[static_cast<size_t>(age)] = static_cast<float>(k / sumK2);
+        m_secondWeights[static_cast<size_t>(age)] = static_cast<float>(2.0 * (k * k - c) / sumQ2);
+    }
+}
+
+Derivatives DerivativeEstimator::estimate(const PoseRing& ring) const
+{
+    Derivatives result;
+    if (ring.size() < m_window) {
+        return result;
+    }
+
+    const int last = m_window - 1;
+    const PoseSample& newest = ring.at(0);
+    const PoseSample& oldest = ring.at(last);
+
+    if (m_method == DerivativeMethod::CentralDifference) {
+        const PoseSample& centre = ring.at(last / 2);
+        const double hAfter = newest.timestamp - centre.timestamp;
+        const double hBefore = centre.timestamp - oldest.timestamp;
+        if (hAfter <= 0.0 || hBefore <= 0.0) {
+            return result;
+        }
+
+        const float span = static_cast<float>(hAfter + hBefore);
+        const QVector3D slopeAfter = (newest.position - centre.position) / static_cast<float>(hAfter);
+        const QVector3D slopeBefore = (centre.position - oldest.position) / static_cast<float>(hBefore);
+
+        // Each slope weighted by the other interval: the slope of the parabola through the three samples
+        result.velocity = (slopeAfter * static_cast<float>(hBefore) + slopeBefore * static_cast<float>(hAfter)) / span;
+        result.acceleration = 2.0f * (slopeAfter - slopeBefore) / span;
+        result.valid = true;
+        return result;
+    }
+
+    // Savitzky–Golay assumes even spacing; use the mean spacing of the window
+    const double spacing = (newest.timestamp - oldest.timestamp) / last;
+    if (spacing <= 0.0) {
+        return result;
+    }
+
+    QVector3D first;
+    QVector3D second;
+    for (int age = 0; age < m_window; ++age) {
+        const QVector3D& position = ring.at(age).position;
+        first += m_firstWeights[static_cast<size_t>(age)] * position;
+        second += m_secondWeights[static_cast<size_t>(age)] * position;
+    }
+
+    result.velocity = first / static_cast<float>(spacing);
+    result.acceleration = second / static_cast<float>(spacing * spacing);
+    result.valid = true;
+    return result;
+}
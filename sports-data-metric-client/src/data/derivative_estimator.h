@@ -0,0 +1,66 @@
+// Velocity and acceleration of a rigid body from its recent poses.
+//
+// Both estimators evaluate the centre of the latest window of a PoseRing, so
+// their output lags the newest frame by half a window:
+// - Central difference: differences of the newest, centre and oldest samples,
+//   exact for uneven frame spacing. Cheap, but passes tracking noise through.
+// - Savitzky–Golay: derivatives of a quadratic least-squares fit over the whole
+//   window. Longer windows trade latency for smoother values.
+//
+// Structs:
+// - Derivatives: The estimated velocity and acceleration vectors.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <QVector3D>
+
+#include "pose_history.h"
+
+/**
+ * @brief How derivatives are estimated from a window of samples.
+ */
+enum class DerivativeMethod : uint8_t {
+    CentralDifference,
+    SavitzkyGolay
+};
+
+struct Derivatives {
+    QVector3D velocity;             // Units per second
+    QVector3D acceleration;         // Units per second squared
+    bool valid = false;             // False until the ring holds a full window of samples
+};
+
+class DerivativeEstimator {
+public:
+    static constexpr int kMinWindow = 3;
+    static constexpr int kMaxWindow = 63;
+
+    DerivativeEstimator() : DerivativeEstimator(DerivativeMethod::CentralDifference, kMinWindow) {}
+
+    /**
+     * @brief Creates an estimator over @p window samples.
+     *
+     * The window is made odd and clamped to [kMinWindow, kMaxWindow].
+     */
+    DerivativeEstimator(DerivativeMethod method, int window);
+
+    DerivativeMethod method() const { return m_method; }
+
+    /**
+     * @brief Samples the estimator reads from a ring.
+     */
+    int window() const { return m_window; }
+
+    /**
+     * @brief Estimates the derivatives at the centre of the newest window of @p ring.
+     */
+    Derivatives estimate(const PoseRing& ring) const;
+
+private:
+    DerivativeMethod m_method;
+    int m_window;
+    std::vector<float> m_firstWeights;  // Savitzky–Golay weights by age, for one unit of spacing
+    std::vector<float> m_secondWeights;
+};
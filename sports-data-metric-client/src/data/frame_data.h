@@ -3,23 +3,31 @@
 // Structs:
 // - RigidBodyData: Represents a single rigid body's position, orientation, and tracking state.
 // - SkeletonData: Represents a skeleton composed of multiple rigid bodies (bones).
-// - FrameData: Represents a full frame of motion capture data, containing all rigid bodies and skeletons.
+// - FrameData: Represents a full frame of motion capture data, containing all rigid bodies, skeletons and markers.
+//   Rigid bodies and skeletons are laid out by the session's AssetSlotMap, so an asset has the same index in every frame.
+// - FramePtr: Shared handle to an immutable FrameData, used to pass frames between threads without copying.
 // 
 // These structures are used for parsing, organizing, and accessing
 // real-time motion capture data streamed over the network.
 
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <string>
+#include <QMetaType>
 #include <QVector3D>
 #include <QQuaternion>
 
+#include "asset_slot_map.h"
+#include "marker_buffer.h"
+
 struct RigidBodyData {
     int id = -1;                    // Motive Rigid body ID
     int parentId = -1;              // ID of parent rigid body
     QVector3D position;             // X, Y, Z position
     QQuaternion orientation;        // Quaternion orientation (X, Y, Z, W)
+    bool tracked = true;            // False for a described rigid body Motive did not stream in this frame
 };
 
 struct SkeletonData {
@@ -32,4 +40,57 @@ struct FrameData {
     double timestamp = 0;
     std::vector<RigidBodyData> rigidBodies;     // Array of rigid bodies
     std::vector<SkeletonData> skeletons;        // Array of skeletons
+    MarkerBuffer labeledMarkers;                // Labeled markers, one array per attribute
+    MarkerBuffer unlabeledMarkers;              // Unlabeled markers; ID -1 and no size from pre-NatNet 3 servers
+    std::shared_ptr<const AssetSlotMap> slotMap; // Layout of rigidBodies and skeletons; null if they are in stream order
+
+    /**
+     * @brief Finds the rigid body with @p id in this frame.
+     * @return The rigid body, or nullptr if it is absent or was not tracked.
+     */
+    const RigidBodyData* findRigidBody(int id) const
+    {
+        if (slotMap) {
+            const int slot = slotMap->rigidBodySlot(id);
+            if (slot < 0 || static_cast<size_t>(slot) >= rigidBodies.size() || !rigidBodies[slot].tracked) {
+                return nullptr;
+            }
+            return &rigidBodies[slot];
+        }
+
+        for (const RigidBodyData& rb : rigidBodies) {
+            if (rb.id == id) {
+                return rb.tracked ? &rb : nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Finds the skeleton with @p id in this frame.
+     * @return The skeleton, or nullptr if it is absent. Skeletons that were not
+     *         streamed or not decoded are present without bones.
+     */
+    const SkeletonData* findSkeleton(int id) const
+    {
+        if (slotMap) {
+            const int slot = slotMap->skeletonSlot(id);
+            if (slot < 0 || static_cast<size_t>(slot) >= skeletons.size()) {
+                return nullptr;
+            }
+            return &skeletons[slot];
+        }
+
+        for (const SkeletonData& skeleton : skeletons) {
+            if (skeleton.id == id) {
+                return &skeleton;
+            }
+        }
+        return nullptr;
+    }
 };
+
+// Frames are never modified once published, so every receiver can share one copy
+using FramePtr = std::shared_ptr<const FrameData>;
+
+Q_DECLARE_METATYPE(FramePtr)
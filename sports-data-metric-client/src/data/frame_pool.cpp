@@ -0,0 +1,93 @@
+#include "frame_pool.h"
+
+#include <algorithm>
+#include <QMutexLocker>
+
+void FramePool::configure(const FrameLayout& layout, size_t poolSize)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_layout = layout;
+    m_frames.clear();
+    m_frames.reserve(poolSize);
+
+    for (size_t i = 0; i < poolSize; ++i) {
+        std::shared_ptr<FrameData> frame = std::make_shared<FrameData>();
+        reserveFrame(*frame, m_layout);
+        m_frames.push_back(std::move(frame));
+    }
+
+    m_next = 0;
+}
+
+std::shared_ptr<FrameData> FramePool::acquire()
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_acquired;
+
+    // Frames are released roughly in the order they were handed out, so the
+    // next frame in line is almost always free.
+    const size_t scan = std::min(kMaxScan, m_frames.size());
+    for (size_t i = 0; i < scan; ++i) {
+        std::shared_ptr<FrameData>& candidate = m_frames[m_next];
+        m_next = (m_next + 1) % m_frames.size();
+
+        if (candidate.use_count() == 1) {
+            // Pair with the release performed by the last reader dropping its handle
+            std::atomic_thread_fence(std::memory_order_acquire);
+            ++m_recycled;
+            return candidate;
+        }
+    }
+
+    ++m_exhausted;
+    std::shared_ptr<FrameData> frame = std::make_shared<FrameData>();
+    reserveFrame(*frame, m_layout);
+    return frame;
+}
+
+void FramePool::noteGrowth()
+{
+    m_grown.fetch_add(1, std::memory_order_relaxed);
+}
+
+FramePoolStats FramePool::getStats() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    FramePoolStats stats;
+    stats.acquired = m_acquired;
+    stats.recycled = m_recycled;
+    stats.exhausted = m_exhausted;
+    stats.grown = m_grown.load(std::memory_order_relaxed);
+    return stats;
+}
+
+size_t FramePool::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_frames.size();
+}
+
+FrameLayout FramePool::layout() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_layout;
+}
+
+void FramePool::reserveFrame(FrameData& frame, const FrameLayout& layout)
+{
+    frame.rigidBodies.reserve(static_cast<size_t>(layout.rigidBodyCount));
+
+    // Skeletons are kept constructed so their bone vectors keep their capacity
+    // when the frame is recycled; the decoder resizes within that capacity.
+    frame.skeletons.reserve(layout.skeletonBoneCounts.size());
+    frame.skeletons.resize(layout.skeletonBoneCounts.size());
+    for (size_t i = 0; i < layout.skeletonBoneCounts.size(); ++i) {
+        frame.skeletons[i].bones.reserve(static_cast<size_t>(layout.skeletonBoneCounts[i]));
+    }
+
+    // Unlabeled markers are reserved alike: they are mostly labeled markers that lost their label
+    frame.labeledMarkers.reserve(static_cast<size_t>(layout.markerCount));
+    frame.unlabeledMarkers.reserve(static_cast<size_t>(layout.markerCount));
+}
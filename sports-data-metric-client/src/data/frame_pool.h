@@ -0,0 +1,97 @@
+// Pool of preallocated FrameData objects recycled by the frame decode path.
+//
+// Frames are sized from the data descriptions (rigid body count and bone count
+// per skeleton), so decoding into a recycled frame only overwrites elements that
+// already exist and performs no heap allocation. A frame becomes free again once
+// every handle to it other than the pool's own has been released, e.g. after it
+// has been evicted from the frame history and all consumers are done with it.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <QMutex>
+
+#include "frame_data.h"
+
+/**
+ * @brief Shape of a frame as announced by the data descriptions.
+ */
+struct FrameLayout {
+    int rigidBodyCount = 0;                 // Number of rigid bodies streamed per frame
+    std::vector<int> skeletonBoneCounts;    // Bone count of each skeleton, in stream order
+    int markerCount = 0;                    // Markers of each kind expected per frame, from the marker set and rigid body descriptions
+};
+
+/**
+ * @brief Counters describing how well the pool covers the decode path.
+ *
+ * In steady state only acquired and recycled increase; exhausted and grown
+ * count the acquisitions and decodes that had to fall back to the heap.
+ */
+struct FramePoolStats {
+    uint64_t acquired = 0;      // Frames handed out
+    uint64_t recycled = 0;      // Frames served from the preallocated pool
+    uint64_t exhausted = 0;     // Acquisitions with no free frame (allocated a new one)
+    uint64_t grown = 0;         // Decodes that exceeded the preallocated capacity
+};
+
+class FramePool {
+public:
+    /**
+     * @brief Preallocates @p poolSize frames shaped after @p layout.
+     *
+     * Replaces any frames previously held by the pool; frames still referenced
+     * elsewhere stay valid and are simply no longer recycled.
+     */
+    void configure(const FrameLayout& layout, size_t poolSize);
+
+    /**
+     * @brief Returns a frame that no one else references, ready to be overwritten.
+     *
+     * Falls back to allocating a new frame when every pooled frame is in use.
+     */
+    std::shared_ptr<FrameData> acquire();
+
+    /**
+     * @brief Records that a decode had to grow a pooled frame's storage.
+     *
+     * Called by the decoder when an incoming frame is larger than the layout.
+     */
+    void noteGrowth();
+
+    /**
+     * @brief Returns a copy of the pool counters.
+     */
+    FramePoolStats getStats() const;
+
+    /**
+     * @brief Number of frames owned by the pool.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Layout the pooled frames were last configured for.
+     */
+    FrameLayout layout() const;
+
+private:
+    /**
+     * @brief Reserves the vectors of @p frame so that decoding @p layout never reallocates.
+     */
+    static void reserveFrame(FrameData& frame, const FrameLayout& layout);
+
+    static constexpr size_t kMaxScan = 32;  // Pooled frames inspected per acquire() before giving up
+
+    mutable QMutex m_mutex;                             // Guards the pool against reconfiguration
+    FrameLayout m_layout;                               // Layout the pooled frames are sized for
+    std::vector<std::shared_ptr<FrameData>> m_frames;   // Pooled frames
+    size_t m_next = 0;                                  // Next pooled frame to inspect
+
+    uint64_t m_acquired = 0;
+    uint64_t m_recycled = 0;
+    uint64_t m_exhausted = 0;
+    std::atomic<uint64_t> m_grown{0};
+};
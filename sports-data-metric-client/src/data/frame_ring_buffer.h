@@ -0,0 +1,466 @@
+// Fixed-capacity history of the most recent motion capture frames.
+//
+// One producer (the NatNet frame handler) publishes frames while any number of
+// readers take snapshots from other threads. Each slot holds a shared pointer to
+// an immutable frame, so a published frame is never rewritten in place: readers
+// either see the old frame or the new one. Memory use is bounded by the capacity.
+//
+// Nothing takes a lock. A slot is an atomic word packing the address of a
+// pooled node, which owns the frame and is stamped with its sequence, with the
+// number of readers copying the frame out of it. Publishing is one exchange of
+// that word; the node it replaces goes back to the pool once its last reader
+// has let go of it, on whichever thread that is. Readers copy a frame under
+// such a pin and check the stamp, so a snapshot drops the frames the producer
+// moved past while it was being taken. The producer only waits for a reader if
+// more than kSpareNodes readers are copying out of replaced slots at once.
+//
+// One slot more than the capacity is kept, so the slot being filled never
+// holds a retained frame.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <vector>
+
+template <typename T>
+class FrameRingBuffer {
+public:
+    using Pointer = std::shared_ptr<const T>;
+
+    static constexpr size_t kSpareNodes = 64;   // Nodes beyond the slots, for readers still copying out of replaced ones
+
+    /**
+     * @brief Immutable, ordered view of the frames held at the time it was taken.
+     *
+     * A snapshot keeps its frames alive on its own, so it stays valid after the
+     * producer has moved on and overwritten the slots it was taken from.
+     */
+    class Snapshot {
+    public:
+        class const_iterator {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const T*;
+            using reference = const T&;
+
+            const_iterator() = default;
+            explicit const_iterator(typename std::vector<Pointer>::const_iterator it) : m_it(it) {}
+
+            reference operator*() const { return **m_it; }
+            pointer operator->() const { return m_it->get(); }
+            reference operator[](difference_type n) const { return *m_it[n]; }
+
+            const_iterator& operator++() { ++m_it; return *this; }
+            const_iterator operator++(int) { const_iterator tmp = *this; ++m_it; return tmp; }
+            const_iterator& operator--() { --m_it; return *this; }
+            const_iterator operator--(int) { const_iterator tmp = *this; --m_it; return tmp; }
+            const_iterator& operator+=(difference_type n) { m_it += n; return *this; }
+            const_iterator& operator-=(difference_type n) { m_it -= n; return *this; }
+            const_iterator operator+(difference_type n) const { return const_iterator(m_it + n); }
+            const_iterator operator-(difference_type n) const { return const_iterator(m_it - n); }
+            difference_type operator-(const const_iterator& other) const { return m_it - other.m_it; }
+
+            bool operator==(const const_iterator& other) const { return m_it == other.m_it; }
+            bool operator!=(const const_iterator& other) const { return m_it != other.m_it; }
+            bool operator<(const const_iterator& other) const { return m_it < other.m_it; }
+
+        private:
+            typename std::vector<Pointer>::const_iterator m_it;
+        };
+
+        Snapshot() = default;
+        Snapshot(std::vector<Pointer> frames, uint64_t firstSequence, uint64_t generation)
+            : m_frames(std::move(frames)), m_firstSequence(firstSequence), m_generation(generation) {}
+
+        const_iterator begin() const { return const_iterator(m_frames.cbegin()); }
+        const_iterator end() const { return const_iterator(m_frames.cend()); }
+
+        size_t size() const { return m_frames.size(); }
+        bool empty() const { return m_frames.empty(); }
+
+        const T& operator[](size_t i) const { return *m_frames[i]; }
+        const T& front() const { return *m_frames.front(); }
+        const T& back() const { return *m_frames.back(); }
+
+        /**
+         * @brief Shared handle to the i-th frame, for passing it on without copying.
+         */
+        const Pointer& pointerAt(size_t i) const { return m_frames[i]; }
+
+        /**
+         * @brief Sequence number of the first frame in the snapshot.
+         *
+         * Sequence numbers count every frame ever pushed since the last reset,
+         * so consecutive snapshots can be stitched together or checked for gaps.
+         */
+        uint64_t firstSequence() const { return m_firstSequence; }
+
+        /**
+         * @brief Number of resets before the snapshot was taken.
+         *
+         * Sequence numbers restart at zero on reset, so they only compare
+         * between snapshots of the same generation.
+         */
+        uint64_t generation() const { return m_generation; }
+
+    private:
+        std::vector<Pointer> m_frames;
+        uint64_t m_firstSequence = 0;
+        uint64_t m_generation = 0;
+    };
+
+    /**
+     * @brief Constructs a ring buffer retaining at most @p capacity frames.
+     */
+    explicit FrameRingBuffer(size_t capacity = 1)
+    {
+        m_storage.store(new Storage(capacity, 0));
+    }
+
+    /**
+     * @brief Frees the frames; no reader may still be using the buffer.
+     */
+    ~FrameRingBuffer()
+    {
+        PinnedPointer<Storage>::release(m_storage.store(nullptr));
+    }
+
+    FrameRingBuffer(const FrameRingBuffer&) = delete;
+    FrameRingBuffer& operator=(const FrameRingBuffer&) = delete;
+
+    /**
+     * @brief Drops all frames and changes the number of frames retained.
+     *
+     * Must not race with push(); readers may keep using snapshots taken before.
+     */
+    void reset(size_t capacity)
+    {
+        Storage* const current = m_storage.owned();
+        PinnedPointer<Storage>::release(m_storage.store(new Storage(capacity, current->generation + 1)));
+    }
+
+    /**
+     * @brief Publishes a frame, evicting the oldest one once the buffer is full.
+     *
+     * Only one thread may call push() at a time.
+     */
+    void push(Pointer frame)
+    {
+        Storage& storage = *m_storage.owned();
+        const uint64_t sequence = storage.head.load(std::memory_order_relaxed);
+
+        Node* const node = storage.takeNode();
+        node->frame = std::move(frame);
+        node->sequence = sequence;
+        PinnedPointer<Node>::release(storage.ring[sequence % storage.slotCount].store(node));
+        storage.head.store(sequence + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copies a frame into a new immutable slot and publishes it.
+     */
+    void push(const T& frame)
+    {
+        push(std::make_shared<const T>(frame));
+    }
+
+    /**
+     * @brief Returns the most recently published frame, or nullptr if empty.
+     * @param sequence If given, receives the sequence of the returned frame.
+     */
+    Pointer latest(uint64_t* sequence = nullptr) const
+    {
+        const StoragePin storage(m_storage);
+        for (;;) {
+            const uint64_t head = storage->head.load(std::memory_order_acquire);
+            if (head == 0) {
+                return nullptr;
+            }
+            Pointer frame;
+            if (storage->read(head - 1, frame)) {
+                if (sequence) {
+                    *sequence = head - 1;
+                }
+                return frame;
+            }
+            // The producer lapped the whole ring since head was read; read the new head
+        }
+    }
+
+    /**
+     * @brief Takes a consistent, ordered snapshot of the retained frames.
+     *
+     * @param maxFrames Upper bound on the number of (most recent) frames returned.
+     * @return Frames from oldest to newest with no gaps or duplicates.
+     */
+    Snapshot snapshot(size_t maxFrames = SIZE_MAX) const
+    {
+        const StoragePin storage(m_storage);
+        const uint64_t head = storage->head.load(std::memory_order_acquire);
+        const uint64_t available = std::min<uint64_t>(head, storage->capacity);
+        const uint64_t count = std::min<uint64_t>(available, maxFrames);
+
+        return collect(*storage, head - count, head);
+    }
+
+    /**
+     * @brief Takes a snapshot of every retained frame with a sequence >= @p sequence.
+     *
+     * Frames that were already evicted are skipped; the returned snapshot's
+     * firstSequence() tells the caller how many were lost.
+     */
+    Snapshot snapshotSince(uint64_t sequence) const
+    {
+        const StoragePin storage(m_storage);
+        const uint64_t head = storage->head.load(std::memory_order_acquire);
+        const uint64_t oldest = head - std::min<uint64_t>(head, storage->capacity);
+
+        return collect(*storage, std::min(std::max(sequence, oldest), head), head);
+    }
+
+    /**
+     * @brief Number of frames currently retained.
+     */
+    size_t size() const
+    {
+        const StoragePin storage(m_storage);
+        return static_cast<size_t>(std::min<uint64_t>(storage->head.load(std::memory_order_acquire),
+                                                      storage->capacity));
+    }
+
+    /**
+     * @brief Maximum number of frames retained.
+     */
+    size_t capacity() const
+    {
+        const StoragePin storage(m_storage);
+        return storage->capacity;
+    }
+
+    /**
+     * @brief Total number of frames pushed since the last reset; the next frame's sequence.
+     */
+    uint64_t totalPushed() const
+    {
+        const StoragePin storage(m_storage);
+        return storage->head.load(std::memory_order_acquire);
+    }
+
+private:
+    /**
+     * @brief An atomic pointer that readers can pin, keeping what it points to alive while they use it.
+     *
+     * The word packs the pointer, shifted past kPinBits, with the number of
+     * readers that pinned it ("split reference counting"). A reader that finds
+     * the pointer replaced when it unpins moves its pin to the target's own
+     * count, and whoever drops that count to zero retires the target through
+     * Target::retire(). Only one thread may store(); any may pin().
+     */
+    template <typename Target>
+    class PinnedPointer {
+    public:
+        /**
+         * @brief Pins the current target, which may be nullptr. Each pin needs an unpin().
+         */
+        Target* pin() const
+        {
+            uint64_t word = m_word.load(std::memory_order_relaxed);
+            while (!m_word.compare_exchange_weak(word, word + 1, std::memory_order_acquire,
+                                                 std::memory_order_relaxed)) {
+            }
+            return targetOf(word);
+        }
+
+        void unpin(Target* target) const
+        {
+            uint64_t word = m_word.load(std::memory_order_relaxed);
+            while (targetOf(word) == target) {
+                if (m_word.compare_exchange_weak(word, word - 1, std::memory_order_release,
+                                                 std::memory_order_relaxed)) {
+                    return;
+                }
+            }
+            // store() moved our pin to the target's count; pins of no target are dropped
+            if (target && target->pins.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                Target::retire(target);
+            }
+        }
+
+        /**
+         * @brief Replaces the target, returning the old one with its pins; pass it to release().
+         */
+        uint64_t store(Target* target)
+        {
+            const uint64_t packed = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(target));
+            assert((packed >> (64 - kPinBits)) == 0 && "address does not fit beside the pin count");
+            return m_word.exchange(packed << kPinBits, std::memory_order_acq_rel);
+        }
+
+        /**
+         * @brief Retires the target of a word store() returned once its readers unpin it.
+         */
+        static void release(uint64_t word)
+        {
+            Target* const target = targetOf(word);
+            const int64_t pins = static_cast<int64_t>(word & kPinMask);
+            if (target && target->pins.fetch_add(pins, std::memory_order_acq_rel) + pins == 0) {
+                Target::retire(target);
+            }
+        }
+
+        /**
+         * @brief The current target, for the thread that stores.
+         */
+        Target* owned() const { return targetOf(m_word.load(std::memory_order_relaxed)); }
+
+    private:
+        static constexpr int kPinBits = 16;     // Readers pinning at once; user-space addresses fit in 48 bits
+        static constexpr uint64_t kPinMask = (uint64_t(1) << kPinBits) - 1;
+
+        static Target* targetOf(uint64_t word)
+        {
+            return reinterpret_cast<Target*>(static_cast<uintptr_t>(word >> kPinBits));
+        }
+
+        mutable std::atomic<uint64_t> m_word{0};
+
+        static_assert(std::atomic<uint64_t>::is_always_lock_free, "PinnedPointer needs lock-free 64-bit atomics");
+    };
+
+    struct Storage;
+
+    /**
+     * @brief A published frame and its sequence; recycled through its storage's free list.
+     */
+    struct Node {
+        Pointer frame;
+        uint64_t sequence = 0;
+        std::atomic<int64_t> pins{0};   // Pins left after the node was replaced in its slot
+        std::atomic<Node*> next{nullptr};
+        Storage* storage = nullptr;
+
+        static void retire(Node* node)
+        {
+            node->frame.reset();
+            node->pins.store(0, std::memory_order_relaxed);
+            node->storage->freeNode(node);
+        }
+    };
+
+    struct Storage {
+        Storage(size_t capacity, uint64_t generation)
+            : capacity(std::max<size_t>(capacity, 1)), slotCount(this->capacity + 1), generation(generation),
+              ring(new PinnedPointer<Node>[slotCount]), nodes(new Node[slotCount + kSpareNodes])
+        {
+            for (size_t i = 0; i < slotCount + kSpareNodes; ++i) {
+                nodes[i].storage = this;
+                freeNode(&nodes[i]);
+            }
+        }
+
+        /**
+         * @brief Copies out the frame of @p sequence; false if its slot has moved on to a later one.
+         */
+        bool read(uint64_t sequence, Pointer& frame) const
+        {
+            const PinnedPointer<Node>& slot = ring[sequence % slotCount];
+            Node* const node = slot.pin();
+            const bool current = node && node->sequence == sequence;
+            if (current) {
+                frame = node->frame;
+            }
+            slot.unpin(node);
+            return current;
+        }
+
+        /**
+         * @brief Pops a free node; only the producer takes nodes, so the list cannot suffer ABA.
+         */
+        Node* takeNode()
+        {
+            Node* node = freeList.load(std::memory_order_acquire);
+            for (;;) {
+                if (!node) {
+                    // More than kSpareNodes readers are copying out of replaced slots
+                    std::this_thread::yield();
+                    node = freeList.load(std::memory_order_acquire);
+                    continue;
+                }
+                if (freeList.compare_exchange_weak(node, node->next.load(std::memory_order_relaxed),
+                                                   std::memory_order_acquire, std::memory_order_acquire)) {
+                    return node;
+                }
+            }
+        }
+
+        void freeNode(Node* node)
+        {
+            Node* head = freeList.load(std::memory_order_relaxed);
+            do {
+                node->next.store(head, std::memory_order_relaxed);
+            } while (!freeList.compare_exchange_weak(head, node, std::memory_order_release,
+                                                     std::memory_order_relaxed));
+        }
+
+        static void retire(Storage* storage) { delete storage; }
+
+        const size_t capacity;                              // Frames retained; one slot fewer than allocated
+        const size_t slotCount;
+        std::atomic<uint64_t> head{0};                      // Sequence number of the next frame to be written
+        const uint64_t generation;                          // Resets before this storage replaced the previous one
+        std::atomic<int64_t> pins{0};                       // Pins left after reset() replaced the storage
+        std::unique_ptr<PinnedPointer<Node>[]> ring;        // Indexed by sequence % slotCount
+        std::unique_ptr<Node[]> nodes;                      // One per slot, and kSpareNodes more
+        std::atomic<Node*> freeList{nullptr};               // Nodes in no slot and pinned by no reader
+    };
+
+    /**
+     * @brief Keeps the current storage alive for the duration of a read.
+     */
+    class StoragePin {
+    public:
+        explicit StoragePin(const PinnedPointer<Storage>& pointer) : m_pointer(pointer), m_storage(pointer.pin()) {}
+        ~StoragePin() { m_pointer.unpin(m_storage); }
+
+        StoragePin(const StoragePin&) = delete;
+        StoragePin& operator=(const StoragePin&) = delete;
+
+        const Storage* operator->() const { return m_storage; }
+        const Storage& operator*() const { return *m_storage; }
+
+    private:
+        const PinnedPointer<Storage>& m_pointer;
+        Storage* const m_storage;
+    };
+
+    /**
+     * @brief Reads sequences [first, head) and discards any that the producer overwrote meanwhile.
+     */
+    static Snapshot collect(const Storage& storage, uint64_t first, uint64_t head)
+    {
+        std::vector<Pointer> frames;
+        frames.reserve(static_cast<size_t>(head - first));
+        for (uint64_t sequence = first; sequence < head; ++sequence) {
+            Pointer frame;
+            if (storage.read(sequence, frame)) {
+                frames.push_back(std::move(frame));
+            } else {
+                // Overwritten, and so is every frame before it
+                frames.clear();
+                first = sequence + 1;
+            }
+        }
+        return Snapshot(std::move(frames), first, storage.generation);
+    }
+
+    PinnedPointer<Storage> m_storage;   // Replaced on reset()
+};
@@ -0,0 +1,693 @@
+#include "json_take_parser.h"
+#include "take_json.h"
+
+#include <algorithm>
+#include <charconv>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string_view>
+#include <vector>
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QThread>
+#include <QThreadPool>
+
+namespace {
+
+constexpr size_t kRangeBytes = 1 << 20;     // Enough frames per range to outweigh handing it to a thread
+constexpr int kRangesPerThread = 2;         // Ranges parsed ahead of the one being handed out, per thread
+
+// Frames written by writeJsonTake() start with this key; other tools' frames may not
+constexpr std::string_view kFrameKey = "\"frameNumber\"";
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/**
+ * @brief Reads JSON values in place. Any failure leaves ok() false and makes later reads fail too.
+ *
+ * Values of an unexpected type read like QJsonValue's conversions: objects and
+ * arrays as empty, numbers as 0.
+ */
+class Cursor {
+public:
+    Cursor(const char* begin, const char* end)
+        : m_p(begin), m_end(end)
+    {}
+
+    bool ok() const { return m_ok; }
+    const char* position() const { return m_p; }
+    void setPosition(const char* p) { m_p = p; }
+
+    void skipSpace()
+    {
+        while (m_p < m_end && isSpace(*m_p)) {
+            ++m_p;
+        }
+    }
+
+    /**
+     * @brief Whether the next character after whitespace is @p c; does not consume it.
+     */
+    bool peek(char c)
+    {
+        skipSpace();
+        return m_p < m_end && *m_p == c;
+    }
+
+    bool expect(char c)
+    {
+        if (!peek(c)) {
+            return error();
+        }
+        ++m_p;
+        return true;
+    }
+
+    /**
+     * @brief Reads an object key and its colon. Escapes are kept as written.
+     */
+    bool key(std::string_view& out)
+    {
+        if (!peek('"')) {
+            return error();
+        }
+        const char* start = ++m_p;
+        if (!skipStringBody()) {
+            return false;
+        }
+        out = std::string_view(start, static_cast<size_t>(m_p - 1 - start));
+        return expect(':');
+    }
+
+    /**
+     * @brief Calls @p member(key) for every member of an object; it must read the value.
+     */
+    template <typename F>
+    bool members(F&& member)
+    {
+        if (!peek('{')) {
+            return skipValue();
+        }
+        ++m_p;
+        if (peek('}')) {
+            ++m_p;
+            return true;
+        }
+        for (;;) {
+            std::string_view name;
+            if (!key(name) || !member(name)) {
+                return error();
+            }
+            if (peek(',')) {
+                ++m_p;
+            } else {
+                return expect('}');
+            }
+        }
+    }
+
+    /**
+     * @brief Calls @p element() for every element of an array; it must read the value.
+     */
+    template <typename F>
+    bool elements(F&& element)
+    {
+        if (!peek('[')) {
+            return skipValue();
+        }
+        ++m_p;
+        if (peek(']')) {
+            ++m_p;
+            return true;
+        }
+        for (;;) {
+            if (!element()) {
+                return error();
+            }
+            if (peek(',')) {
+                ++m_p;
+            } else {
+                return expect(']');
+            }
+        }
+    }
+
+    bool number(double& out)
+    {
+        out = 0.0;
+        skipSpace();
+        if (m_p < m_end && (*m_p == '-' || (*m_p >= '0' && *m_p <= '9'))) {
+            const std::from_chars_result result = std::from_chars(m_p, m_end, out);
+            if (result.ec == std::errc::invalid_argument) {
+                return error();
+            }
+            m_p = result.ptr;
+            return true;
+        }
+        return skipValue();
+    }
+
+    bool integer(int& out)
+    {
+        double value;
+        if (!number(value)) {
+            return false;
+        }
+        out = static_cast<int>(value);
+        return true;
+    }
+
+    /**
+     * @brief Reads an array of numbers into @p out if it has exactly @p count of them.
+     */
+    bool floats(float* out, int count)
+    {
+        float values[4];
+        int n = 0;
+        const bool read = elements([&] {
+            double value;
+            if (!number(value)) {
+                return false;
+            }
+            if (n < count) {
+                values[n] = static_cast<float>(value);
+            }
+            ++n;
+            return true;
+        });
+        if (read && n == count) {
+            std::copy(values, values + count, out);
+        }
+        return read;
+    }
+
+    bool skipValue()
+    {
+        skipSpace();
+        if (m_p >= m_end) {
+            return error();
+        }
+
+        if (*m_p == '"') {
+            ++m_p;
+            return skipStringBody();
+        }
+
+        if (*m_p == '{' || *m_p == '[') {
+            // Only brackets and strings matter when skipping a container
+            int depth = 0;
+            while (m_p < m_end) {
+                const char c = *m_p++;
+                if (c == '"') {
+                    if (!skipStringBody()) {
+                        return false;
+                    }
+                } else if (c == '{' || c == '[') {
+                    ++depth;
+                } else if (c == '}' || c == ']') {
+                    if (--depth == 0) {
+                        return true;
+                    }
+                }
+            }
+            return error();
+        }
+
+        // Numbers, true, false and null run up to the next delimiter
+        const char* start = m_p;
+        while (m_p < m_end && !isSpace(*m_p) && *m_p != ',' && *m_p != '}' && *m_p != ']') {
+            ++m_p;
+        }
+        return m_p > start || error();
+    }
+
+private:
+    bool skipStringBody()
+    {
+        while (m_p < m_end) {
+            const char c = *m_p++;
+            if (c == '\\') {
+                ++m_p;
+            } else if (c == '"') {
+                return true;
+            }
+        }
+        return error();
+    }
+
+    bool error()
+    {
+        m_ok = false;
+        m_p = m_end;
+        return false;
+    }
+
+    const char* m_p;
+    const char* m_end;
+    bool m_ok = true;
+};
+
+bool parseBody(Cursor& cursor, RigidBodyData& body)
+{
+    // Missing members read as QJsonValue's defaults
+    body.id = 0;
+    body.parentId = 0;
+
+    return cursor.members([&](std::string_view name) {
+        if (name == "id") {
+            return cursor.integer(body.id);
+        }
+        if (name == "parentId") {
+            return cursor.integer(body.parentId);
+        }
+        if (name == "position") {
+            float p[3] = { 0.0f, 0.0f, 0.0f };
+            if (!cursor.floats(p, 3)) {
+                return false;
+            }
+            body.position = QVector3D(p[0], p[1], p[2]);
+            return true;
+        }
+        if (name == "orientation") {
+            float q[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            if (!cursor.floats(q, 4)) {
+                return false;
+            }
+            body.orientation = QQuaternion(q[3], q[0], q[1], q[2]);
+            return true;
+        }
+        return cursor.skipValue();
+    });
+}
+
+bool parseBodies(Cursor& cursor, std::vector<RigidBodyData>& bodies)
+{
+    return cursor.elements([&] {
+        bodies.emplace_back();
+        return parseBody(cursor, bodies.back());
+    });
+}
+
+bool parseFrame(Cursor& cursor, FrameData& frame)
+{
+    return cursor.members([&](std::string_view name) {
+        if (name == "frameNumber") {
+            return cursor.integer(frame.frameNumber);
+        }
+        if (name == "timestamp") {
+            return cursor.number(frame.timestamp);
+        }
+        if (name == "rigidBodies") {
+            return parseBodies(cursor, frame.rigidBodies);
+        }
+        if (name == "skeletons") {
+            return cursor.elements([&] {
+                frame.skeletons.emplace_back();
+                SkeletonData& skeleton = frame.skeletons.back();
+                skeleton.id = 0;
+                return cursor.members([&](std::string_view member) {
+                    if (member == "id") {
+                        return cursor.integer(skeleton.id);
+                    }
+                    if (member == "bones") {
+                        return parseBodies(cursor, skeleton.bones);
+                    }
+                    return cursor.skipValue();
+                });
+            });
+        }
+        return cursor.skipValue();
+    });
+}
+
+/**
+ * @brief Whether @p frame, with its assets in file order, has assets or skeleton bones @p slotMap lacks.
+ */
+bool hasNewAssets(const FrameData& frame, const AssetSlotMap& slotMap)
+{
+    for (const RigidBodyData& rb : frame.rigidBodies) {
+        if (slotMap.rigidBodySlot(rb.id) < 0) {
+            return true;
+        }
+    }
+    for (const SkeletonData& skeleton : frame.skeletons) {
+        const int slot = slotMap.skeletonSlot(skeleton.id);
+        if (slot < 0 || (slotMap.boneCount(slot) == 0 && !skeleton.bones.empty())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void addAssets(const FrameData& frame, AssetSlotMap& slotMap)
+{
+    for (const RigidBodyData& rb : frame.rigidBodies) {
+        slotMap.addRigidBody(rb.id);
+    }
+
+    for (const SkeletonData& skeleton : frame.skeletons) {
+        // The first frame carrying a skeleton's bones gives their order
+        const int skeletonSlot = slotMap.addSkeleton(skeleton.id);
+        if (slotMap.boneCount(skeletonSlot) == 0 && !skeleton.bones.empty()) {
+            std::vector<int> boneIds;
+            boneIds.reserve(skeleton.bones.size());
+            for (const RigidBodyData& bone : skeleton.bones) {
+                boneIds.push_back(bone.id);
+            }
+            slotMap.setSkeletonBones(skeletonSlot, std::move(boneIds));
+        }
+    }
+}
+
+/**
+ * @brief Moves the assets of @p frame from file order into the slots of @p slotMap, which holds them all.
+ */
+void layOutFrame(FrameData& frame, const AssetSlotMap& slotMap)
+{
+    // Rigid Bodies
+    std::vector<RigidBodyData> rigidBodies = std::move(frame.rigidBodies);
+    frame.rigidBodies.assign(static_cast<size_t>(slotMap.rigidBodyCount()), RigidBodyData());
+    for (int k = 0; k < slotMap.rigidBodyCount(); ++k) {
+        frame.rigidBodies[k].id = slotMap.rigidBodyId(k);
+        frame.rigidBodies[k].tracked = false;
+    }
+    for (const RigidBodyData& rb : rigidBodies) {
+        frame.rigidBodies[slotMap.rigidBodySlot(rb.id)] = rb;
+    }
+
+    // Skeletons
+    std::vector<SkeletonData> skeletons = std::move(frame.skeletons);
+    frame.skeletons.assign(static_cast<size_t>(slotMap.skeletonCount()), SkeletonData());
+    for (int k = 0; k < slotMap.skeletonCount(); ++k) {
+        frame.skeletons[k].id = slotMap.skeletonId(k);
+    }
+    for (SkeletonData& skeleton : skeletons) {
+        frame.skeletons[slotMap.skeletonSlot(skeleton.id)] = std::move(skeleton);
+    }
+}
+
+} // namespace
+
+struct JsonTakeParser::Range {
+    size_t begin = 0;                   // Offset of the first frame
+    size_t end = 0;                     // Offset of the first frame of the next range, or the array end
+    std::vector<FrameData> frames;      // Assets in file order
+    size_t parsedEnd = 0;               // Where parsing stopped; end if the range is well formed
+    bool ok = false;
+    bool done = false;                  // Guarded by parseFrames()' mutex
+};
+
+JsonTakeParser::~JsonTakeParser()
+{
+    close();
+}
+
+bool JsonTakeParser::open(const QString& path)
+{
+    close();
+    m_error.clear();
+    m_canceled.store(false, std::memory_order_relaxed);
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return fail(m_file.errorString());
+    }
+
+    m_size = static_cast<size_t>(m_file.size());
+    if (uchar* mapped = m_size > 0 ? m_file.map(0, m_file.size()) : nullptr) {
+        m_data = reinterpret_cast<const char*>(mapped);
+    } else {
+        // Files that cannot be mapped, such as compressed resources, are read whole
+        m_buffer = m_file.readAll();
+        m_data = m_buffer.constData();
+        m_size = static_cast<size_t>(m_buffer.size());
+    }
+
+    if (readRoot(true)) {
+        return true;
+    }
+
+    // The last frame was not where it was expected; skip the frames one by one
+    m_error.clear();
+    if (!readRoot(false)) {
+        return fail("Not a JSON take");
+    }
+    return true;
+}
+
+void JsonTakeParser::close()
+{
+    if (m_file.isOpen()) {
+        m_file.close();     // Also unmaps
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_buffer.clear();
+
+    m_header = TakeHeader();
+    m_framesBegin = 0;
+    m_framesEnd = 0;
+}
+
+bool JsonTakeParser::parseFrames(const FrameHandler& handler)
+{
+    if (!m_data) {
+        return fail("No take is open");
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount()));
+    const size_t window = static_cast<size_t>(pool.maxThreadCount() * kRangesPerThread);
+
+    // Ranges split at frame boundaries about kRangeBytes apart, found just
+    // ahead of the parsing. A deque keeps the ranges in flight where they are
+    // as more are added. An empty frames array is one empty range.
+    std::deque<Range> ranges;
+    std::mutex mutex;
+    std::condition_variable rangeDone;
+    auto submitNext = [&]() {
+        const size_t begin = ranges.empty() ? m_framesBegin : ranges.back().end;
+        if (!ranges.empty() && begin >= m_framesEnd) {
+            return;
+        }
+        ranges.emplace_back();
+        Range* range = &ranges.back();
+        range->begin = begin;
+        range->end = nextFrameStart(begin, begin + kRangeBytes);
+
+        pool.start([this, range, &mutex, &rangeDone] {
+            parseRange(*range);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                range->done = true;
+            }
+            rangeDone.notify_all();
+        });
+    };
+
+    for (size_t i = 0; i < window; ++i) {
+        submitNext();
+    }
+
+    auto slotMap = std::make_shared<AssetSlotMap>();
+    size_t frameCount = 0;
+    bool ok = true;
+    for (size_t i = 0; i < ranges.size() && ok; ++i) {
+        Range& range = ranges[i];
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            rangeDone.wait(lock, [&range] { return range.done; });
+        }
+        submitNext();
+
+        if (m_canceled.load(std::memory_order_relaxed)) {
+            ok = fail("Parsing was canceled");
+            break;
+        }
+        if (!range.ok || range.parsedEnd != range.end) {
+            ok = fail(QString("Malformed frame at byte %1").arg(static_cast<qulonglong>(range.parsedEnd)));
+            break;
+        }
+
+        // Laid out in file order, so slots match a sequential parse
+        QVector<FramePtr> batch;
+        batch.reserve(static_cast<qsizetype>(range.frames.size()));
+        for (FrameData& parsed : range.frames) {
+            if (hasNewAssets(parsed, *slotMap)) {
+                auto grown = std::make_shared<AssetSlotMap>(*slotMap);
+                addAssets(parsed, *grown);
+                slotMap = std::move(grown);
+            }
+
+            std::shared_ptr<FrameData> frame = std::make_shared<FrameData>(std::move(parsed));
+            layOutFrame(*frame, *slotMap);
+            frame->slotMap = slotMap;
+            batch.push_back(std::move(frame));
+        }
+        std::vector<FrameData>().swap(range.frames);
+
+        if (!batch.isEmpty()) {
+            frameCount += static_cast<size_t>(batch.size());
+            handler(std::move(batch));
+        }
+    }
+
+    if (!ok) {
+        pool.clear();
+    }
+    pool.waitForDone();
+
+    if (ok) {
+        qDebug() << "JsonTakeParser: parsed" << frameCount << "frames in" << ranges.size() << "ranges";
+    }
+    return ok;
+}
+
+bool JsonTakeParser::fail(const QString& error)
+{
+    // A more specific error may have been recorded on the way
+    m_error = m_error.isEmpty() ? error : error + ": " + m_error;
+    return false;
+}
+
+bool JsonTakeParser::readRoot(bool fromTail)
+{
+    Cursor cursor(m_data, m_data + m_size);
+    QJsonObject root;
+    bool hasFrames = false;
+
+    const bool read = cursor.members([&](std::string_view name) {
+        if (name == "frames") {
+            if (!cursor.peek('[')) {
+                m_error = "Frames are not an array";
+                return false;
+            }
+            m_framesBegin = static_cast<size_t>(cursor.position() - m_data) + 1;
+
+            const size_t end = fromTail ? framesEndFromTail() : 0;
+            if (end > 0) {
+                cursor.setPosition(m_data + end + 1);
+            } else if (!cursor.skipValue()) {
+                return false;
+            }
+            m_framesEnd = static_cast<size_t>(cursor.position() - m_data) - 1;
+            hasFrames = true;
+            return true;
+        }
+
+        if (name != "rigidBodies" && name != "skeletons" && name != "bones" && name != "glAssets") {
+            return cursor.skipValue();
+        }
+
+        // The header is small; let QJsonDocument have it
+        cursor.skipSpace();
+        const char* start = cursor.position();
+        if (!cursor.skipValue()) {
+            return false;
+        }
+        const QByteArray json = QByteArray::fromRawData(start, static_cast<qsizetype>(cursor.position() - start));
+        QJsonParseError parseError;
+        const QJsonDocument doc = QJsonDocument::fromJson(json, &parseError);
+        if (parseError.error != QJsonParseError::NoError) {
+            m_error = parseError.errorString();
+            return false;
+        }
+        root[QString::fromUtf8(name.data(), static_cast<qsizetype>(name.size()))] = doc.object();
+        return true;
+    });
+
+    cursor.skipSpace();
+    if (!read || !cursor.ok() || cursor.position() != m_data + m_size) {
+        return fail("Malformed JSON");
+    }
+    if (!hasFrames) {
+        return fail("No frames array");
+    }
+
+    m_header = takeHeaderFromJson(root);
+    return true;
+}
+
+size_t JsonTakeParser::framesEndFromTail() const
+{
+    // The last frame key of the file, unless one of the maps after the frames has such a string
+    const std::string_view text(m_data, m_size);
+    const size_t keyAt = text.rfind(kFrameKey);
+    if (keyAt == std::string_view::npos || keyAt <= m_framesBegin) {
+        return 0;
+    }
+
+    size_t frameStart = keyAt;
+    while (frameStart > m_framesBegin && isSpace(text[frameStart - 1])) {
+        --frameStart;
+    }
+    if (frameStart == m_framesBegin || text[frameStart - 1] != '{') {
+        return 0;
+    }
+    --frameStart;
+
+    // The frame must be followed by the end of the array; readRoot() checks the rest of the file
+    Cursor cursor(m_data + frameStart, m_data + m_size);
+    if (!cursor.skipValue() || !cursor.peek(']')) {
+        return 0;
+    }
+    return static_cast<size_t>(cursor.position() - m_data);
+}
+
+size_t JsonTakeParser::nextFrameStart(size_t frameStart, size_t offset) const
+{
+    // Step over whole frames from one known to start there. Only brackets and
+    // strings decide where a frame ends, so any keys in any order will do.
+    Cursor cursor(m_data + frameStart, m_data + m_framesEnd);
+    cursor.skipSpace();
+    while (cursor.position() < m_data + offset) {
+        // parseRange() reports malformed frames; the range just runs to the array end
+        if (!cursor.skipValue() || !cursor.peek(',')) {
+            return m_framesEnd;
+        }
+        cursor.setPosition(cursor.position() + 1);
+        cursor.skipSpace();
+    }
+    return static_cast<size_t>(cursor.position() - m_data);
+}
+
+void JsonTakeParser::parseRange(Range& range) const
+{
+    Cursor cursor(m_data + range.begin, m_data + m_framesEnd);
+    const char* end = m_data + range.end;
+
+    range.ok = true;
+    cursor.skipSpace();
+    while (cursor.position() < end) {
+        if (m_canceled.load(std::memory_order_relaxed)) {
+            break;
+        }
+
+        range.frames.emplace_back();
+        if (!parseFrame(cursor, range.frames.back())) {
+            range.ok = false;
+            break;
+        }
+
+        // A comma, then the next frame; the last frame of the array has none
+        if (cursor.peek(',')) {
+            cursor.setPosition(cursor.position() + 1);
+            cursor.skipSpace();
+            if (cursor.position() == m_data + m_framesEnd) {
+                range.ok = false;
+                break;
+            }
+        } else if (cursor.position() != m_data + m_framesEnd) {
+            range.ok = false;
+            break;
+        }
+    }
+
+    range.parsedEnd = static_cast<size_t>(cursor.position() - m_data);
+}
@@ -0,0 +1,108 @@
+// Streams the frames of JSON takes (see take_json.h) without building a DOM.
+//
+// open() maps the file and reads the ID-to-name maps and glAssets around the
+// "frames" array, which is only located. parseFrames() splits the array at frame
+// boundaries into ranges of about a megabyte, parses the ranges on a thread pool
+// straight into FrameData and hands them out in file order, each as soon as it
+// and the ones before it are done. Memory beyond the mapping is the decoded
+// frames plus the few ranges in flight.
+//
+// Frames are laid out by an AssetSlotMap in order of first appearance, like
+// TakeReader's. Handed-out frames may be read on other threads while parsing
+// continues, so the map is copied rather than changed when a frame brings new
+// assets: every map is a prefix of the next, and the last frame's map holds
+// every asset of the take.
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+#include "frame_data.h"
+#include "take_format.h"
+
+class JsonTakeParser {
+public:
+    /**
+     * @brief Receives the frames of one range, in file order.
+     */
+    using FrameHandler = std::function<void(QVector<FramePtr>)>;
+
+    JsonTakeParser() = default;
+    ~JsonTakeParser();
+
+    JsonTakeParser(const JsonTakeParser&) = delete;
+    JsonTakeParser& operator=(const JsonTakeParser&) = delete;
+
+    /**
+     * @brief Maps the take at @p path and reads everything but its frames.
+     * @return False if it cannot be read or is not a JSON take; see errorString().
+     */
+    bool open(const QString& path);
+
+    /**
+     * @brief Unmaps the take; frames already handed out stay valid.
+     */
+    void close();
+
+    QString errorString() const { return m_error; }
+
+    /**
+     * @brief The ID-to-name maps and rendering assets of the take.
+     */
+    const TakeHeader& header() const { return m_header; }
+
+    /**
+     * @brief Parses every frame, calling @p handler on this thread with each range's frames.
+     * @return False if a frame is malformed or cancel() was called; frames handed out so far stay valid.
+     */
+    bool parseFrames(const FrameHandler& handler);
+
+    /**
+     * @brief Stops a parseFrames() in progress at its next range. Thread safe.
+     */
+    void cancel() { m_canceled.store(true, std::memory_order_relaxed); }
+
+private:
+    struct Range;
+
+    bool fail(const QString& error);
+
+    /**
+     * @brief Reads the members of the root object; the frames array is skipped.
+     * @param fromTail Find the end of the frames array from the end of the file rather than by skipping it.
+     */
+    bool readRoot(bool fromTail);
+
+    /**
+     * @brief Offset of the "]" closing the frames array, found from the last frame; 0 if it cannot be.
+     */
+    size_t framesEndFromTail() const;
+
+    /**
+     * @brief Offset of the first frame that starts at or after @p offset; the array end if there is none.
+     * @param frameStart Offset of a frame before @p offset, from which the frames are stepped over.
+     */
+    size_t nextFrameStart(size_t frameStart, size_t offset) const;
+
+    /**
+     * @brief Parses the frames of @p range into it.
+     */
+    void parseRange(Range& range) const;
+
+    QFile m_file;
+    const char* m_data = nullptr;       // The mapped file, or m_buffer if it cannot be mapped
+    size_t m_size = 0;
+    QByteArray m_buffer;
+
+    QString m_error;
+    TakeHeader m_header;
+    size_t m_framesBegin = 0;           // Just past the "[" of the frames array
+    size_t m_framesEnd = 0;             // At its "]"
+    std::atomic<bool> m_canceled{false};
+};
@@ -0,0 +1,39 @@
+#include "marker_buffer.h"
+
+void MarkerBuffer::reserve(size_t count)
+{
+    const size_t paddedCount = padded(count);
+    m_x.reserve(paddedCount);
+    m_y.reserve(paddedCount);
+    m_z.reserve(paddedCount);
+    m_sizes.reserve(paddedCount);
+    m_ids.reserve(paddedCount);
+    m_params.reserve(paddedCount);
+}
+
+void MarkerBuffer::resize(size_t count)
+{
+    const size_t paddedCount = padded(count);
+    m_x.resize(paddedCount);
+    m_y.resize(paddedCount);
+    m_z.resize(paddedCount);
+    m_sizes.resize(paddedCount);
+    m_ids.resize(paddedCount);
+    m_params.resize(paddedCount);
+
+    m_count = count;
+    for (size_t i = count; i < paddedCount; ++i) {
+        set(i, -1, 0.0f, 0.0f, 0.0f, 0.0f, 0);
+    }
+}
+
+void MarkerBuffer::clear()
+{
+    resize(0);
+    m_truncated = 0;
+}
+
+size_t MarkerBuffer::memoryBytes() const
+{
+    return capacity() * (4 * sizeof(float) + sizeof(int32_t) + sizeof(int16_t));
+}
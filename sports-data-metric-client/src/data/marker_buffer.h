@@ -0,0 +1,144 @@
+// Structure-of-arrays storage for the markers of one motion capture frame.
+//
+// Each marker attribute lives in its own contiguous, 32-byte aligned array so
+// that per-axis loops over all markers vectorize cleanly. The arrays are padded
+// with inert markers up to a multiple of kLaneWidth, letting kernels process
+// whole SIMD lanes without a scalar tail. Buffers are reused across frames:
+// resizing within the reserved capacity never allocates.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+#include <QVector3D>
+
+/**
+ * @brief Minimal allocator returning storage aligned to @p Alignment bytes.
+ */
+template <typename T, size_t Alignment>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* p, size_t)
+    {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+class MarkerBuffer {
+public:
+    static constexpr size_t kAlignment = 32;    // Byte alignment of every attribute array (one AVX register)
+    static constexpr size_t kLaneWidth = 8;     // Arrays are padded to a multiple of this many floats
+
+    template <typename T>
+    using AlignedVector = std::vector<T, AlignedAllocator<T, kAlignment>>;
+
+    /**
+     * @brief Reserves room for @p count markers so later resizes within it do not allocate.
+     */
+    void reserve(size_t count);
+
+    /**
+     * @brief Sets the number of markers, keeping existing storage when it is large enough.
+     *
+     * Existing values are left unspecified and must be overwritten with set(); the
+     * padding past @p count is reset to inert markers.
+     */
+    void resize(size_t count);
+
+    /**
+     * @brief Removes all markers; keeps the storage for reuse.
+     */
+    void clear();
+
+    /**
+     * @brief Overwrites the marker at index @p i.
+     */
+    void set(size_t i, int32_t id, float x, float y, float z, float size, int16_t params)
+    {
+        m_ids[i] = id;
+        m_x[i] = x;
+        m_y[i] = y;
+        m_z[i] = z;
+        m_sizes[i] = size;
+        m_params[i] = params;
+    }
+
+    /**
+     * @brief Number of valid markers.
+     */
+    size_t size() const { return m_count; }
+
+    /**
+     * @brief Number of elements in each attribute array, including padding; a multiple of kLaneWidth.
+     */
+    size_t paddedSize() const { return m_x.size(); }
+
+    /**
+     * @brief Number of markers the buffer can hold without allocating.
+     */
+    size_t capacity() const { return m_x.capacity(); }
+
+    bool empty() const { return m_count == 0; }
+
+    // Attribute arrays; each is aligned to kAlignment and holds paddedSize() elements.
+    // Padding markers have id -1, a zero position and a zero size.
+    const float* x() const { return m_x.data(); }
+    const float* y() const { return m_y.data(); }
+    const float* z() const { return m_z.data(); }
+    const float* sizes() const { return m_sizes.data(); }
+    const int32_t* ids() const { return m_ids.data(); }
+    const int16_t* params() const { return m_params.data(); }
+
+    /**
+     * @brief Position of the marker at index @p i.
+     */
+    QVector3D position(size_t i) const { return QVector3D(m_x[i], m_y[i], m_z[i]); }
+
+    /**
+     * @brief Number of markers streamed for this frame but discarded by the memory cap.
+     */
+    uint32_t truncated() const { return m_truncated; }
+
+    /**
+     * @brief Records how many markers the memory cap discarded for this frame.
+     */
+    void setTruncated(uint32_t count) { m_truncated = count; }
+
+    /**
+     * @brief Heap memory held by the attribute arrays, in bytes.
+     */
+    size_t memoryBytes() const;
+
+private:
+    static size_t padded(size_t count) { return (count + kLaneWidth - 1) / kLaneWidth * kLaneWidth; }
+
+    AlignedVector<float> m_x;           // X positions
+    AlignedVector<float> m_y;           // Y positions
+    AlignedVector<float> m_z;           // Z positions
+    AlignedVector<float> m_sizes;       // Marker diameters
+    AlignedVector<int32_t> m_ids;       // Marker IDs (labeled) or -1 (unlabeled and padding)
+    AlignedVector<int16_t> m_params;    // Host defined flags (bit 0: occluded, bit 1: point cloud solved, ...)
+
+    size_t m_count = 0;                 // Valid markers, excluding padding
+    uint32_t m_truncated = 0;           // Markers dropped by the cap
+};
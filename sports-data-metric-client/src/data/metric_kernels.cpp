@@ -0,0 +1,181 @@
+#include "metric_kernels.h"
+#include "metric_kernels_simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(METRIC_KERNELS_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace metric_kernels {
+
+namespace {
+
+constexpr float kDegreesPerRadian = 57.295779513082320876f;
+constexpr float kHalfPi = 1.5707963267948966192f;
+
+void scalarJointAngles(QuatColumns a, QuatColumns b, float* out, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        // Scalar part of the normalized relative rotation conj(a) * b
+        const float dot = a.w[i] * b.w[i] + a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i];
+        const float norm = std::sqrt((a.w[i] * a.w[i] + a.x[i] * a.x[i] + a.y[i] * a.y[i] + a.z[i] * a.z[i]) *
+                                     (b.w[i] * b.w[i] + b.x[i] * b.x[i] + b.y[i] * b.y[i] + b.z[i] * b.z[i]));
+        const float cosHalf = norm > 0.0f ? std::clamp(dot / norm, -1.0f, 1.0f) : 0.0f;
+        out[i] = 2.0f * std::acos(cosHalf) * kDegreesPerRadian;
+    }
+}
+
+void scalarTilts(QuatColumns q, float* out, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        // Pitch and roll as QQuaternion::toEulerAngles() derives them
+        float xx = q.x[i] * q.x[i];
+        float xy = q.x[i] * q.y[i];
+        float xw = q.x[i] * q.w[i];
+        float yz = q.y[i] * q.z[i];
+        float zz = q.z[i] * q.z[i];
+        float zw = q.z[i] * q.w[i];
+        const float lengthSquared = xx + q.y[i] * q.y[i] + zz + q.w[i] * q.w[i];
+        if (lengthSquared > 0.0f) {
+            xx /= lengthSquared;
+            xy /= lengthSquared;
+            xw /= lengthSquared;
+            yz /= lengthSquared;
+            zz /= lengthSquared;
+            zw /= lengthSquared;
+        }
+
+        const float sinPitch = -2.0f * (yz - xw);
+        float pitch;
+        float roll;
+        if (std::abs(sinPitch) >= 1.0f) {
+            // Gimbal lock: no unique roll
+            pitch = std::copysign(kHalfPi, sinPitch);
+            roll = 0.0f;
+        } else {
+            pitch = std::asin(sinPitch);
+            roll = std::atan2(2.0f * (xy + zw), 1.0f - 2.0f * (xx + zz));
+        }
+
+        pitch *= kDegreesPerRadian;
+        roll *= kDegreesPerRadian;
+        out[i] = std::sqrt(pitch * pitch + roll * roll);
+    }
+}
+
+void scalarHorizontalDistances(Vec3Columns a, Vec3Columns b, float* out, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        const float dx = b.x[i] - a.x[i];
+        const float dz = b.z[i] - a.z[i];
+        out[i] = std::sqrt(dx * dx + dz * dz) * 100.0f;
+    }
+}
+
+void scalarSpeeds(Vec3Columns velocity, float* out, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = std::sqrt(velocity.x[i] * velocity.x[i] + velocity.y[i] * velocity.y[i] +
+                           velocity.z[i] * velocity.z[i]);
+    }
+}
+
+void scalarTangentialAccelerations(Vec3Columns velocity, Vec3Columns acceleration, float* out, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        const float speed = std::sqrt(velocity.x[i] * velocity.x[i] + velocity.y[i] * velocity.y[i] +
+                                      velocity.z[i] * velocity.z[i]);
+        if (speed <= kFuzzyZero) {
+            out[i] = std::sqrt(acceleration.x[i] * acceleration.x[i] + acceleration.y[i] * acceleration.y[i] +
+                               acceleration.z[i] * acceleration.z[i]);
+        } else {
+            out[i] = (velocity.x[i] * acceleration.x[i] + velocity.y[i] * acceleration.y[i] +
+                      velocity.z[i] * acceleration.z[i]) / speed;
+        }
+    }
+}
+
+constexpr Kernels kScalarKernels = {
+    "scalar",
+    scalarJointAngles,
+    scalarTilts,
+    scalarHorizontalDistances,
+    scalarSpeeds,
+    scalarTangentialAccelerations,
+};
+
+#if defined(METRIC_KERNELS_X86)
+
+bool cpuSupportsSse4()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+#else
+    return __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+bool cpuSupportsAvx2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    // The OS must save the YMM registers on context switches
+    __cpuid(info, 1);
+    const bool osSavesAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 0x6) == 0x6;
+    if (!osSavesAvx) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+} // namespace
+
+const Kernels& scalar()
+{
+    return kScalarKernels;
+}
+
+const Kernels* sse4()
+{
+#if defined(METRIC_KERNELS_X86)
+    static const bool supported = cpuSupportsSse4();
+    return supported ? &sse4Kernels() : nullptr;
+#else
+    return nullptr;
+#endif
+}
+
+const Kernels* avx2()
+{
+#if defined(METRIC_KERNELS_X86)
+    static const bool supported = cpuSupportsAvx2();
+    return supported ? &avx2Kernels() : nullptr;
+#else
+    return nullptr;
+#endif
+}
+
+const Kernels& best()
+{
+    static const Kernels& kernels = avx2() ? *avx2() : sse4() ? *sse4() : scalar();
+    return kernels;
+}
+
+} // namespace metric_kernels
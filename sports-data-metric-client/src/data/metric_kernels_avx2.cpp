@@ -0,0 +1,48 @@
+// AVX2 build of the metric kernels; compiled with AVX2 enabled, called only on CPUs that have it.
+
+#include "metric_kernels_simd.h"
+
+#include <immintrin.h>
+
+namespace metric_kernels {
+
+namespace {
+
+struct Avx2 {
+    static constexpr size_t kWidth = 8;
+
+    __m256 v;
+
+    static Avx2 splat(float f) { return { _mm256_set1_ps(f) }; }
+    static Avx2 load(const float* p) { return { _mm256_loadu_ps(p) }; }
+};
+
+inline void store(float* p, Avx2 a) { _mm256_storeu_ps(p, a.v); }
+
+inline Avx2 operator+(Avx2 a, Avx2 b) { return { _mm256_add_ps(a.v, b.v) }; }
+inline Avx2 operator-(Avx2 a, Avx2 b) { return { _mm256_sub_ps(a.v, b.v) }; }
+inline Avx2 operator*(Avx2 a, Avx2 b) { return { _mm256_mul_ps(a.v, b.v) }; }
+inline Avx2 operator/(Avx2 a, Avx2 b) { return { _mm256_div_ps(a.v, b.v) }; }
+
+inline Avx2 sqrt(Avx2 a) { return { _mm256_sqrt_ps(a.v) }; }
+inline Avx2 min(Avx2 a, Avx2 b) { return { _mm256_min_ps(a.v, b.v) }; }
+inline Avx2 max(Avx2 a, Avx2 b) { return { _mm256_max_ps(a.v, b.v) }; }
+inline Avx2 abs(Avx2 a) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v) }; }
+
+inline Avx2 lessThan(Avx2 a, Avx2 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+inline Avx2 greaterThan(Avx2 a, Avx2 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+inline Avx2 greaterEqual(Avx2 a, Avx2 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) }; }
+inline Avx2 select(Avx2 mask, Avx2 a, Avx2 b) { return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+
+inline Avx2 signOf(Avx2 a) { return { _mm256_and_ps(_mm256_set1_ps(-0.0f), a.v) }; }
+inline Avx2 withSign(Avx2 a, Avx2 signs) { return { _mm256_or_ps(a.v, signs.v) }; }
+
+} // namespace
+
+const Kernels& avx2Kernels()
+{
+    static const Kernels kernels = simd::makeKernels<Avx2>("avx2");
+    return kernels;
+}
+
+} // namespace metric_kernels
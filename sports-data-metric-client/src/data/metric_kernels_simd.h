@@ -0,0 +1,200 @@
+// Vector implementations of the metric kernels, shared by the SSE4.1 and AVX2 builds.
+//
+// Internal to metric_kernels*.cpp. The kernels are templates over a register
+// wrapper V, which each instruction set's translation unit defines with:
+// - V::kWidth, V::splat(float), V::load(const float*), store(float*, V)
+// - +, -, *, / and sqrt, min, max, abs
+// - lessThan, greaterEqual and greaterThan, returning lane masks
+// - select(mask, a, b), taking a where the mask is set
+// - signOf(V), the sign bits alone, and withSign(V, signs), or-ing them in
+// Lanes past the last multiple of kWidth are left to the scalar kernels.
+
+#pragma once
+
+#include "metric_kernels.h"
+
+namespace metric_kernels {
+
+constexpr float kFuzzyZero = 0.00001f;     // qFuzzyIsNull() threshold for floats
+
+#if defined(METRIC_KERNELS_X86)
+const Kernels& sse4Kernels();
+const Kernels& avx2Kernels();
+#endif
+
+namespace simd {
+
+constexpr float kPi = 3.1415926535897932385f;
+constexpr float kHalfPi = 1.5707963267948966192f;
+constexpr float kDegreesPerRadian = 57.295779513082320876f;
+
+// Everything here is compiled once per instruction set; internal linkage keeps
+// the linker from sharing one build of a function between them.
+namespace {
+
+inline Vec3Columns offset(Vec3Columns c, size_t i) { return { c.x + i, c.y + i, c.z + i }; }
+inline QuatColumns offset(QuatColumns c, size_t i) { return { c.w + i, c.x + i, c.y + i, c.z + i }; }
+
+/**
+ * @brief acos(x) for x in [0, 1], to about 2e-8 (Abramowitz & Stegun 4.4.46).
+ */
+template <typename V>
+inline V acosUnit(V x)
+{
+    V p = V::splat(-0.0012624911f);
+    p = p * x + V::splat(0.0066700901f);
+    p = p * x + V::splat(-0.0170881256f);
+    p = p * x + V::splat(0.0308918810f);
+    p = p * x + V::splat(-0.0501743046f);
+    p = p * x + V::splat(0.0889789874f);
+    p = p * x + V::splat(-0.2145988016f);
+    p = p * x + V::splat(1.5707963050f);
+    return sqrt(max(V::splat(1.0f) - x, V::splat(0.0f))) * p;
+}
+
+template <typename V>
+inline V acos(V x)
+{
+    const V r = acosUnit(abs(x));
+    return select(lessThan(x, V::splat(0.0f)), V::splat(kPi) - r, r);
+}
+
+template <typename V>
+inline V asin(V x)
+{
+    return withSign(V::splat(kHalfPi) - acosUnit(abs(x)), signOf(x));
+}
+
+/**
+ * @brief atan(t) for t in [0, 1], to about 2e-8 (Abramowitz & Stegun 4.4.49).
+ */
+template <typename V>
+inline V atanUnit(V t)
+{
+    const V t2 = t * t;
+    V p = V::splat(0.0028662257f);
+    p = p * t2 + V::splat(-0.0161657367f);
+    p = p * t2 + V::splat(0.0429096138f);
+    p = p * t2 + V::splat(-0.0752896400f);
+    p = p * t2 + V::splat(0.1065626393f);
+    p = p * t2 + V::splat(-0.1420889944f);
+    p = p * t2 + V::splat(0.1999355085f);
+    p = p * t2 + V::splat(-0.3333314528f);
+    p = p * t2 + V::splat(1.0f);
+    return p * t;
+}
+
+template <typename V>
+inline V atan2(V y, V x)
+{
+    const V ax = abs(x);
+    const V ay = abs(y);
+    const V hi = max(ax, ay);
+    const V lo = min(ax, ay);
+
+    // atan2(0, 0) is 0
+    const V ratio = select(greaterThan(hi, V::splat(0.0f)), lo / hi, V::splat(0.0f));
+    V r = atanUnit(ratio);
+    r = select(greaterThan(ay, ax), V::splat(kHalfPi) - r, r);
+    r = select(lessThan(x, V::splat(0.0f)), V::splat(kPi) - r, r);
+    return withSign(r, signOf(y));
+}
+
+template <typename V>
+void jointAngles(QuatColumns a, QuatColumns b, float* out, size_t n)
+{
+    size_t i = 0;
+    for (; i + V::kWidth <= n; i += V::kWidth) {
+        const V aw = V::load(a.w + i), ax = V::load(a.x + i), ay = V::load(a.y + i), az = V::load(a.z + i);
+        const V bw = V::load(b.w + i), bx = V::load(b.x + i), by = V::load(b.y + i), bz = V::load(b.z + i);
+
+        const V dot = aw * bw + ax * bx + ay * by + az * bz;
+        const V norm = sqrt((aw * aw + ax * ax + ay * ay + az * az) * (bw * bw + bx * bx + by * by + bz * bz));
+        V cosHalf = select(greaterThan(norm, V::splat(0.0f)), dot / norm, V::splat(0.0f));
+        cosHalf = min(max(cosHalf, V::splat(-1.0f)), V::splat(1.0f));
+
+        store(out + i, V::splat(2.0f * kDegreesPerRadian) * acos(cosHalf));
+    }
+    scalar().jointAngles(offset(a, i), offset(b, i), out + i, n - i);
+}
+
+template <typename V>
+void tilts(QuatColumns q, float* out, size_t n)
+{
+    size_t i = 0;
+    for (; i + V::kWidth <= n; i += V::kWidth) {
+        const V w = V::load(q.w + i), x = V::load(q.x + i), y = V::load(q.y + i), z = V::load(q.z + i);
+
+        // Divided rather than scaled by a reciprocal, so the products round as in the scalar kernel;
+        // otherwise a sine of the pitch one ulp either side of 1 flips the gimbal lock branch
+        const V lengthSquared = x * x + y * y + z * z + w * w;
+        const V divisor = select(greaterThan(lengthSquared, V::splat(0.0f)), lengthSquared, V::splat(1.0f));
+        const V xx = x * x / divisor, xy = x * y / divisor, xw = x * w / divisor;
+        const V yz = y * z / divisor, zz = z * z / divisor, zw = z * w / divisor;
+
+        const V sinPitch = V::splat(-2.0f) * (yz - xw);
+        const V locked = greaterEqual(abs(sinPitch), V::splat(1.0f));
+
+        const V pitch = asin(min(max(sinPitch, V::splat(-1.0f)), V::splat(1.0f)));
+        const V roll = select(locked, V::splat(0.0f),
+                              atan2(V::splat(2.0f) * (xy + zw), V::splat(1.0f) - V::splat(2.0f) * (xx + zz)));
+
+        store(out + i, V::splat(kDegreesPerRadian) * sqrt(pitch * pitch + roll * roll));
+    }
+    scalar().tilts(offset(q, i), out + i, n - i);
+}
+
+template <typename V>
+void horizontalDistances(Vec3Columns a, Vec3Columns b, float* out, size_t n)
+{
+    size_t i = 0;
+    for (; i + V::kWidth <= n; i += V::kWidth) {
+        const V dx = V::load(b.x + i) - V::load(a.x + i);
+        const V dz = V::load(b.z + i) - V::load(a.z + i);
+        store(out + i, sqrt(dx * dx + dz * dz) * V::splat(100.0f));
+    }
+    scalar().horizontalDistances(offset(a, i), offset(b, i), out + i, n - i);
+}
+
+template <typename V>
+void speeds(Vec3Columns velocity, float* out, size_t n)
+{
+    size_t i = 0;
+    for (; i + V::kWidth <= n; i += V::kWidth) {
+        const V x = V::load(velocity.x + i), y = V::load(velocity.y + i), z = V::load(velocity.z + i);
+        store(out + i, sqrt(x * x + y * y + z * z));
+    }
+    scalar().speeds(offset(velocity, i), out + i, n - i);
+}
+
+template <typename V>
+void tangentialAccelerations(Vec3Columns velocity, Vec3Columns acceleration, float* out, size_t n)
+{
+    size_t i = 0;
+    for (; i + V::kWidth <= n; i += V::kWidth) {
+        const V vx = V::load(velocity.x + i), vy = V::load(velocity.y + i), vz = V::load(velocity.z + i);
+        const V ax = V::load(acceleration.x + i), ay = V::load(acceleration.y + i), az = V::load(acceleration.z + i);
+
+        const V speed = sqrt(vx * vx + vy * vy + vz * vz);
+        const V moving = greaterThan(speed, V::splat(kFuzzyZero));
+        const V along = (vx * ax + vy * ay + vz * az) / select(moving, speed, V::splat(1.0f));
+
+        store(out + i, select(moving, along, sqrt(ax * ax + ay * ay + az * az)));
+    }
+    scalar().tangentialAccelerations(offset(velocity, i), offset(acceleration, i), out + i, n - i);
+}
+
+/**
+ * @brief The kernel table of one instruction set.
+ */
+template <typename V>
+Kernels makeKernels(const char* name)
+{
+    return { name, jointAngles<V>, tilts<V>, horizontalDistances<V>, speeds<V>, tangentialAccelerations<V> };
+}
+
+} // namespace
+
+} // namespace simd
+
+} // namespace metric_kernels
@@ -0,0 +1,48 @@
+// SSE4.1 build of the metric kernels; compiled with SSE4.1 enabled, called only on CPUs that have it.
+
+#include "metric_kernels_simd.h"
+
+#include <smmintrin.h>
+
+namespace metric_kernels {
+
+namespace {
+
+struct Sse4 {
+    static constexpr size_t kWidth = 4;
+
+    __m128 v;
+
+    static Sse4 splat(float f) { return { _mm_set1_ps(f) }; }
+    static Sse4 load(const float* p) { return { _mm_loadu_ps(p) }; }
+};
+
+inline void store(float* p, Sse4 a) { _mm_storeu_ps(p, a.v); }
+
+inline Sse4 operator+(Sse4 a, Sse4 b) { return { _mm_add_ps(a.v, b.v) }; }
+inline Sse4 operator-(Sse4 a, Sse4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+inline Sse4 operator*(Sse4 a, Sse4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+inline Sse4 operator/(Sse4 a, Sse4 b) { return { _mm_div_ps(a.v, b.v) }; }
+
+inline Sse4 sqrt(Sse4 a) { return { _mm_sqrt_ps(a.v) }; }
+inline Sse4 min(Sse4 a, Sse4 b) { return { _mm_min_ps(a.v, b.v) }; }
+inline Sse4 max(Sse4 a, Sse4 b) { return { _mm_max_ps(a.v, b.v) }; }
+inline Sse4 abs(Sse4 a) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+
+inline Sse4 lessThan(Sse4 a, Sse4 b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+inline Sse4 greaterThan(Sse4 a, Sse4 b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+inline Sse4 greaterEqual(Sse4 a, Sse4 b) { return { _mm_cmpge_ps(a.v, b.v) }; }
+inline Sse4 select(Sse4 mask, Sse4 a, Sse4 b) { return { _mm_blendv_ps(b.v, a.v, mask.v) }; }
+
+inline Sse4 signOf(Sse4 a) { return { _mm_and_ps(_mm_set1_ps(-0.0f), a.v) }; }
+inline Sse4 withSign(Sse4 a, Sse4 signs) { return { _mm_or_ps(a.v, signs.v) }; }
+
+} // namespace
+
+const Kernels& sse4Kernels()
+{
+    static const Kernels kernels = simd::makeKernels<Sse4>("sse4.1");
+    return kernels;
+}
+
+} // namespace metric_kernels
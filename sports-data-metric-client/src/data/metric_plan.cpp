@@ -0,0 +1,143 @@
+#include "metric_plan.h"
+
+#include <algorithm>
+#include <QDebug>
+#include <QJsonObject>
+
+namespace {
+
+/**
+ * @brief How a metric class of sports.json maps onto a step.
+ */
+struct MetricClass {
+    const char* name;       // "class" value in sports.json
+    MetricOp op;
+    int maxOutputs;         // Labels used; extra labels are ignored
+    bool needsBones;        // Reads a "joint" or two bone IDs from "ids"
+    bool needsEstimator;    // Reads an optional "estimator"
+};
+
+constexpr MetricClass kMetricClasses[] = {
+    { "tilt",         MetricOp::Tilt,               1, false, false },
+    { "velocity",     MetricOp::Velocity,           1, false, true  },
+    { "acceleration", MetricOp::Acceleration,       1, false, true  },
+    { "position",     MetricOp::Position,           3, false, false },
+    { "orientation",  MetricOp::Orientation,        3, false, false },
+    { "angle",        MetricOp::JointAngle,         1, true,  false },
+    { "distance",     MetricOp::HorizontalDistance, 1, true,  false },
+};
+
+/**
+ * @brief Reads the "estimator" object of a metric; a central difference if absent.
+ */
+DerivativeEstimator parseEstimator(const QJsonObject& metricObj)
+{
+    const QJsonObject estimatorObj = metricObj["estimator"].toObject();
+    const QString method = estimatorObj["method"].toString(QStringLiteral("centralDifference"));
+    const int window = estimatorObj["window"].toInt(DerivativeEstimator::kMinWindow);
+
+    if (method == QLatin1String("savitzkyGolay")) {
+        return DerivativeEstimator(DerivativeMethod::SavitzkyGolay, window);
+    }
+    if (method != QLatin1String("centralDifference")) {
+        qWarning() << "MetricPlan: unknown estimator" << method << "for metric" << metricObj["name"].toString()
+                   << "using a central difference";
+    }
+    return DerivativeEstimator(DerivativeMethod::CentralDifference, window);
+}
+
+} // namespace
+
+MetricSchema::MetricSchema(const QStringList& labels)
+    : m_labels(labels)
+{
+    if (!m_labels.isEmpty()) {
+        // 0 is reserved for "no schema"
+        m_version = static_cast<uint32_t>(qHashRange(m_labels.cbegin(), m_labels.cend()));
+        if (m_version == 0) {
+            m_version = 1;
+        }
+    }
+}
+
+MetricPlan MetricPlan::compile(const QJsonArray& settings)
+{
+    MetricPlan plan;
+    QStringList labels;
+
+    for (const QJsonValue& val : settings) {
+        const QJsonObject metricObj = val.toObject();
+        const QString metricClass = metricObj["class"].toString();
+        const QJsonArray metricLabels = metricObj["labels"].toArray();
+        const QJsonArray ids = metricObj["ids"].toArray();
+        const QString joint = metricObj["joint"].toString();
+
+        const auto match = std::find_if(std::begin(kMetricClasses), std::end(kMetricClasses),
+                                        [&](const MetricClass& c) { return metricClass == QLatin1String(c.name); });
+        if (match == std::end(kMetricClasses)) {
+            qWarning() << "MetricPlan: unknown metric class" << metricClass;
+            continue;
+        }
+        if (metricLabels.isEmpty()) {
+            qWarning() << "MetricPlan: metric" << metricObj["name"].toString() << "has no labels";
+            continue;
+        }
+        if (match->needsBones && joint.isEmpty() && ids.size() < 2) {
+            qWarning() << "MetricPlan: metric" << metricObj["name"].toString() << "needs a joint or two bone IDs";
+            continue;
+        }
+
+        MetricStep step;
+        step.op = match->op;
+        step.slot = static_cast<int>(labels.size());
+        step.count = std::min(static_cast<int>(metricLabels.size()), match->maxOutputs);
+        if (step.slot + step.count > MetricsData::kMaxSlots) {
+            qWarning() << "MetricPlan: more than" << MetricsData::kMaxSlots << "metric values, ignoring"
+                       << metricObj["name"].toString();
+            continue;
+        }
+        if (match->needsBones) {
+            if (!joint.isEmpty()) {
+                step.joint = static_cast<int>(plan.m_joints.indexOf(joint));
+                if (step.joint == -1) {
+                    step.joint = static_cast<int>(plan.m_joints.size());
+                    plan.m_joints.append(joint);
+                }
+            }
+            if (ids.size() >= 2) {
+                step.bone1 = ids[0].toInt();
+                step.bone2 = ids[1].toInt();
+            }
+        }
+
+        if (match->needsEstimator) {
+            const DerivativeEstimator estimator = parseEstimator(metricObj);
+            const auto same = std::find_if(plan.m_estimators.begin(), plan.m_estimators.end(),
+                                           [&](const DerivativeEstimator& e) {
+                                               return e.method() == estimator.method() && e.window() == estimator.window();
+                                           });
+            step.estimator = static_cast<int>(same - plan.m_estimators.begin());
+            if (same == plan.m_estimators.end()) {
+                plan.m_estimators.push_back(estimator);
+            }
+        }
+
+        for (int j = 0; j < step.count; ++j) {
+            labels.append(metricLabels[j].toString());
+        }
+
+        plan.m_steps.push_back(step);
+    }
+
+    plan.m_schema = MetricSchema(labels);
+    return plan;
+}
+
+int MetricPlan::historyDepth() const
+{
+    int depth = DerivativeEstimator::kMinWindow;
+    for (const DerivativeEstimator& estimator : m_estimators) {
+        depth = std::max(depth, estimator.window());
+    }
+    return depth;
+}
@@ -0,0 +1,133 @@
+// Compiled form of the metric settings of a sport.
+//
+// The "rigidMetrics" and "bodyMetrics" arrays of sports.json describe metrics by
+// class name, output labels and either a joint of skeleton_config.json or two
+// bone IDs. They are compiled once, when a sport is selected, into a flat list
+// of typed steps whose output slots are already resolved. Computing the metrics
+// of a frame then only walks this list: no JSON lookups, string comparisons or
+// allocations per frame.
+//
+// Velocity and acceleration may choose a derivative estimator and its window
+// with an "estimator" object, e.g. {"method": "savitzkyGolay", "window": 7};
+// the default is a three sample central difference.
+//
+// The output slots form a MetricSchema shared with the consumers of the
+// metrics, which bind their labels to slots once per sport.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <QJsonArray>
+#include <QStringList>
+
+#include "derivative_estimator.h"
+#include "metrics_data.h"
+
+/**
+ * @brief Operation performed by one step of a metric plan.
+ */
+enum class MetricOp : uint8_t {
+    Tilt,                   // Rigid body tilt from horizontal
+    Velocity,               // Rigid body speed
+    Acceleration,           // Rigid body change of speed
+    Position,               // Rigid body position, one slot per axis
+    Orientation,            // Rigid body Euler angles, one slot per axis
+    JointAngle,             // Angle between two bones of a skeleton
+    HorizontalDistance      // Horizontal distance between two bones of a skeleton
+};
+
+/**
+ * @brief One metric of a plan with its resolved outputs and inputs.
+ */
+struct MetricStep {
+    MetricOp op = MetricOp::Tilt;
+    int slot = 0;           // First output slot
+    int count = 1;          // Consecutive slots written; the components of vector metrics
+    int estimator = -1;     // Index into MetricPlan::estimators(), for velocity and acceleration
+    int joint = -1;         // Joint of skeleton_config.json, index into MetricPlan::joints(); -1 to use the bone IDs
+    int bone1 = -1;         // First bone ID, for skeleton metrics without a joint
+    int bone2 = -1;         // Second bone ID, for skeleton metrics without a joint
+};
+
+/**
+ * @brief Assignment of metric labels to the value slots of MetricsData.
+ *
+ * The version is derived from the labels alone, so the data thread and the UI,
+ * each compiling the same settings, agree on it without exchanging the schema.
+ */
+class MetricSchema {
+public:
+    MetricSchema() = default;
+
+    /**
+     * @brief Builds the schema giving label i slot i.
+     */
+    explicit MetricSchema(const QStringList& labels);
+
+    /**
+     * @brief Slot of @p label, or -1 if the schema has no such label.
+     */
+    int slotOf(const QString& label) const { return static_cast<int>(m_labels.indexOf(label)); }
+
+    /**
+     * @brief The label of each slot.
+     */
+    const QStringList& labels() const { return m_labels; }
+
+    int slotCount() const { return static_cast<int>(m_labels.size()); }
+
+    /**
+     * @brief Version tagged onto the MetricsData produced with this schema; 0 for an empty schema.
+     */
+    uint32_t version() const { return m_version; }
+
+private:
+    QStringList m_labels;
+    uint32_t m_version = 0;
+};
+
+class MetricPlan {
+public:
+    /**
+     * @brief Compiles a metric settings array of sports.json.
+     *
+     * Entries with an unknown class, no labels or neither a joint nor two bone IDs are skipped
+     * with a warning. Every label gets its own output slot, in settings order,
+     * up to MetricsData::kMaxSlots.
+     */
+    static MetricPlan compile(const QJsonArray& settings);
+
+    /**
+     * @brief The steps to evaluate for each frame, in settings order.
+     */
+    const std::vector<MetricStep>& steps() const { return m_steps; }
+
+    /**
+     * @brief The output slots written by the plan.
+     */
+    const MetricSchema& schema() const { return m_schema; }
+
+    /**
+     * @brief The skeleton_config.json joints referenced by the steps.
+     */
+    const QStringList& joints() const { return m_joints; }
+
+    /**
+     * @brief The derivative estimators referenced by the steps.
+     */
+    const std::vector<DerivativeEstimator>& estimators() const { return m_estimators; }
+
+    /**
+     * @brief Pose samples each rigid body must keep for the estimators.
+     */
+    int historyDepth() const;
+
+    bool empty() const { return m_steps.empty(); }
+
+private:
+    std::vector<MetricStep> m_steps;
+    MetricSchema m_schema;
+    QStringList m_joints;
+    std::vector<DerivativeEstimator> m_estimators;
+};
@@ -0,0 +1,244 @@
+#include "metric_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+P2Quantile::P2Quantile(double quantile)
+    : m_quantile(quantile)
+{
+    reset();
+}
+
+void P2Quantile::reset()
+{
+    const double p = m_quantile;
+    m_count = 0;
+
+    for (int i = 0; i < 5; ++i) {
+        m_positions[i] = i + 1;
+    }
+
+    m_desired[0] = 1.0;
+    m_desired[1] = 1.0 + 2.0 * p;
+    m_desired[2] = 1.0 + 4.0 * p;
+    m_desired[3] = 3.0 + 2.0 * p;
+    m_desired[4] = 5.0;
+
+    m_increments[0] = 0.0;
+    m_increments[1] = p / 2.0;
+    m_increments[2] = p;
+    m_increments[3] = (1.0 + p) / 2.0;
+    m_increments[4] = 1.0;
+}
+
+void P2Quantile::add(double x)
+{
+    // The first five samples become the markers
+    if (m_count < 5) {
+        m_heights[m_count++] = x;
+        if (m_count == 5) {
+            std::sort(m_heights, m_heights + 5);
+        }
+        return;
+    }
+    ++m_count;
+
+    // Cell the sample falls into, stretching the extremes if needed
+    int cell;
+    if (x < m_heights[0]) {
+        m_heights[0] = x;
+        cell = 0;
+    } else if (x >= m_heights[4]) {
+        m_heights[4] = x;
+        cell = 3;
+    } else {
+        cell = 0;
+        while (x >= m_heights[cell + 1]) {
+            ++cell;
+        }
+    }
+
+    for (int i = cell + 1; i < 5; ++i) {
+        m_positions[i] += 1.0;
+    }
+    for (int i = 0; i < 5; ++i) {
+        m_desired[i] += m_increments[i];
+    }
+
+    // Move the middle markers towards their desired positions
+    for (int i = 1; i < 4; ++i) {
+        const double offset = m_desired[i] - m_positions[i];
+        if ((offset >= 1.0 && m_positions[i + 1] - m_positions[i] > 1.0) ||
+            (offset <= -1.0 && m_positions[i - 1] - m_positions[i] < -1.0)) {
+            const int d = offset > 0.0 ? 1 : -1;
+
+            // Piecewise parabolic prediction, or linear if it would break the marker order
+            const double parabolic = m_heights[i] + d / (m_positions[i + 1] - m_positions[i - 1]) *
+                ((m_positions[i] - m_positions[i - 1] + d) * (m_heights[i + 1] - m_heights[i]) /
+                     (m_positions[i + 1] - m_positions[i]) +
+                 (m_positions[i + 1] - m_positions[i] - d) * (m_heights[i] - m_heights[i - 1]) /
+                     (m_positions[i] - m_positions[i - 1]));
+
+            if (m_heights[i - 1] < parabolic && parabolic < m_heights[i + 1]) {
+                m_heights[i] = parabolic;
+            } else {
+                m_heights[i] += d * (m_heights[i + d] - m_heights[i]) / (m_positions[i + d] - m_positions[i]);
+            }
+            m_positions[i] += d;
+        }
+    }
+}
+
+double P2Quantile::value() const
+{
+    if (m_count == 0) {
+        return 0.0;
+    }
+    if (m_count >= 5) {
+        return m_heights[2];
+    }
+
+    double sorted[5];
+    std::copy(m_heights, m_heights + m_count, sorted);
+    std::sort(sorted, sorted + m_count);
+    return sorted[static_cast<size_t>(std::lround(m_quantile * static_cast<double>(m_count - 1)))];
+}
+
+void MetricAccumulator::add(double x)
+{
+    ++m_count;
+    if (m_count == 1) {
+        m_min = x;
+        m_max = x;
+    } else {
+        m_min = std::min(m_min, x);
+        m_max = std::max(m_max, x);
+    }
+
+    // Welford's update, stable for long sessions
+    const double delta = x - m_mean;
+    m_mean += delta / static_cast<double>(m_count);
+    m_m2 += delta * (x - m_mean);
+
+    m_p50.add(x);
+    m_p90.add(x);
+    m_p99.add(x);
+}
+
+MetricSummary MetricAccumulator::summary() const
+{
+    MetricSummary summary;
+    summary.count = m_count;
+    summary.mean = m_mean;
+    summary.variance = m_count > 1 ? m_m2 / static_cast<double>(m_count - 1) : 0.0;
+    summary.min = m_min;
+    summary.max = m_max;
+    summary.p50 = m_p50.value();
+    summary.p90 = m_p90.value();
+    summary.p99 = m_p99.value();
+    return summary;
+}
+
+void MetricAccumulator::reset()
+{
+    m_count = 0;
+    m_mean = 0.0;
+    m_m2 = 0.0;
+    m_min = 0.0;
+    m_max = 0.0;
+    m_p50.reset();
+    m_p90.reset();
+    m_p99.reset();
+}
+
+void MetricStatistics::add(const MetricsData& metrics)
+{
+    if (metrics.schemaVersion == 0) {
+        return;
+    }
+
+    // Values of another sport share no slots with the current ones
+    if (metrics.schemaVersion != m_schemaVersion) {
+        for (MetricAccumulator& accumulator : m_accumulators) {
+            accumulator.reset();
+        }
+        m_schemaVersion = metrics.schemaVersion;
+    }
+
+    m_count = std::clamp(metrics.count, 0, MetricsData::kMaxSlots);
+    for (int i = 0; i < m_count; ++i) {
+        m_accumulators[static_cast<size_t>(i)].add(metrics.values[static_cast<size_t>(i)]);
+    }
+
+    publish();
+}
+
+void MetricStatistics::reset()
+{
+    for (MetricAccumulator& accumulator : m_accumulators) {
+        accumulator.reset();
+    }
+    m_schemaVersion = 0;
+    m_count = 0;
+
+    publish();
+}
+
+void MetricStatistics::publish()
+{
+    const uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    m_publishedVersion.store(m_schemaVersion, std::memory_order_relaxed);
+    m_publishedCount.store(m_count, std::memory_order_relaxed);
+    for (int i = 0; i < m_count; ++i) {
+        const MetricSummary summary = m_accumulators[static_cast<size_t>(i)].summary();
+        const double fields[kFields] = { static_cast<double>(summary.count), summary.mean, summary.variance,
+                                         summary.min, summary.max, summary.p50, summary.p90, summary.p99 };
+        for (int f = 0; f < kFields; ++f) {
+            m_published[static_cast<size_t>(i * kFields + f)].store(fields[f], std::memory_order_relaxed);
+        }
+    }
+
+    m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+MetricStatistics::Snapshot MetricStatistics::snapshot() const
+{
+    Snapshot snapshot;
+
+    for (;;) {
+        const uint32_t before = m_sequence.load(std::memory_order_acquire);
+        if (before & 1u) {
+            // A publication takes microseconds; let the writer finish
+            std::this_thread::yield();
+            continue;
+        }
+
+        snapshot.schemaVersion = m_publishedVersion.load(std::memory_order_relaxed);
+        snapshot.count = std::clamp(m_publishedCount.load(std::memory_order_relaxed), 0, MetricsData::kMaxSlots);
+        for (int i = 0; i < snapshot.count; ++i) {
+            double fields[kFields];
+            for (int f = 0; f < kFields; ++f) {
+                fields[f] = m_published[static_cast<size_t>(i * kFields + f)].load(std::memory_order_relaxed);
+            }
+
+            MetricSummary& summary = snapshot.summaries[static_cast<size_t>(i)];
+            summary.count = static_cast<uint64_t>(fields[0]);
+            summary.mean = fields[1];
+            summary.variance = fields[2];
+            summary.min = fields[3];
+            summary.max = fields[4];
+            summary.p50 = fields[5];
+            summary.p90 = fields[6];
+            summary.p99 = fields[7];
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_sequence.load(std::memory_order_relaxed) == before) {
+            return snapshot;
+        }
+    }
+}
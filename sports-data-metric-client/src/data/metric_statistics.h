@@ -0,0 +1,125 @@
+// Running statistics of a metric stream, for end-of-session reporting.
+//
+// Every value slot of the stream feeds a fixed-size accumulator: Welford's mean
+// and variance, the extremes, and P² estimates (Jain & Chlamtac) of the median,
+// 90th and 99th percentiles. A sample costs O(1) per slot, and the footprint
+// does not grow with the length of the session.
+//
+// The data thread is the only writer. After each sample it publishes the
+// summaries behind a sequence lock, so any thread can read a consistent
+// snapshot at any time without blocking or slowing down the writer.
+//
+// Structs:
+// - MetricSummary: The statistics of one value slot.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "metrics_data.h"
+
+struct MetricSummary {
+    uint64_t count = 0;             // Samples seen
+    double mean = 0.0;
+    double variance = 0.0;          // Sample variance; 0 below two samples
+    double min = 0.0;
+    double max = 0.0;
+    double p50 = 0.0;               // Estimated median
+    double p90 = 0.0;               // Estimated 90th percentile
+    double p99 = 0.0;               // Estimated 99th percentile
+};
+
+/**
+ * @brief P² estimate of one quantile, from five markers.
+ */
+class P2Quantile {
+public:
+    explicit P2Quantile(double quantile = 0.5);
+
+    void add(double x);
+
+    /**
+     * @brief The estimate; exact while fewer than five samples were added.
+     */
+    double value() const;
+
+    void reset();
+
+private:
+    double m_quantile;
+    uint64_t m_count = 0;
+    double m_heights[5] = {};       // Marker heights; the first samples until there are five
+    double m_positions[5] = {};     // Actual marker positions, 1-based
+    double m_desired[5] = {};       // Desired marker positions
+    double m_increments[5] = {};    // Desired position increment per sample
+};
+
+/**
+ * @brief Statistics of one value slot.
+ */
+class MetricAccumulator {
+public:
+    void add(double x);
+
+    MetricSummary summary() const;
+
+    void reset();
+
+private:
+    uint64_t m_count = 0;
+    double m_mean = 0.0;
+    double m_m2 = 0.0;              // Sum of squared deviations from the mean
+    double m_min = 0.0;
+    double m_max = 0.0;
+    P2Quantile m_p50{0.5};
+    P2Quantile m_p90{0.9};
+    P2Quantile m_p99{0.99};
+};
+
+class MetricStatistics {
+public:
+    /**
+     * @brief The published statistics of every slot of a schema.
+     */
+    struct Snapshot {
+        uint32_t schemaVersion = 0;     // Schema the slots belong to; 0 before the first sample
+        int count = 0;                  // Slots in use
+        std::array<MetricSummary, MetricsData::kMaxSlots> summaries;
+    };
+
+    /**
+     * @brief Adds the values of @p metrics and publishes the new statistics.
+     *
+     * Metrics without values are ignored; a new schema version starts over.
+     * Data thread only.
+     */
+    void add(const MetricsData& metrics);
+
+    /**
+     * @brief Drops every sample and publishes the empty statistics. Data thread only.
+     */
+    void reset();
+
+    /**
+     * @brief A consistent copy of the latest published statistics. Any thread.
+     */
+    Snapshot snapshot() const;
+
+private:
+    static constexpr int kFields = 8;   // Values of a MetricSummary
+
+    void publish();
+
+    // Writer state, touched only by the data thread
+    std::array<MetricAccumulator, MetricsData::kMaxSlots> m_accumulators;
+    uint32_t m_schemaVersion = 0;
+    int m_count = 0;
+
+    // Published state; odd sequence numbers mark a publication in progress
+    std::atomic<uint32_t> m_sequence{0};
+    std::atomic<uint32_t> m_publishedVersion{0};
+    std::atomic<int> m_publishedCount{0};
+    std::array<std::atomic<double>, MetricsData::kMaxSlots * kFields> m_published{};
+};
@@ -0,0 +1,35 @@
+// Metrics of many assets for one frame, as computed by the DataProcessor's worker pool.
+//
+// Structs:
+// - AssetMetrics: The metrics of one rigid body or skeleton.
+// - ShardTiming: How long one worker took for its share of the assets.
+// - MetricsBatch: All assets of a frame together with the timing of each shard.
+
+#pragma once
+
+#include <vector>
+#include <QMetaType>
+
+#include "metrics_data.h"
+
+struct AssetMetrics {
+    int assetId = -1;               // Motive rigid body or skeleton ID
+    MetricsData metrics;            // Values in the slots of the rigid body or skeleton schema
+};
+
+struct ShardTiming {
+    int assets = 0;                 // Assets computed by the shard
+    int rigidBodies = 0;            // Rigid bodies among them; the rest are skeletons
+    double computeUs = 0.0;         // Time the shard took, in microseconds
+    double rigidBodyUs = 0.0;       // Part of computeUs spent on the rigid bodies, in microseconds
+};
+
+struct MetricsBatch {
+    int frameNumber = 0;                    // Motive frame the metrics belong to
+    std::vector<AssetMetrics> rigidBodies;  // One entry per rigid body in the batch
+    std::vector<AssetMetrics> skeletons;    // One entry per skeleton in the batch
+    std::vector<ShardTiming> shards;        // One entry per shard the assets were split into
+    double wallUs = 0.0;                    // Time from dispatch until every shard finished, in microseconds
+};
+
+Q_DECLARE_METATYPE(MetricsBatch)
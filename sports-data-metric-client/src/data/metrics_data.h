@@ -1,9 +1,14 @@
 #pragma once
 
-#include <QVector3D>
-#include <QHash>
+#include <array>
+#include <cstdint>
+#include <QtGlobal>
 
 struct MetricsData {
-    int id = -1;                    // Motive Frame ID
-    QHash<QString, qreal> metrics;
-};
\ No newline at end of file
+    static constexpr int kMaxSlots = 32;    // Metric values one sport can define per asset type
+
+    int id = -1;                            // Motive Frame ID
+    uint32_t schemaVersion = 0;             // MetricSchema::version() of the values; 0 if none were computed
+    int count = 0;                          // Slots in use
+    std::array<qreal, kMaxSlots> values{};  // Metric values indexed by MetricSchema slot
+};
@@ -0,0 +1,76 @@
+#include "pose_history.h"
+
+#include <algorithm>
+
+void PoseRing::reset(int capacity)
+{
+    unsigned size = 1;
+    while (size < static_cast<unsigned>(std::max(capacity, 1))) {
+        size <<= 1;
+    }
+
+    m_samples.assign(size, PoseSample());
+    m_mask = size - 1;
+    m_head = 0;
+    m_count = 0;
+}
+
+void PoseRing::push(const PoseSample& sample)
+{
+    m_head = static_cast<int>(static_cast<unsigned>(m_head + 1) & m_mask);
+    m_samples[static_cast<size_t>(m_head)] = sample;
+    m_count = std::min(m_count + 1, static_cast<int>(m_samples.size()));
+}
+
+void PoseHistory::setDepth(int samples)
+{
+    m_depth = std::max(samples, 1);
+    for (PoseRing& ring : m_rings) {
+        ring.reset(m_depth);
+    }
+}
+
+void PoseHistory::push(const FrameData& frame)
+{
+    if (!frame.slotMap) {
+        return;
+    }
+
+    // A new session lays its rigid bodies out differently
+    if (frame.slotMap != m_slotMap) {
+        m_slotMap = frame.slotMap;
+        m_rings.resize(static_cast<size_t>(m_slotMap->rigidBodyCount()));
+        for (PoseRing& ring : m_rings) {
+            ring.reset(m_depth);
+        }
+    }
+
+    const size_t count = std::min(m_rings.size(), frame.rigidBodies.size());
+    for (size_t k = 0; k < count; ++k) {
+        const RigidBodyData& body = frame.rigidBodies[k];
+        PoseRing& ring = m_rings[k];
+
+        // Derivatives need evenly progressing samples; gaps and rewinds restart the history
+        if (!body.tracked || (ring.size() > 0 && frame.timestamp <= ring.at(0).timestamp)) {
+            ring.clear();
+            if (!body.tracked) {
+                continue;
+            }
+        }
+
+        ring.push(PoseSample{body.position, body.orientation, frame.timestamp});
+    }
+}
+
+const PoseRing* PoseHistory::find(int id) const
+{
+    if (!m_slotMap) {
+        return nullptr;
+    }
+
+    const int slot = m_slotMap->rigidBodySlot(id);
+    if (slot < 0 || static_cast<size_t>(slot) >= m_rings.size()) {
+        return nullptr;
+    }
+    return &m_rings[static_cast<size_t>(slot)];
+}
@@ -0,0 +1,97 @@
+// Short history of the poses of every rigid body, for motion metrics.
+//
+// Each rigid body of the session owns a fixed ring of compact samples, indexed
+// by its slot in the frame layout. Pushing a frame writes one sample per
+// tracked body in place, so the metrics no longer hold on to whole frames to
+// look back in time. A body that drops out of tracking, or a replay that jumps
+// back, starts a fresh history, so a window never spans a gap.
+//
+// Structs:
+// - PoseSample: Position, orientation and time of one rigid body in one frame.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <QQuaternion>
+#include <QVector3D>
+
+#include "asset_slot_map.h"
+#include "frame_data.h"
+
+struct PoseSample {
+    QVector3D position;             // X, Y, Z position
+    QQuaternion orientation;        // Orientation of the rigid body
+    double timestamp = 0.0;         // Frame timestamp, in seconds
+};
+
+/**
+ * @brief Fixed capacity ring of pose samples, newest first.
+ */
+class PoseRing {
+public:
+    /**
+     * @brief Empties the ring and makes room for at least @p capacity samples.
+     */
+    void reset(int capacity);
+
+    /**
+     * @brief Drops every sample, keeping the storage.
+     */
+    void clear() { m_count = 0; }
+
+    /**
+     * @brief Adds @p sample as the newest, overwriting the oldest once full.
+     */
+    void push(const PoseSample& sample);
+
+    /**
+     * @brief The sample pushed @p age pushes ago; 0 is the newest. Requires age < size().
+     */
+    const PoseSample& at(int age) const
+    {
+        return m_samples[static_cast<unsigned>(m_head - age) & m_mask];
+    }
+
+    int size() const { return m_count; }
+
+private:
+    std::vector<PoseSample> m_samples;  // Power of two storage, indexed with m_mask
+    unsigned m_mask = 0;
+    int m_head = 0;                     // Index of the newest sample
+    int m_count = 0;                    // Samples held, up to the storage size
+};
+
+/**
+ * @brief The pose rings of every rigid body of a session.
+ *
+ * Pushed and read on the data thread; the rings may be read from several
+ * threads at once between two pushes.
+ */
+class PoseHistory {
+public:
+    /**
+     * @brief Sets the samples kept per rigid body, dropping the history.
+     */
+    void setDepth(int samples);
+
+    int depth() const { return m_depth; }
+
+    /**
+     * @brief Records the pose of every tracked rigid body of @p frame.
+     *
+     * Frames of a new session, by their AssetSlotMap, drop the history.
+     * Frames without a slot map are not recorded.
+     */
+    void push(const FrameData& frame);
+
+    /**
+     * @brief The ring of the rigid body with @p id, or nullptr if it was not described.
+     */
+    const PoseRing* find(int id) const;
+
+private:
+    std::shared_ptr<const AssetSlotMap> m_slotMap;  // Layout the rings are indexed by
+    std::vector<PoseRing> m_rings;                  // Ring by rigid body slot
+    int m_depth = 3;
+};
@@ -1,6 +1,10 @@
 #include "replay_controller.h"
 #include "data_processor.h"
 #include "glwidget.h"
+#include "json_take_parser.h"
+#include "take_reader.h"
+#include "take_writer.h"
+#include <algorithm>
 #include <QDebug>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -10,22 +14,57 @@
 #include <QOpenGLWidget>
 #include <QVector>
 
+namespace {
+
+/**
+ * @brief Frames of a mapped binary take, decoded on request; keeps the take mapped while analyzed.
+ */
+class TakeReaderFrames : public TakeFrames {
+public:
+    explicit TakeReaderFrames(std::shared_ptr<const TakeReader> reader) : m_reader(std::move(reader)) {}
+
+    int frameCount() const override { return static_cast<int>(m_reader->frameCount()); }
+
+    FramePtr frame(int index) const override { return m_reader->frame(static_cast<size_t>(index)); }
+
+private:
+    std::shared_ptr<const TakeReader> m_reader;
+};
+
+} // namespace
 
 ReplayController::ReplayController(QObject* parent)
     : QObject(parent)
 {
+    // Restarted for each wakeup, so stopping the replay cancels the pending one
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
     connect(&m_timer, &QTimer::timeout, this, &ReplayController::emitNextFrame);
+
+    m_timingTimer.setInterval(kReplayTimingIntervalMs);
+    connect(&m_timingTimer, &QTimer::timeout, this, &ReplayController::publishReplayTiming);
+    m_clock.start();
+
+    // One take loads at a time
+    m_loadPool.setMaxThreadCount(1);
 }
 
-void ReplayController::setSavedFrames(const QVector<FrameData>& frames)
+ReplayController::~ReplayController()
 {
+    cancelLoading();
+}
+
+void ReplayController::setSavedFrames(const QVector<FramePtr>& frames)
+{
+    cancelLoading();
+    m_take.reset();
     m_savedFrames = frames;
     m_currentIndex = 0;
 }
 
 void ReplayController::startReplay()
 {
-    if (m_savedFrames.isEmpty()) {
+    if (loadedFrameCount() == 0 && !isLoading()) {
         qWarning() << "ReplayController: No frames to replay.";
         return;
     }
@@ -33,35 +72,191 @@ void ReplayController::startReplay()
     m_currentIndex = 0;
     m_isReplaying = true;
 
-    m_lastFrameTime.start();  // QElapsedTimer
-    QTimer::singleShot(0, this, &ReplayController::emitNextFrame);
+    m_scheduler.start(m_clock.nsecsElapsed());
+    m_timer.start(0);
+    m_timingTimer.start();
 }
 
 void ReplayController::stopReplay()
 {
     m_timer.stop();
+    if (!m_isReplaying) {
+        return;
+    }
     m_isReplaying = false;
+    m_timingTimer.stop();
+
+    const ReplayTimingStats timing = m_scheduler.stats();
+    emit replayTiming(timing);
+    qDebug() << "Replay timing:" << timing.frames << "frames," << timing.droppedFrames << "dropped,"
+             << timing.framesPerSecond << "frames/s";
+    if (timing.lateness.samples > 0) {
+        qDebug() << "Replay lateness p50/p99/max:" << timing.lateness.p50Ms << "/" << timing.lateness.p99Ms
+                 << "/" << timing.lateness.maxMs << "ms, mean error" << timing.meanErrorMs << "ms";
+    }
 }
 
 void ReplayController::emitNextFrame()
 {
-    if (!m_isReplaying || m_currentIndex >= m_savedFrames.size()) {
-        stopReplay();
+    for (int emitted = 0; emitted < kMaxFramesPerPass; ++emitted) {
+        // A receiver may have stopped the replay
+        if (!m_isReplaying) {
+            return;
+        }
+
+        if (m_currentIndex >= loadedFrameCount()) {
+            if (!isLoading()) {
+                stopReplay();
+                return;
+            }
+
+            // Caught up with loading; the wait does not count against the next frame
+            m_scheduler.pause();
+            m_timer.start(kLoadWaitIntervalMs);
+            return;
+        }
+
+        FramePtr frame = loadedFrame(m_currentIndex);
+        const int64_t untilDue = m_scheduler.nanosecondsUntilDue(frame->timestamp, m_clock.nsecsElapsed());
+        if (untilDue > kEarlyToleranceNs) {
+            // Rounded to the nearest millisecond, so frames leave within half of one of their due times
+            m_timer.start(static_cast<int>((untilDue + 500000) / 1000000));
+            return;
+        }
+
+        // Too far behind to catch up; skip to the frame due now
+        if (m_scheduler.isTooLate(-untilDue)) {
+            const int dueIndex = loadedIndexAtTime(m_scheduler.dueTimestamp(m_clock.nsecsElapsed()), m_currentIndex);
+            if (dueIndex > m_currentIndex) {
+                m_scheduler.framesDropped(static_cast<uint64_t>(dueIndex - m_currentIndex));
+                m_currentIndex = dueIndex;
+                frame = loadedFrame(m_currentIndex);
+            }
+        }
+
+        emit replayFrame(frame);
+        m_scheduler.frameEmitted(frame->timestamp, m_clock.nsecsElapsed());
+        ++m_currentIndex;
+    }
+
+    // Frames are still due, or the replay is as fast as possible; let the event loop run first
+    m_timer.start(0);
+}
+
+void ReplayController::publishReplayTiming()
+{
+    emit replayTiming(m_scheduler.stats());
+}
+
+void ReplayController::analyzeTake()
+{
+    if (isLoading()) {
+        qWarning() << "ReplayController: Take is still loading.";
+        return;
+    }
+
+    if (loadedFrameCount() == 0) {
+        qWarning() << "ReplayController: No frames to analyze.";
+        return;
+    }
+
+    // A mapped take stays mapped; each chunk of the analysis decodes only its own frames
+    if (m_take) {
+        emit analyzeFrames(std::make_shared<TakeReaderFrames>(m_take));
+    } else {
+        emit analyzeFrames(std::make_shared<VectorTakeFrames>(m_savedFrames));
+    }
+}
+
+void ReplayController::startLoading(std::shared_ptr<JsonTakeParser> parser)
+{
+    const quint64 generation = ++m_loadGeneration;
+    m_loader = parser;
+
+    // Frames come back to this thread in batches, so replay can start on the first one
+    m_loadPool.start([this, parser, generation] {
+        const bool ok = parser->parseFrames([this, generation](QVector<FramePtr> frames) {
+            QMetaObject::invokeMethod(this, [this, generation, frames] {
+                appendLoadedFrames(generation, frames);
+            }, Qt::QueuedConnection);
+        });
+        if (!ok) {
+            qWarning() << "Failed to load JSON take:" << parser->errorString();
+        }
+
+        QMetaObject::invokeMethod(this, [this, generation, ok] {
+            finishLoading(generation, ok);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ReplayController::cancelLoading()
+{
+    if (m_loader) {
+        m_loader->cancel();
+    }
+    m_loadPool.waitForDone();
+
+    // Batches still queued belong to the canceled load
+    ++m_loadGeneration;
+    m_loader.reset();
+}
+
+void ReplayController::appendLoadedFrames(quint64 generation, const QVector<FramePtr>& frames)
+{
+    if (generation == m_loadGeneration) {
+        m_savedFrames.append(frames);
+    }
+}
+
+void ReplayController::finishLoading(quint64 generation, bool ok)
+{
+    if (generation != m_loadGeneration) {
         return;
     }
 
-    emit replayFrame(m_savedFrames[m_currentIndex]);
-    ++m_currentIndex;
+    m_loader.reset();
+    if (ok) {
+        qDebug() << "Loaded" << m_savedFrames.size() << "frames.";
+    }
+}
+
+int ReplayController::loadedFrameCount() const
+{
+    return m_take ? static_cast<int>(m_take->frameCount()) : static_cast<int>(m_savedFrames.size());
+}
+
+FramePtr ReplayController::loadedFrame(int index) const
+{
+    return m_take ? m_take->frame(static_cast<size_t>(index)) : m_savedFrames[index];
+}
+
+int ReplayController::loadedIndexAtTime(double timestamp, int from) const
+{
+    if (m_take) {
+        return std::max(from, static_cast<int>(m_take->indexAtTime(timestamp)));
+    }
 
-    qint64 elapsed = m_lastFrameTime.elapsed();
-    int delay = std::max(0, m_intervalMs - static_cast<int>(elapsed));
-    m_lastFrameTime.restart();
+    const auto next = std::upper_bound(m_savedFrames.cbegin() + from, m_savedFrames.cend(), timestamp,
+                                       [](double time, const FramePtr& frame) { return time < frame->timestamp; });
+    return std::max(from, static_cast<int>(next - m_savedFrames.cbegin()) - 1);
+}
 
-    // Only continue if replay is still active
-    if (m_isReplaying) {
-        QTimer::singleShot(delay, this, &ReplayController::emitNextFrame);
+void ReplayController::setPlaySpeed(QString playspeed)
+{
+    if (playspeed == "Max") {
+        m_scheduler.setSpeed(ReplayScheduler::kAsFastAsPossible);
+        return;
     }
 
+    bool ok = false;
+    const double speed = playspeed.remove('%').toDouble(&ok) / 100.0;
+    if (!ok || speed <= 0.0) {
+        qWarning() << "ReplayController: Unknown play speed" << playspeed << "- replaying at 100%.";
+        m_scheduler.setSpeed(1.0);
+        return;
+    }
+    m_scheduler.setSpeed(speed);
 }
 
 void ReplayController::setDataProcessor(DataProcessor* processor) {
@@ -75,6 +270,11 @@ void ReplayController::setOpenGLWidget(GLWidget* widget) {
 void ReplayController::recordStream(ConnectionSettings ConnectionSettings, bool isRecording)
 {
     m_isRecording = isRecording;
+
+    // The recorder writes the stream to disk as it arrives
+    if (m_isRecording) {
+        emit startStreamRecording(newTakePath(), takeHeader());
+    }
 }
 
 void ReplayController::recordReplay(bool isRecording)
@@ -86,21 +286,15 @@ void ReplayController::loadCommonTake(QString filename, QString playspeed)
 {
     qDebug() << "Loading common take:" << filename;
 
-    double scaleFactor = playspeed.remove('%').toDouble() / 100.0;
-    m_intervalMs = static_cast<int>(1 / scaleFactor);
+    setPlaySpeed(playspeed);
 
     QString filePath = ":json/src/assets/json/" + filename;
 
-    QJsonObject root;
-    if (!loadJsonFile(filePath, root)) {
+    if (!loadTake(filePath)) {
         qWarning() << "Failed to load common take file.";
         return;
     }
 
-    parseIdMaps(root);
-    parseFrames(root["frames"].toArray());
-    parseGLAssets(root["glAssets"].toObject());
-
     emit commonTakeReady(true);
 }
 
@@ -108,142 +302,55 @@ void ReplayController::loadSavedTake(QString filename, QString playspeed)
 {
     qDebug() << "Loading saved take:" << filename;
 
-    double scaleFactor = playspeed.remove('%').toDouble() / 100.0;
-    m_intervalMs = static_cast<int>(1 / scaleFactor);
+    setPlaySpeed(playspeed);
 
     QString filePath = QCoreApplication::applicationDirPath() + "/saved_takes/" + filename;
 
-    QJsonObject root;
-    if (!loadJsonFile(filePath, root)) {
+    if (!loadTake(filePath)) {
         qWarning() << "Failed to load saved take file.";
         return;
     }
 
-    parseIdMaps(root);
-    parseFrames(root["frames"].toArray());
-    parseGLAssets(root["glAssets"].toObject());
-
     emit savedTakeReady(true);
 }
 
-bool ReplayController::loadJsonFile(const QString& path, QJsonObject& outRoot)
-{
-    QFile file(path);
-    if (!file.open(QIODevice::ReadOnly)) {
-        qWarning() << "Failed to open JSON file:" << path;
-        return false;
-    }
-
-    QByteArray jsonData = file.readAll();
-    file.close();
-
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(jsonData, &parseError);
-    if (parseError.error != QJsonParseError::NoError) {
-        qWarning() << "JSON parse error:" << parseError.errorString();
-        return false;
-    }
-
-    if (!doc.isObject()) {
-        qWarning() << "JSON root is not an object in:" << path;
-        return false;
-    }
-
-    outRoot = doc.object();
-    return true;
-}
-
-void ReplayController::parseFrames(const QJsonArray& framesJson)
+bool ReplayController::loadTake(const QString& path)
 {
-    m_savedFrames.clear();
-
-    for (const QJsonValue& frameVal : framesJson) {
-        QJsonObject frameObj = frameVal.toObject();
-
-        FrameData frame;
-        frame.frameNumber = frameObj["frameNumber"].toInt();
-        frame.timestamp = frameObj["timestamp"].toDouble();
-
-        // Rigid Bodies
-        QJsonArray rigidBodiesJson = frameObj["rigidBodies"].toArray();
-        for (const QJsonValue& rbVal : rigidBodiesJson) {
-            QJsonObject rbObj = rbVal.toObject();
-            RigidBodyData rb;
-            rb.id = rbObj["id"].toInt();
-            rb.parentId = rbObj["parentId"].toInt();
-
-            QJsonArray pos = rbObj["position"].toArray();
-            if (pos.size() == 3)
-                rb.position = QVector3D(pos[0].toDouble(), pos[1].toDouble(), pos[2].toDouble());
-
-            QJsonArray ori = rbObj["orientation"].toArray();
-            if (ori.size() == 4)
-                rb.orientation = QQuaternion(ori[3].toDouble(), ori[0].toDouble(), ori[1].toDouble(), ori[2].toDouble());
-
-            frame.rigidBodies.push_back(rb);
+    TakeHeader header;
+
+    if (path.endsWith(".take", Qt::CaseInsensitive)) {
+        // Binary takes are mapped and their frames decoded as they are replayed
+        auto reader = std::make_unique<TakeReader>();
+        if (!reader->open(path)) {
+            qWarning() << "Failed to read binary take:" << path << reader->errorString();
+            return false;
         }
 
-        // Skeletons
-        QJsonArray skeletonsJson = frameObj["skeletons"].toArray();
-        for (const QJsonValue& skelVal : skeletonsJson) {
-            QJsonObject skelObj = skelVal.toObject();
-            SkeletonData skeleton;
-            skeleton.id = skelObj["id"].toInt();
-
-            QJsonArray bonesJson = skelObj["bones"].toArray();
-            for (const QJsonValue& boneVal : bonesJson) {
-                QJsonObject boneObj = boneVal.toObject();
-                RigidBodyData bone;
-                bone.id = boneObj["id"].toInt();
-                bone.parentId = boneObj["parentId"].toInt();
-
-                QJsonArray pos = boneObj["position"].toArray();
-                if (pos.size() == 3)
-                    bone.position = QVector3D(pos[0].toDouble(), pos[1].toDouble(), pos[2].toDouble());
-
-                QJsonArray ori = boneObj["orientation"].toArray();
-                if (ori.size() == 4)
-                    bone.orientation = QQuaternion(ori[3].toDouble(), ori[0].toDouble(), ori[1].toDouble(), ori[2].toDouble());
-
-                skeleton.bones.push_back(bone);
-            }
+        header = reader->header();
+        qDebug() << "Mapped" << reader->frameCount() << "frames.";
 
-            frame.skeletons.push_back(skeleton);
+        cancelLoading();
+        m_savedFrames.clear();
+        m_take = std::move(reader);
+    } else {
+        // JSON takes are ready once their header is read; the frames follow in the background
+        auto parser = std::make_shared<JsonTakeParser>();
+        if (!parser->open(path)) {
+            qWarning() << "Failed to read JSON take:" << path << parser->errorString();
+            return false;
         }
 
-        m_savedFrames.push_back(frame);
-    }
-
-    qDebug() << "Parsed" << m_savedFrames.size() << "frames.";
-}
-
-void ReplayController::parseIdMaps(const QJsonObject& root)
-{
-    std::unordered_map<int, std::string> rigidBodyMap;
-    QJsonObject rbMapJson = root.value("rigidBodies").toObject();
-    for (const QString& key : rbMapJson.keys()) {
-        rigidBodyMap[key.toInt()] = rbMapJson.value(key).toString().toStdString();
-    }
+        header = parser->header();
 
-    std::unordered_map<int, std::string> skeletonMap;
-    QJsonObject skelMapJson = root.value("skeletons").toObject();
-    for (const QString& key : skelMapJson.keys()) {
-        skeletonMap[key.toInt()] = skelMapJson.value(key).toString().toStdString();
-    }
-
-    std::unordered_map<int, std::unordered_map<int, std::string>> boneMap;
-    QJsonObject boneMapJson = root.value("bones").toObject();
-    for (const QString& skeletonIdStr : boneMapJson.keys()) {
-        int skeletonId = skeletonIdStr.toInt();
-        QJsonObject boneSubMap = boneMapJson.value(skeletonIdStr).toObject();
-        std::unordered_map<int, std::string> subMap;
-        for (const QString& boneIdStr : boneSubMap.keys()) {
-            subMap[boneIdStr.toInt()] = boneSubMap.value(boneIdStr).toString().toStdString();
-        }
-        boneMap[skeletonId] = subMap;
+        cancelLoading();
+        m_take.reset();
+        m_savedFrames.clear();
+        startLoading(parser);
     }
 
-    emit loadReplayMaps(rigidBodyMap, skeletonMap, boneMap);
+    emit loadReplayMaps(header.rigidBodies, header.skeletons, header.bones);
+    parseGLAssets(header.glAssets);
+    return true;
 }
 
 void ReplayController::parseGLAssets(const QJsonObject& glAssetsObj)
@@ -296,12 +403,18 @@ void ReplayController::parseGLAssets(const QJsonObject& glAssetsObj)
 void ReplayController::saveStream()
 {
     if (m_isRecording){
-        m_savedFrames = QVector<FrameData>(m_dataProcessor->getFrames().begin(), m_dataProcessor->getFrames().end());
-        m_currentIndex = m_savedFrames.size();
-        saveTake();
+        // Only the frames since the recorder's last drain and the trailer are left to write
+        emit stopStreamRecording(takeHeader());
+        m_isRecording = false;
     }
 }
 
+void ReplayController::onStreamRecordingSaved(QString path, quint64 frameCount)
+{
+    qDebug() << "Stream saved to" << path << "-" << frameCount << "frames";
+    emit newSavedTake();
+}
+
 void ReplayController::saveReplay()
 {
     stopReplay();
@@ -312,92 +425,59 @@ void ReplayController::saveReplay()
 
 void ReplayController::saveTake()
 {
-qDebug() << "Saving frames and ID maps";
+    qDebug() << "Saving frames and ID maps";
 
-    QJsonObject root;
-
-    // --- Save ID-to-name maps ---
-
-    QJsonObject rigidMap;
-    for (const auto& [id, name] : m_dataProcessor->getRigidBodyMap()) {
-        rigidMap[QString::number(id)] = QString::fromStdString(name);
-    }
-    root["rigidBodies"] = rigidMap;
-
-    QJsonObject skeletonMap;
-    for (const auto& [id, name] : m_dataProcessor->getSkeletonNameMap()) {
-        skeletonMap[QString::number(id)] = QString::fromStdString(name);
-    }
-    root["skeletons"] = skeletonMap;
+    const QString savePath = newTakePath();
 
-    QJsonObject bonesMap;
-    for (const auto& [skeletonId, boneMap] : m_dataProcessor->getBoneNameMap()) {
-        QJsonObject boneObj;
-        for (const auto& [boneId, boneName] : boneMap) {
-            boneObj[QString::number(boneId)] = QString::fromStdString(boneName);
+    // Save to file
+    TakeWriter writer;
+    writer.setEncoding(TakeEncoding::quantized());
+    if (writer.open(savePath, takeHeader())) {
+        for (int i = 0; i < m_currentIndex && i < loadedFrameCount(); ++i) {
+            if (!writer.writeFrame(*loadedFrame(i))) {
+                break;
+            }
         }
-        bonesMap[QString::number(skeletonId)] = boneObj;
-    }
-    root["bones"] = bonesMap;
-
-    // --- Save frame data ---
-
-    QJsonArray framesArray;
-
-    for (int i = 0; i < m_currentIndex && i < m_savedFrames.size(); ++i) {
-        const FrameData& frame = m_savedFrames[i];
-
-        QJsonObject frameObj;
-        frameObj["frameNumber"] = frame.frameNumber;
-        frameObj["timestamp"] = frame.timestamp;
-
-        QJsonArray rigidArray;
-        for (const RigidBodyData& rb : frame.rigidBodies) {
-            QJsonObject rbObj;
-            rbObj["id"] = rb.id;
-            rbObj["parentId"] = rb.parentId;
-
-            QJsonArray posArray = { rb.position.x(), rb.position.y(), rb.position.z() };
-            rbObj["position"] = posArray;
-
-            QJsonArray orientArray = { rb.orientation.x(), rb.orientation.y(), rb.orientation.z(), rb.orientation.scalar() };
-            rbObj["orientation"] = orientArray;
 
-            rigidArray.append(rbObj);
+        if (writer.close()) {
+            qDebug() << "Full session saved to" << savePath << "-" << writer.framesWritten() << "frames";
+        } else {
+            qWarning() << "Failed to write take:" << savePath << writer.errorString();
         }
-        frameObj["rigidBodies"] = rigidArray;
-
-        QJsonArray skeletonArray;
-        for (const SkeletonData& skeleton : frame.skeletons) {
-            QJsonObject skeletonObj;
-            skeletonObj["id"] = skeleton.id;
-
-            QJsonArray bonesArray;
-            for (const RigidBodyData& bone : skeleton.bones) {
-                QJsonObject boneObj;
-                boneObj["id"] = bone.id;
-                boneObj["parentId"] = bone.parentId;
-
-                QJsonArray posArray = { bone.position.x(), bone.position.y(), bone.position.z() };
-                boneObj["position"] = posArray;
+    } else {
+        qWarning() << "Failed to open file for saving:" << savePath << writer.errorString();
+    }
 
-                QJsonArray orientArray = { bone.orientation.x(), bone.orientation.y(), bone.orientation.z(), bone.orientation.scalar() };
-                boneObj["orientation"] = orientArray;
+    m_isRecording = false;
+    emit newSavedTake();
+}
 
-                bonesArray.append(boneObj);
-            }
-            skeletonObj["bones"] = bonesArray;
-            skeletonArray.append(skeletonObj);
-        }
-        frameObj["skeletons"] = skeletonArray;
+QString ReplayController::newTakePath() const
+{
+    // Get the program's directory
+    QString appDir = QCoreApplication::applicationDirPath();
+    QString saveDir = QDir(appDir).filePath("saved_takes");
 
-        framesArray.append(frameObj);
-    }
+    // Create the directory if it doesn't exist
+    QDir().mkpath(saveDir);
 
-    root["frames"] = framesArray;
+    QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
+    QString fileName = QString("take_%1.take").arg(timestamp);
+    return QDir(saveDir).filePath(fileName);
+}
 
-    // --- Save GLWidget data ---
+TakeHeader ReplayController::takeHeader() const
+{
+    TakeHeader header;
+    header.rigidBodies = m_dataProcessor->getRigidBodyMap();
+    header.skeletons = m_dataProcessor->getSkeletonNameMap();
+    header.bones = m_dataProcessor->getBoneNameMap();
+    header.glAssets = serializeGLAssets();
+    return header;
+}
 
+QJsonObject ReplayController::serializeGLAssets() const
+{
     GLWidgetAssets glassets = m_openGLWidget->getAssets();
 
     qDebug() << "Recieved gl skeletons" << glassets.skeletons;
@@ -426,40 +506,13 @@ qDebug() << "Saving frames and ID maps";
             markerArray.append(QJsonArray{ vec.x(), vec.y(), vec.z() });
         }
 
-    offsetObj["markerOffsets"] = markerArray;
-    offsetsArray.append(offsetObj);
-}
+        offsetObj["markerOffsets"] = markerArray;
+        offsetsArray.append(offsetObj);
+    }
 
     // Combine into a GL assets object
     QJsonObject glAssetsObj;
     glAssetsObj["skeletons"] = skeletonsArray;
     glAssetsObj["rbOffsets"] = offsetsArray;
-
-    // Add to root
-    root["glAssets"] = glAssetsObj;
-
-    QJsonDocument doc(root);
-    // Get the program's directory
-    QString appDir = QCoreApplication::applicationDirPath();
-    QString saveDir = QDir(appDir).filePath("saved_takes");
-
-    // Create the directory if it doesn't exist
-    QDir().mkpath(saveDir);
-
-    QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
-    QString fileName = QString("take_%1.json").arg(timestamp);    
-    QString savePath = QDir(saveDir).filePath(fileName);
-
-    // Save to file
-    QFile file(savePath);
-    if (file.open(QIODevice::WriteOnly)) {
-        file.write(doc.toJson(QJsonDocument::Indented));
-        file.close();
-        qDebug() << "Full session saved to" << savePath;
-    } else {
-        qWarning() << "Failed to open file for saving:" << savePath;
-    }
-
-    m_isRecording = false;
-    emit newSavedTake();
-}
\ No newline at end of file
+    return glAssetsObj;
+}
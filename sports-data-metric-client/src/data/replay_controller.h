@@ -1,31 +1,52 @@
 #pragma once
 
+#include <memory>
+#include <QElapsedTimer>
 #include <QObject>
+#include <QThreadPool>
 #include <QVector>
 #include <QTimer>
 #include "frame_data.h"
 #include "glwidget.h"
+#include "replay_scheduler.h"
+#include "take_format.h"
+#include "take_frames.h"
 
 class DataProcessor;
+class JsonTakeParser;
+class TakeReader;
 
 /**
  * @brief Controls replay functionality for recorded motion capture data.
  *
- * This class manages playback of saved frames, loading from JSON files,
+ * This class manages playback of saved frames, loading from JSON or binary takes,
  * and interfacing with rendering and data processing components. It also
  * handles recording of streamed or replayed takes.
+ *
+ * JSON takes load in the background: their frames are appended as they are
+ * parsed, and a replay that catches up with loading waits for more.
+ *
+ * Frames are emitted when their timestamps fall due at the chosen play speed
+ * (see ReplayScheduler), or as fast as the event loop allows at "Max".
  */
 class ReplayController : public QObject
 {
     Q_OBJECT
 
 public:
+    static constexpr int kLoadWaitIntervalMs = 10;  // How often a replay that caught up with loading checks for frames
+    static constexpr int kMaxFramesPerPass = 32;    // Frames emitted back to back before the event loop runs again
+    static constexpr int64_t kEarlyToleranceNs = 500000;    // Frames due this soon are emitted now; timers have millisecond resolution
+    static constexpr int kReplayTimingIntervalMs = 1000;    // Period of replayTiming() while replaying
+
     /**
      * @brief Constructs the ReplayController.
      * @param parent Optional parent QObject.
      */
     explicit ReplayController(QObject* parent = nullptr);
 
+    ~ReplayController() override;
+
     /**
      * @brief Sets the data processor used to compute metrics.
      * @param processor Pointer to the data processor.
@@ -40,27 +61,32 @@ public:
 
     /**
      * @brief Loads frames into the controller for replay.
-     * @param frames A vector of saved FrameData.
+     * @param frames A vector of shared handles to saved FrameData.
      */
-    void setSavedFrames(const QVector<FrameData>& frames);
+    void setSavedFrames(const QVector<FramePtr>& frames);
 
     /**
      * @brief Stops the current replay if active.
      */
     void stopReplay();
 
+    /**
+     * @brief How closely the current or last replay kept to the frame timestamps.
+     */
+    ReplayTimingStats getReplayTiming() const { return m_scheduler.stats(); }
+
 public slots:
     /**
      * @brief Loads a commonly formatted take for replay.
      * @param filename The file to load.
-     * @param playspeed The playback speed setting.
+     * @param playspeed The playback speed setting, e.g. "200%" or "Max".
      */
     void loadCommonTake(QString filename, QString playspeed);
 
     /**
      * @brief Loads a previously saved take.
      * @param filename The file to load.
-     * @param playspeed The playback speed setting.
+     * @param playspeed The playback speed setting, e.g. "200%" or "Max".
      */
     void loadSavedTake(QString filename, QString playspeed);
 
@@ -69,6 +95,11 @@ public slots:
      */
     void startReplay();
 
+    /**
+     * @brief Hands every loaded frame to the data processor for batch analysis, once loading is done.
+     */
+    void analyzeTake();
+
     /**
      * @brief Saves the current replayed frames.
      */
@@ -88,10 +119,17 @@ public slots:
     void recordReplay(bool isRecording);
 
     /**
-     * @brief Saves data if it was recorded during a stream.
+     * @brief Stops recording the stream, if it was recorded.
      */
     void saveStream();
 
+    /**
+     * @brief Handles a stream recording that the recorder closed.
+     * @param path The take file.
+     * @param frameCount Frames recorded.
+     */
+    void onStreamRecordingSaved(QString path, quint64 frameCount);
+
     /**
      * @brief Saves data if it was recorded during a replay.
      */
@@ -103,7 +141,19 @@ signals:
      * @brief Signal emitted with the current frame to replay.
      * @param frame The frame being replayed.
      */
-    void replayFrame(FrameData frame);
+    void replayFrame(FramePtr frame);
+
+    /**
+     * @brief Signal emitted with the replay's timing, periodically while replaying and once when it stops.
+     * @param timing How closely the frames emitted so far kept to their timestamps.
+     */
+    void replayTiming(ReplayTimingStats timing);
+
+    /**
+     * @brief Signal emitted with the whole loaded take, to compute its metrics at once.
+     * @param frames Every frame of the take, in order; a mapped take is decoded as it is read.
+     */
+    void analyzeFrames(TakeFramesPtr frames);
 
     /**
      * @brief Signal to load rigid body, skeleton, and bone ID maps.
@@ -132,49 +182,116 @@ signals:
      */
     void newSavedTake();
 
+    /**
+     * @brief Signal to start recording the stream to a take.
+     * @param path File to record to.
+     * @param header ID-to-name maps and rendering assets known so far.
+     */
+    void startStreamRecording(QString path, TakeHeader header);
+
+    /**
+     * @brief Signal to stop recording the stream and close its take.
+     * @param header Final ID-to-name maps and rendering assets.
+     */
+    void stopStreamRecording(TakeHeader header);
+
 
 private slots:
     /**
-     * @brief Emits the next frame in the replay sequence.
+     * @brief Emits the frames that are due, and sets the timer for the next one.
      */
     void emitNextFrame();
 
+    /**
+     * @brief Emits replayTiming() with the current replay timing.
+     */
+    void publishReplayTiming();
+
 private:
-    QVector<FrameData> m_savedFrames;  // Stored frames for replay.
+    QVector<FramePtr> m_savedFrames;   // Stored frames for replay.
+    std::shared_ptr<TakeReader> m_take; // Mapped binary take replayed instead of m_savedFrames, if loaded; shared with its analysis
+    QThreadPool m_loadPool;            // Parses a JSON take into m_savedFrames in the background.
+    std::shared_ptr<JsonTakeParser> m_loader; // The JSON take being parsed, if any.
+    quint64 m_loadGeneration = 0;      // Identifies the current load; frames of earlier loads are dropped.
     int m_currentIndex = 0;            // Index of the current replay frame.
-    QTimer m_timer;                    // Timer to control frame playback.
+    QTimer m_timer;                    // Wakes the replay when its next frame is due.
+    QTimer m_timingTimer;              // Publishes the replay timing while replaying.
+    QElapsedTimer m_clock;             // Steady clock the replay is paced by.
     bool m_isReplaying = false;        // Whether replay is active.
-    int m_intervalMs = 1;              // Time interval between frames (ms).
+    ReplayScheduler m_scheduler;       // Play speed and due times of the replayed frames.
     bool m_isRecording = false;        // Whether recording is enabled.
 
-    QElapsedTimer m_lastFrameTime;     // Timer for tracking real-time playback.
-
     DataProcessor* m_dataProcessor = nullptr; // Pointer to the data processor.
     GLWidget* m_openGLWidget = nullptr;       // Pointer to the OpenGL widget.
 
     /**
-     * @brief Loads a JSON file from disk.
-     * @param path Path to the JSON file.
-     * @param outRoot Output root object to populate.
+     * @brief Loads a JSON or binary take, by its suffix, for replay.
+     * @param path Path to the take file.
      * @return True if load was successful, false otherwise.
      */
-    bool loadJsonFile(const QString& path, QJsonObject& outRoot);
+    bool loadTake(const QString& path);
 
     /**
-     * @brief Parses frames from a JSON array into FrameData objects.
-     * @param framesJson JSON array of frame objects.
+     * @brief Parses the frames of an opened JSON take into m_savedFrames on the load pool.
      */
-    void parseFrames(const QJsonArray& framesJson);
+    void startLoading(std::shared_ptr<JsonTakeParser> parser);
 
     /**
-     * @brief Parses identifier-to-name maps from JSON.
-     * @param root Root object containing mapping data.
+     * @brief Stops a JSON take that is still loading; the frames loaded so far are kept.
      */
-    void parseIdMaps(const QJsonObject& root);
+    void cancelLoading();
+
+    /**
+     * @brief Appends frames parsed by load @p generation, unless it was superseded.
+     */
+    void appendLoadedFrames(quint64 generation, const QVector<FramePtr>& frames);
+
+    /**
+     * @brief Ends load @p generation, unless it was superseded.
+     */
+    void finishLoading(quint64 generation, bool ok);
+
+    bool isLoading() const { return m_loader != nullptr; }
+
+    /**
+     * @brief Number of frames of the loaded take.
+     */
+    int loadedFrameCount() const;
+
+    /**
+     * @brief Frame @p index of the loaded take, decoded from the mapped take if there is one.
+     */
+    FramePtr loadedFrame(int index) const;
+
+    /**
+     * @brief Index of the last loaded frame at or before @p timestamp, but no earlier than @p from.
+     */
+    int loadedIndexAtTime(double timestamp, int from) const;
+
+    /**
+     * @brief Sets the replay speed from a play speed setting such as "50%" or "Max".
+     */
+    void setPlaySpeed(QString playspeed);
 
     /**
      * @brief Parses OpenGL assets used in rendering.
      * @param glAssetsObj JSON object containing asset data.
      */
     void parseGLAssets(const QJsonObject& glAssetsObj);
+
+    /**
+     * @brief Serializes the OpenGL widget's assets for saving with a take.
+     * @return JSON object with skeleton bone pairs and rigid body marker offsets.
+     */
+    QJsonObject serializeGLAssets() const;
+
+    /**
+     * @brief Path of a new timestamped take in the saved takes directory, which is created if needed.
+     */
+    QString newTakePath() const;
+
+    /**
+     * @brief ID-to-name maps of the data processor and the OpenGL widget's assets, for saving a take.
+     */
+    TakeHeader takeHeader() const;
 };
@@ -0,0 +1,87 @@
+#include "replay_scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+void ReplayScheduler::setSpeed(double speed)
+{
+    m_speed = speed == kAsFastAsPossible ? kAsFastAsPossible : std::clamp(speed, kMinSpeed, kMaxSpeed);
+    m_anchored = false;
+}
+
+void ReplayScheduler::start(int64_t nowNs)
+{
+    m_anchored = false;
+
+    m_startNs = nowNs;
+    m_lastEmittedNs = nowNs;
+    m_frames = 0;
+    m_droppedFrames = 0;
+    m_errorSumMs = 0.0;
+    m_lateness.reset();
+}
+
+int64_t ReplayScheduler::nanosecondsUntilDue(double timestamp, int64_t nowNs)
+{
+    if (isAsFastAsPossible()) {
+        return 0;
+    }
+
+    const double step = timestamp - m_lastTimestamp;
+    if (!m_anchored || !(step >= 0.0 && step <= kMaxTimestampGap)) {
+        anchor(timestamp, nowNs);
+    }
+    m_lastTimestamp = timestamp;
+
+    return dueNs(timestamp) - nowNs;
+}
+
+double ReplayScheduler::dueTimestamp(int64_t nowNs) const
+{
+    return m_anchorTimestamp + (nowNs - m_anchorNs) * m_speed / 1e9;
+}
+
+void ReplayScheduler::frameEmitted(double timestamp, int64_t nowNs)
+{
+    ++m_frames;
+    m_lastTimestamp = timestamp;
+    m_lastEmittedNs = nowNs;
+    if (isAsFastAsPossible() || !m_anchored) {
+        return;
+    }
+
+    const double errorMs = (nowNs - dueNs(timestamp)) / 1e6;
+    m_errorSumMs += errorMs;
+    m_lateness.record(errorMs);
+}
+
+ReplayTimingStats ReplayScheduler::stats() const
+{
+    ReplayTimingStats stats;
+    stats.speed = m_speed;
+    stats.frames = m_frames;
+    stats.droppedFrames = m_droppedFrames;
+    stats.lateness = m_lateness.summary();
+    if (stats.lateness.samples > 0) {
+        stats.meanErrorMs = m_errorSumMs / stats.lateness.samples;
+    }
+
+    // Up to the last frame, so the rate holds once the replay has stopped
+    const double elapsed = (m_lastEmittedNs - m_startNs) / 1e9;
+    if (elapsed > 0.0) {
+        stats.framesPerSecond = m_frames / elapsed;
+    }
+    return stats;
+}
+
+void ReplayScheduler::anchor(double timestamp, int64_t nowNs)
+{
+    m_anchored = true;
+    m_anchorNs = nowNs;
+    m_anchorTimestamp = timestamp;
+}
+
+int64_t ReplayScheduler::dueNs(double timestamp) const
+{
+    return m_anchorNs + static_cast<int64_t>(std::llround((timestamp - m_anchorTimestamp) / m_speed * 1e9));
+}
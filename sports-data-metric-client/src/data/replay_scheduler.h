@@ -0,0 +1,119 @@
+// Paces a replay by the timestamps of its frames.
+//
+// Each frame is due when the clock has advanced by its timestamp's distance
+// from an anchor frame, divided by the replay speed. The clock is the caller's:
+// every call takes the current time in nanoseconds, so the pacing can be driven
+// by a steady clock in the application and by a simulated one in tests. Due times are
+// absolute, so timer wakeups that come late do not add up over a take. The
+// clock is re-anchored on the first frame, after pause(), and where the
+// timestamps step backwards or jump by more than kMaxTimestampGap, so a bad
+// timestamp delays or hurries at most one frame.
+//
+// A replay that falls behind emits the frames it owes back to back; frames
+// more than kMaxLagNs behind are dropped instead, skipping to the one due
+// now. At speed 0 frames are due as soon as they are asked for.
+
+#pragma once
+
+#include <cstdint>
+#include <QMetaType>
+
+#include "stream_tracker.h"
+
+/**
+ * @brief How closely a replay kept to the timestamps of its frames.
+ */
+struct ReplayTimingStats {
+    double speed = 1.0;                 // Replay speed; 0 if as fast as possible
+    uint64_t frames = 0;                // Frames emitted
+    uint64_t droppedFrames = 0;         // Frames skipped to catch up with the clock
+    double meanErrorMs = 0.0;           // Emission less due time, averaged; negative if frames left early
+    LatencySummary lateness;            // Emission less due time; early frames count as on time
+    double framesPerSecond = 0.0;       // Frames emitted per second, from the start to the last frame
+};
+
+Q_DECLARE_METATYPE(ReplayTimingStats)
+
+class ReplayScheduler {
+public:
+    static constexpr double kMinSpeed = 0.1;
+    static constexpr double kMaxSpeed = 10.0;
+    static constexpr double kAsFastAsPossible = 0.0;
+    static constexpr double kMaxTimestampGap = 1.0;         // Seconds of take time between frames before the clock is re-anchored
+    static constexpr int64_t kMaxLagNs = 100000000;         // Frames later than this are dropped rather than caught up
+
+    /**
+     * @brief Sets the replay speed, clamped to [kMinSpeed, kMaxSpeed]; kAsFastAsPossible paces nothing.
+     *
+     * Re-anchors the clock, so frames already emitted keep their timing.
+     */
+    void setSpeed(double speed);
+
+    double speed() const { return m_speed; }
+    bool isAsFastAsPossible() const { return m_speed == kAsFastAsPossible; }
+
+    /**
+     * @brief Starts the replay at @p nowNs and clears the statistics.
+     */
+    void start(int64_t nowNs);
+
+    /**
+     * @brief Re-anchors the clock on the next frame, so waiting for frames does not count against them.
+     */
+    void pause() { m_anchored = false; }
+
+    /**
+     * @brief Nanoseconds from @p nowNs until the frame with @p timestamp is due; zero or less once it is.
+     *
+     * Anchors the clock on this frame if it is the first since start() or
+     * pause(), or if its timestamp breaks from the previous frame's.
+     */
+    int64_t nanosecondsUntilDue(double timestamp, int64_t nowNs);
+
+    /**
+     * @brief Whether a frame that is @p lateNs nanoseconds overdue should be dropped.
+     */
+    bool isTooLate(int64_t lateNs) const { return lateNs > kMaxLagNs; }
+
+    /**
+     * @brief The take time due at @p nowNs, for finding the frame to skip to.
+     */
+    double dueTimestamp(int64_t nowNs) const;
+
+    /**
+     * @brief Records that the frame with @p timestamp was emitted at @p nowNs.
+     */
+    void frameEmitted(double timestamp, int64_t nowNs);
+
+    /**
+     * @brief Records that @p count frames were skipped.
+     */
+    void framesDropped(uint64_t count) { m_droppedFrames += count; }
+
+    /**
+     * @brief How closely the frames emitted since start() kept to their timestamps.
+     */
+    ReplayTimingStats stats() const;
+
+private:
+    /**
+     * @brief Makes the frame with @p timestamp due at @p nowNs.
+     */
+    void anchor(double timestamp, int64_t nowNs);
+
+    int64_t dueNs(double timestamp) const;
+
+    double m_speed = 1.0;
+
+    bool m_anchored = false;
+    int64_t m_anchorNs = 0;             // Clock time the anchor frame was due
+    double m_anchorTimestamp = 0.0;     // Timestamp of the anchor frame
+    double m_lastTimestamp = 0.0;       // Timestamp of the last frame asked about
+
+    int64_t m_startNs = 0;             // Clock time the replay started
+    int64_t m_lastEmittedNs = 0;        // Clock time the last frame was emitted
+    uint64_t m_frames = 0;
+    uint64_t m_droppedFrames = 0;
+    double m_errorSumMs = 0.0;
+    LatencyHistogram m_lateness;
+};
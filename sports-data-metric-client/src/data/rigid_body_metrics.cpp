@@ -2,112 +2,174 @@
 
 #include <QJsonObject>
 
+#include "metric_kernels.h"
+
+namespace {
+
+// Inputs and output of the kernels, one column each
+enum Column {
+    kQw, kQx, kQy, kQz,     // Orientation
+    kVx, kVy, kVz,          // Estimated velocity
+    kAx, kAy, kAz,          // Estimated acceleration
+    kResult,
+    kColumnCount
+};
+
+/**
+ * @brief Buffers of the batch path, kept per thread so a frame allocates nothing.
+ */
+struct BatchScratch {
+    std::vector<int> rows;                          // Batch index of each tracked asset
+    std::vector<const RigidBodyData*> bodies;       // Current pose of each tracked asset
+    std::vector<const PoseRing*> histories;         // Pose history of each tracked asset, if any
+    metric_kernels::ColumnBuffer columns;
+};
+
+thread_local BatchScratch t_scratch;
+
+} // namespace
+
 RigidBodyMetrics::RigidBodyMetrics(QObject* parent)
     : QObject(parent) {
 }
 
-MetricsData RigidBodyMetrics::computeMetricsForFrame(const FrameData& current, const FrameData& previous, const FrameData& secondPrevious) {
-    MetricsData data;
-
+MetricsData RigidBodyMetrics::computeMetricsForFrame(const FrameData& current) {
     // Early exit if no asset selected
     if (selectedAsset == -1) {
-        qDebug() << "No asset selected for metric computation.";
-        return data;
+        return MetricsData();
     }
 
-    for (size_t i = 0; i < current.rigidBodies.size(); ++i) 
-    {
-            const RigidBodyData& curr_rigid = current.rigidBodies[i];
-            const RigidBodyData& prev_rigid = previous.rigidBodies[i];
-            const RigidBodyData& sec_prev_rigid = secondPrevious.rigidBodies[i];
-
-            if (curr_rigid.id != selectedAsset)
-            {
-                continue;
-            }
-        
-            data.id = current.frameNumber;
-
-            QVector3D orientation = curr_rigid.orientation.toEulerAngles();
-
-        for (const QJsonValue& val : m_metricSettings) {
-            QJsonObject metricObj = val.toObject();
-            QString metricClass = metricObj["class"].toString();
-            QJsonArray labels = metricObj["labels"].toArray();
-
-            if (metricClass == "tilt") {
-                qreal tilt = computeTilt(orientation);
-                if (!labels.isEmpty())
-                    data.metrics.insert(labels[0].toString(), tilt);
-
-            } else if (metricClass == "velocity") {
-                qreal velocity = computeVelocity(curr_rigid.position, prev_rigid.position,
-                                                 current.timestamp - previous.timestamp);
-                if (!labels.isEmpty())
-                    data.metrics.insert(labels[0].toString(), velocity);
-
-            } else if (metricClass == "acceleration") {
-                qreal acceleration = computeAcceleration(curr_rigid.position, prev_rigid.position, sec_prev_rigid.position,
-                                                         current.timestamp - previous.timestamp,
-                                                         previous.timestamp - secondPrevious.timestamp);
-                if (!labels.isEmpty())
-                    data.metrics.insert(labels[0].toString(), acceleration);
-
-            } else if (metricClass == "position") {
-                QVector3D pos = curr_rigid.position;
-                for (int j = 0; j < labels.size() && j < 3; ++j) {
-                    data.metrics.insert(labels[j].toString(), pos[j]);
-                }
-
-            } else if (metricClass == "orientation") {
-                for (int j = 0; j < labels.size() && j < 3; ++j) {
-                    data.metrics.insert(labels[j].toString(), orientation[j]);
-                }
-            }
-
-        }
-
-            qDebug() << "RB metrics: " << data.metrics;
+    return computeMetricsForAsset(selectedAsset, current);
+}
 
-            return data;
-    }
+void RigidBodyMetrics::pushFrame(const FrameData& frame)
+{
+    m_history.push(frame);
 }
 
-float RigidBodyMetrics::computeVelocity(const QVector3D& currentPosition, const QVector3D& previousPosition, double deltaTime) const
+MetricsData RigidBodyMetrics::computeMetricsForAsset(int assetId, const FrameData& current) const
 {
-    // handle divide by 0 error
-    if (deltaTime <= 0.0)
-        return 0.0f;
+    AssetMetrics asset{assetId, MetricsData()};
+    computeMetricsForAssets(&asset, 1, current);
+    return asset.metrics;
+}
 
-    QVector3D distance = currentPosition - previousPosition;
-    
-    return distance.length() / deltaTime;
+void RigidBodyMetrics::computeMetricsForAssets(AssetMetrics* assets, int count, const FrameData& current) const
+{
+    computeMetricsForAssets(assets, count, current, m_history);
 }
 
-float RigidBodyMetrics::computeAcceleration(const QVector3D& currentPosition,
-                                            const QVector3D& previousPosition,
-                                            const QVector3D& secondPreviousPosition,
-                                            double currDeltaTime,
-                                            double prevDeltaTime) const
+void RigidBodyMetrics::computeMetricsForAssets(AssetMetrics* assets, int count, const FrameData& current,
+                                               const PoseHistory& history) const
 {
-    // handle divide by 0 error
-    if (currDeltaTime <= 0.0)
-        return 0.0f;
+    BatchScratch& scratch = t_scratch;
+    scratch.rows.clear();
+    scratch.bodies.clear();
+    scratch.histories.clear();
+
+    for (int i = 0; i < count; ++i) {
+        MetricsData& data = assets[i].metrics;
+        data = MetricsData();
+
+        // The asset has the same slot in every frame of the session; found without searching
+        const RigidBodyData* body = current.findRigidBody(assets[i].assetId);
+        if (!body) {
+            continue;
+        }
 
-    float curr_speed = computeVelocity(currentPosition, previousPosition, currDeltaTime);
-    float prev_speed = computeVelocity(previousPosition, secondPreviousPosition, prevDeltaTime);
-    float delta_speed = curr_speed - prev_speed;
+        data.id = current.frameNumber;
+        data.schemaVersion = m_plan.schema().version();
+        data.count = m_plan.schema().slotCount();
 
-    return delta_speed / currDeltaTime;
-}
+        // Until the history holds a full window of the asset, motion metrics read as zero
+        scratch.rows.push_back(i);
+        scratch.bodies.push_back(body);
+        scratch.histories.push_back(history.find(assets[i].assetId));
+    }
 
-float RigidBodyMetrics::computeTilt(const QVector3D& eulerAngles) const
-{
-    float pitch = eulerAngles.x();
-    float roll  = eulerAngles.z();
+    const size_t n = scratch.rows.size();
+    if (n == 0) {
+        return;
+    }
+
+    const metric_kernels::Kernels& kernels = metric_kernels::best();
+    metric_kernels::ColumnBuffer& columns = scratch.columns;
+    columns.reserve(kColumnCount, n);
+    float* result = columns.column(kResult);
+
+    // Inputs are gathered into columns once, on first use by a step
+    bool orientationsGathered = false;
+    int derivativesGathered = -1;   // Estimator whose derivatives fill the columns
 
-    // Compute total tilt angle from horizontal
-    return std::sqrt(pitch * pitch + roll * roll);
+    auto scatter = [&](int slot) {
+        for (size_t r = 0; r < n; ++r) {
+            assets[scratch.rows[r]].metrics.values[slot] = result[r];
+        }
+    };
+
+    for (const MetricStep& step : m_plan.steps()) {
+        switch (step.op) {
+        case MetricOp::Tilt:
+            if (!orientationsGathered) {
+                for (size_t r = 0; r < n; ++r) {
+                    const QQuaternion& q = scratch.bodies[r]->orientation;
+                    columns.column(kQw)[r] = q.scalar();
+                    columns.column(kQx)[r] = q.x();
+                    columns.column(kQy)[r] = q.y();
+                    columns.column(kQz)[r] = q.z();
+                }
+                orientationsGathered = true;
+            }
+            kernels.tilts(columns.quat(kQw), result, n);
+            scatter(step.slot);
+            break;
+        case MetricOp::Velocity:
+        case MetricOp::Acceleration:
+            if (derivativesGathered != step.estimator) {
+                const DerivativeEstimator& estimator = m_plan.estimators()[step.estimator];
+                for (size_t r = 0; r < n; ++r) {
+                    // Invalid estimates are zero, which the kernels turn into zero metrics
+                    const PoseRing* history = scratch.histories[r];
+                    const Derivatives d = history ? estimator.estimate(*history) : Derivatives();
+                    const QVector3D velocity = d.valid ? d.velocity : QVector3D();
+                    const QVector3D acceleration = d.valid ? d.acceleration : QVector3D();
+                    for (int axis = 0; axis < 3; ++axis) {
+                        columns.column(kVx + axis)[r] = velocity[axis];
+                        columns.column(kAx + axis)[r] = acceleration[axis];
+                    }
+                }
+                derivativesGathered = step.estimator;
+            }
+            if (step.op == MetricOp::Velocity) {
+                kernels.speeds(columns.vec3(kVx), result, n);
+            } else {
+                kernels.tangentialAccelerations(columns.vec3(kVx), columns.vec3(kAx), result, n);
+            }
+            scatter(step.slot);
+            break;
+        case MetricOp::Position:
+            for (size_t r = 0; r < n; ++r) {
+                qreal* values = assets[scratch.rows[r]].metrics.values.data();
+                for (int j = 0; j < step.count; ++j) {
+                    values[step.slot + j] = scratch.bodies[r]->position[j];
+                }
+            }
+            break;
+        case MetricOp::Orientation:
+            for (size_t r = 0; r < n; ++r) {
+                qreal* values = assets[scratch.rows[r]].metrics.values.data();
+                const QVector3D orientation = scratch.bodies[r]->orientation.toEulerAngles();
+                for (int j = 0; j < step.count; ++j) {
+                    values[step.slot + j] = orientation[j];
+                }
+            }
+            break;
+        case MetricOp::JointAngle:
+        case MetricOp::HorizontalDistance:
+            // Skeleton metrics; not part of a rigid body plan
+            break;
+        }
+    }
 }
 
 void RigidBodyMetrics::setRigidBodyMap(const std::unordered_map<int, std::string> rigidBodies) {
@@ -142,5 +204,6 @@ const std::unordered_map<int, std::string>& RigidBodyMetrics::getRigidBodyMap()
 
 void RigidBodyMetrics::setMetricSettings(QJsonArray rigidMetricsSettings)
 {
-    m_metricSettings = rigidMetricsSettings;
+    m_plan = MetricPlan::compile(rigidMetricsSettings);
+    m_history.setDepth(m_plan.historyDepth());
 }
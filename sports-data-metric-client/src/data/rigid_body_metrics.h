@@ -4,14 +4,18 @@
 #include <QVector>
 #include <QJsonArray>
 #include "frame_data.h"
+#include "metrics_batch.h"
 #include "metrics_data.h"
+#include "metric_plan.h"
+#include "pose_history.h"
 
 /**
  * @brief Computes per-rigid-body motion metrics for each frame.
  *
  * This class calculates metrics such as velocity, acceleration, and tilt
- * for each rigid body in the current frame. It compares the current frame
- * with previous frames to extract motion data and emits the computed results.
+ * for each rigid body in the current frame. It keeps a short pose history of
+ * every rigid body, from which the configured derivative estimators extract
+ * motion data, and emits the computed results.
  */
 class RigidBodyMetrics : public QObject {
     Q_OBJECT
@@ -23,9 +27,57 @@ public:
      * @brief Constructs a RigidBodyMetrics processor.
      * @param parent Optional Qt parent object.
      */
-    MetricsData computeMetricsForFrame(const FrameData& current,
-                                                        const FrameData& previous,
-                                                        const FrameData& secondPrevious);
+    MetricsData computeMetricsForFrame(const FrameData& current);
+
+    /**
+     * @brief Adds the poses of @p frame to the history the motion metrics read.
+     *
+     * Called once per frame, before any metrics of that frame are computed.
+     *
+     * @param frame The newest frame.
+     */
+    void pushFrame(const FrameData& frame);
+
+    /**
+     * @brief Computes the metrics of one rigid body, selected or not.
+     *
+     * Reads only the compiled settings, so it may run for several assets on
+     * different threads at once, as long as the settings do not change meanwhile.
+     *
+     * @param assetId Motive ID of the rigid body.
+     * @param current The newest frame, as last passed to pushFrame().
+     * @return The metrics; without values if the rigid body is not tracked in @p current.
+     */
+    MetricsData computeMetricsForAsset(int assetId, const FrameData& current) const;
+
+    /**
+     * @brief Computes the metrics of several rigid bodies at once.
+     *
+     * Evaluates each metric for all of them with the vector kernels. Like
+     * computeMetricsForAsset(), it may run on several threads at once.
+     *
+     * @param assets The rigid bodies, by ID; their metrics are overwritten.
+     * @param count Number of entries in @p assets.
+     * @param current The newest frame, as last passed to pushFrame().
+     */
+    void computeMetricsForAssets(AssetMetrics* assets, int count, const FrameData& current) const;
+
+    /**
+     * @brief Like computeMetricsForAssets() above, reading motion from another pose history.
+     *
+     * Lets a take be analyzed in chunks, each with a history of its own, while
+     * the live history is left alone. Safe to call from several threads at once.
+     *
+     * @param current The newest frame, as last pushed to @p history.
+     * @param history Poses of the frames up to and including @p current.
+     */
+    void computeMetricsForAssets(AssetMetrics* assets, int count, const FrameData& current,
+                                 const PoseHistory& history) const;
+
+    /**
+     * @brief Frames of pose history the configured estimators read, including the newest.
+     */
+    int historyDepth() const { return m_history.depth(); }
 
     /**
      * @brief Creates reverse lookup maps (name → ID) for rigid bodies, skeletons, and bones.
@@ -57,53 +109,16 @@ public:
     /**
      * @brief Sets the configuration for rigid body metric calculations.
      *
+     * Compiles the settings into the plan evaluated for every frame.
+     *
      * @param rigidMetricsSettings A QJsonArray containing metric definitions and settings.
      */
     void setMetricSettings(QJsonArray rigidMetricsSettings);
 
 private:
-    /**
-     * @brief Computes velocity between two positions over a time delta.
-     *
-     * @param currentPosition Position in the current frame.
-     * @param previousPosition Position in the previous frame.
-     * @param deltaTime Time elapsed between the two frames.
-     * @return Velocity in units per second.
-     */
-    float computeVelocity(const QVector3D& currentPosition,
-                          const QVector3D& previousPosition,
-                          double deltaTime) const;
-
-    /**
-     * @brief Computes acceleration from three positions and time deltas.
-     *
-     * Uses finite difference between two computed velocities to estimate acceleration.
-     *
-     * @param currentPosition Position in the current frame.
-     * @param previousPosition Position in the previous frame.
-     * @param secondPreviousPosition Position two frames ago.
-     * @param currDeltaTime Time between current and previous.
-     * @param prevDeltaTime Time between previous and second previous.
-     * @return Acceleration in units per second squared.
-     */
-    float computeAcceleration(const QVector3D& currentPosition,
-                              const QVector3D& previousPosition,
-                              const QVector3D& secondPreviousPosition,
-                              double currDeltaTime,
-                              double prevDeltaTime) const;
-
-    /**
-     * @brief Computes the forward tilt angle from Euler rotation.
-     *
-     * Typically uses the X or Z rotation component depending on the coordinate system.
-     *
-     * @param eulerAngles The rotation angles (pitch, yaw, roll).
-     * @return Tilt angle in degrees or radians (depending on usage).
-     */
-    float computeTilt(const QVector3D& eulerAngles) const;
-
     int selectedAsset = 0;  // ID of selected rigid body asset
-    QJsonArray m_metricSettings; // Metric settings for current sport
+    MetricPlan m_plan;           // Compiled metric settings for current sport
+    PoseHistory m_history;       // Recent poses of every rigid body, as deep as the estimators need
     std::unordered_map<int, std::string> m_rigidBodies; // Rigid body ID-to-name map 
     QMap<QString, int> m_rigidBodyNameToId;    // Map of rigid body name → ID (reverse of m_rigidBodies)
 
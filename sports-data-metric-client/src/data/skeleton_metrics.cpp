@@ -5,84 +5,160 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QDebug>
-#include <QCoreApplication>
-#include <QDir>
+
+#include "metric_kernels.h"
+
+namespace {
+
+// Bundled with the application, so it is found whatever the working directory
+const QString kJointConfigPath = QStringLiteral(":/config/src/data/skeleton_config.json");
+
+// Inputs and output of the kernels, one column each; positions use the x, y and z columns
+enum Column {
+    kAw, kAx, kAy, kAz,     // First bone
+    kBw, kBx, kBy, kBz,     // Second bone
+    kResult,
+    kColumnCount
+};
+
+} // namespace
+
+struct SkeletonMetrics::BatchScratch {
+    std::vector<int> rows;                          // Batch index of each computed skeleton
+    std::vector<const SkeletonData*> skeletons;     // Bones of each computed skeleton
+    std::vector<const BonePair*> bones;             // Resolved bone pairs of each computed skeleton
+    metric_kernels::ColumnBuffer columns;
+};
+
+SkeletonMetrics::BatchScratch& SkeletonMetrics::batchScratch()
+{
+    thread_local BatchScratch scratch;
+    return scratch;
+}
 
 SkeletonMetrics::SkeletonMetrics(QObject* parent)
     : QObject(parent)
 {
+    // Parsed once; switching conventions only picks another entry
+    loadConfiguration(kJointConfigPath);
 }
 
-MetricsData SkeletonMetrics::computeMetricsForFrame(const FrameData& current) {
-    MetricsData data;
-
+MetricsData SkeletonMetrics::computeMetricsForFrame(const FrameData& current) const {
     // Early exit if no asset selected
     if (selectedAsset == -1) {
-        qDebug() << "No asset selected for metric computation.";
-        return data;
+        return MetricsData();
     }
-    
-    for (size_t i = 0; i < current.skeletons.size(); ++i) {
-        data.id = current.frameNumber;
 
-        for (const QJsonValue& val : m_metricSettings) {
-            QJsonObject metricObj = val.toObject();
-            QString metricClass = metricObj["class"].toString();
-            QJsonArray ids = metricObj["ids"].toArray();
-            QJsonArray labels = metricObj["labels"].toArray();
-
-            if (metricClass == "angle" && ids.size() >= 2 && !labels.isEmpty()) {
-                int id1 = ids[0].toInt();
-                int id2 = ids[1].toInt();
-                qreal angle = getJointAngle(id1, id2, current.skeletons[i]);
-                data.metrics.insert(labels[0].toString(), angle);
-            }
-            else if (metricClass == "distance" && ids.size() >= 2 && !labels.isEmpty()) {
-                int id1 = ids[0].toInt();
-                int id2 = ids[1].toInt();
-                qreal distance = computeForwardTilt(id1, id2, current.skeletons[i]);
-                data.metrics.insert(labels[0].toString(), distance);
-            }
-        }
+    return computeMetricsForAsset(selectedAsset, current);
+}
 
-        qDebug() << "Skeleton metrics: " << data.metrics;
-        return data; 
-    }
+MetricsData SkeletonMetrics::computeMetricsForAsset(int assetId, const FrameData& current) const
+{
+    AssetMetrics asset{assetId, MetricsData()};
+    computeMetricsForAssets(&asset, 1, current);
+    return asset.metrics;
 }
 
-float SkeletonMetrics::getJointAngle(int bone1Id, int bone2Id, const SkeletonData& skeleton)
+void SkeletonMetrics::computeMetricsForAssets(AssetMetrics* assets, int count, const FrameData& current) const
 {
-    return computeJointAngle(
-        skeleton.bones[bone1Id].orientation,
-        skeleton.bones[bone2Id].orientation
-    );
+    computeWithBones(assets, count, current, m_activeBones);
 }
 
-float SkeletonMetrics::computeJointAngle(const QQuaternion& bone1Orientation, const QQuaternion& bone2Orientation) 
+void SkeletonMetrics::computeMetricsForAssets(AssetMetrics* assets, int count, const FrameData& current,
+                                              const ResolvedBones& bones) const
 {
-    // Compute the relative rotation from bone1 to bone2
-    QQuaternion relativeRotation = bone1Orientation.conjugated() * bone2Orientation;
+    computeWithBones(assets, count, current, &bones);
+}
+
+void SkeletonMetrics::computeWithBones(AssetMetrics* assets, int count, const FrameData& current,
+                                       const ResolvedBones* bones) const
+{
+    BatchScratch& scratch = batchScratch();
+    scratch.rows.clear();
+    scratch.skeletons.clear();
+    scratch.bones.clear();
+
+    for (int i = 0; i < count; ++i) {
+        MetricsData& data = assets[i].metrics;
+        data = MetricsData();
+
+        // Only subscribed skeletons are decoded; absent or skipped skeletons carry no bones
+        const SkeletonData* skeleton = current.findSkeleton(assets[i].assetId);
+        if (!skeleton || skeleton->bones.empty() || !bones) {
+            continue;
+        }
 
-    // Ensure the quaternion is normalized
-    relativeRotation.normalize();
+        const auto resolved = bones->find(assets[i].assetId);
+        if (resolved == bones->end()) {
+            continue;
+        }
 
-    // Extract the angle (in radians) from the relative rotation quaternion
-    float angleRadians = 2.0f * qAcos(relativeRotation.scalar());
+        data.id = current.frameNumber;
+        data.schemaVersion = m_plan.schema().version();
+        data.count = m_plan.schema().slotCount();
 
-    // Convert the angle to degrees
-    float angleDegrees = qRadiansToDegrees(angleRadians);
+        scratch.rows.push_back(i);
+        scratch.skeletons.push_back(skeleton);
+        scratch.bones.push_back(resolved->second.data());
+    }
 
-    return angleDegrees;
-}
+    const size_t n = scratch.rows.size();
+    if (n == 0) {
+        return;
+    }
 
-float SkeletonMetrics::computeForwardTilt(int bone1Id, int bone2Id, const SkeletonData& skeleton) 
-{
-    const QVector3D& pos1 = skeleton.bones[bone1Id].position;
-    const QVector3D& pos2 = skeleton.bones[bone2Id].position;
+    const metric_kernels::Kernels& kernels = metric_kernels::best();
+    metric_kernels::ColumnBuffer& columns = scratch.columns;
+    columns.reserve(kColumnCount, n);
+    float* result = columns.column(kResult);
+
+    const std::vector<MetricStep>& steps = m_plan.steps();
+    for (size_t i = 0; i < steps.size(); ++i) {
+        const MetricStep& step = steps[i];
+        if (step.op != MetricOp::JointAngle && step.op != MetricOp::HorizontalDistance) {
+            // Rigid body metrics; not part of a skeleton plan
+            continue;
+        }
 
-    float dx = pos2.x() - pos1.x();
-    float dz = pos2.z() - pos1.z();
-    return std::sqrt(dx * dx + dz * dz) * 100.0f;  // horizontal distance in cm
+        // Gather the two bones of the metric; skeletons without them get an identity
+        // rotation and coincident positions, which the kernels turn into zero metrics
+        for (size_t r = 0; r < n; ++r) {
+            const std::vector<RigidBodyData>& bones = scratch.skeletons[r]->bones;
+            const BonePair& pair = scratch.bones[r][i];
+            const int boneCount = static_cast<int>(bones.size());
+            const bool valid = pair.first >= 0 && pair.first < boneCount && pair.second >= 0 && pair.second < boneCount;
+
+            if (step.op == MetricOp::JointAngle) {
+                const QQuaternion a = valid ? bones[pair.first].orientation : QQuaternion();
+                const QQuaternion b = valid ? bones[pair.second].orientation : QQuaternion();
+                columns.column(kAw)[r] = a.scalar();
+                columns.column(kAx)[r] = a.x();
+                columns.column(kAy)[r] = a.y();
+                columns.column(kAz)[r] = a.z();
+                columns.column(kBw)[r] = b.scalar();
+                columns.column(kBx)[r] = b.x();
+                columns.column(kBy)[r] = b.y();
+                columns.column(kBz)[r] = b.z();
+            } else {
+                const QVector3D a = valid ? bones[pair.first].position : QVector3D();
+                const QVector3D b = valid ? bones[pair.second].position : QVector3D();
+                for (int axis = 0; axis < 3; ++axis) {
+                    columns.column(kAx + axis)[r] = a[axis];
+                    columns.column(kBx + axis)[r] = b[axis];
+                }
+            }
+        }
+
+        if (step.op == MetricOp::JointAngle) {
+            kernels.jointAngles(columns.quat(kAw), columns.quat(kBw), result, n);
+        } else {
+            kernels.horizontalDistances(columns.vec3(kAx), columns.vec3(kBx), result, n);
+        }
+
+        for (size_t r = 0; r < n; ++r) {
+            assets[scratch.rows[r]].metrics.values[step.slot] = result[r];
+        }
+    }
 }
 
 const QMap<QString, int>& SkeletonMetrics::getSkeletonNameToId() const {
@@ -100,6 +176,10 @@ const std::unordered_map<int, std::unordered_map<int, std::string>>& SkeletonMet
 }
 
 void SkeletonMetrics::createInverseMaps() {
+    // Maps replace those of the previous session
+    m_skeletonNameToId.clear();
+    m_boneNameToId.clear();
+
     // Reverse m_skeletons: name -> ID
     for (const auto& [id, name] : m_skeletons) {
         m_skeletonNameToId.insert(QString::fromStdString(name), id);
@@ -113,6 +193,9 @@ void SkeletonMetrics::createInverseMaps() {
         }
         m_boneNameToId.insert(skeletonId, reversedBoneMap);
     }
+
+    invalidateBones();
+    resolveBones();
 }
 
 void SkeletonMetrics::setSkeletonMap(const std::unordered_map<int, std::string> skeletons) {
@@ -132,22 +215,38 @@ void SkeletonMetrics::setAsset(QString skeletonAsset)
         qDebug() << "SkeletonMetrics: Invalid asset.";
         selectedAsset = -1;
     }
+
+    resolveBones();
 }
 
 void SkeletonMetrics::setNamingConvention(const QString& convention) 
 {
     qDebug() << "Setting naming convention to:" << convention;
     m_namingConvention = convention;
-    configFilePath = QDir::cleanPath(QCoreApplication::applicationDirPath() + "/../../src/data/skeleton_config.json");
-    loadConfiguration(configFilePath);
+    loadJointMappings();
+    resolveBones();
+}
+
+void SkeletonMetrics::setSlotMap(std::shared_ptr<const AssetSlotMap> slotMap)
+{
+    if (slotMap == m_slotMap) {
+        return;
+    }
+
+    m_slotMap = std::move(slotMap);
+    invalidateBones();
+    resolveBones();
 }
 
 bool SkeletonMetrics::loadConfiguration(const QString& filePath) {
     qDebug() << "Loading config from:" << filePath;
 
     // Open the configuration file for reading
-    QFile file(configFilePath);
-    file.open(QIODevice::ReadOnly);
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "SkeletonMetrics: cannot open joint configuration" << filePath;
+        return false;
+    }
 
     // Read the entire contents of the file into a byte array
     QByteArray jsonData = file.readAll();
@@ -161,15 +260,23 @@ bool SkeletonMetrics::loadConfiguration(const QString& filePath) {
         return false;
     }
 
+    // Extract the root object
+    jointConfig = doc.object();
+    loadJointMappings();
+    invalidateBones();
+    resolveBones();
+    return true;
+}
+
+void SkeletonMetrics::loadJointMappings()
+{
     // Delete the old join mapping
     jointMappings.clear();
 
-    // Extract the root object
-    QJsonObject rootObj = doc.object();
-
     // Extract the joints 
-    QJsonObject conventionObj = rootObj.value(m_namingConvention).toObject();
+    QJsonObject conventionObj = jointConfig.value(m_namingConvention).toObject();
     QJsonObject jointsObj = conventionObj.value("joints").toObject();
+    configSkeleton = conventionObj.value("skeleton").toString();
 
     // Iterate through each joint
     for (const QString& key : jointsObj.keys()) {
@@ -184,11 +291,103 @@ bool SkeletonMetrics::loadConfiguration(const QString& filePath) {
         // Insert the list of bone names into the jointMappings map under the metric
         jointMappings.insert(key, boneNames);
     }
+}
 
-    return true;
+void SkeletonMetrics::invalidateBones()
+{
+    m_resolvedBones.clear();
+    m_activeBones = nullptr;
+}
+
+void SkeletonMetrics::resolveBones()
+{
+    // Bone order comes with the first frame of a session
+    if (!m_slotMap) {
+        m_activeBones = nullptr;
+        return;
+    }
+
+    auto cached = m_resolvedBones.find(m_namingConvention);
+    if (cached != m_resolvedBones.end()) {
+        m_activeBones = &cached.value();
+        return;
+    }
+
+    cached = m_resolvedBones.insert(m_namingConvention, resolveBonesFor(*m_slotMap));
+    m_activeBones = &cached.value();
+}
+
+SkeletonMetrics::ResolvedBones SkeletonMetrics::resolveBonesFor(const AssetSlotMap& slotMap) const
+{
+    const std::vector<MetricStep>& steps = m_plan.steps();
+    ResolvedBones resolved;
+
+    for (int k = 0; k < slotMap.skeletonCount(); ++k) {
+        const int skeletonId = slotMap.skeletonId(k);
+        std::vector<BonePair>& pairs = resolved[skeletonId];
+        pairs.resize(steps.size());
+
+        for (size_t i = 0; i < steps.size(); ++i) {
+            const MetricStep& step = steps[i];
+            int bone1Id = -1;
+            int bone2Id = -1;
+
+            // Joints of the configuration take precedence; the bone IDs are the fallback
+            if (step.joint != -1) {
+                const QStringList boneNames = jointMappings.value(m_plan.joints()[step.joint]);
+                if (boneNames.size() >= 2) {
+                    bone1Id = findBoneId(skeletonId, boneNames[0]);
+                    bone2Id = findBoneId(skeletonId, boneNames[1]);
+                }
+            }
+            if (bone1Id == -1 || bone2Id == -1) {
+                bone1Id = step.bone1;
+                bone2Id = step.bone2;
+            }
+
+            pairs[i].first = slotMap.boneIndex(k, bone1Id);
+            pairs[i].second = slotMap.boneIndex(k, bone2Id);
+
+            if (pairs[i].first == -1 || pairs[i].second == -1) {
+                qWarning() << "SkeletonMetrics: cannot resolve the bones of"
+                           << m_plan.schema().labels().value(step.slot) << "for skeleton" << skeletonId
+                           << "with naming convention" << m_namingConvention;
+            }
+        }
+    }
+
+    return resolved;
+}
+
+int SkeletonMetrics::findBoneId(int skeletonId, const QString& configName) const
+{
+    const auto bones = m_boneNameToId.constFind(skeletonId);
+    if (bones == m_boneNameToId.constEnd()) {
+        return -1;
+    }
+
+    // Bone names are prefixed with the skeleton they belong to
+    QString boneName = configName;
+    const QString prefix = configSkeleton + QLatin1Char('_');
+    if (!configSkeleton.isEmpty() && boneName.startsWith(prefix)) {
+        boneName = boneName.mid(prefix.size());
+    }
+
+    const auto skeleton = m_skeletons.find(skeletonId);
+    if (skeleton != m_skeletons.end()) {
+        const auto prefixed = bones->constFind(QString::fromStdString(skeleton->second) + QLatin1Char('_') + boneName);
+        if (prefixed != bones->constEnd()) {
+            return prefixed.value();
+        }
+    }
+
+    // Streamed without a prefix
+    return bones->value(boneName, -1);
 }
 
 void SkeletonMetrics::setMetricSettings(QJsonArray skeletonMetricsSettings)
 {
-    m_metricSettings = skeletonMetricsSettings;
+    m_plan = MetricPlan::compile(skeletonMetricsSettings);
+    invalidateBones();
+    resolveBones();
 }
\ No newline at end of file
@@ -1,13 +1,21 @@
 #pragma once
 
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <QHash>
+#include <QJsonObject>
 #include <QMap>
 #include <QString>
 #include <QStringList>
 #include <QObject>
 #include <QVector>
 #include <QJsonArray>
+#include "asset_slot_map.h"
 #include "frame_data.h"
+#include "metrics_batch.h"
 #include "metrics_data.h"
+#include "metric_plan.h"
 
 /**
  * @brief Computes skeletal joint-based metrics from motion capture frame data.
@@ -16,6 +24,11 @@
  * kinematic measurements such as joint angles and forward tilt. It supports
  * customizable joint mappings defined in a JSON config file and provides
  * reverse lookup maps from bone/skeleton names to IDs.
+ *
+ * The bones of each metric are resolved to SkeletonData::bones indices whenever
+ * the settings, the naming convention, the asset maps or the frame layout
+ * change, and cached per skeleton and naming convention. A frame then only
+ * reads the two bones of each metric by index.
  */
 class SkeletonMetrics : public QObject {
     Q_OBJECT
@@ -39,7 +52,55 @@ public:
      * @param current The current FrameData containing skeleton information.
      * @return A QVector of SkeletonMetricsData, one for each detected skeleton.
      */
-    MetricsData computeMetricsForFrame(const FrameData& current);
+    MetricsData computeMetricsForFrame(const FrameData& current) const;
+
+    /**
+     * @brief Computes the metrics of one skeleton, selected or not.
+     *
+     * Reads only the compiled settings, so it may run for several assets on
+     * different threads at once, as long as the settings do not change meanwhile.
+     *
+     * @param assetId Motive ID of the skeleton.
+     * @param current The current FrameData containing skeleton information.
+     * @return The metrics; without values if the skeleton's bones were not decoded.
+     */
+    MetricsData computeMetricsForAsset(int assetId, const FrameData& current) const;
+
+    /**
+     * @brief Computes the metrics of several skeletons at once.
+     *
+     * Evaluates each metric for all of them with the vector kernels. Like
+     * computeMetricsForAsset(), it may run on several threads at once.
+     *
+     * @param assets The skeletons, by ID; their metrics are overwritten.
+     * @param count Number of entries in @p assets.
+     * @param current The current FrameData containing skeleton information.
+     */
+    void computeMetricsForAssets(AssetMetrics* assets, int count, const FrameData& current) const;
+
+    /**
+     * @brief Indices in SkeletonData::bones of the two bones a metric reads; -1 if unresolved.
+     */
+    struct BonePair {
+        int first = -1;
+        int second = -1;
+    };
+
+    using ResolvedBones = std::unordered_map<int, std::vector<BonePair>>; // Skeleton ID → one pair per plan step
+
+    /**
+     * @brief Resolves the bones of every metric for the frames laid out by @p slotMap.
+     *
+     * Leaves the layout the live metrics use untouched, so frames of another
+     * session, such as a recorded take, can be computed alongside them.
+     */
+    ResolvedBones resolveBonesFor(const AssetSlotMap& slotMap) const;
+
+    /**
+     * @brief Like computeMetricsForAssets() above, with the bones resolved by resolveBonesFor().
+     */
+    void computeMetricsForAssets(AssetMetrics* assets, int count, const FrameData& current,
+                                 const ResolvedBones& bones) const;
 
     /**
      * @brief Retrieves the name-to-ID map for skeletons.
@@ -80,6 +141,8 @@ public:
     /**
      * @brief Sets the configuration for skeleton metric calculations.
      *
+     * Compiles the settings into the plan evaluated for every frame.
+     *
      * @param skeletonMetricsSettings A QJsonArray containing metric definitions and settings.
      */
     void setMetricSettings(QJsonArray skeletonMetricsSettings);
@@ -92,14 +155,43 @@ public:
      */
     void setNamingConvention(const QString& convention);
 
+    /**
+     * @brief Loads the joint configuration from a JSON file.
+     * 
+     * Parses the joint-to-bone mappings of every naming convention into jointConfig.
+     * The one built into the application is loaded on construction; loading
+     * another picks the joints of the current convention again and resolves
+     * the bones anew.
+     * 
+     * @param filePath The path to the JSON configuration file.
+     * @return True if the config was successfully loaded and parsed; false otherwise.
+     */
+    bool loadConfiguration(const QString& filePath);
+
+    /**
+     * @brief Sets the layout of the frames the metrics are computed from.
+     *
+     * The layout gives the order of each skeleton's bones. A new layout, as
+     * after a reconnect, resolves the bones of the metrics again; passing the
+     * current one does nothing, so it may be called for every frame.
+     *
+     * @param slotMap The AssetSlotMap of the latest frame.
+     */
+    void setSlotMap(std::shared_ptr<const AssetSlotMap> slotMap);
+
 private:
+    QJsonObject jointConfig;                   // Contents of the joint configuration file, by naming convention
     QMap<QString, QStringList> jointMappings;  // Maps joint names to alist of bone names used for that joint
-    QString configFilePath;                    // Path to the joint configuration JSON file
+    QString configSkeleton;                    // Skeleton name prefixed to the bone names of jointMappings
 
     QString m_namingConvention = "";
 
+    std::shared_ptr<const AssetSlotMap> m_slotMap;  // Layout of the frames, with each skeleton's bone order
+    QHash<QString, ResolvedBones> m_resolvedBones;  // Resolved bones by naming convention
+    const ResolvedBones* m_activeBones = nullptr;   // Entry of m_resolvedBones for m_namingConvention
+
     int selectedAsset = 0;  // ID of selected skeleton asset
-    QJsonArray m_metricSettings; // Metric settings for current sport
+    MetricPlan m_plan;           // Compiled metric settings for current sport
 
     std::unordered_map<int, std::string> m_skeletons;   // Skeleton ID-to-name map 
     std::unordered_map<int, std::unordered_map<int, std::string>> m_bones; // Bone ID-to-name maps
@@ -108,50 +200,43 @@ private:
     QMap<int, QMap<QString, int>> m_boneNameToId; // Map of skeleton ID → (bone name → ID), reversed from m_bones
 
     /**
-     * @brief Loads the joint configuration from a JSON file.
-     * 
-     * Parses joint-to-bone mappings from the given config file and populates jointMappings.
-     * 
-     * @param filePath The path to the JSON configuration file.
-     * @return True if the config was successfully loaded and parsed; false otherwise.
+     * @brief Populates jointMappings with the joints of the current naming convention.
      */
-    bool loadConfiguration(const QString& filePath);
+    void loadJointMappings();
 
     /**
-     * @brief Computes the angle between two bones in a skeleton.
-     *
-     * Calculates the joint angle using the orientations of two specified bones.
-     *
-     * @param bone1Id ID of the first bone.
-     * @param bone2Id ID of the second bone.
-     * @param skeleton The skeleton data containing bone orientations.
-     * @return The computed angle between the two bones, in degrees.
+     * @brief Drops the resolved bones of every naming convention.
      */
-    float getJointAngle(int bone1Id, int bone2Id, const SkeletonData& skeleton);
+    void invalidateBones();
 
     /**
-     * @brief Computes the angle between two bone orientations using quaternions.
-     * 
-     * This method calculates the relative rotation between two quaternions and converts
-     * it to a single scalar angle.
-     * 
-     * @param bone1Orientation Orientation of the first bone (QQuaternion).
-     * @param bone2Orientation Orientation of the second bone (QQuaternion).
-     * @return The angle between the two bones in degrees.
+     * @brief Resolves the bones of every plan step for every skeleton, unless cached for the current convention.
      */
-    float computeJointAngle(const QQuaternion& bone1Orientation, const QQuaternion& bone2Orientation);
- 
+    void resolveBones();
+
+    /**
+     * @brief Shared by both computeMetricsForAssets(); @p bones may be null, leaving every skeleton without values.
+     */
+    void computeWithBones(AssetMetrics* assets, int count, const FrameData& current, const ResolvedBones* bones) const;
+
     /**
-     * @brief Computes the forward tilt (horizontal distance) between two bones in a skeleton.
+     * @brief Looks up a bone named in the joint configuration.
      *
-     * Measures the horizontal distance between two bone positions.
+     * The configuration names bones after its own skeleton; the prefix is
+     * swapped for the skeleton's name, and bones streamed without a prefix
+     * are matched too.
      *
-     * @param bone1Id ID of the first bone.
-     * @param bone2Id ID of the second bone.
-     * @param skeleton The skeleton data containing bone positions.
-     * @return The computed forward tilt distance in centimeters.
+     * @param skeletonId ID of the skeleton.
+     * @param configName Bone name as given in the joint configuration.
+     * @return The bone ID, or -1 if the skeleton has no such bone.
+     */
+    int findBoneId(int skeletonId, const QString& configName) const;
+
+    /**
+     * @brief Buffers of the batch path, kept per thread so a frame allocates nothing.
      */
-    float computeForwardTilt(int bone1Id, int bone2Id, const SkeletonData& skeleton);
+    struct BatchScratch;
+    static BatchScratch& batchScratch();
 
 signals:
     /**
@@ -0,0 +1,118 @@
+#include "take_analyzer.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "pose_history.h"
+
+namespace {
+
+std::vector<AssetSeries> makeSeries(const std::vector<int>& ids, int frameCount)
+{
+    std::vector<AssetSeries> series(ids.size());
+    for (size_t a = 0; a < ids.size(); ++a) {
+        series[a].assetId = ids[a];
+        series[a].frames.resize(static_cast<size_t>(frameCount));
+    }
+    return series;
+}
+
+void addStatistics(std::vector<AssetSeries>& series)
+{
+    for (AssetSeries& asset : series) {
+        MetricStatistics statistics;
+        for (const MetricsData& metrics : asset.frames) {
+            statistics.add(metrics);
+        }
+        asset.statistics = statistics.snapshot();
+    }
+}
+
+} // namespace
+
+TakeAnalyzer::TakeAnalyzer(const RigidBodyMetrics& rigidBodyMetrics, const SkeletonMetrics& skeletonMetrics,
+                           QThreadPool& pool)
+    : m_rigidBodyMetrics(rigidBodyMetrics),
+      m_skeletonMetrics(skeletonMetrics),
+      m_pool(pool)
+{
+}
+
+TakeMetrics TakeAnalyzer::analyze(const TakeFrames& frames, const std::vector<int>& rigidBodyIds,
+                                  const std::vector<int>& skeletonIds, int chunks) const
+{
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+
+    TakeMetrics take;
+    const int frameCount = frames.frameCount();
+    take.rigidBodies = makeSeries(rigidBodyIds, frameCount);
+    take.skeletons = makeSeries(skeletonIds, frameCount);
+    if (frameCount == 0) {
+        return take;
+    }
+
+    // Frames before a chunk that its first derivatives reach back to
+    const int depth = m_rigidBodyMetrics.historyDepth();
+    const int halo = depth - 1;
+
+    // Contiguous chunks of frames; each writes only its own entries, so no locking is needed
+    take.chunks = std::clamp(chunks, 1, frameCount);
+
+    auto computeChunk = [&](int chunk) {
+        const int first = frameCount * chunk / take.chunks;
+        const int last = frameCount * (chunk + 1) / take.chunks;
+
+        PoseHistory history;
+        history.setDepth(depth);
+        for (int i = std::max(0, first - halo); i < first; ++i) {
+            history.push(*frames.frame(i));
+        }
+
+        std::vector<AssetMetrics> rigidBodies(rigidBodyIds.size());
+        std::vector<AssetMetrics> skeletons(skeletonIds.size());
+        for (size_t a = 0; a < rigidBodyIds.size(); ++a) {
+            rigidBodies[a].assetId = rigidBodyIds[a];
+        }
+        for (size_t a = 0; a < skeletonIds.size(); ++a) {
+            skeletons[a].assetId = skeletonIds[a];
+        }
+
+        // A take's layout only grows; the bones are resolved again whenever it does
+        std::shared_ptr<const AssetSlotMap> layout;
+        SkeletonMetrics::ResolvedBones bones;
+
+        for (int i = first; i < last; ++i) {
+            const FramePtr frame = frames.frame(i);
+            history.push(*frame);
+            if (frame->slotMap != layout) {
+                layout = frame->slotMap;
+                bones = layout ? m_skeletonMetrics.resolveBonesFor(*layout) : SkeletonMetrics::ResolvedBones();
+            }
+
+            m_rigidBodyMetrics.computeMetricsForAssets(rigidBodies.data(), static_cast<int>(rigidBodies.size()),
+                                                       *frame, history);
+            m_skeletonMetrics.computeMetricsForAssets(skeletons.data(), static_cast<int>(skeletons.size()),
+                                                      *frame, bones);
+
+            for (size_t a = 0; a < rigidBodies.size(); ++a) {
+                take.rigidBodies[a].frames[static_cast<size_t>(i)] = rigidBodies[a].metrics;
+            }
+            for (size_t a = 0; a < skeletons.size(); ++a) {
+                take.skeletons[a].frames[static_cast<size_t>(i)] = skeletons[a].metrics;
+            }
+        }
+    };
+
+    for (int chunk = 1; chunk < take.chunks; ++chunk) {
+        m_pool.start([&computeChunk, chunk] { computeChunk(chunk); });
+    }
+    computeChunk(0);
+    m_pool.waitForDone();
+
+    addStatistics(take.rigidBodies);
+    addStatistics(take.skeletons);
+
+    take.wallUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    return take;
+}
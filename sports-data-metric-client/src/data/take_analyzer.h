@@ -0,0 +1,45 @@
+// Computes the metrics of every frame of a take at once, in parallel chunks.
+//
+// The frames are split into contiguous chunks computed on a thread pool, the
+// calling thread taking the first. Each chunk reads only its own range of the
+// take, plus the halo of frames before it that the motion estimators reach
+// back to, into a pose history of its own; the skeleton bones are resolved for
+// the layout of the frames read. The live metrics' history and layout are left
+// alone, so the result equals one sequential pass over the take.
+
+#pragma once
+
+#include <vector>
+#include <QThreadPool>
+
+#include "rigid_body_metrics.h"
+#include "skeleton_metrics.h"
+#include "take_frames.h"
+#include "take_metrics.h"
+
+class TakeAnalyzer {
+public:
+    /**
+     * @brief Constructs an analyzer evaluating the settings of @p rigidBodyMetrics and @p skeletonMetrics.
+     *
+     * The settings must not change while analyze() runs.
+     * @param pool Workers computing every chunk but the first.
+     */
+    TakeAnalyzer(const RigidBodyMetrics& rigidBodyMetrics, const SkeletonMetrics& skeletonMetrics,
+                 QThreadPool& pool);
+
+    /**
+     * @brief Computes the metrics of the given assets for every frame of @p frames.
+     * @param rigidBodyIds Rigid bodies to compute, in the order of TakeMetrics::rigidBodies.
+     * @param skeletonIds Skeletons to compute, in the order of TakeMetrics::skeletons.
+     * @param chunks Chunks to split the frames into; at least one, at most one per frame.
+     * @return The series and statistics of each asset; the selected indices are left at -1.
+     */
+    TakeMetrics analyze(const TakeFrames& frames, const std::vector<int>& rigidBodyIds,
+                        const std::vector<int>& skeletonIds, int chunks) const;
+
+private:
+    const RigidBodyMetrics& m_rigidBodyMetrics;
+    const SkeletonMetrics& m_skeletonMetrics;
+    QThreadPool& m_pool;
+};
@@ -0,0 +1,428 @@
+#include "take_codec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr double kMaxSteps = 1e15;          // Quantized values stay far from int64 overflow
+constexpr double kSqrtHalf = 0.70710678118654752440;
+constexpr int kCompressionLevel = 6;         // Decodes as fast as level 1, and the encode runs once per chunk
+
+/**
+ * @brief Where one pose and the flag saying whether it is present lie in a record.
+ */
+struct PoseColumn {
+    size_t offset;
+    size_t presenceOffset;
+};
+
+/**
+ * @brief Record offsets of the presence flags and poses of @p layout, in stream order.
+ */
+void columnsOf(const TakeLayout& layout, std::vector<size_t>& flags, std::vector<PoseColumn>& poses)
+{
+    size_t offset = TakeLayout::kFrameHeaderSize;
+    for (size_t i = 0; i < layout.rigidBodies().size(); ++i) {
+        flags.push_back(offset + TakeLayout::kPoseSize);
+        poses.push_back(PoseColumn{offset, offset + TakeLayout::kPoseSize});
+        offset += TakeLayout::kRigidBodySize;
+    }
+
+    for (const TakeLayout::Skeleton& skeleton : layout.skeletons()) {
+        const size_t hasBones = offset;
+        flags.push_back(hasBones);
+        offset += sizeof(uint32_t);
+        for (size_t b = 0; b < skeleton.bones.size(); ++b) {
+            poses.push_back(PoseColumn{offset, hasBones});
+            offset += TakeLayout::kPoseSize;
+        }
+    }
+}
+
+uint32_t readFlag(const char* record, size_t offset)
+{
+    uint32_t flag;
+    std::memcpy(&flag, record + offset, sizeof(flag));
+    return flag;
+}
+
+int64_t quantize(double value, double resolution)
+{
+    const double steps = value / resolution;
+    if (!std::isfinite(steps)) {
+        return 0;
+    }
+    return static_cast<int64_t>(std::llround(std::clamp(steps, -kMaxSteps, kMaxSteps)));
+}
+
+/**
+ * @brief Predicts the next value of a series from its last two.
+ */
+class LinearPredictor {
+public:
+    int64_t predict() const
+    {
+        if (m_count == 0) {
+            return 0;
+        }
+        return m_count == 1 ? m_last : 2 * m_last - m_previous;
+    }
+
+    void push(int64_t value)
+    {
+        m_previous = m_last;
+        m_last = value;
+        m_count = std::min(m_count + 1, 2);
+    }
+
+private:
+    int64_t m_last = 0;
+    int64_t m_previous = 0;
+    int m_count = 0;
+};
+
+class StreamWriter {
+public:
+    explicit StreamWriter(QByteArray& out)
+        : m_out(out)
+    {
+    }
+
+    void byte(uint8_t value) { m_out.append(static_cast<char>(value)); }
+
+    void varint(uint64_t value)
+    {
+        while (value >= 0x80) {
+            byte(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        byte(static_cast<uint8_t>(value));
+    }
+
+    // Zigzag, so small residuals of either sign take one byte
+    void signedVarint(int64_t value)
+    {
+        varint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    void residual(LinearPredictor& predictor, int64_t value)
+    {
+        signedVarint(value - predictor.predict());
+        predictor.push(value);
+    }
+
+private:
+    QByteArray& m_out;
+};
+
+/**
+ * @brief Bounds checked reader of a stream; reads past its end leave ok() false.
+ */
+class StreamReader {
+public:
+    StreamReader(const char* data, size_t size)
+        : m_pos(reinterpret_cast<const uint8_t*>(data)), m_end(m_pos + size)
+    {
+    }
+
+    bool ok() const { return m_ok; }
+    bool atEnd() const { return m_pos == m_end; }
+
+    uint8_t byte()
+    {
+        if (m_pos == m_end) {
+            m_ok = false;
+            return 0;
+        }
+        return *m_pos++;
+    }
+
+    uint64_t varint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (m_pos == m_end) {
+                m_ok = false;
+                return 0;
+            }
+            const uint8_t b = *m_pos++;
+            value |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                return value;
+            }
+        }
+        m_ok = false;
+        return 0;
+    }
+
+    int64_t signedVarint()
+    {
+        const uint64_t value = varint();
+        return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+    }
+
+    int64_t residual(LinearPredictor& predictor)
+    {
+        // Wraps rather than overflows on malformed input
+        const int64_t value = static_cast<int64_t>(static_cast<uint64_t>(predictor.predict()) +
+                                                   static_cast<uint64_t>(signedVarint()));
+        predictor.push(value);
+        return value;
+    }
+
+private:
+    const uint8_t* m_pos;
+    const uint8_t* m_end;
+    bool m_ok = true;
+};
+
+/**
+ * @brief A quaternion as the index of its largest component, that component's sign and the other three.
+ */
+struct SmallestThree {
+    uint8_t symbol = 0;                 // Index of the largest component (x, y, z, w), plus 4 if it is negative
+    int64_t components[3] = {};         // The others in index order, in steps of kSqrtHalf / scale
+};
+
+SmallestThree encodeOrientation(const float* xyzw, double scale)
+{
+    double q[4] = { xyzw[0], xyzw[1], xyzw[2], xyzw[3] };
+    const double norm = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+
+    SmallestThree encoded;
+    if (!(norm > 0.0) || !std::isfinite(norm)) {
+        // Degenerate quaternions are stored as the identity
+        encoded.symbol = 3;
+        return encoded;
+    }
+
+    int largest = 0;
+    for (int i = 0; i < 4; ++i) {
+        q[i] /= norm;
+        if (std::abs(q[i]) > std::abs(q[largest])) {
+            largest = i;
+        }
+    }
+
+    encoded.symbol = static_cast<uint8_t>(largest + (q[largest] < 0.0 ? 4 : 0));
+    for (int i = 0, c = 0; i < 4; ++i) {
+        if (i != largest) {
+            encoded.components[c++] = static_cast<int64_t>(std::lround(q[i] / kSqrtHalf * scale));
+        }
+    }
+    return encoded;
+}
+
+void decodeOrientation(const SmallestThree& encoded, double scale, float* xyzw)
+{
+    const int largest = encoded.symbol & 3;
+    double sum = 0.0;
+    double q[4];
+    for (int i = 0, c = 0; i < 4; ++i) {
+        if (i != largest) {
+            q[i] = std::clamp(static_cast<double>(encoded.components[c++]) / scale * kSqrtHalf, -1.0, 1.0);
+            sum += q[i] * q[i];
+        }
+    }
+    q[largest] = std::sqrt(std::max(0.0, 1.0 - sum)) * ((encoded.symbol & 4) ? -1.0 : 1.0);
+
+    for (int i = 0; i < 4; ++i) {
+        xyzw[i] = static_cast<float>(q[i]);
+    }
+}
+
+/**
+ * @brief Largest stored component of @p bits bits, sign included.
+ */
+double orientationScale(uint32_t bits)
+{
+    return static_cast<double>((uint64_t(1) << (bits - 1)) - 1);
+}
+
+} // namespace
+
+namespace take_codec {
+
+bool isValid(const TakeQuantization& quantization)
+{
+    return std::isfinite(quantization.positionResolution) && quantization.positionResolution > 0.0 &&
+           std::isfinite(quantization.timestampResolution) && quantization.timestampResolution > 0.0 &&
+           quantization.orientationBits >= 2 && quantization.orientationBits <= 31;
+}
+
+QByteArray encodeChunk(const TakeChunkHeader& header, const TakeLayout& layout, const char* records,
+                       const TakeQuantization& quantization)
+{
+    const size_t frameCount = header.frameCount;
+    const size_t recordSize = header.recordSize;
+    const double scale = orientationScale(quantization.orientationBits);
+
+    std::vector<size_t> flags;
+    std::vector<PoseColumn> poses;
+    columnsOf(layout, flags, poses);
+
+    QByteArray stream;
+    stream.reserve(static_cast<qsizetype>(frameCount * (8 + flags.size() + poses.size() * 10)));
+    StreamWriter out(stream);
+
+    // Frame numbers and timestamps; timestamps count from the chunk's first
+    LinearPredictor frameNumbers;
+    LinearPredictor timestamps;
+    for (size_t f = 0; f < frameCount; ++f) {
+        const char* record = records + f * recordSize;
+        int32_t frameNumber;
+        double timestamp;
+        std::memcpy(&frameNumber, record, sizeof(frameNumber));
+        std::memcpy(&timestamp, record + TakeLayout::kTimestampOffset, sizeof(timestamp));
+
+        out.residual(frameNumbers, frameNumber);
+        out.residual(timestamps, quantize(timestamp - header.firstTimestamp, quantization.timestampResolution));
+    }
+
+    for (size_t flag : flags) {
+        for (size_t f = 0; f < frameCount; ++f) {
+            out.byte(readFlag(records + f * recordSize, flag) ? 1 : 0);
+        }
+    }
+
+    std::vector<SmallestThree> orientations;
+    orientations.reserve(frameCount);
+    for (const PoseColumn& pose : poses) {
+        orientations.clear();
+        for (size_t f = 0; f < frameCount; ++f) {
+            const char* record = records + f * recordSize;
+            if (readFlag(record, pose.presenceOffset)) {
+                float xyzw[4];
+                std::memcpy(xyzw, record + pose.offset + 3 * sizeof(float), sizeof(xyzw));
+                orientations.push_back(encodeOrientation(xyzw, scale));
+                out.byte(orientations.back().symbol);
+            }
+        }
+
+        LinearPredictor position[3];
+        for (size_t f = 0; f < frameCount; ++f) {
+            const char* record = records + f * recordSize;
+            if (readFlag(record, pose.presenceOffset)) {
+                float xyz[3];
+                std::memcpy(xyz, record + pose.offset, sizeof(xyz));
+                for (int c = 0; c < 3; ++c) {
+                    out.residual(position[c], quantize(xyz[c], quantization.positionResolution));
+                }
+            }
+        }
+
+        LinearPredictor orientation[3];
+        for (size_t i = 0; i < orientations.size(); ++i) {
+            if (i > 0 && orientations[i].symbol != orientations[i - 1].symbol) {
+                std::fill(orientation, orientation + 3, LinearPredictor());
+            }
+            for (int c = 0; c < 3; ++c) {
+                out.residual(orientation[c], orientations[i].components[c]);
+            }
+        }
+    }
+
+    QByteArray payload(reinterpret_cast<const char*>(&quantization), sizeof(quantization));
+    payload.append(qCompress(stream, kCompressionLevel));
+    return payload;
+}
+
+bool decodeChunk(const TakeChunkHeader& header, const TakeLayout& layout, const char* payload, size_t size,
+                 QByteArray& records)
+{
+    TakeQuantization quantization;
+    if (size < sizeof(quantization)) {
+        return false;
+    }
+    std::memcpy(&quantization, payload, sizeof(quantization));
+    if (!isValid(quantization)) {
+        return false;
+    }
+
+    const QByteArray stream = qUncompress(reinterpret_cast<const uchar*>(payload + sizeof(quantization)),
+                                          static_cast<qsizetype>(size - sizeof(quantization)));
+    StreamReader in(stream.constData(), static_cast<size_t>(stream.size()));
+
+    const size_t frameCount = header.frameCount;
+    const size_t recordSize = header.recordSize;
+    const double scale = orientationScale(quantization.orientationBits);
+
+    std::vector<size_t> flags;
+    std::vector<PoseColumn> poses;
+    columnsOf(layout, flags, poses);
+
+    records = QByteArray(static_cast<qsizetype>(frameCount * recordSize), '\0');
+    char* const out = records.data();
+
+    LinearPredictor frameNumbers;
+    LinearPredictor timestamps;
+    for (size_t f = 0; f < frameCount; ++f) {
+        char* record = out + f * recordSize;
+        const int32_t frameNumber = static_cast<int32_t>(in.residual(frameNumbers));
+        const double timestamp = header.firstTimestamp +
+                                 static_cast<double>(in.residual(timestamps)) * quantization.timestampResolution;
+        std::memcpy(record, &frameNumber, sizeof(frameNumber));
+        std::memcpy(record + TakeLayout::kTimestampOffset, &timestamp, sizeof(timestamp));
+    }
+
+    for (size_t flag : flags) {
+        for (size_t f = 0; f < frameCount; ++f) {
+            const uint32_t value = in.byte() ? 1 : 0;
+            std::memcpy(out + f * recordSize + flag, &value, sizeof(value));
+        }
+    }
+
+    std::vector<SmallestThree> orientations;
+    orientations.reserve(frameCount);
+    for (const PoseColumn& pose : poses) {
+        orientations.clear();
+        for (size_t f = 0; f < frameCount; ++f) {
+            if (readFlag(out + f * recordSize, pose.presenceOffset)) {
+                orientations.emplace_back();
+                orientations.back().symbol = in.byte() & 7;
+            }
+        }
+
+        LinearPredictor position[3];
+        for (size_t f = 0; f < frameCount; ++f) {
+            char* record = out + f * recordSize;
+            if (readFlag(record, pose.presenceOffset)) {
+                float xyz[3];
+                for (int c = 0; c < 3; ++c) {
+                    xyz[c] = static_cast<float>(static_cast<double>(in.residual(position[c])) *
+                                                quantization.positionResolution);
+                }
+                std::memcpy(record + pose.offset, xyz, sizeof(xyz));
+            }
+        }
+
+        LinearPredictor components[3];
+        size_t i = 0;
+        for (size_t f = 0; f < frameCount; ++f) {
+            char* record = out + f * recordSize;
+            if (!readFlag(record, pose.presenceOffset)) {
+                continue;
+            }
+
+            SmallestThree& orientation = orientations[i];
+            if (i > 0 && orientation.symbol != orientations[i - 1].symbol) {
+                std::fill(components, components + 3, LinearPredictor());
+            }
+            for (int c = 0; c < 3; ++c) {
+                orientation.components[c] = in.residual(components[c]);
+            }
+
+            float xyzw[4];
+            decodeOrientation(orientation, scale, xyzw);
+            std::memcpy(record + pose.offset + 3 * sizeof(float), xyzw, sizeof(xyzw));
+            ++i;
+        }
+    }
+
+    return in.ok() && in.atEnd();
+}
+
+} // namespace take_codec
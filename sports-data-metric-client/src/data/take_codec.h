@@ -0,0 +1,77 @@
+// Quantized chunk payloads of binary takes (TakeChunkHeader::kQuantizedEncoding).
+//
+// A quantized payload is a TakeQuantization followed by a qCompress()ed stream
+// of variable-length integers. The stream is laid out column by column, so the
+// values of one asset follow each other and compress well:
+//   per frame                    frame number and timestamp steps, less a linear
+//                                prediction from the previous two frames
+//   per rigid body, per frame    tracked flag
+//   per skeleton, per frame      hasBones flag
+//   per pose, over the frames it is present in (rigid bodies, then the bones of each skeleton):
+//     symbols                    which quaternion component is largest, and its sign
+//     positions                  position steps, less a linear prediction
+//     orientations               the other three quaternion components ("smallest
+//                                three"), less the previous frame's if it has the same symbol
+//
+// Positions are rounded to positionResolution, so they are off by at most half
+// of it. Quaternions are normalized and their three smallest components rounded
+// to orientationBits; the largest is restored from the unit norm and keeps its
+// sign, so q and -q stay distinct. At the default 13 bits the restored rotation
+// is within 0.025 degrees of the original, and at 16 bits within 0.003 degrees.
+// Timestamps are rounded to timestampResolution.
+//
+// Decoding restores the chunk's plain records, so readers treat decoded chunks
+// like plain ones.
+
+#pragma once
+
+#include <cstdint>
+#include <QByteArray>
+
+#include "take_format.h"
+
+/**
+ * @brief How TakeWriter stores chunks.
+ */
+struct TakeEncoding {
+    static constexpr double kDefaultPositionResolution = 1e-4;     // 0.1 mm, about the accuracy of a calibrated volume
+    static constexpr double kDefaultTimestampResolution = 1e-6;    // 1 us
+    static constexpr uint32_t kDefaultOrientationBits = 13;        // Within 0.025 degrees
+
+    uint32_t encoding = TakeChunkHeader::kPlainEncoding;
+    TakeQuantization quantization = { kDefaultPositionResolution, kDefaultTimestampResolution,
+                                      kDefaultOrientationBits, 0 };
+
+    /**
+     * @brief Quantized chunks with positions rounded to @p positionResolution meters.
+     */
+    static TakeEncoding quantized(double positionResolution = kDefaultPositionResolution)
+    {
+        TakeEncoding encoding;
+        encoding.encoding = TakeChunkHeader::kQuantizedEncoding;
+        encoding.quantization.positionResolution = positionResolution;
+        return encoding;
+    }
+};
+
+namespace take_codec {
+
+/**
+ * @brief Whether @p quantization can be encoded and decoded.
+ */
+bool isValid(const TakeQuantization& quantization);
+
+/**
+ * @brief Encodes the plain @p records of a chunk described by @p header and @p layout.
+ */
+QByteArray encodeChunk(const TakeChunkHeader& header, const TakeLayout& layout, const char* records,
+                       const TakeQuantization& quantization);
+
+/**
+ * @brief Decodes a quantized @p payload of @p size bytes into the chunk's plain records.
+ * @return False if the payload is malformed.
+ */
+bool decodeChunk(const TakeChunkHeader& header, const TakeLayout& layout, const char* payload, size_t size,
+                 QByteArray& records);
+
+} // namespace take_codec
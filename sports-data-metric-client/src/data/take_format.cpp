@@ -0,0 +1,308 @@
+#include "take_format.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+template <typename T>
+void append(QByteArray& out, T value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/**
+ * @brief Bounds checked cursor over a serialized layout.
+ */
+class LayoutReader {
+public:
+    LayoutReader(const char* data, size_t size)
+        : m_pos(data), m_end(data + size)
+    {
+    }
+
+    template <typename T>
+    T read()
+    {
+        T value{};
+        if (!m_ok || static_cast<size_t>(m_end - m_pos) < sizeof(T)) {
+            m_ok = false;
+            return value;
+        }
+        std::memcpy(&value, m_pos, sizeof(T));
+        m_pos += sizeof(T);
+        return value;
+    }
+
+    /**
+     * @brief Reads a count prefix of entries at least @p entrySize bytes each.
+     */
+    uint32_t readCount(size_t entrySize)
+    {
+        const uint32_t count = read<uint32_t>();
+        if (m_ok && count > static_cast<size_t>(m_end - m_pos) / entrySize) {
+            m_ok = false;
+            return 0;
+        }
+        return count;
+    }
+
+    bool ok() const { return m_ok; }
+    bool atEnd() const { return m_pos == m_end; }
+
+private:
+    const char* m_pos;
+    const char* m_end;
+    bool m_ok = true;
+};
+
+void writePose(const RigidBodyData& body, char* out)
+{
+    const float pose[7] = {
+        body.position.x(), body.position.y(), body.position.z(),
+        body.orientation.x(), body.orientation.y(), body.orientation.z(), body.orientation.scalar()
+    };
+    std::memcpy(out, pose, sizeof(pose));
+}
+
+void readPose(const char* in, RigidBodyData& body)
+{
+    float pose[7];
+    std::memcpy(pose, in, sizeof(pose));
+    body.position = QVector3D(pose[0], pose[1], pose[2]);
+    body.orientation = QQuaternion(pose[6], pose[3], pose[4], pose[5]);
+}
+
+} // namespace
+
+TakeLayout TakeLayout::fromFrame(const FrameData& frame)
+{
+    TakeLayout layout;
+
+    layout.m_rigidBodies.reserve(frame.rigidBodies.size());
+    for (const RigidBodyData& rb : frame.rigidBodies) {
+        layout.m_rigidBodies.push_back(Body{rb.id, rb.parentId});
+    }
+
+    layout.m_skeletons.reserve(frame.skeletons.size());
+    for (const SkeletonData& skeleton : frame.skeletons) {
+        Skeleton entry;
+        entry.id = skeleton.id;
+        entry.bones.reserve(skeleton.bones.size());
+        for (const RigidBodyData& bone : skeleton.bones) {
+            entry.bones.push_back(Body{bone.id, bone.parentId});
+        }
+        layout.m_skeletons.push_back(std::move(entry));
+    }
+
+    return layout;
+}
+
+bool TakeLayout::fits(const FrameData& frame) const
+{
+    if (frame.rigidBodies.size() != m_rigidBodies.size() || frame.skeletons.size() != m_skeletons.size()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < m_rigidBodies.size(); ++i) {
+        const RigidBodyData& rb = frame.rigidBodies[i];
+
+        // Untracked bodies only hold their slot; their parent is not recorded
+        if (rb.id != m_rigidBodies[i].id || (rb.tracked && rb.parentId != m_rigidBodies[i].parentId)) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < m_skeletons.size(); ++i) {
+        const SkeletonData& skeleton = frame.skeletons[i];
+        const Skeleton& entry = m_skeletons[i];
+        if (skeleton.id != entry.id) {
+            return false;
+        }
+        if (skeleton.bones.empty()) {
+            continue;
+        }
+
+        if (skeleton.bones.size() != entry.bones.size()) {
+            return false;
+        }
+        for (size_t b = 0; b < entry.bones.size(); ++b) {
+            if (skeleton.bones[b].id != entry.bones[b].id || skeleton.bones[b].parentId != entry.bones[b].parentId) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+size_t TakeLayout::recordSize() const
+{
+    size_t size = kFrameHeaderSize + m_rigidBodies.size() * kRigidBodySize;
+    for (const Skeleton& skeleton : m_skeletons) {
+        size += sizeof(uint32_t) + skeleton.bones.size() * kPoseSize;
+    }
+    return (size + 7) & ~size_t(7);
+}
+
+void TakeLayout::serialize(QByteArray& out) const
+{
+    append<uint32_t>(out, static_cast<uint32_t>(m_rigidBodies.size()));
+    for (const Body& rb : m_rigidBodies) {
+        append<int32_t>(out, rb.id);
+        append<int32_t>(out, rb.parentId);
+    }
+
+    append<uint32_t>(out, static_cast<uint32_t>(m_skeletons.size()));
+    for (const Skeleton& skeleton : m_skeletons) {
+        append<int32_t>(out, skeleton.id);
+        append<uint32_t>(out, static_cast<uint32_t>(skeleton.bones.size()));
+        for (const Body& bone : skeleton.bones) {
+            append<int32_t>(out, bone.id);
+            append<int32_t>(out, bone.parentId);
+        }
+    }
+}
+
+bool TakeLayout::deserialize(const char* data, size_t size)
+{
+    LayoutReader reader(data, size);
+
+    m_rigidBodies.resize(reader.readCount(2 * sizeof(int32_t)));
+    for (Body& rb : m_rigidBodies) {
+        rb.id = reader.read<int32_t>();
+        rb.parentId = reader.read<int32_t>();
+    }
+
+    m_skeletons.resize(reader.readCount(sizeof(int32_t) + sizeof(uint32_t)));
+    for (Skeleton& skeleton : m_skeletons) {
+        skeleton.id = reader.read<int32_t>();
+        skeleton.bones.resize(reader.readCount(2 * sizeof(int32_t)));
+        for (Body& bone : skeleton.bones) {
+            bone.id = reader.read<int32_t>();
+            bone.parentId = reader.read<int32_t>();
+        }
+    }
+
+    return reader.ok() && reader.atEnd();
+}
+
+void TakeLayout::writeRecord(const FrameData& frame, char* out) const
+{
+    char* const start = out;
+
+    const int32_t frameNumber = frame.frameNumber;
+    const uint32_t flags = 0;
+    std::memcpy(out, &frameNumber, sizeof(frameNumber));
+    std::memcpy(out + 4, &flags, sizeof(flags));
+    std::memcpy(out + kTimestampOffset, &frame.timestamp, sizeof(frame.timestamp));
+    out += kFrameHeaderSize;
+
+    for (const RigidBodyData& rb : frame.rigidBodies) {
+        const uint32_t tracked = rb.tracked ? 1 : 0;
+        writePose(rb, out);
+        std::memcpy(out + kPoseSize, &tracked, sizeof(tracked));
+        out += kRigidBodySize;
+    }
+
+    for (size_t i = 0; i < m_skeletons.size(); ++i) {
+        const SkeletonData& skeleton = frame.skeletons[i];
+        const uint32_t hasBones = skeleton.bones.empty() ? 0 : 1;
+        std::memcpy(out, &hasBones, sizeof(hasBones));
+        out += sizeof(uint32_t);
+
+        // Boneless skeletons still fill their share of the fixed size record
+        const size_t boneCount = m_skeletons[i].bones.size();
+        if (hasBones) {
+            for (const RigidBodyData& bone : skeleton.bones) {
+                writePose(bone, out);
+                out += kPoseSize;
+            }
+        } else {
+            std::memset(out, 0, boneCount * kPoseSize);
+            out += boneCount * kPoseSize;
+        }
+    }
+
+    std::memset(out, 0, recordSize() - static_cast<size_t>(out - start));
+}
+
+void TakeLayout::bindSlots(AssetSlotMap& slotMap)
+{
+    m_rigidBodySlots.clear();
+    m_rigidBodyExtent = 0;
+    for (const Body& rb : m_rigidBodies) {
+        const int slot = slotMap.addRigidBody(rb.id);
+        m_rigidBodySlots.push_back(slot);
+        m_rigidBodyExtent = std::max(m_rigidBodyExtent, slot + 1);
+    }
+
+    m_skeletonSlots.clear();
+    m_skeletonExtent = 0;
+    for (const Skeleton& skeleton : m_skeletons) {
+        const int slot = slotMap.addSkeleton(skeleton.id);
+        m_skeletonSlots.push_back(slot);
+        m_skeletonExtent = std::max(m_skeletonExtent, slot + 1);
+
+        // The first layout with a skeleton's bones gives their order
+        if (slotMap.boneCount(slot) == 0 && !skeleton.bones.empty()) {
+            std::vector<int> boneIds;
+            boneIds.reserve(skeleton.bones.size());
+            for (const Body& bone : skeleton.bones) {
+                boneIds.push_back(bone.id);
+            }
+            slotMap.setSkeletonBones(slot, std::move(boneIds));
+        }
+    }
+}
+
+void TakeLayout::readRecord(const char* record, const AssetSlotMap& slotMap, FrameData& frame) const
+{
+    int32_t frameNumber;
+    std::memcpy(&frameNumber, record, sizeof(frameNumber));
+    std::memcpy(&frame.timestamp, record + kTimestampOffset, sizeof(frame.timestamp));
+    frame.frameNumber = frameNumber;
+    record += kFrameHeaderSize;
+
+    frame.rigidBodies.assign(static_cast<size_t>(m_rigidBodyExtent), RigidBodyData());
+    for (int k = 0; k < m_rigidBodyExtent; ++k) {
+        frame.rigidBodies[k].id = slotMap.rigidBodyId(k);
+        frame.rigidBodies[k].tracked = false;
+    }
+
+    for (size_t i = 0; i < m_rigidBodies.size(); ++i) {
+        RigidBodyData& rb = frame.rigidBodies[m_rigidBodySlots[i]];
+        uint32_t tracked;
+        std::memcpy(&tracked, record + kPoseSize, sizeof(tracked));
+
+        rb.tracked = tracked != 0;
+        if (rb.tracked) {
+            rb.parentId = m_rigidBodies[i].parentId;
+            readPose(record, rb);
+        }
+        record += kRigidBodySize;
+    }
+
+    frame.skeletons.assign(static_cast<size_t>(m_skeletonExtent), SkeletonData());
+    for (int k = 0; k < m_skeletonExtent; ++k) {
+        frame.skeletons[k].id = slotMap.skeletonId(k);
+    }
+
+    for (size_t i = 0; i < m_skeletons.size(); ++i) {
+        const std::vector<Body>& bones = m_skeletons[i].bones;
+        uint32_t hasBones;
+        std::memcpy(&hasBones, record, sizeof(hasBones));
+        record += sizeof(uint32_t);
+
+        if (hasBones) {
+            SkeletonData& skeleton = frame.skeletons[m_skeletonSlots[i]];
+            skeleton.bones.resize(bones.size());
+            for (size_t b = 0; b < bones.size(); ++b) {
+                skeleton.bones[b].id = bones[b].id;
+                skeleton.bones[b].parentId = bones[b].parentId;
+                readPose(record + b * kPoseSize, skeleton.bones[b]);
+            }
+        }
+        record += bones.size() * kPoseSize;
+    }
+}
@@ -0,0 +1,202 @@
+// On-disk layout of binary takes (.take files).
+//
+// A take is written front to back in one pass, so a live session can be
+// recorded without knowing where it ends:
+//
+//   TakeFileHeader         magic, version and the size of the metadata
+//   metadata               compact JSON: ID-to-name maps and glAssets, as in JSON takes
+//   chunk...               TakeChunkHeader, TakeLayout, then the frame records
+//   TakeIndexEntry...      one per chunk
+//   metadata               optional; supersedes the first, for maps only known later
+//   TakeFooter             where the index starts; last bytes of the file
+//
+// The index, trailing metadata and footer form the trailer. A recording
+// writes a trailer at every checkpoint and the next chunk overwrites it, so
+// the file on disk is a complete take as of its last checkpoint.
+//
+// Every frame of a chunk has the same assets, described once by the chunk's
+// layout, so all its records have the same size and frame i of a chunk lies
+// at a fixed offset. A frame whose assets differ from the open chunk's (a
+// rigid body appears, a skeleton gains its bones) starts a new chunk.
+//
+// Frame record:
+//   int32 frameNumber, uint32 flags (0), double timestamp
+//   per rigid body:  float position[3], float orientation[4] (x, y, z, w), uint32 tracked
+//   per skeleton:    uint32 hasBones, then per bone float position[3], float orientation[4]
+//   zero padding to a multiple of 8 bytes
+//
+// Plain chunks (kPlainEncoding) store the records as they are, with the floats
+// FrameData holds, so converting to and from JSON takes is lossless. Quantized
+// chunks (kQuantizedEncoding) store them compressed, within the error bounds
+// of their TakeQuantization; see take_codec.h. Integers and floats are
+// little-endian, as on every host the client runs on. A take without a valid
+// footer was cut short while writing a chunk; its chunks can still be found by
+// walking them from the metadata.
+//
+// Structs:
+// - TakeHeader: ID-to-name maps and rendering assets of a take.
+// - TakeFileHeader: First bytes of the file.
+// - TakeChunkHeader: Describes one chunk of frame records.
+// - TakeQuantization: Precision of a quantized chunk; first bytes of its payload.
+// - TakeIndexEntry: Where one chunk starts, for seeking.
+// - TakeFooter: Locates the chunk index.
+// - TakeLayout: The rigid bodies and skeletons of every frame in a chunk.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QMetaType>
+
+#include "frame_data.h"
+
+struct TakeHeader {
+    std::unordered_map<int, std::string> rigidBodies;                       // Rigid body ID to name
+    std::unordered_map<int, std::string> skeletons;                         // Skeleton ID to name
+    std::unordered_map<int, std::unordered_map<int, std::string>> bones;    // Skeleton ID to bone ID to name
+    QJsonObject glAssets;                                                   // Skeleton bone pairs and marker offsets
+};
+
+Q_DECLARE_METATYPE(TakeHeader)
+
+struct TakeFileHeader {
+    static constexpr char kMagic[8] = {'S', 'D', 'M', 'T', 'A', 'K', 'E', '\0'};
+    static constexpr uint32_t kVersion = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t metadataSize;          // Bytes of JSON metadata following the header
+};
+
+struct TakeChunkHeader {
+    static constexpr char kMagic[4] = {'T', 'C', 'H', 'K'};
+    static constexpr uint32_t kPlainEncoding = 0;
+    static constexpr uint32_t kQuantizedEncoding = 1;
+
+    char magic[4];
+    uint32_t layoutSize;            // Bytes of the TakeLayout following the header
+    uint32_t recordSize;            // Bytes of each frame record, once decoded
+    uint32_t frameCount;            // Frame records in the chunk
+    uint32_t encoding;              // How the payload stores the records
+    uint32_t payloadSize;           // Bytes of the payload following the layout
+    int32_t firstFrameNumber;
+    int32_t lastFrameNumber;
+    double firstTimestamp;
+    double lastTimestamp;
+};
+
+struct TakeQuantization {
+    double positionResolution;      // Meters per position step
+    double timestampResolution;     // Seconds per timestamp step
+    uint32_t orientationBits;       // Bits per stored quaternion component, sign included
+    uint32_t reserved;              // 0
+};
+
+struct TakeIndexEntry {
+    uint64_t offset;                // File offset of the chunk header
+    uint32_t frameCount;
+    int32_t firstFrameNumber;
+    double firstTimestamp;
+};
+
+struct TakeFooter {
+    static constexpr char kMagic[8] = {'S', 'D', 'M', 'T', 'E', 'N', 'D', '\0'};
+
+    uint64_t indexOffset;           // File offset of the first TakeIndexEntry
+    uint32_t chunkCount;
+    uint32_t metadataSize;          // Bytes of trailing metadata after the index; 0 if there is none
+    uint64_t frameCount;            // Frames in the whole take
+    char magic[8];
+};
+
+static_assert(sizeof(TakeFileHeader) == 16, "TakeFileHeader must match the file layout");
+static_assert(sizeof(TakeChunkHeader) == 48, "TakeChunkHeader must match the file layout");
+static_assert(sizeof(TakeQuantization) == 24, "TakeQuantization must match the file layout");
+static_assert(sizeof(TakeIndexEntry) == 24, "TakeIndexEntry must match the file layout");
+static_assert(sizeof(TakeFooter) == 32, "TakeFooter must match the file layout");
+
+/**
+ * @brief The assets of every frame in a chunk, in the order of their records.
+ */
+class TakeLayout {
+public:
+    struct Body {
+        int32_t id = -1;
+        int32_t parentId = -1;
+    };
+
+    struct Skeleton {
+        int32_t id = -1;
+        std::vector<Body> bones;    // Empty if the skeleton has no bones in any frame of the chunk
+    };
+
+    static constexpr size_t kFrameHeaderSize = 16;      // frameNumber, flags, timestamp
+    static constexpr size_t kTimestampOffset = 8;       // Of the timestamp in a record
+    static constexpr size_t kPoseSize = 7 * sizeof(float);
+    static constexpr size_t kRigidBodySize = kPoseSize + sizeof(uint32_t);
+
+    /**
+     * @brief The layout of @p frame's rigid bodies and skeletons.
+     */
+    static TakeLayout fromFrame(const FrameData& frame);
+
+    /**
+     * @brief Whether @p frame can be recorded with this layout.
+     *
+     * Skeletons without bones in @p frame fit either way.
+     */
+    bool fits(const FrameData& frame) const;
+
+    /**
+     * @brief Bytes of one frame record.
+     */
+    size_t recordSize() const;
+
+    /**
+     * @brief Appends the serialized layout to @p out.
+     */
+    void serialize(QByteArray& out) const;
+
+    /**
+     * @brief Parses a serialized layout of @p size bytes.
+     * @return False if the data is malformed.
+     */
+    bool deserialize(const char* data, size_t size);
+
+    /**
+     * @brief Writes the record of @p frame, which must fit(), to the recordSize() bytes at @p out.
+     */
+    void writeRecord(const FrameData& frame, char* out) const;
+
+    /**
+     * @brief Adds the assets of this layout to @p slotMap, in record order, and keeps their slots.
+     *
+     * Required before readRecord(); every layout of a take binds to the same map.
+     */
+    void bindSlots(AssetSlotMap& slotMap);
+
+    /**
+     * @brief Decodes a record into @p frame, laid out by the @p slotMap the layout was bound to.
+     *
+     * Slots below the highest one of this layout that it does not describe
+     * are left as untracked or boneless placeholders.
+     */
+    void readRecord(const char* record, const AssetSlotMap& slotMap, FrameData& frame) const;
+
+    const std::vector<Body>& rigidBodies() const { return m_rigidBodies; }
+    const std::vector<Skeleton>& skeletons() const { return m_skeletons; }
+
+private:
+    std::vector<Body> m_rigidBodies;
+    std::vector<Skeleton> m_skeletons;
+
+    // Set by bindSlots()
+    std::vector<int> m_rigidBodySlots;      // Slot of each rigid body record
+    std::vector<int> m_skeletonSlots;       // Slot of each skeleton record
+    int m_rigidBodyExtent = 0;              // Rigid body slots a decoded frame holds
+    int m_skeletonExtent = 0;               // Skeleton slots a decoded frame holds
+};
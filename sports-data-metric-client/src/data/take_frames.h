@@ -0,0 +1,47 @@
+// Random access to the frames of a loaded take, for analysis off the replay thread.
+//
+// A take is either a mapped binary take, whose frames are decoded on request,
+// or frames already held in memory. Analysis splits the take into chunks read
+// on several threads at once, each only through its own range of indices, so a
+// mapped take never has to be decoded whole up front.
+//
+// Classes:
+// - TakeFrames: The interface analysis reads a take through.
+// - VectorTakeFrames: Frames held in a QVector.
+
+#pragma once
+
+#include <memory>
+#include <QMetaType>
+#include <QVector>
+
+#include "frame_data.h"
+
+class TakeFrames {
+public:
+    virtual ~TakeFrames() = default;
+
+    virtual int frameCount() const = 0;
+
+    /**
+     * @brief Frame @p index, below frameCount(). May be called from several threads at once.
+     */
+    virtual FramePtr frame(int index) const = 0;
+};
+
+using TakeFramesPtr = std::shared_ptr<const TakeFrames>;
+
+class VectorTakeFrames : public TakeFrames {
+public:
+    explicit VectorTakeFrames(QVector<FramePtr> frames) : m_frames(std::move(frames)) {}
+
+    int frameCount() const override { return static_cast<int>(m_frames.size()); }
+
+    // at() never detaches the shared vector
+    FramePtr frame(int index) const override { return m_frames.at(index); }
+
+private:
+    QVector<FramePtr> m_frames;
+};
+
+Q_DECLARE_METATYPE(TakeFramesPtr)
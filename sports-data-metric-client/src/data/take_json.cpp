@@ -0,0 +1,219 @@
+#include "take_json.h"
+#include "json_take_parser.h"
+#include "take_reader.h"
+#include "take_writer.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+namespace {
+
+QJsonObject bodyToJson(const RigidBodyData& body)
+{
+    QJsonObject obj;
+    obj["id"] = body.id;
+    obj["parentId"] = body.parentId;
+    obj["position"] = QJsonArray{ body.position.x(), body.position.y(), body.position.z() };
+    obj["orientation"] = QJsonArray{ body.orientation.x(), body.orientation.y(), body.orientation.z(),
+                                     body.orientation.scalar() };
+    return obj;
+}
+
+std::unordered_map<int, std::string> nameMapFromJson(const QJsonObject& obj)
+{
+    std::unordered_map<int, std::string> map;
+    for (const QString& key : obj.keys()) {
+        map[key.toInt()] = obj.value(key).toString().toStdString();
+    }
+    return map;
+}
+
+QJsonObject nameMapToJson(const std::unordered_map<int, std::string>& map)
+{
+    QJsonObject obj;
+    for (const auto& [id, name] : map) {
+        obj[QString::number(id)] = QString::fromStdString(name);
+    }
+    return obj;
+}
+
+bool isBinaryTake(const QString& path)
+{
+    return QFileInfo(path).suffix().compare("take", Qt::CaseInsensitive) == 0;
+}
+
+bool isJsonTake(const QString& path)
+{
+    return QFileInfo(path).suffix().compare("json", Qt::CaseInsensitive) == 0;
+}
+
+} // namespace
+
+TakeHeader takeHeaderFromJson(const QJsonObject& root)
+{
+    TakeHeader header;
+    header.rigidBodies = nameMapFromJson(root.value("rigidBodies").toObject());
+    header.skeletons = nameMapFromJson(root.value("skeletons").toObject());
+
+    QJsonObject boneMapJson = root.value("bones").toObject();
+    for (const QString& skeletonIdStr : boneMapJson.keys()) {
+        header.bones[skeletonIdStr.toInt()] = nameMapFromJson(boneMapJson.value(skeletonIdStr).toObject());
+    }
+
+    header.glAssets = root.value("glAssets").toObject();
+    return header;
+}
+
+QJsonObject takeHeaderToJson(const TakeHeader& header)
+{
+    QJsonObject root;
+    root["rigidBodies"] = nameMapToJson(header.rigidBodies);
+    root["skeletons"] = nameMapToJson(header.skeletons);
+
+    QJsonObject bonesMap;
+    for (const auto& [skeletonId, boneMap] : header.bones) {
+        bonesMap[QString::number(skeletonId)] = nameMapToJson(boneMap);
+    }
+    root["bones"] = bonesMap;
+
+    root["glAssets"] = header.glAssets;
+    return root;
+}
+
+QJsonObject frameToJson(const FrameData& frame)
+{
+    QJsonObject frameObj;
+    frameObj["frameNumber"] = frame.frameNumber;
+    frameObj["timestamp"] = frame.timestamp;
+
+    QJsonArray rigidArray;
+    for (const RigidBodyData& rb : frame.rigidBodies) {
+        // Described bodies missing from the frame only hold a slot
+        if (!rb.tracked)
+            continue;
+
+        rigidArray.append(bodyToJson(rb));
+    }
+    frameObj["rigidBodies"] = rigidArray;
+
+    QJsonArray skeletonArray;
+    for (const SkeletonData& skeleton : frame.skeletons) {
+        QJsonObject skeletonObj;
+        skeletonObj["id"] = skeleton.id;
+
+        QJsonArray bonesArray;
+        for (const RigidBodyData& bone : skeleton.bones) {
+            bonesArray.append(bodyToJson(bone));
+        }
+        skeletonObj["bones"] = bonesArray;
+        skeletonArray.append(skeletonObj);
+    }
+    frameObj["skeletons"] = skeletonArray;
+
+    return frameObj;
+}
+
+bool readJsonTake(const QString& path, TakeHeader& header, QVector<FramePtr>& frames)
+{
+    JsonTakeParser parser;
+    if (!parser.open(path)) {
+        qWarning() << "Failed to read JSON take:" << path << parser.errorString();
+        return false;
+    }
+    header = parser.header();
+
+    frames.clear();
+    const bool ok = parser.parseFrames([&frames](QVector<FramePtr> batch) {
+        frames.append(batch);
+    });
+    if (!ok) {
+        qWarning() << "Failed to parse JSON take:" << path << parser.errorString();
+        return false;
+    }
+
+    qDebug() << "Parsed" << frames.size() << "frames.";
+    return true;
+}
+
+bool writeJsonTake(const QString& path, const TakeHeader& header, const QVector<FramePtr>& frames)
+{
+    QJsonObject root = takeHeaderToJson(header);
+
+    QJsonArray framesArray;
+    for (const FramePtr& frame : frames) {
+        framesArray.append(frameToJson(*frame));
+    }
+    root["frames"] = framesArray;
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to open file for saving:" << path;
+        return false;
+    }
+
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+    if (file.write(json) != json.size()) {
+        qWarning() << "Failed to write JSON take:" << path << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool convertTake(const QString& inPath, const QString& outPath, const TakeEncoding& encoding)
+{
+    if (isJsonTake(inPath) && isBinaryTake(outPath)) {
+        TakeHeader header;
+        QVector<FramePtr> frames;
+        if (!readJsonTake(inPath, header, frames)) {
+            return false;
+        }
+
+        TakeWriter writer;
+        if (!writer.setEncoding(encoding)) {
+            qWarning() << "Invalid take encoding for" << outPath;
+            return false;
+        }
+        if (!writer.open(outPath, header)) {
+            qWarning() << "Failed to open binary take:" << outPath << writer.errorString();
+            return false;
+        }
+        for (const FramePtr& frame : frames) {
+            if (!writer.writeFrame(*frame)) {
+                break;
+            }
+        }
+        if (!writer.close()) {
+            qWarning() << "Failed to write binary take:" << outPath << writer.errorString();
+            return false;
+        }
+
+        qDebug() << "Converted" << frames.size() << "frames to" << outPath;
+        return true;
+    }
+
+    if (isBinaryTake(inPath) && isJsonTake(outPath)) {
+        TakeReader reader;
+        if (!reader.open(inPath)) {
+            qWarning() << "Failed to read binary take:" << inPath << reader.errorString();
+            return false;
+        }
+
+        QVector<FramePtr> frames;
+        frames.reserve(static_cast<qsizetype>(reader.frameCount()));
+        for (size_t i = 0; i < reader.frameCount(); ++i) {
+            frames.push_back(reader.frame(i));
+        }
+        if (!writeJsonTake(outPath, reader.header(), frames)) {
+            return false;
+        }
+
+        qDebug() << "Converted" << frames.size() << "frames to" << outPath;
+        return true;
+    }
+
+    qWarning() << "Cannot convert" << inPath << "to" << outPath << "- expected a .json and a .take file";
+    return false;
+}
@@ -0,0 +1,52 @@
+// Reading and writing takes as JSON, and converting them to and from binary takes.
+//
+// A JSON take is one object: the ID-to-name maps ("rigidBodies", "skeletons",
+// "bones"), the rendering assets ("glAssets") and the "frames" array. Each
+// frame lists its tracked rigid bodies and every skeleton slot, with positions
+// and orientations ([x, y, z, w]) as arrays. Loaded frames are laid out by an
+// AssetSlotMap, slotted in order of first appearance, like live frames.
+// Reading streams the frames through JsonTakeParser rather than a QJsonDocument.
+
+#pragma once
+
+#include <memory>
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+
+#include "frame_data.h"
+#include "take_codec.h"
+#include "take_format.h"
+
+/**
+ * @brief Reads the ID-to-name maps and rendering assets of a JSON take.
+ */
+TakeHeader takeHeaderFromJson(const QJsonObject& root);
+
+/**
+ * @brief A JSON take with the maps and rendering assets of @p header and no frames.
+ */
+QJsonObject takeHeaderToJson(const TakeHeader& header);
+
+/**
+ * @brief Serializes one frame; rigid bodies that were not tracked are left out.
+ */
+QJsonObject frameToJson(const FrameData& frame);
+
+/**
+ * @brief Loads a whole JSON take.
+ * @return False if the file cannot be read or is not a take.
+ */
+bool readJsonTake(const QString& path, TakeHeader& header, QVector<FramePtr>& frames);
+
+/**
+ * @brief Writes a JSON take, replacing @p path.
+ */
+bool writeJsonTake(const QString& path, const TakeHeader& header, const QVector<FramePtr>& frames);
+
+/**
+ * @brief Converts a take to the other format, chosen by the file suffixes (.json or .take).
+ * @param encoding How a binary take is stored; plain by default, which is lossless.
+ * @return False if either path has an unknown suffix or reading or writing fails.
+ */
+bool convertTake(const QString& inPath, const QString& outPath, const TakeEncoding& encoding = TakeEncoding());
@@ -0,0 +1,30 @@
+// Metrics of every frame of a recorded take, as computed by the DataProcessor's batch analysis.
+//
+// Structs:
+// - AssetSeries: The metric time series of one asset, with its statistics over the take.
+// - TakeMetrics: The series of every asset analyzed, with the timing of the analysis.
+
+#pragma once
+
+#include <vector>
+#include <QMetaType>
+
+#include "metric_statistics.h"
+#include "metrics_data.h"
+
+struct AssetSeries {
+    int assetId = -1;                       // Motive rigid body or skeleton ID
+    std::vector<MetricsData> frames;        // One entry per frame of the take; without values where the asset is missing
+    MetricStatistics::Snapshot statistics;  // Statistics of the frames with values
+};
+
+struct TakeMetrics {
+    std::vector<AssetSeries> rigidBodies;   // Selected rigid body and the batch ones, in the order requested
+    std::vector<AssetSeries> skeletons;     // Selected skeleton and the batch ones, in the order requested
+    int selectedRigidBody = -1;             // Index of the selected rigid body in rigidBodies; -1 if none
+    int selectedSkeleton = -1;              // Index of the selected skeleton in skeletons; -1 if none
+    int chunks = 0;                         // Chunks the frames were split into
+    double wallUs = 0.0;                    // Time from dispatch until every chunk finished, in microseconds
+};
+
+Q_DECLARE_METATYPE(TakeMetrics)
@@ -0,0 +1,344 @@
+#include "take_reader.h"
+#include "take_codec.h"
+#include "take_json.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonParseError>
+
+TakeReader::~TakeReader()
+{
+    close();
+}
+
+bool TakeReader::open(const QString& path)
+{
+    close();
+    m_error.clear();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return fail(m_file.errorString());
+    }
+
+    m_size = static_cast<size_t>(m_file.size());
+    if (uchar* mapped = m_size > 0 ? m_file.map(0, m_file.size()) : nullptr) {
+        m_data = reinterpret_cast<const char*>(mapped);
+    } else {
+        // Files that cannot be mapped, such as compressed resources, are read whole
+        m_buffer = m_file.readAll();
+        m_data = m_buffer.constData();
+        m_size = static_cast<size_t>(m_buffer.size());
+    }
+
+    TakeFileHeader fileHeader;
+    if (m_size < sizeof(fileHeader)) {
+        return fail("File is too short for a take");
+    }
+    std::memcpy(&fileHeader, m_data, sizeof(fileHeader));
+    if (std::memcmp(fileHeader.magic, TakeFileHeader::kMagic, sizeof(fileHeader.magic)) != 0) {
+        return fail("Not a binary take");
+    }
+    if (fileHeader.version != TakeFileHeader::kVersion) {
+        return fail(QString("Unsupported take version %1").arg(fileHeader.version));
+    }
+    if (fileHeader.metadataSize > m_size - sizeof(fileHeader)) {
+        return fail("Truncated take metadata");
+    }
+
+    if (!readMetadata(sizeof(fileHeader), fileHeader.metadataSize)) {
+        return fail("Invalid take metadata");
+    }
+
+    const size_t firstChunk = sizeof(fileHeader) + fileHeader.metadataSize;
+    if (loadIndex(firstChunk)) {
+        return true;
+    }
+
+    // Without a usable index, recover every complete chunk
+    m_chunks.clear();
+    m_frameCount = 0;
+    m_error.clear();
+    walkChunks(firstChunk);
+
+    qWarning() << "TakeReader: take was not closed cleanly, recovered" << m_frameCount << "frames:" << path << m_error;
+    m_error.clear();
+    return true;
+}
+
+void TakeReader::close()
+{
+    if (m_file.isOpen()) {
+        m_file.close();     // Also unmaps
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_buffer.clear();
+
+    m_header = TakeHeader();
+    m_chunks.clear();
+    m_slotMap.reset();
+    m_frameCount = 0;
+
+    std::lock_guard<std::mutex> lock(m_decodedMutex);
+    m_decoded.clear();
+}
+
+double TakeReader::firstTimestamp() const
+{
+    return m_frameCount > 0 ? recordTimestamp(m_chunks.front(), 0) : 0.0;
+}
+
+double TakeReader::lastTimestamp() const
+{
+    return m_frameCount > 0 ? recordTimestamp(m_chunks.back(), m_chunks.back().frameCount - 1) : 0.0;
+}
+
+FramePtr TakeReader::frame(size_t index) const
+{
+    const Chunk& chunk = chunkOf(index);
+
+    std::shared_ptr<const QByteArray> decoded;
+    const char* records = chunkRecords(chunk, decoded);
+
+    std::shared_ptr<FrameData> frame = std::make_shared<FrameData>();
+    frame->slotMap = m_slotMap;
+    chunk.layout.readRecord(records + (index - chunk.firstFrame) * chunk.recordSize, *m_slotMap, *frame);
+    return frame;
+}
+
+size_t TakeReader::indexAtTime(double timestamp) const
+{
+    if (m_chunks.empty()) {
+        return 0;
+    }
+
+    // Last chunk starting at or before the timestamp
+    auto it = std::upper_bound(m_chunks.begin(), m_chunks.end(), timestamp,
+                               [](double t, const Chunk& chunk) { return t < chunk.firstTimestamp; });
+    if (it == m_chunks.begin()) {
+        return 0;
+    }
+    const Chunk& chunk = *(it - 1);
+
+    // Last record at or before it; records of a chunk are in time order
+    size_t low = 0;
+    size_t high = chunk.frameCount;
+    while (high - low > 1) {
+        const size_t mid = low + (high - low) / 2;
+        if (recordTimestamp(chunk, mid) <= timestamp) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return chunk.firstFrame + low;
+}
+
+bool TakeReader::readMetadata(size_t offset, size_t size)
+{
+    QJsonParseError parseError;
+    const QJsonDocument metadata = QJsonDocument::fromJson(QByteArray::fromRawData(m_data + offset, static_cast<qsizetype>(size)),
+                                                           &parseError);
+    if (parseError.error != QJsonParseError::NoError || !metadata.isObject()) {
+        qWarning() << "TakeReader: invalid take metadata:" << parseError.errorString();
+        return false;
+    }
+
+    m_header = takeHeaderFromJson(metadata.object());
+    return true;
+}
+
+bool TakeReader::loadIndex(size_t firstChunk)
+{
+    TakeFooter footer;
+    if (m_size < firstChunk + sizeof(footer)) {
+        return false;
+    }
+    std::memcpy(&footer, m_data + m_size - sizeof(footer), sizeof(footer));
+    if (std::memcmp(footer.magic, TakeFooter::kMagic, sizeof(footer.magic)) != 0) {
+        return false;
+    }
+
+    // The trailer must fill the file from the index to the footer
+    const size_t trailerEnd = m_size - sizeof(footer);
+    const uint64_t trailerSize = static_cast<uint64_t>(footer.chunkCount) * sizeof(TakeIndexEntry) + footer.metadataSize;
+    if (footer.indexOffset < firstChunk || footer.indexOffset > trailerEnd ||
+        trailerEnd - footer.indexOffset != trailerSize) {
+        return false;
+    }
+
+    const size_t end = static_cast<size_t>(footer.indexOffset);
+    m_slotMap = std::make_shared<AssetSlotMap>();
+    m_chunks.reserve(footer.chunkCount);
+    for (uint32_t i = 0; i < footer.chunkCount; ++i) {
+        TakeIndexEntry entry;
+        std::memcpy(&entry, m_data + end + i * sizeof(entry), sizeof(entry));
+
+        bool complete = false;
+        size_t chunkEnd = 0;
+        if (entry.offset < firstChunk || entry.offset > end ||
+            !addChunk(static_cast<size_t>(entry.offset), end, complete, chunkEnd) || !complete) {
+            qWarning() << "TakeReader: corrupt chunk index entry" << i << m_error;
+            return false;
+        }
+    }
+    if (m_frameCount != footer.frameCount) {
+        qWarning() << "TakeReader: chunk index does not match the footer";
+        return false;
+    }
+
+    // Maps that became known while recording supersede the ones in the file header
+    if (footer.metadataSize > 0) {
+        readMetadata(end + footer.chunkCount * sizeof(TakeIndexEntry), footer.metadataSize);
+    }
+    return true;
+}
+
+void TakeReader::walkChunks(size_t firstChunk)
+{
+    m_slotMap = std::make_shared<AssetSlotMap>();
+
+    // Stops at the first bytes that are not a complete chunk: a checkpoint's trailer or a torn write
+    size_t offset = firstChunk;
+    bool complete = true;
+    while (complete) {
+        if (!addChunk(offset, m_size, complete, offset)) {
+            break;
+        }
+    }
+}
+
+bool TakeReader::addChunk(size_t offset, size_t end, bool& complete, size_t& chunkEnd)
+{
+    complete = false;
+    if (offset > end || end - offset < sizeof(TakeChunkHeader)) {
+        return true;
+    }
+
+    TakeChunkHeader chunkHeader;
+    std::memcpy(&chunkHeader, m_data + offset, sizeof(chunkHeader));
+    if (std::memcmp(chunkHeader.magic, TakeChunkHeader::kMagic, sizeof(chunkHeader.magic)) != 0) {
+        return false;
+    }
+
+    const size_t layoutOffset = offset + sizeof(chunkHeader);
+    const size_t recordsOffset = layoutOffset + chunkHeader.layoutSize;
+    if (static_cast<uint64_t>(recordsOffset) + chunkHeader.payloadSize > end) {
+        return true;
+    }
+
+    Chunk chunk;
+    if (!chunk.layout.deserialize(m_data + layoutOffset, chunkHeader.layoutSize)) {
+        return false;
+    }
+    if (chunkHeader.frameCount == 0 || chunkHeader.recordSize != chunk.layout.recordSize()) {
+        return false;
+    }
+
+    if (chunkHeader.encoding == TakeChunkHeader::kPlainEncoding) {
+        if (static_cast<uint64_t>(chunkHeader.recordSize) * chunkHeader.frameCount != chunkHeader.payloadSize) {
+            return false;
+        }
+        chunk.records = m_data + recordsOffset;
+    } else if (chunkHeader.encoding == TakeChunkHeader::kQuantizedEncoding) {
+        // The payload itself is only checked once it is decoded
+        TakeQuantization quantization;
+        if (chunkHeader.payloadSize < sizeof(quantization) ||
+            static_cast<uint64_t>(chunkHeader.recordSize) * chunkHeader.frameCount > std::numeric_limits<int32_t>::max()) {
+            return false;
+        }
+        std::memcpy(&quantization, m_data + recordsOffset, sizeof(quantization));
+        if (!take_codec::isValid(quantization)) {
+            return false;
+        }
+    } else {
+        m_error = QString("Unsupported chunk encoding %1").arg(chunkHeader.encoding);
+        return false;
+    }
+
+    chunk.layout.bindSlots(*m_slotMap);
+    chunk.payload = m_data + recordsOffset;
+    chunk.payloadSize = chunkHeader.payloadSize;
+    chunk.encoding = chunkHeader.encoding;
+    chunk.recordSize = chunkHeader.recordSize;
+    chunk.firstFrame = m_frameCount;
+    chunk.frameCount = chunkHeader.frameCount;
+    chunk.firstTimestamp = chunkHeader.firstTimestamp;
+
+    m_frameCount += chunk.frameCount;
+    m_chunks.push_back(std::move(chunk));
+
+    complete = true;
+    chunkEnd = recordsOffset + chunkHeader.payloadSize;
+    return true;
+}
+
+const TakeReader::Chunk& TakeReader::chunkOf(size_t index) const
+{
+    // Last chunk starting at or before the frame
+    auto it = std::upper_bound(m_chunks.begin(), m_chunks.end(), index,
+                               [](size_t i, const Chunk& chunk) { return i < chunk.firstFrame; });
+    return *(it - 1);
+}
+
+const char* TakeReader::chunkRecords(const Chunk& chunk, std::shared_ptr<const QByteArray>& decoded) const
+{
+    if (chunk.records) {
+        return chunk.records;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_decodedMutex);
+        for (auto it = m_decoded.begin(); it != m_decoded.end(); ++it) {
+            if (it->first == chunk.firstFrame) {
+                decoded = it->second;
+                std::rotate(it, it + 1, m_decoded.end());
+                return decoded->constData();
+            }
+        }
+    }
+
+    // Decoded outside the lock; two threads may both decode a chunk, but neither waits
+    TakeChunkHeader header{};
+    header.recordSize = static_cast<uint32_t>(chunk.recordSize);
+    header.frameCount = static_cast<uint32_t>(chunk.frameCount);
+    header.firstTimestamp = chunk.firstTimestamp;
+
+    QByteArray records;
+    if (!take_codec::decodeChunk(header, chunk.layout, chunk.payload, chunk.payloadSize, records)) {
+        // Frames of a corrupt chunk read as empty rather than failing the replay
+        qWarning() << "TakeReader: corrupt chunk at frame" << chunk.firstFrame;
+        records = QByteArray(static_cast<qsizetype>(chunk.recordSize * chunk.frameCount), '\0');
+    }
+    decoded = std::make_shared<const QByteArray>(std::move(records));
+
+    std::lock_guard<std::mutex> lock(m_decodedMutex);
+    if (m_decoded.size() >= kDecodedChunkCount) {
+        m_decoded.erase(m_decoded.begin());
+    }
+    m_decoded.emplace_back(chunk.firstFrame, decoded);
+    return decoded->constData();
+}
+
+double TakeReader::recordTimestamp(const Chunk& chunk, size_t index) const
+{
+    std::shared_ptr<const QByteArray> decoded;
+    const char* records = chunkRecords(chunk, decoded);
+
+    double timestamp;
+    std::memcpy(&timestamp, records + index * chunk.recordSize + TakeLayout::kTimestampOffset, sizeof(timestamp));
+    return timestamp;
+}
+
+bool TakeReader::fail(const QString& error)
+{
+    // A more specific error may have been recorded on the way
+    const QString message = m_error.isEmpty() ? error : error + ": " + m_error;
+    close();
+    m_error = message;
+    return false;
+}
@@ -0,0 +1,133 @@
+// Reads binary takes (see take_format.h) by memory-mapping them.
+//
+// open() maps the file and reads only its header and the chunk index from the
+// trailer; a take that was cut short while writing has its chunks walked instead.
+// Every chunk's layout is bound to one AssetSlotMap. Frames are decoded
+// straight from the mapping on request, so opening a take costs its chunk
+// count rather than its size, and only the pages of frames actually read are
+// brought into memory. Quantized chunks are decompressed whole on their first
+// read and the last few are kept. Decoding may run on several threads.
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include "frame_data.h"
+#include "take_format.h"
+
+class TakeReader {
+public:
+    static constexpr size_t kDecodedChunkCount = 4;    // Quantized chunks kept decompressed
+
+    TakeReader() = default;
+    ~TakeReader();
+
+    TakeReader(const TakeReader&) = delete;
+    TakeReader& operator=(const TakeReader&) = delete;
+
+    /**
+     * @brief Maps the take at @p path.
+     * @return False if it cannot be read or is not a binary take; see errorString().
+     */
+    bool open(const QString& path);
+
+    /**
+     * @brief Unmaps the take; frames already decoded stay valid.
+     */
+    void close();
+
+    QString errorString() const { return m_error; }
+
+    /**
+     * @brief The ID-to-name maps and rendering assets of the take.
+     */
+    const TakeHeader& header() const { return m_header; }
+
+    size_t frameCount() const { return m_frameCount; }
+
+    /**
+     * @brief Timestamps of the first and last frames; zero for an empty take.
+     */
+    double firstTimestamp() const;
+    double lastTimestamp() const;
+
+    /**
+     * @brief Decodes frame @p index, which must be below frameCount().
+     */
+    FramePtr frame(size_t index) const;
+
+    /**
+     * @brief Index of the last frame at or before @p timestamp; 0 if every frame is later.
+     *
+     * Searches the chunk index, then the timestamps of one chunk's records.
+     */
+    size_t indexAtTime(double timestamp) const;
+
+private:
+    struct Chunk {
+        TakeLayout layout;
+        const char* records = nullptr;  // First record, in the mapping; null if the chunk is not plain
+        const char* payload = nullptr;  // Encoded records, in the mapping
+        size_t payloadSize = 0;
+        uint32_t encoding = TakeChunkHeader::kPlainEncoding;
+        size_t recordSize = 0;
+        size_t firstFrame = 0;          // Take index of the first frame
+        size_t frameCount = 0;
+        double firstTimestamp = 0;
+    };
+
+    bool fail(const QString& error);
+
+    /**
+     * @brief Parses @p size bytes of metadata at @p offset into the header.
+     */
+    bool readMetadata(size_t offset, size_t size);
+
+    /**
+     * @brief Reads the chunks listed in the trailer of a take whose chunks start at @p firstChunk.
+     * @return False if the take has no trailer or it does not match the chunks.
+     */
+    bool loadIndex(size_t firstChunk);
+
+    /**
+     * @brief Reads the chunks one after another from @p firstChunk, for takes without a trailer.
+     */
+    void walkChunks(size_t firstChunk);
+
+    /**
+     * @brief Adds the chunk whose header is at @p offset, which must end by @p end.
+     * @return False if the chunk is malformed; true with @p complete false if it runs past @p end.
+     */
+    bool addChunk(size_t offset, size_t end, bool& complete, size_t& chunkEnd);
+
+    /**
+     * @brief The chunk holding frame @p index.
+     */
+    const Chunk& chunkOf(size_t index) const;
+
+    /**
+     * @brief The plain records of @p chunk: in the mapping, or decoded and held by @p decoded.
+     */
+    const char* chunkRecords(const Chunk& chunk, std::shared_ptr<const QByteArray>& decoded) const;
+
+    double recordTimestamp(const Chunk& chunk, size_t index) const;
+
+    QFile m_file;
+    const char* m_data = nullptr;       // The mapped file, or m_buffer if it cannot be mapped
+    size_t m_size = 0;
+    QByteArray m_buffer;
+
+    QString m_error;
+    TakeHeader m_header;
+    std::vector<Chunk> m_chunks;
+    std::shared_ptr<AssetSlotMap> m_slotMap;
+    size_t m_frameCount = 0;
+
+    mutable std::mutex m_decodedMutex;
+    mutable std::vector<std::pair<size_t, std::shared_ptr<const QByteArray>>> m_decoded; // By first frame; newest last
+};
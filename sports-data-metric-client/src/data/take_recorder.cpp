@@ -0,0 +1,101 @@
+#include "take_recorder.h"
+
+#include <QDebug>
+
+TakeRecorder::TakeRecorder(std::shared_ptr<FrameTap> tap, QObject* parent)
+    : QObject(parent), m_tap(std::move(tap))
+{
+    // Parented so it follows the recorder onto its thread
+    m_drainTimer = new QTimer(this);
+    m_drainTimer->setInterval(kDrainIntervalMs);
+    connect(m_drainTimer, &QTimer::timeout, this, &TakeRecorder::drainFrames);
+}
+
+void TakeRecorder::startRecording(QString path, TakeHeader header)
+{
+    if (m_writer.isOpen()) {
+        stopRecording(m_header);
+    }
+
+    m_path = path;
+    m_header = std::move(header);
+    m_writer.setEncoding(TakeEncoding::quantized());
+    if (!m_writer.open(m_path, m_header)) {
+        qWarning() << "TakeRecorder: failed to create take:" << m_path << m_writer.errorString();
+        return;
+    }
+
+    // Frames left in the tap belong to the previous recording
+    m_drained.clear();
+    m_tap->drain(m_drained);
+    m_drained.clear();
+    m_droppedAtStart = m_tap->dropped();
+    m_tap->setEnabled(true);
+
+    m_sinceCheckpoint.start();
+    m_drainTimer->start();
+    qDebug() << "TakeRecorder: recording to" << m_path;
+}
+
+void TakeRecorder::stopRecording(TakeHeader header)
+{
+    if (!m_writer.isOpen()) {
+        return;
+    }
+
+    m_tap->setEnabled(false);
+    drainFrames();
+    m_drainTimer->stop();
+
+    m_header = std::move(header);
+    m_writer.setHeader(m_header);
+    if (!m_writer.close()) {
+        qWarning() << "TakeRecorder: failed to close take:" << m_path << m_writer.errorString();
+    }
+
+    const uint64_t framesLost = m_tap->dropped() - m_droppedAtStart;
+    if (framesLost > 0) {
+        qWarning() << "TakeRecorder:" << framesLost << "frames did not fit in the tap between drains and were not recorded";
+    }
+    qDebug() << "TakeRecorder: saved" << m_writer.framesWritten() << "frames to" << m_path;
+
+    emit recordingSaved(m_path, m_writer.framesWritten());
+}
+
+void TakeRecorder::receiveMaps(const std::unordered_map<int, std::string>& rigidBodies,
+                               const std::unordered_map<int, std::string>& skeletons,
+                               const std::unordered_map<int, std::unordered_map<int, std::string>>& bones)
+{
+    m_header.rigidBodies = rigidBodies;
+    m_header.skeletons = skeletons;
+    m_header.bones = bones;
+    m_writer.setHeader(m_header);
+}
+
+void TakeRecorder::drainFrames()
+{
+    if (!m_writer.isOpen()) {
+        return;
+    }
+
+    // Reused across drains; clearing releases the frames back to the source's pool
+    m_drained.clear();
+    m_tap->drain(m_drained);
+    for (const FramePtr& frame : m_drained) {
+        if (!m_writer.writeFrame(*frame)) {
+            qWarning() << "TakeRecorder: failed to write take:" << m_path << m_writer.errorString();
+            m_tap->setEnabled(false);
+            m_drainTimer->stop();
+            m_drained.clear();
+            return;
+        }
+    }
+    m_drained.clear();
+
+    if (m_sinceCheckpoint.elapsed() >= kCheckpointIntervalMs) {
+        if (!m_writer.checkpoint()) {
+            qWarning() << "TakeRecorder: failed to checkpoint take:" << m_path << m_writer.errorString();
+        }
+        m_sinceCheckpoint.restart();
+    }
+}
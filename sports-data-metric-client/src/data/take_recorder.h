@@ -0,0 +1,88 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "frame_data.h"
+#include "frame_tap.h"
+#include "take_format.h"
+#include "take_writer.h"
+
+/**
+ * @brief Records live frames to a binary take on its own thread.
+ *
+ * While recording, the ingest worker hands every frame it publishes to a
+ * FrameTap, and a timer drains the tap into a TakeWriter, so memory stays
+ * bounded by the tap and one open chunk however long the session runs. Unlike
+ * the frame history, the tap keeps every frame between drains; frames are only
+ * lost, and counted, if a drain falls a whole tap behind. Every
+ * kCheckpointIntervalMs the take is checkpointed and synced to disk; a crash
+ * loses at most the frames since. Stopping only writes the last few frames and
+ * the trailer.
+ */
+class TakeRecorder : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int kDrainIntervalMs = 100;
+    static constexpr int kCheckpointIntervalMs = 1000;
+
+    /**
+     * @brief Constructs the recorder reading from the connection's record tap.
+     * @param tap Tap the frame sources hand every published frame to; the recorder is its only consumer.
+     * @param parent Optional parent QObject.
+     */
+    explicit TakeRecorder(std::shared_ptr<FrameTap> tap, QObject* parent = nullptr);
+
+public slots:
+    /**
+     * @brief Creates the take at @p path and records every frame published from now on.
+     * @param path File to record to, replacing any file there.
+     * @param header ID-to-name maps and rendering assets known so far.
+     */
+    void startRecording(QString path, TakeHeader header);
+
+    /**
+     * @brief Writes the remaining frames and closes the take.
+     * @param header Final ID-to-name maps and rendering assets of the session.
+     */
+    void stopRecording(TakeHeader header);
+
+    /**
+     * @brief Updates the maps written with the next checkpoint.
+     */
+    void receiveMaps(const std::unordered_map<int, std::string>& rigidBodies,
+                     const std::unordered_map<int, std::string>& skeletons,
+                     const std::unordered_map<int, std::unordered_map<int, std::string>>& bones);
+
+signals:
+    /**
+     * @brief Signal emitted once a recorded take is closed.
+     * @param path The take file.
+     * @param frameCount Frames written to it.
+     */
+    void recordingSaved(QString path, quint64 frameCount);
+
+private slots:
+    /**
+     * @brief Appends the frames queued in the tap since the last drain, checkpointing when due.
+     */
+    void drainFrames();
+
+private:
+    std::shared_ptr<FrameTap> m_tap;                // Every frame published by the connection
+    std::vector<FramePtr> m_drained;                // Frames taken from the tap by the current drain
+    TakeWriter m_writer;
+    TakeHeader m_header;                            // Written with each checkpoint
+    QString m_path;
+
+    QTimer* m_drainTimer = nullptr;                 // Drains the tap while recording
+    QElapsedTimer m_sinceCheckpoint;
+
+    uint64_t m_droppedAtStart = 0;                  // Frames the tap had dropped when recording started
+};
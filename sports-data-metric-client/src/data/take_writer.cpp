@@ -0,0 +1,239 @@
+#include "take_writer.h"
+#include "take_json.h"
+
+#include <algorithm>
+#include <cstring>
+#include <QJsonDocument>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+TakeWriter::TakeWriter(int framesPerChunk)
+    : m_framesPerChunk(std::max(1, framesPerChunk))
+{
+}
+
+TakeWriter::~TakeWriter()
+{
+    if (isOpen()) {
+        close();
+    }
+}
+
+bool TakeWriter::open(const QString& path, const TakeHeader& header)
+{
+    if (isOpen()) {
+        close();
+    }
+
+    m_error.clear();
+    m_chunk = TakeChunkHeader{};
+    m_records.resize(0);
+    m_index.clear();
+    m_framesWritten = 0;
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+
+    setHeader(header);
+
+    TakeFileHeader fileHeader{};
+    std::memcpy(fileHeader.magic, TakeFileHeader::kMagic, sizeof(fileHeader.magic));
+    fileHeader.version = TakeFileHeader::kVersion;
+    fileHeader.metadataSize = static_cast<uint32_t>(m_metadata.size());
+
+    if (!write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader)) ||
+        !write(m_metadata.constData(), m_metadata.size())) {
+        m_file.close();
+        return false;
+    }
+    return true;
+}
+
+bool TakeWriter::writeFrame(const FrameData& frame)
+{
+    if (!isOpen()) {
+        return false;
+    }
+
+    if (m_chunk.frameCount > 0 &&
+        (m_chunk.frameCount >= chunkFrameLimit() || !m_layout.fits(frame))) {
+        if (!flushChunk()) {
+            return false;
+        }
+    }
+
+    if (m_chunk.frameCount == 0) {
+        m_layout = TakeLayout::fromFrame(frame);
+        m_chunk.recordSize = static_cast<uint32_t>(m_layout.recordSize());
+        m_chunk.firstFrameNumber = frame.frameNumber;
+        m_chunk.firstTimestamp = frame.timestamp;
+        m_records.reserve(static_cast<qsizetype>(m_chunk.recordSize) * chunkFrameLimit());
+    }
+
+    const qsizetype offset = m_records.size();
+    m_records.resize(offset + static_cast<qsizetype>(m_chunk.recordSize));
+    m_layout.writeRecord(frame, m_records.data() + offset);
+
+    ++m_chunk.frameCount;
+    m_chunk.lastFrameNumber = frame.frameNumber;
+    m_chunk.lastTimestamp = frame.timestamp;
+    ++m_framesWritten;
+    return true;
+}
+
+bool TakeWriter::setEncoding(const TakeEncoding& encoding)
+{
+    if (encoding.encoding == TakeChunkHeader::kQuantizedEncoding && !take_codec::isValid(encoding.quantization)) {
+        return false;
+    }
+    if (encoding.encoding != TakeChunkHeader::kPlainEncoding &&
+        encoding.encoding != TakeChunkHeader::kQuantizedEncoding) {
+        return false;
+    }
+
+    m_encoding = encoding;
+    return true;
+}
+
+void TakeWriter::setHeader(const TakeHeader& header)
+{
+    m_metadata = QJsonDocument(takeHeaderToJson(header)).toJson(QJsonDocument::Compact);
+}
+
+bool TakeWriter::checkpoint()
+{
+    if (!isOpen()) {
+        return false;
+    }
+
+    if (!flushChunk()) {
+        return false;
+    }
+
+    // The next chunk starts where this trailer does
+    const qint64 chunksEnd = m_file.pos();
+    if (!writeTrailer() || !sync()) {
+        return false;
+    }
+    if (!m_file.seek(chunksEnd)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool TakeWriter::close()
+{
+    if (!isOpen()) {
+        return m_error.isEmpty();
+    }
+
+    bool ok = flushChunk() && writeTrailer();
+
+    // A checkpoint's trailer may have been longer than this one
+    if (ok && !m_file.resize(m_file.pos())) {
+        m_error = m_file.errorString();
+        ok = false;
+    }
+    ok = ok && sync();
+
+    m_file.close();
+    return ok;
+}
+
+bool TakeWriter::writeTrailer()
+{
+    TakeFooter footer{};
+    footer.indexOffset = static_cast<uint64_t>(m_file.pos());
+    footer.chunkCount = static_cast<uint32_t>(m_index.size());
+    footer.metadataSize = static_cast<uint32_t>(m_metadata.size());
+    footer.frameCount = m_framesWritten;
+    std::memcpy(footer.magic, TakeFooter::kMagic, sizeof(footer.magic));
+
+    return write(reinterpret_cast<const char*>(m_index.data()),
+                 static_cast<qint64>(m_index.size() * sizeof(TakeIndexEntry))) &&
+           write(m_metadata.constData(), m_metadata.size()) &&
+           write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+}
+
+bool TakeWriter::sync()
+{
+    if (!m_file.flush()) {
+        m_error = m_file.errorString();
+        return false;
+    }
+
+#if defined(_WIN32)
+    const bool synced = _commit(m_file.handle()) == 0;
+#else
+    const bool synced = ::fsync(m_file.handle()) == 0;
+#endif
+    if (!synced) {
+        m_error = "Failed to sync the take to disk";
+    }
+    return synced;
+}
+
+uint32_t TakeWriter::chunkFrameLimit() const
+{
+    const uint32_t frames = static_cast<uint32_t>(m_framesPerChunk);
+    if (m_encoding.encoding != TakeChunkHeader::kQuantizedEncoding) {
+        return frames;
+    }
+
+    const size_t fitting = kQuantizedChunkBytes / std::max<size_t>(m_chunk.recordSize, 1);
+    return static_cast<uint32_t>(std::clamp<size_t>(fitting, frames, size_t(frames) * kMaxQuantizedChunkScale));
+}
+
+bool TakeWriter::flushChunk()
+{
+    if (m_chunk.frameCount == 0) {
+        return true;
+    }
+
+    QByteArray layout;
+    m_layout.serialize(layout);
+
+    // Quantized chunks are compressed here, once per chunk rather than per frame
+    const QByteArray payload = m_encoding.encoding == TakeChunkHeader::kQuantizedEncoding
+        ? take_codec::encodeChunk(m_chunk, m_layout, m_records.constData(), m_encoding.quantization)
+        : m_records;
+
+    std::memcpy(m_chunk.magic, TakeChunkHeader::kMagic, sizeof(m_chunk.magic));
+    m_chunk.layoutSize = static_cast<uint32_t>(layout.size());
+    m_chunk.encoding = m_encoding.encoding;
+    m_chunk.payloadSize = static_cast<uint32_t>(payload.size());
+
+    TakeIndexEntry entry{};
+    entry.offset = static_cast<uint64_t>(m_file.pos());
+    entry.frameCount = m_chunk.frameCount;
+    entry.firstFrameNumber = m_chunk.firstFrameNumber;
+    entry.firstTimestamp = m_chunk.firstTimestamp;
+
+    const bool ok = write(reinterpret_cast<const char*>(&m_chunk), sizeof(m_chunk)) &&
+                    write(layout.constData(), layout.size()) &&
+                    write(payload.constData(), payload.size());
+    if (ok) {
+        m_index.push_back(entry);
+    }
+
+    m_chunk = TakeChunkHeader{};
+    m_records.resize(0);
+    return ok;
+}
+
+bool TakeWriter::write(const char* data, qint64 size)
+{
+    if (m_file.write(data, size) != size) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    return true;
+}
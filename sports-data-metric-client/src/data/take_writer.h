@@ -0,0 +1,124 @@
+// Writes binary takes (see take_format.h) one frame at a time.
+//
+// Frames are appended to the open chunk in memory and written out a chunk at
+// a time, so recording costs one memcpy-sized encode per frame and a file
+// write every few hundred frames. Chunks are plain unless setEncoding() asks
+// for quantized ones, which are compressed as they are written out. The
+// trailer (chunk index, metadata and footer) is written by close(), and by
+// checkpoint() for takes that must survive the process dying while they are
+// recorded.
+
+#pragma once
+
+#include <vector>
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include "frame_data.h"
+#include "take_codec.h"
+#include "take_format.h"
+
+class TakeWriter {
+public:
+    static constexpr int kDefaultFramesPerChunk = 256;
+    static constexpr int kMaxQuantizedChunkScale = 4;           // Quantized chunks hold up to this many times framesPerChunk frames...
+    static constexpr size_t kQuantizedChunkBytes = 1 << 20;     // ...while their decoded records fit in this many bytes
+
+    /**
+     * @brief Constructs a writer that starts a new chunk every @p framesPerChunk frames.
+     *
+     * Quantized chunks of small scenes run longer, up to kMaxQuantizedChunkScale
+     * times as many frames, spreading their headers and the compressor's warm-up
+     * over more frames; decoding one stays as cheap as a chunk of a large scene.
+     */
+    explicit TakeWriter(int framesPerChunk = kDefaultFramesPerChunk);
+
+    /**
+     * @brief Closes the take if it is still open.
+     */
+    ~TakeWriter();
+
+    TakeWriter(const TakeWriter&) = delete;
+    TakeWriter& operator=(const TakeWriter&) = delete;
+
+    /**
+     * @brief Creates the take at @p path, replacing any file there, and writes its header.
+     * @return False if the file cannot be written; see errorString().
+     */
+    bool open(const QString& path, const TakeHeader& header);
+
+    /**
+     * @brief Appends a frame to the take.
+     * @return False if writing a finished chunk failed; see errorString().
+     */
+    bool writeFrame(const FrameData& frame);
+
+    /**
+     * @brief Sets how the chunks written from now on are stored.
+     * @return False, leaving the encoding unchanged, if its quantization is invalid.
+     */
+    bool setEncoding(const TakeEncoding& encoding);
+
+    /**
+     * @brief Replaces the maps and rendering assets written with the trailer.
+     */
+    void setHeader(const TakeHeader& header);
+
+    /**
+     * @brief Writes the open chunk and a trailer, and waits for the file to reach the disk.
+     *
+     * The next chunk overwrites the trailer, so a take that is never closed
+     * still reads back up to its last checkpoint.
+     * @return False if writing or syncing failed; see errorString().
+     */
+    bool checkpoint();
+
+    /**
+     * @brief Writes the last chunk and the trailer, and closes the file.
+     * @return False if any of them could not be written; see errorString().
+     */
+    bool close();
+
+    bool isOpen() const { return m_file.isOpen(); }
+    QString errorString() const { return m_error; }
+    quint64 framesWritten() const { return m_framesWritten; }
+
+private:
+    /**
+     * @brief Number of frames after which the open chunk is written.
+     */
+    uint32_t chunkFrameLimit() const;
+
+    /**
+     * @brief Writes the open chunk, if it has frames, and adds it to the index.
+     */
+    bool flushChunk();
+
+    /**
+     * @brief Writes the index, trailing metadata and footer after the last chunk.
+     */
+    bool writeTrailer();
+
+    /**
+     * @brief Flushes the file and waits for the operating system to store it.
+     */
+    bool sync();
+
+    /**
+     * @brief Writes @p size bytes, recording the file error on failure.
+     */
+    bool write(const char* data, qint64 size);
+
+    QFile m_file;
+    QString m_error;
+    int m_framesPerChunk;
+    TakeEncoding m_encoding;
+
+    TakeLayout m_layout;                    // Layout of the open chunk
+    TakeChunkHeader m_chunk{};              // Header of the open chunk, filled as frames arrive
+    QByteArray m_records;                   // Records of the open chunk
+    std::vector<TakeIndexEntry> m_index;    // One entry per written chunk
+    QByteArray m_metadata;                  // Compact JSON of the header, for the trailer
+    quint64 m_framesWritten = 0;
+};
@@ -351,12 +351,15 @@ void GLWidget::paintGL()
     m_prog.release();
 }
 
-void GLWidget::onFramesUpdated(FrameData frame)
+void GLWidget::onFramesUpdated(FramePtr frame)
 {
     if (!m_controller)
         return;
-        
-    m_latestFrame = frame;
+
+    {
+        QMutexLocker lock(&m_frameMutex);
+        m_latestFrame = std::move(frame);
+    }
 
     update();
 }
@@ -458,11 +461,28 @@ void GLWidget::prepareSkeletonData(QVector<QVector3D> &boneData, QVector<QVector
     
     // Lock frame data for thread safety
     QMutexLocker lock(&m_frameMutex);
-    const auto &skeletons = m_latestFrame.skeletons;
+    if (!m_latestFrame)
+        return;
+    const auto &skeletons = m_latestFrame->skeletons;
+    const auto skeletonNames = m_controller->getSkeletonIdToName();
+    const std::string selectedSkeleton = m_selectedAssets.skeleton.toStdString();
     
     for (int s = 0; s < skeletons.size(); ++s)
     {
         const auto &skel = skeletons[s];
+
+        // Skeletons absent from the frame or skipped by the decoder carry no bones
+        if (s >= m_skeletonBones.size() || skel.bones.empty())
+            continue;
+
+        // Only the selected skeleton, if the view is set to draw just that one
+        if (m_selectedAssets.drawSelectedOnly)
+        {
+            auto it = skeletonNames.find(skel.id);
+            if (it == skeletonNames.end() || it->second != selectedSkeleton)
+                continue;
+        }
+
         m_prog.setUniformValue("skeleton_id", float(s));
         
         // Iterate through all bones in the skeleton
@@ -555,7 +575,9 @@ void GLWidget::prepareRigidBodies(std::vector<std::unique_ptr<Mesh>>& meshes)
     std::vector<QVector3D>  rbPoints;
     std::vector<uint32_t>   rbIndices;
     
-    const auto& rbFrameList = m_latestFrame.rigidBodies; 
+    QMutexLocker lock(&m_frameMutex);
+    if (!m_latestFrame)
+        return;
     
     // For each precomputed RigidBodyOffsets, find matching frame data
     for (const auto& ro : m_rbOffsets)
@@ -565,14 +587,8 @@ void GLWidget::prepareRigidBodies(std::vector<std::unique_ptr<Mesh>>& meshes)
 
         rbPoints.clear();
         rbIndices.clear();
-        // find the matching live data by ID
-        const RigidBodyData* dataPtr = nullptr;
-        for (const auto& rd : rbFrameList) {
-            if (rd.id == ro.bodyID) {
-                dataPtr = &rd;
-                break;
-            }
-        }
+        // find the matching live data by ID; skips bodies not tracked in this frame
+        const RigidBodyData* dataPtr = m_latestFrame->findRigidBody(ro.bodyID);
         if (!dataPtr) continue;
         
         // compute body’s world transform
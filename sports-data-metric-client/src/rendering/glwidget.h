@@ -56,6 +56,10 @@ public:
      */
     void setAssets(GLWidgetAssets assets);
 
+    /**
+     * @brief Highlights the selected assets and, if asked to, draws only the selected skeleton.
+     * @param assets The asset selection from the configure panel.
+     */
     void selectAsset(AssetSettings assets);
 
 public slots:
@@ -63,7 +67,7 @@ public slots:
      * @brief Slot called when new frame data is available from the ConnectionController.
      *        Grabs the latest FrameData and triggers a repaint.
      */
-    void onFramesUpdated(FrameData frame);
+    void onFramesUpdated(FramePtr frame);
 
 protected:
     /**
@@ -207,7 +211,7 @@ private:
     float     m_pitch       = 0.0f;
     
     QMutex    m_frameMutex;         // Mutex lock for frame data
-    FrameData m_latestFrame;        // Most recent FrameData received from connection
+    FramePtr  m_latestFrame;        // Most recent FrameData received from connection
 };
 
 #endif // GLWIDGET_H
\ No newline at end of file
@@ -111,7 +111,7 @@ QStringList fetchSavedTakeFileNames()
     }
 
     QStringList filters;
-    filters << "*.json";
+    filters << "*.json" << "*.take";
     dir.setNameFilters(filters);
 
     fileNames = dir.entryList(QDir::Files | QDir::NoDotAndDotDot);
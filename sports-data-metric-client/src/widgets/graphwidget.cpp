@@ -35,6 +35,26 @@ void GraphWidget::addData(qreal x, qreal y) {
     update();
 }
 
+void GraphWidget::setData(const QVector<qreal> &x, const QVector<qreal> &y) {
+
+    // Replaces the series in one go, repainting once rather than per point
+    xData.clear();
+    yData.clear();
+    xData.reserve(x.size());
+    yData.reserve(y.size());
+
+    for (qsizetype i = 0; i < x.size() && i < y.size(); ++i) {
+        if (y[i] < -1e6 || y[i] > 1e6 || std::isnan(y[i])) {
+            continue;
+        }
+        xData.append(x[i]);
+        yData.append(y[i]);
+    }
+
+    xScrollOffset = xData.isEmpty() ? 0.0 : qMax(0.0, xData.last() - xWindowSize);
+    update();
+}
+
 QList<QVector<qreal>> GraphWidget::getData() {
 
     QList<QVector<qreal>> data;
@@ -12,6 +12,7 @@ class GraphWidget: public QOpenGLWidget, protected QOpenGLFunctions {
 public:
     GraphWidget(QWidget *parent = nullptr);
     void addData(qreal x, qreal y);
+    void setData(const QVector<qreal> &x, const QVector<qreal> &y);
     QList<QVector<qreal>>getData();
 
 protected:
@@ -0,0 +1,77 @@
+// DecodeFilter: the selection is the union of the subscriptions, any "all"
+// subscription selects every skeleton, and each change bumps the version the
+// ingest worker polls.
+
+#include "decode_filter.h"
+#include "test_check.h"
+
+namespace {
+
+using Subscriber = DecodeFilter::Subscriber;
+using Subscription = DecodeFilter::Subscription;
+
+void testDefaultsToAllSkeletons()
+{
+    DecodeFilter filter;
+    DecodeFilter::Selection selection;
+    CHECK(filter.version() == 0);
+    CHECK(filter.read(selection) == 0);
+    CHECK(selection.wantsAllSkeletons());
+    CHECK(selection.wantsSkeleton(42));
+}
+
+void testUnionOfSubscriptions()
+{
+    DecodeFilter filter;
+    filter.subscribe(Subscriber::Metrics, Subscription::only({7, 3, 3}));
+
+    // The renderer still wants everything
+    DecodeFilter::Selection selection;
+    filter.read(selection);
+    CHECK(selection.wantsAllSkeletons());
+
+    filter.subscribe(Subscriber::Renderer, Subscription::only({5, 7}));
+    filter.read(selection);
+    CHECK(!selection.wantsAllSkeletons());
+    CHECK(selection.wantsSkeleton(3));
+    CHECK(selection.wantsSkeleton(5));
+    CHECK(selection.wantsSkeleton(7));
+    CHECK(!selection.wantsSkeleton(4));
+
+    // Replacing one subscription drops its IDs
+    filter.subscribe(Subscriber::Metrics, Subscription::only({}));
+    filter.read(selection);
+    CHECK(!selection.wantsSkeleton(3));
+    CHECK(selection.wantsSkeleton(5));
+
+    filter.subscribe(Subscriber::Renderer, Subscription::only({}));
+    filter.read(selection);
+    CHECK(!selection.wantsAllSkeletons());
+    CHECK(!selection.wantsSkeleton(5));
+
+    filter.subscribe(Subscriber::Renderer, Subscription::all());
+    filter.read(selection);
+    CHECK(selection.wantsSkeleton(3));
+}
+
+void testVersion()
+{
+    DecodeFilter filter;
+    filter.subscribe(Subscriber::Metrics, Subscription::only({1}));
+    filter.subscribe(Subscriber::Renderer, Subscription::only({2}));
+    CHECK(filter.version() == 2);
+
+    DecodeFilter::Selection selection;
+    CHECK(filter.read(selection) == 2);
+    CHECK(selection.wantsSkeleton(1) && selection.wantsSkeleton(2));
+}
+
+} // namespace
+
+int main()
+{
+    testDefaultsToAllSkeletons();
+    testUnionOfSubscriptions();
+    testVersion();
+    return test_check::result();
+}
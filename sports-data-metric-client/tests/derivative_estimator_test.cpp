@@ -0,0 +1,183 @@
+// DerivativeEstimator and PoseHistory: derivatives of known motion with even
+// and uneven frame spacing, the window rules, smoothing of tracking noise, and
+// the history restarting on tracking gaps, rewinds and new sessions.
+
+#include "derivative_estimator.h"
+#include "pose_history.h"
+#include "test_check.h"
+
+#include <random>
+
+namespace {
+
+// Motion with constant acceleration: x(t) = p + v t + a t^2 / 2, per axis. Samples are
+// taken near t = 0, where float positions round finely enough for 240 Hz differences.
+const QVector3D kPosition(0.5f, 1.2f, -0.3f);
+const QVector3D kVelocity(2.0f, -0.5f, 1.0f);
+const QVector3D kAcceleration(-3.0f, 9.81f, 0.5f);
+
+QVector3D positionAt(double t)
+{
+    const float s = static_cast<float>(t);
+    return kPosition + kVelocity * s + kAcceleration * (0.5f * s * s);
+}
+
+QVector3D velocityAt(double t)
+{
+    return kVelocity + kAcceleration * static_cast<float>(t);
+}
+
+void checkNear(const QVector3D& actual, const QVector3D& expected, float tolerance)
+{
+    CHECK_NEAR(actual.x(), expected.x(), tolerance);
+    CHECK_NEAR(actual.y(), expected.y(), tolerance);
+    CHECK_NEAR(actual.z(), expected.z(), tolerance);
+}
+
+/**
+ * @brief A ring of the motion sampled at @p times, oldest first.
+ */
+PoseRing sampleMotion(const std::vector<double>& times)
+{
+    PoseRing ring;
+    ring.reset(static_cast<int>(times.size()));
+    for (double t : times) {
+        ring.push(PoseSample{positionAt(t), QQuaternion(), t});
+    }
+    return ring;
+}
+
+void testWindow()
+{
+    CHECK(DerivativeEstimator().window() == DerivativeEstimator::kMinWindow);
+    CHECK(DerivativeEstimator(DerivativeMethod::SavitzkyGolay, 4).window() == 5);
+    CHECK(DerivativeEstimator(DerivativeMethod::SavitzkyGolay, 1).window() == DerivativeEstimator::kMinWindow);
+    CHECK(DerivativeEstimator(DerivativeMethod::SavitzkyGolay, 500).window() == DerivativeEstimator::kMaxWindow);
+
+    // Not valid until the ring holds a full window
+    const DerivativeEstimator estimator(DerivativeMethod::SavitzkyGolay, 7);
+    std::vector<double> times;
+    for (int i = 0; i < 6; ++i) {
+        times.push_back(i / 240.0);
+    }
+    CHECK(!estimator.estimate(sampleMotion(times)).valid);
+    times.push_back(6 / 240.0);
+    CHECK(estimator.estimate(sampleMotion(times)).valid);
+
+    // Nor over samples that do not move forward in time
+    CHECK(!DerivativeEstimator().estimate(sampleMotion({ 1.0, 1.0, 1.0 })).valid);
+}
+
+void testEvenSpacing()
+{
+    // Both methods are exact for constant acceleration, at the centre of the window
+    for (DerivativeMethod method : { DerivativeMethod::CentralDifference, DerivativeMethod::SavitzkyGolay }) {
+        for (int window : { 3, 9, 31 }) {
+            const DerivativeEstimator estimator(method, window);
+            std::vector<double> times;
+            for (int i = 0; i < estimator.window(); ++i) {
+                times.push_back(0.1 + i / 240.0);
+            }
+            const double centre = times[static_cast<size_t>(estimator.window() / 2)];
+
+            const Derivatives derivatives = estimator.estimate(sampleMotion(times));
+            CHECK(derivatives.valid);
+            checkNear(derivatives.velocity, velocityAt(centre), 2e-3f);
+            checkNear(derivatives.acceleration, kAcceleration, 0.05f);
+        }
+    }
+}
+
+void testUnevenSpacing()
+{
+    // A late frame before the centre and an early one after it
+    const std::vector<double> times = { 0.2, 0.2 + 1.5 / 240.0, 0.2 + 2.0 / 240.0 };
+    const Derivatives derivatives = DerivativeEstimator().estimate(sampleMotion(times));
+    CHECK(derivatives.valid);
+    checkNear(derivatives.velocity, velocityAt(times[1]), 2e-3f);
+    checkNear(derivatives.acceleration, kAcceleration, 0.05f);
+}
+
+void testNoise()
+{
+    // Millimetre tracking noise on a body at rest: the longer fit passes less of it through
+    std::mt19937 rng(7);
+    std::normal_distribution<float> noise(0.0f, 0.001f);
+
+    const DerivativeEstimator central(DerivativeMethod::CentralDifference, 3);
+    const DerivativeEstimator fitted(DerivativeMethod::SavitzkyGolay, 15);
+    PoseRing ring;
+    ring.reset(fitted.window());
+
+    double centralSquares = 0.0;
+    double fittedSquares = 0.0;
+    for (int i = 0; i < 2000; ++i) {
+        ring.push(PoseSample{ QVector3D(noise(rng), noise(rng), noise(rng)), QQuaternion(), i / 240.0 });
+        if (ring.size() < fitted.window()) {
+            continue;
+        }
+        centralSquares += central.estimate(ring).velocity.lengthSquared();
+        fittedSquares += fitted.estimate(ring).velocity.lengthSquared();
+    }
+    CHECK(fittedSquares * 10.0 < centralSquares);
+}
+
+void testHistory()
+{
+    auto slotMap = std::make_shared<AssetSlotMap>();
+    slotMap->addRigidBody(10);
+    slotMap->addRigidBody(20);
+
+    PoseHistory history;
+    history.setDepth(4);
+    CHECK(history.find(10) == nullptr);
+
+    auto frameAt = [&](double t, bool secondTracked) {
+        FrameData frame;
+        frame.timestamp = t;
+        frame.slotMap = slotMap;
+        RigidBodyData first;
+        first.id = 10;
+        first.position = positionAt(t);
+        RigidBodyData second;
+        second.id = 20;
+        second.tracked = secondTracked;
+        frame.rigidBodies = { first, second };
+        return frame;
+    };
+
+    for (int i = 0; i < 6; ++i) {
+        history.push(frameAt(i / 240.0, i != 4));
+    }
+    CHECK(history.find(30) == nullptr);
+    CHECK(history.find(10) != nullptr && history.find(10)->size() == 4);
+    CHECK(history.find(10)->at(0).timestamp == 5 / 240.0);
+
+    // The second body lost tracking in frame 4, so only frame 5 is in its ring
+    CHECK(history.find(20) != nullptr && history.find(20)->size() == 1);
+
+    // A rewind restarts every ring
+    history.push(frameAt(1 / 240.0, true));
+    CHECK(history.find(10)->size() == 1);
+    CHECK(history.find(20)->size() == 1);
+
+    // As does a new session
+    auto nextSession = std::make_shared<AssetSlotMap>();
+    nextSession->addRigidBody(10);
+    slotMap = nextSession;
+    history.push(frameAt(2 / 240.0, true));
+    CHECK(history.find(10)->size() == 1);
+    CHECK(history.find(20) == nullptr);
+}
+
+} // namespace
+
+int main()
+{
+    testWindow();
+    testEvenSpacing();
+    testUnevenSpacing();
+    testNoise();
+    testHistory();
+    return test_check::result();
+}
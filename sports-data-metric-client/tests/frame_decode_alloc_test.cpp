@@ -0,0 +1,326 @@
+// Heap use of the live decode path: staging a frame on the receive thread must
+// never allocate, and once every pooled frame has been through the ingest
+// worker, decoding must not either, including when skeletons drop out of the
+// stream or the marker counts change. Also checks the decode filter: skipped
+// skeletons carry no bones in the history, while the frames handed to an
+// enabled tap stay complete.
+
+#include "frame_source.h"
+#include "test_check.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <thread>
+
+namespace {
+
+std::atomic<bool> counting{false};
+std::atomic<uint64_t> stagingAllocations{0};    // Made by the thread staging frames
+std::atomic<uint64_t> ingestAllocations{0};     // Made by any other thread, the ingest worker
+thread_local bool isStagingThread = false;
+
+void* allocate(size_t size, size_t alignment)
+{
+    if (counting.load(std::memory_order_relaxed)) {
+        (isStagingThread ? stagingAllocations : ingestAllocations).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Over-allocate and keep the malloc'd pointer just before the aligned block
+    void* raw = std::malloc(size + alignment + sizeof(void*));
+    if (!raw) {
+        throw std::bad_alloc();
+    }
+    const uintptr_t start = reinterpret_cast<uintptr_t>(raw) + sizeof(void*);
+    void* aligned = reinterpret_cast<void*>((start + alignment - 1) & ~(uintptr_t(alignment) - 1));
+    static_cast<void**>(aligned)[-1] = raw;
+    return aligned;
+}
+
+void release(void* p) noexcept
+{
+    if (p) {
+        std::free(static_cast<void**>(p)[-1]);
+    }
+}
+
+} // namespace
+
+void* operator new(size_t size) { return allocate(size, alignof(std::max_align_t)); }
+void* operator new[](size_t size) { return allocate(size, alignof(std::max_align_t)); }
+void* operator new(size_t size, std::align_val_t alignment) { return allocate(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return allocate(size, static_cast<size_t>(alignment)); }
+void operator delete(void* p) noexcept { release(p); }
+void operator delete[](void* p) noexcept { release(p); }
+void operator delete(void* p, size_t) noexcept { release(p); }
+void operator delete[](void* p, size_t) noexcept { release(p); }
+void operator delete(void* p, std::align_val_t) noexcept { release(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { release(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { release(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { release(p); }
+
+namespace {
+
+constexpr int kRigidBodies = 4;
+constexpr int kMarkersPerRigidBody = 4;
+constexpr int kSkeletons = 2;
+constexpr int kBones = 21;
+constexpr int kMarkerSetMarkers = 2 * 41 + kRigidBodies * kMarkersPerRigidBody;
+
+/**
+ * @brief Source fed directly by the test through stageFrameData().
+ */
+class TestSource : public FrameSource {
+public:
+    using FrameSource::FrameSource;
+
+    bool connect() override
+    {
+        processDataDescriptions(descriptions);
+        startIngest();
+        connected = true;
+        return true;
+    }
+
+    bool disconnect() override
+    {
+        stopIngest();
+        connected = false;
+        return true;
+    }
+
+    sDataDescriptions* getDataDescriptions() override { return descriptions; }
+
+    sDataDescriptions* descriptions = nullptr;
+};
+
+/**
+ * @brief Descriptions of kRigidBodies rigid bodies, kSkeletons skeletons and the "all" marker set.
+ */
+struct Scene {
+    std::unique_ptr<sDataDescriptions> descriptions = std::make_unique<sDataDescriptions>();
+    std::unique_ptr<sRigidBodyDescription[]> rigidBodies = std::make_unique<sRigidBodyDescription[]>(kRigidBodies);
+    std::unique_ptr<sSkeletonDescription[]> skeletons = std::make_unique<sSkeletonDescription[]>(kSkeletons);
+    sMarkerSetDescription allMarkers{};
+
+    Scene()
+    {
+        int count = 0;
+        std::snprintf(allMarkers.szName, MAX_NAMELENGTH, "all");
+        allMarkers.nMarkers = kMarkerSetMarkers;
+        descriptions->arrDataDescriptions[count].type = Descriptor_MarkerSet;
+        descriptions->arrDataDescriptions[count++].Data.MarkerSetDescription = &allMarkers;
+
+        for (int i = 0; i < kRigidBodies; ++i) {
+            sRigidBodyDescription& rb = rigidBodies[i];
+            std::snprintf(rb.szName, MAX_NAMELENGTH, "Body%d", i);
+            rb.ID = 100 + i;
+            rb.nMarkers = kMarkersPerRigidBody;
+            descriptions->arrDataDescriptions[count].type = Descriptor_RigidBody;
+            descriptions->arrDataDescriptions[count++].Data.RigidBodyDescription = &rb;
+        }
+
+        for (int i = 0; i < kSkeletons; ++i) {
+            sSkeletonDescription& skel = skeletons[i];
+            std::snprintf(skel.szName, MAX_NAMELENGTH, "Skeleton%d", i);
+            skel.skeletonID = 1 + i;
+            skel.nRigidBodies = kBones;
+            for (int j = 0; j < kBones; ++j) {
+                std::snprintf(skel.RigidBodies[j].szName, MAX_NAMELENGTH, "Bone%d", j);
+                skel.RigidBodies[j].ID = 1 + j;
+            }
+            descriptions->arrDataDescriptions[count].type = Descriptor_Skeleton;
+            descriptions->arrDataDescriptions[count++].Data.SkeletonDescription = &skel;
+        }
+
+        descriptions->nDataDescriptions = count;
+    }
+};
+
+/**
+ * @brief A frame of the scene whose optional content varies with @p frameNumber.
+ *
+ * The second skeleton is missing from every fifth frame, and the marker counts
+ * cycle between zero and what the descriptions announce. Every fourth marker
+ * of the marker list is flagged unlabeled, as NatNet 3+ streams them; odd
+ * frames also fill the legacy unlabeled list.
+ */
+class FrameGenerator {
+public:
+    FrameGenerator()
+    {
+        for (int i = 0; i < kSkeletons; ++i) {
+            for (int j = 0; j < kBones; ++j) {
+                m_bones[i][j].ID = ((1 + i) << 16) | (1 + j);
+            }
+        }
+    }
+
+    sFrameOfMocapData* frame(int frameNumber)
+    {
+        sFrameOfMocapData& data = *m_data;
+        data.iFrame = frameNumber;
+        data.fTimestamp = frameNumber / 120.0;
+
+        data.nRigidBodies = kRigidBodies;
+        for (int i = 0; i < kRigidBodies; ++i) {
+            data.RigidBodies[i].ID = 100 + i;
+            data.RigidBodies[i].x = 0.001f * frameNumber;
+        }
+
+        data.nSkeletons = frameNumber % 5 == 0 ? 1 : kSkeletons;
+        for (int i = 0; i < kSkeletons; ++i) {
+            data.Skeletons[i].skeletonID = 1 + i;
+            data.Skeletons[i].nRigidBodies = kBones;
+            data.Skeletons[i].RigidBodyData = m_bones[i];
+        }
+
+        data.nLabeledMarkers = frameNumber % (kMarkerSetMarkers + 1);
+        for (int i = 0; i < data.nLabeledMarkers; ++i) {
+            data.LabeledMarkers[i].ID = i;
+            data.LabeledMarkers[i].x = 0.001f * i;
+            data.LabeledMarkers[i].params = i % 4 == 3 ? kMarkerParamUnlabeled : 0;
+        }
+
+        data.nOtherMarkers = frameNumber % 2 == 1 ? (frameNumber * 7) % (kMarkerSetMarkers + 1) : 0;
+        data.OtherMarkers = m_otherMarkers;
+        return &data;
+    }
+
+private:
+    std::unique_ptr<sFrameOfMocapData> m_data = std::make_unique<sFrameOfMocapData>();
+    sRigidBodyData m_bones[kSkeletons][kBones];
+    MarkerData m_otherMarkers[kMarkerSetMarkers] = {};
+};
+
+/**
+ * @brief Stages @p count frames one at a time, waiting for each to be decoded.
+ */
+void streamFrames(TestSource& source, FrameGenerator& generator, int firstFrame, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        const uint64_t decoded = source.getIngestStats().decoded;
+        source.stageFrameData(generator.frame(firstFrame + i));
+        while (source.getIngestStats().decoded == decoded) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void testLiveDecodeDoesNotAllocate()
+{
+    constexpr size_t kHistoryDepth = 32;
+
+    Scene scene;
+    FrameGenerator generator;
+    FrameRingBuffer<FrameData> frames(kHistoryDepth);
+    TestSource source(frames);
+    source.descriptions = scene.descriptions.get();
+    source.connect();
+
+    // Staging is reserved from the descriptions; decoding warms up over one
+    // pass of the pool (history plus in-flight frames)
+    constexpr int kWarmUpFrames = 200;
+    isStagingThread = true;
+    counting = true;
+    streamFrames(source, generator, 1, kWarmUpFrames);
+    CHECK(stagingAllocations.load() == 0);
+
+    ingestAllocations = 0;
+    streamFrames(source, generator, 1 + kWarmUpFrames, 2000);
+    counting = false;
+    isStagingThread = false;
+    CHECK(stagingAllocations.load() == 0);
+    CHECK(ingestAllocations.load() == 0);
+
+    const FramePoolStats pool = source.getFramePoolStats();
+    CHECK(pool.exhausted == 0);
+    CHECK(pool.grown == 0);
+
+    // The frames carry what was streamed
+    const std::shared_ptr<const FrameData> latest = frames.latest();
+    CHECK(latest != nullptr);
+    if (latest) {
+        CHECK(latest->frameNumber == kWarmUpFrames + 2000);
+        CHECK(latest->rigidBodies.size() == static_cast<size_t>(kRigidBodies));
+        CHECK(latest->skeletons.size() == static_cast<size_t>(kSkeletons));
+        CHECK(latest->skeletons[0].bones.size() == static_cast<size_t>(kBones));
+
+        // 22 streamed markers, 5 of them flagged unlabeled
+        CHECK(latest->labeledMarkers.size() == 17);
+        CHECK(latest->unlabeledMarkers.size() == 5);
+        CHECK(latest->unlabeledMarkers.ids()[0] == 3);
+    }
+
+    source.disconnect();
+}
+
+void testFilteredDecode()
+{
+    Scene scene;
+    FrameGenerator generator;
+    FrameRingBuffer<FrameData> frames(32);
+    auto tap = std::make_shared<FrameTap>(64);
+    TestSource source(frames);
+    source.descriptions = scene.descriptions.get();
+    source.setFrameTap(tap);
+    source.connect();
+
+    // Only the first skeleton is subscribed
+    source.subscribeDecode(DecodeFilter::Subscriber::Metrics, DecodeFilter::Subscription::only({1}));
+    source.subscribeDecode(DecodeFilter::Subscriber::Renderer, DecodeFilter::Subscription::only({}));
+    streamFrames(source, generator, 1, 200);
+
+    std::shared_ptr<const FrameData> latest = frames.latest();
+    CHECK(latest != nullptr);
+    if (latest) {
+        CHECK(latest->skeletons.size() == static_cast<size_t>(kSkeletons));
+        CHECK(latest->skeletons[0].bones.size() == static_cast<size_t>(kBones));
+        CHECK(latest->skeletons[1].id == 2);
+        CHECK(latest->skeletons[1].bones.empty());
+    }
+
+    // The second skeleton is streamed in four frames out of five
+    DecodeStats stats = source.getDecodeStats();
+    CHECK(stats.frames == 200);
+    CHECK(stats.filteredFrames == 160);
+    CHECK(stats.skeletonsSkipped == 160);
+    CHECK(stats.bonesSkipped == 160 * kBones);
+    CHECK(stats.skeletonsDecoded == 200);
+    CHECK(stats.meanFilteredDecodeUs > 0.0);
+    CHECK(stats.meanFullDecodeUs > 0.0);
+
+    // Filtered frames never reach the tap; frames decoded while it is enabled are complete
+    std::vector<FramePtr> drained;
+    CHECK(tap->drain(drained) == 0);
+    tap->setEnabled(true);
+    streamFrames(source, generator, 201, 20);
+    CHECK(tap->drain(drained) == 20);
+    for (const FramePtr& frame : drained) {
+        const bool streamed = frame->frameNumber % 5 != 0;
+        CHECK(frame->skeletons[1].bones.size() == (streamed ? static_cast<size_t>(kBones) : 0));
+    }
+    stats = source.getDecodeStats();
+    CHECK(stats.skeletonsSkipped == 160);
+
+    // Subscribing every skeleton again turns the filter off
+    tap->setEnabled(false);
+    source.subscribeDecode(DecodeFilter::Subscriber::Renderer, DecodeFilter::Subscription::all());
+    streamFrames(source, generator, 221, 4);
+    latest = frames.latest();
+    CHECK(latest && latest->skeletons[1].bones.size() == static_cast<size_t>(kBones));
+    CHECK(source.getDecodeStats().skeletonsSkipped == 160);
+
+    source.disconnect();
+}
+
+} // namespace
+
+int main()
+{
+    testLiveDecodeDoesNotAllocate();
+    testFilteredDecode();
+    return test_check::result();
+}
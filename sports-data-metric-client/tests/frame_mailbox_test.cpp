@@ -0,0 +1,138 @@
+// FrameMailbox: one wakeup per drain, coalescing to the latest frame, every
+// frame with evictions counted, resets of the history with and without the
+// mailbox, and a consumer racing the producer never getting a frame twice.
+
+#include "frame_mailbox.h"
+#include "test_check.h"
+
+#include <atomic>
+#include <thread>
+
+namespace {
+
+void pushFrame(FrameRingBuffer<FrameData>& history, int frameNumber)
+{
+    FrameData frame;
+    frame.frameNumber = frameNumber;
+    history.push(frame);
+}
+
+void testCoalescing()
+{
+    FrameRingBuffer<FrameData> history(16);
+    FrameMailbox mailbox(history);
+
+    // Only the first post asks for a wakeup until the consumer takes
+    for (int i = 0; i < 5; ++i) {
+        pushFrame(history, i);
+        CHECK(mailbox.post() == (i == 0));
+    }
+
+    const std::vector<FrameMailbox::Pointer> frames = mailbox.take(FrameMailbox::Delivery::LatestOnly);
+    CHECK(frames.size() == 1 && frames[0]->frameNumber == 4);
+    CHECK(mailbox.take(FrameMailbox::Delivery::LatestOnly).empty());
+
+    pushFrame(history, 5);
+    CHECK(mailbox.post());
+
+    const FrameMailbox::Stats stats = mailbox.getStats();
+    CHECK(stats.posted == 6);
+    CHECK(stats.delivered == 1);
+    CHECK(stats.coalesced == 4);
+    CHECK(stats.wakeups == 2);
+}
+
+void testEveryFrame()
+{
+    FrameRingBuffer<FrameData> history(4);
+    FrameMailbox mailbox(history);
+    for (int i = 0; i < 6; ++i) {
+        pushFrame(history, i);
+        mailbox.post();
+    }
+
+    // The first two were evicted before the consumer woke
+    const std::vector<FrameMailbox::Pointer> frames = mailbox.take(FrameMailbox::Delivery::EveryFrame);
+    CHECK(frames.size() == 4);
+    for (size_t i = 0; i < frames.size(); ++i) {
+        CHECK(frames[i]->frameNumber == static_cast<int>(i + 2));
+    }
+    CHECK(mailbox.getStats().skipped == 2);
+
+    pushFrame(history, 6);
+    const std::vector<FrameMailbox::Pointer> next = mailbox.take(FrameMailbox::Delivery::EveryFrame);
+    CHECK(next.size() == 1 && next[0]->frameNumber == 6);
+}
+
+void testReset()
+{
+    FrameRingBuffer<FrameData> history(16);
+    FrameMailbox mailbox(history);
+    for (int i = 0; i < 10; ++i) {
+        pushFrame(history, i);
+    }
+    CHECK(mailbox.take(FrameMailbox::Delivery::LatestOnly).size() == 1);
+
+    // Reset together: the counters restart and the new session's frames are delivered
+    history.reset(16);
+    mailbox.reset();
+    for (int i = 0; i < 3; ++i) {
+        pushFrame(history, 100 + i);
+    }
+    std::vector<FrameMailbox::Pointer> frames = mailbox.take(FrameMailbox::Delivery::LatestOnly);
+    CHECK(frames.size() == 1 && frames[0]->frameNumber == 102);
+    CHECK(mailbox.getStats().coalesced == 2);
+
+    // The history reset underneath the mailbox: it resynchronizes on the next take
+    history.reset(16);
+    pushFrame(history, 200);
+    CHECK(mailbox.take(FrameMailbox::Delivery::LatestOnly).empty());
+    pushFrame(history, 201);
+    frames = mailbox.take(FrameMailbox::Delivery::LatestOnly);
+    CHECK(frames.size() == 1 && frames[0]->frameNumber == 201);
+}
+
+void testConcurrentLatest()
+{
+    // Every frame is either delivered once or counted as coalesced, in order
+    constexpr int kFrames = 200000;
+    FrameRingBuffer<FrameData> history(8);
+    FrameMailbox mailbox(history);
+    std::atomic<bool> done{false};
+
+    std::thread producer([&] {
+        for (int i = 0; i < kFrames; ++i) {
+            pushFrame(history, i);
+            mailbox.post();
+        }
+        done.store(true);
+    });
+
+    int last = -1;
+    int outOfOrder = 0;
+    bool finished = false;
+    while (!finished) {
+        finished = done.load();
+        for (const FrameMailbox::Pointer& frame : mailbox.take(FrameMailbox::Delivery::LatestOnly)) {
+            outOfOrder += frame->frameNumber <= last ? 1 : 0;
+            last = frame->frameNumber;
+        }
+    }
+    producer.join();
+
+    const FrameMailbox::Stats stats = mailbox.getStats();
+    CHECK(outOfOrder == 0);
+    CHECK(last == kFrames - 1);
+    CHECK(stats.delivered + stats.coalesced == static_cast<uint64_t>(kFrames));
+}
+
+} // namespace
+
+int main()
+{
+    testCoalescing();
+    testEveryFrame();
+    testReset();
+    testConcurrentLatest();
+    return test_check::result();
+}
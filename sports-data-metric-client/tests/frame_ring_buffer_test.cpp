@@ -0,0 +1,183 @@
+// FrameRingBuffer: eviction, frames freed once evicted and unreferenced,
+// resumable snapshots, and snapshots taken by several readers while the
+// producer runs and resets the buffer.
+
+#include "frame_ring_buffer.h"
+#include "test_check.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void testEviction()
+{
+    FrameRingBuffer<int> buffer(4);
+    CHECK(buffer.latest() == nullptr);
+    CHECK(buffer.snapshot().empty());
+
+    for (int i = 0; i < 10; ++i) {
+        buffer.push(i);
+    }
+    CHECK(buffer.size() == 4);
+    CHECK(buffer.capacity() == 4);
+    CHECK(buffer.totalPushed() == 10);
+    CHECK(*buffer.latest() == 9);
+
+    const FrameRingBuffer<int>::Snapshot all = buffer.snapshot();
+    CHECK(all.size() == 4);
+    CHECK(all.firstSequence() == 6);
+    for (size_t i = 0; i < all.size(); ++i) {
+        CHECK(all[i] == static_cast<int>(6 + i));
+    }
+
+    const FrameRingBuffer<int>::Snapshot recent = buffer.snapshot(2);
+    CHECK(recent.size() == 2);
+    CHECK(recent.front() == 8);
+}
+
+void testRelease()
+{
+    FrameRingBuffer<int> buffer(2);
+    auto first = std::make_shared<const int>(0);
+    const std::weak_ptr<const int> watched = first;
+    buffer.push(std::move(first));
+
+    // Held by a snapshot after the buffer moves past it, and freed with the snapshot
+    FrameRingBuffer<int>::Snapshot held = buffer.snapshot();
+    for (int i = 1; i < 5; ++i) {
+        buffer.push(i);
+    }
+    CHECK(!watched.expired());
+    held = FrameRingBuffer<int>::Snapshot();
+    CHECK(watched.expired());
+
+    // And freed by a reset
+    auto second = std::make_shared<const int>(5);
+    const std::weak_ptr<const int> reset = second;
+    buffer.push(std::move(second));
+    buffer.reset(2);
+    CHECK(reset.expired());
+}
+
+void testSnapshotSince()
+{
+    FrameRingBuffer<int> buffer(4);
+    for (int i = 0; i < 6; ++i) {
+        buffer.push(i);
+    }
+
+    // Evicted frames are skipped, and firstSequence() shows how many
+    const FrameRingBuffer<int>::Snapshot lost = buffer.snapshotSince(0);
+    CHECK(lost.firstSequence() == 2);
+    CHECK(lost.size() == 4);
+
+    const FrameRingBuffer<int>::Snapshot tail = buffer.snapshotSince(5);
+    CHECK(tail.size() == 1);
+    CHECK(tail.front() == 5);
+    CHECK(buffer.snapshotSince(6).empty());
+}
+
+void testReset()
+{
+    FrameRingBuffer<int> buffer(2);
+    buffer.push(1);
+    const FrameRingBuffer<int>::Snapshot before = buffer.snapshot();
+
+    buffer.reset(3);
+    CHECK(buffer.size() == 0);
+    CHECK(buffer.capacity() == 3);
+    CHECK(buffer.snapshot().generation() == before.generation() + 1);
+    CHECK(before.front() == 1);
+}
+
+void testConcurrentSnapshots()
+{
+    // Every frame holds its own sequence number, so a torn or reordered
+    // snapshot shows up as a frame that is not where its sequence says
+    constexpr size_t kCapacity = 8;
+    constexpr uint64_t kFrames = 2000000;
+    FrameRingBuffer<uint64_t> buffer(kCapacity);
+    std::atomic<bool> done{false};
+
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < kFrames; ++i) {
+            buffer.push(i);
+        }
+        done.store(true);
+    });
+
+    uint64_t snapshots = 0;
+    while (!done.load()) {
+        const FrameRingBuffer<uint64_t>::Snapshot snapshot = buffer.snapshot();
+        CHECK(snapshot.size() <= kCapacity);
+        for (size_t i = 0; i < snapshot.size(); ++i) {
+            if (snapshot[i] != snapshot.firstSequence() + i) {
+                CHECK(snapshot[i] == snapshot.firstSequence() + i);
+                break;
+            }
+        }
+        ++snapshots;
+    }
+    producer.join();
+    CHECK(snapshots > 0);
+}
+
+void testConcurrentResets()
+{
+    // Several readers pin slots and storage while the producer keeps replacing both
+    constexpr size_t kCapacity = 16;
+    constexpr uint64_t kFrames = 500000;
+    FrameRingBuffer<uint64_t> buffer(kCapacity);
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+
+    std::thread producer([&] {
+        for (uint64_t i = 0, sequence = 0; i < kFrames; ++i, ++sequence) {
+            if (i % 10007 == 0) {
+                buffer.reset(kCapacity + i % 3);
+                sequence = 0;
+            }
+            buffer.push(sequence);
+        }
+        done.store(true);
+    });
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&] {
+            while (!done.load()) {
+                const FrameRingBuffer<uint64_t>::Snapshot snapshot = buffer.snapshot();
+                for (size_t i = 0; i < snapshot.size(); ++i) {
+                    if (snapshot[i] != snapshot.firstSequence() + i) {
+                        torn.fetch_add(1);
+                    }
+                }
+                const FrameRingBuffer<uint64_t>::Pointer latest = buffer.latest();
+                if (latest && *latest >= buffer.totalPushed() + kFrames) {
+                    torn.fetch_add(1);
+                }
+            }
+        });
+    }
+    producer.join();
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    CHECK(torn.load() == 0);
+    CHECK(buffer.totalPushed() > 0);
+}
+
+} // namespace
+
+int main()
+{
+    testEviction();
+    testRelease();
+    testSnapshotSince();
+    testReset();
+    testConcurrentSnapshots();
+    testConcurrentResets();
+    return test_check::result();
+}
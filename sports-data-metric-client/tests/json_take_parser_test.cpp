@@ -0,0 +1,100 @@
+// JsonTakeParser: takes split into several ranges whatever the order of the
+// frame keys, frames holding objects that look like frames, and malformed
+// frames reported wherever their range starts.
+
+#include "json_take_parser.h"
+#include "test_check.h"
+
+#include <cstdio>
+#include <string>
+
+namespace {
+
+constexpr int kFrames = 30000;      // About 5 MB, several of the parser's ranges
+const char* const kPath = "json_take_parser_test.json";
+
+/**
+ * @brief A JSON take of kFrames frames, one rigid body each, with keys in the order other tools may write them.
+ *
+ * Every third frame also carries a nested object starting with a frame number
+ * and a string full of brackets, which frame boundaries must not be found in.
+ */
+std::string makeTake()
+{
+    std::string json = "{\n  \"rigidBodies\": { \"7\": \"Bat\" },\n  \"frames\": [\n";
+    char frame[320];
+    for (int i = 0; i < kFrames; ++i) {
+        const char* extra = i % 3 == 0 ? "\"source\": { \"frameNumber\": -1 }, \"note\": \"}, {\\\"frameNumber\\\": [\", " : "";
+        std::snprintf(frame, sizeof(frame),
+                      "    { \"timestamp\": %.6f, %s\"rigidBodies\": [ { \"position\": [ %d, 0, 0 ], \"id\": 7 } ], "
+                      "\"skeletons\": [], \"frameNumber\": %d }%s\n",
+                      i / 240.0, extra, i, i, i + 1 < kFrames ? "," : "");
+        json += frame;
+    }
+    json += "  ],\n  \"skeletons\": {},\n  \"bones\": {}\n}\n";
+    return json;
+}
+
+bool writeFile(const std::string& text)
+{
+    FILE* file = std::fopen(kPath, "wb");
+    if (!file) {
+        return false;
+    }
+    const bool written = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    return std::fclose(file) == 0 && written;
+}
+
+void testKeyOrder()
+{
+    CHECK(writeFile(makeTake()));
+
+    JsonTakeParser parser;
+    CHECK(parser.open(kPath));
+    CHECK(parser.header().rigidBodies.size() == 1);
+
+    int batches = 0;
+    int expected = 0;
+    bool ordered = true;
+    const bool ok = parser.parseFrames([&](QVector<FramePtr> frames) {
+        ++batches;
+        for (const FramePtr& frame : frames) {
+            ordered = ordered && frame->frameNumber == expected
+                      && frame->rigidBodies.size() == 1 && frame->rigidBodies[0].id == 7
+                      && frame->rigidBodies[0].position.x() == static_cast<float>(expected);
+            ++expected;
+        }
+    });
+    CHECK(ok);
+    CHECK(ordered);
+    CHECK(expected == kFrames);
+
+    // Split into ranges even though no frame starts with its frame number
+    CHECK(batches > 1);
+}
+
+void testMalformed()
+{
+    // A frame missing a colon, well into the take
+    std::string json = makeTake();
+    const size_t broken = json.find("\"frameNumber\": 20000 }");
+    CHECK(broken != std::string::npos);
+    json.erase(json.find(':', broken), 1);
+    CHECK(writeFile(json));
+
+    JsonTakeParser parser;
+    CHECK(parser.open(kPath));
+    int frames = 0;
+    CHECK(!parser.parseFrames([&](QVector<FramePtr> batch) { frames += static_cast<int>(batch.size()); }));
+    CHECK(frames <= 20000);
+}
+
+} // namespace
+
+int main()
+{
+    testKeyOrder();
+    testMalformed();
+    std::remove(kPath);
+    return test_check::result();
+}
@@ -0,0 +1,204 @@
+// Metric kernels: the SSE4.1 and AVX2 builds against the scalar kernels, on
+// random rotations and motions, at the edges of the inverse trigonometric
+// functions and around gimbal lock, and for batch sizes that leave tails to
+// the scalar kernels.
+
+#include "metric_kernels.h"
+#include "test_check.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace metric_kernels;
+
+constexpr float kMaxAngleError = 1e-4f;     // Degrees; the bound metric_kernels.h states
+
+/**
+ * @brief Float columns of one input set, with the views the kernels take.
+ */
+struct Columns {
+    explicit Columns(size_t n) : data(8, std::vector<float>(n)) {}
+
+    QuatColumns quat(int first) const
+    {
+        return { data[first].data(), data[first + 1].data(), data[first + 2].data(), data[first + 3].data() };
+    }
+
+    Vec3Columns vec3(int first) const { return { data[first].data(), data[first + 1].data(), data[first + 2].data() }; }
+
+    std::vector<std::vector<float>> data;
+};
+
+/**
+ * @brief Random rotations in columns 0-3 and 4-7, unnormalized as Motive can send them, and every edge case.
+ */
+Columns makeRotations(size_t n, std::mt19937& rng)
+{
+    std::normal_distribution<float> gaussian(0.0f, 1.0f);
+    Columns c(n);
+    for (size_t i = 0; i < n; ++i) {
+        for (int column = 0; column < 8; ++column) {
+            c.data[column][i] = gaussian(rng);
+        }
+    }
+
+    const float halfSqrt2 = std::sqrt(0.5f);
+    for (size_t i = 0; i + 8 <= n; i += 8) {
+        const float e = std::ldexp(1.0f, -static_cast<int>((i / 8) % 24));
+
+        // Pitch a hair from +-90 degrees, where the sine of the pitch rounds either side of 1
+        for (size_t j = i; j < i + 4; ++j) {
+            c.data[0][j] = halfSqrt2;
+            c.data[1][j] = (j % 2 ? -halfSqrt2 : halfSqrt2) * (1.0f + 0.1f * e * gaussian(rng));
+            c.data[2][j] = e * gaussian(rng);
+            c.data[3][j] = e * gaussian(rng);
+        }
+
+        // Relative rotations of a hair above 0 and below 360 degrees
+        for (size_t j = i; j < i + 8; ++j) {
+            const float sign = j % 2 ? -1.0f : 1.0f;
+            for (int column = 0; column < 4; ++column) {
+                c.data[4 + column][j] = sign * c.data[column][j] * (1.0f + e * gaussian(rng));
+            }
+        }
+    }
+
+    // Zero rotations, exact gimbal lock and identical rotations
+    if (n >= 3) {
+        for (int column = 0; column < 8; ++column) {
+            c.data[column][0] = 0.0f;
+        }
+        c.data[0][1] = halfSqrt2;
+        c.data[1][1] = halfSqrt2;
+        c.data[2][1] = 0.0f;
+        c.data[3][1] = 0.0f;
+        for (int column = 0; column < 4; ++column) {
+            c.data[4 + column][2] = c.data[column][2];
+        }
+    }
+    return c;
+}
+
+/**
+ * @brief Random velocities in columns 0-2 and accelerations in columns 3-5, some at rest.
+ */
+Columns makeMotions(size_t n, std::mt19937& rng)
+{
+    std::normal_distribution<float> gaussian(0.0f, 3.0f);
+    Columns c(n);
+    for (size_t i = 0; i < n; ++i) {
+        const bool atRest = i % 5 == 0;
+        for (int column = 0; column < 6; ++column) {
+            c.data[column][i] = (atRest && column < 3) ? 1e-7f * gaussian(rng) : gaussian(rng);
+        }
+    }
+    return c;
+}
+
+/**
+ * @brief Largest absolute difference between @p a and @p b.
+ */
+float maxDifference(const std::vector<float>& a, const std::vector<float>& b)
+{
+    float worst = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i) {
+        worst = std::fmax(worst, std::fabs(a[i] - b[i]));
+    }
+    return worst;
+}
+
+/**
+ * @brief Largest difference between @p a and @p b relative to the magnitude of @p a.
+ */
+float maxRelativeDifference(const std::vector<float>& a, const std::vector<float>& b)
+{
+    float worst = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i) {
+        worst = std::fmax(worst, std::fabs(a[i] - b[i]) / std::fmax(1.0f, std::fabs(a[i])));
+    }
+    return worst;
+}
+
+void testKernels(const Kernels& kernels, size_t n)
+{
+    std::mt19937 rng(static_cast<unsigned>(n));
+    const Columns rotations = makeRotations(n, rng);
+    const Columns motions = makeMotions(n, rng);
+    std::vector<float> expected(n);
+    std::vector<float> actual(n);
+
+    scalar().jointAngles(rotations.quat(0), rotations.quat(4), expected.data(), n);
+    kernels.jointAngles(rotations.quat(0), rotations.quat(4), actual.data(), n);
+    CHECK(maxDifference(expected, actual) <= kMaxAngleError);
+
+    scalar().tilts(rotations.quat(0), expected.data(), n);
+    kernels.tilts(rotations.quat(0), actual.data(), n);
+    CHECK(maxDifference(expected, actual) <= kMaxAngleError);
+
+    // The remaining kernels take the same steps as the scalar ones; only rounding may differ
+    scalar().horizontalDistances(motions.vec3(0), motions.vec3(3), expected.data(), n);
+    kernels.horizontalDistances(motions.vec3(0), motions.vec3(3), actual.data(), n);
+    CHECK(maxRelativeDifference(expected, actual) <= 1e-6f);
+
+    scalar().speeds(motions.vec3(0), expected.data(), n);
+    kernels.speeds(motions.vec3(0), actual.data(), n);
+    CHECK(maxRelativeDifference(expected, actual) <= 1e-6f);
+
+    scalar().tangentialAccelerations(motions.vec3(0), motions.vec3(3), expected.data(), n);
+    kernels.tangentialAccelerations(motions.vec3(0), motions.vec3(3), actual.data(), n);
+    CHECK(maxRelativeDifference(expected, actual) <= 1e-5f);
+}
+
+void testScalarKernels()
+{
+    // Quarter turns about X: a joint angle and a pitch of 90 degrees
+    const float halfSqrt2 = std::sqrt(0.5f);
+    const float one[] = { 1.0f };
+    const float zero[] = { 0.0f };
+    const float w[] = { halfSqrt2 };
+    const float x[] = { halfSqrt2 };
+    const QuatColumns identity = { one, zero, zero, zero };
+    const QuatColumns quarterTurn = { w, x, zero, zero };
+
+    float out = 0.0f;
+    scalar().jointAngles(identity, quarterTurn, &out, 1);
+    CHECK_NEAR(out, 90.0f, 1e-4f);
+    scalar().tilts(quarterTurn, &out, 1);
+    CHECK_NEAR(out, 90.0f, 1e-4f);
+
+    // 3-4-5 triangles: horizontal distance in centimeters, speed, acceleration along the velocity
+    const float three[] = { 3.0f };
+    const float four[] = { 4.0f };
+    scalar().horizontalDistances({ zero, zero, zero }, { three, one, four }, &out, 1);
+    CHECK_NEAR(out, 500.0f, 1e-3f);
+    scalar().speeds({ three, zero, four }, &out, 1);
+    CHECK_NEAR(out, 5.0f, 1e-6f);
+    scalar().tangentialAccelerations({ three, zero, four }, { zero, zero, one }, &out, 1);
+    CHECK_NEAR(out, 0.8f, 1e-6f);
+    scalar().tangentialAccelerations({ zero, zero, zero }, { three, zero, four }, &out, 1);
+    CHECK_NEAR(out, 5.0f, 1e-6f);
+}
+
+} // namespace
+
+int main()
+{
+    testScalarKernels();
+
+    CHECK(&best() == avx2() || &best() == sse4() || &best() == &scalar());
+
+    // Batch sizes below, at and past the vector widths, leaving every possible tail
+    for (const Kernels* kernels : { sse4(), avx2() }) {
+        if (!kernels) {
+            continue;
+        }
+        for (size_t n : { 1, 3, 4, 7, 8, 15, 17, 64, 4099 }) {
+            testKernels(*kernels, n);
+        }
+        testKernels(*kernels, 1 << 18);
+    }
+    return test_check::result();
+}
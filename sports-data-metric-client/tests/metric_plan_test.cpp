@@ -0,0 +1,177 @@
+// MetricPlan compilation: output slots assigned in settings order, extra
+// labels dropped, estimators parsed, made valid and shared, joints and bone IDs
+// read, entries with an unknown class or missing inputs skipped, and the
+// settings that would overflow MetricsData::kMaxSlots left out.
+
+#include "metric_plan.h"
+#include "test_check.h"
+
+#include <string>
+#include <QJsonDocument>
+
+namespace {
+
+QJsonArray parse(const char* json)
+{
+    return QJsonDocument::fromJson(QByteArray(json)).array();
+}
+
+void testSlots()
+{
+    const MetricPlan plan = MetricPlan::compile(parse(R"([
+        {"name": "Tilt", "class": "tilt", "labels": ["tilt"]},
+        {"name": "Position", "class": "position", "labels": ["x", "y", "z"]},
+        {"name": "Heading", "class": "orientation", "labels": ["pitch", "yaw"]},
+        {"name": "Speed", "class": "velocity", "labels": ["speed", "unused"]}
+    ])"));
+
+    const std::vector<MetricStep>& steps = plan.steps();
+    CHECK(steps.size() == 4);
+    CHECK(steps[0].op == MetricOp::Tilt && steps[0].slot == 0 && steps[0].count == 1);
+    CHECK(steps[1].op == MetricOp::Position && steps[1].slot == 1 && steps[1].count == 3);
+    CHECK(steps[2].op == MetricOp::Orientation && steps[2].slot == 4 && steps[2].count == 2);
+    CHECK(steps[3].op == MetricOp::Velocity && steps[3].slot == 6 && steps[3].count == 1);
+
+    // Labels past a class's outputs get no slot
+    CHECK(plan.schema().slotCount() == 7);
+    CHECK(plan.schema().labels() == QStringList({ "tilt", "x", "y", "z", "pitch", "yaw", "speed" }));
+    CHECK(plan.schema().slotOf("unused") == -1);
+
+    // Rigid body metrics read no bones
+    CHECK(steps[1].joint == -1 && steps[1].bone1 == -1 && steps[1].bone2 == -1);
+    CHECK(steps[0].estimator == -1);
+}
+
+void testEstimators()
+{
+    const MetricPlan plan = MetricPlan::compile(parse(R"([
+        {"name": "Speed", "class": "velocity", "labels": ["speed"]},
+        {"name": "Smooth Speed", "class": "velocity", "labels": ["smoothSpeed"],
+         "estimator": {"method": "savitzkyGolay", "window": 7}},
+        {"name": "Smooth Acceleration", "class": "acceleration", "labels": ["smoothAcceleration"],
+         "estimator": {"method": "savitzkyGolay", "window": 7}},
+        {"name": "Even Window", "class": "acceleration", "labels": ["even"],
+         "estimator": {"method": "savitzkyGolay", "window": 8}},
+        {"name": "Unknown Method", "class": "velocity", "labels": ["unknown"],
+         "estimator": {"method": "kalman", "window": 5}},
+        {"name": "Too Long", "class": "velocity", "labels": ["long"],
+         "estimator": {"method": "savitzkyGolay", "window": 1000}}
+    ])"));
+
+    const std::vector<MetricStep>& steps = plan.steps();
+    const std::vector<DerivativeEstimator>& estimators = plan.estimators();
+    CHECK(steps.size() == 6);
+    CHECK(estimators.size() == 5);
+    if (steps.size() != 6 || estimators.size() != 5) {
+        return;
+    }
+
+    // No estimator: a three sample central difference
+    CHECK(estimators[static_cast<size_t>(steps[0].estimator)].method() == DerivativeMethod::CentralDifference);
+    CHECK(estimators[static_cast<size_t>(steps[0].estimator)].window() == DerivativeEstimator::kMinWindow);
+
+    // Equal estimators are shared between metrics
+    CHECK(steps[1].estimator == steps[2].estimator);
+    CHECK(estimators[static_cast<size_t>(steps[1].estimator)].method() == DerivativeMethod::SavitzkyGolay);
+    CHECK(estimators[static_cast<size_t>(steps[1].estimator)].window() == 7);
+
+    // Windows are made odd and clamped
+    CHECK(estimators[static_cast<size_t>(steps[3].estimator)].window() == 9);
+    CHECK(estimators[static_cast<size_t>(steps[5].estimator)].window() == DerivativeEstimator::kMaxWindow);
+
+    // An unknown method falls back to a central difference over its window
+    CHECK(estimators[static_cast<size_t>(steps[4].estimator)].method() == DerivativeMethod::CentralDifference);
+    CHECK(estimators[static_cast<size_t>(steps[4].estimator)].window() == 5);
+
+    // The history keeps the longest window
+    CHECK(plan.historyDepth() == DerivativeEstimator::kMaxWindow);
+    CHECK(MetricPlan::compile(parse(R"([{"class": "tilt", "labels": ["tilt"]}])")).historyDepth() ==
+          DerivativeEstimator::kMinWindow);
+}
+
+void testBones()
+{
+    const MetricPlan plan = MetricPlan::compile(parse(R"([
+        {"name": "Knee", "class": "angle", "labels": ["knee"], "joint": "left_knee_angle"},
+        {"name": "Elbow", "class": "angle", "labels": ["elbow"], "ids": [14, 15]},
+        {"name": "Tilt", "class": "distance", "labels": ["tilt"], "joint": "forward_tilt", "ids": [1, 5]},
+        {"name": "Other Knee", "class": "distance", "labels": ["kneeSpread"], "joint": "left_knee_angle"}
+    ])"));
+
+    const std::vector<MetricStep>& steps = plan.steps();
+    CHECK(steps.size() == 4);
+    CHECK(plan.joints() == QStringList({ "left_knee_angle", "forward_tilt" }));
+    if (steps.size() != 4) {
+        return;
+    }
+
+    CHECK(steps[0].op == MetricOp::JointAngle && steps[0].joint == 0 && steps[0].bone1 == -1);
+    CHECK(steps[1].joint == -1 && steps[1].bone1 == 14 && steps[1].bone2 == 15);
+    CHECK(steps[2].op == MetricOp::HorizontalDistance && steps[2].joint == 1);
+    CHECK(steps[2].bone1 == 1 && steps[2].bone2 == 5);      // The fallback if the joint cannot be found
+    CHECK(steps[3].joint == 0);                             // Joints are listed once
+}
+
+void testSkipped()
+{
+    const MetricPlan plan = MetricPlan::compile(parse(R"([
+        {"name": "Unknown", "class": "jerk", "labels": ["jerk"]},
+        {"name": "No Class", "labels": ["none"]},
+        {"name": "No Labels", "class": "tilt", "labels": []},
+        {"name": "No Bones", "class": "angle", "labels": ["angle"]},
+        {"name": "One Bone", "class": "distance", "labels": ["distance"], "ids": [3]},
+        {"name": "Kept", "class": "tilt", "labels": ["tilt"]}
+    ])"));
+
+    CHECK(plan.steps().size() == 1);
+    CHECK(plan.schema().labels() == QStringList({ "tilt" }));
+    CHECK(!plan.empty());
+
+    // Nothing valid: an empty plan with an empty schema
+    const MetricPlan empty = MetricPlan::compile(parse(R"([{"class": "jerk", "labels": ["jerk"]}])"));
+    CHECK(empty.empty());
+    CHECK(empty.schema().slotCount() == 0 && empty.schema().version() == 0);
+    CHECK(MetricPlan::compile(QJsonArray()).empty());
+}
+
+void testSlotLimit()
+{
+    // Ten positions fill 30 slots; the eleventh would need 33
+    QJsonArray settings;
+    for (int i = 0; i < 11; ++i) {
+        QJsonObject metric;
+        const QString n = QString::fromStdString(std::to_string(i));
+        metric["name"] = "Position " + n;
+        metric["class"] = "position";
+        metric["labels"] = QJsonArray({ "x" + n, "y" + n, "z" + n });
+        settings.append(metric);
+    }
+
+    // Smaller metrics after it still fit in the slots left
+    QJsonObject tilt;
+    tilt["name"] = "Tilt";
+    tilt["class"] = "tilt";
+    tilt["labels"] = QJsonArray({ "tilt" });
+    settings.append(tilt);
+    settings.append(tilt);
+    settings.append(tilt);
+
+    const MetricPlan plan = MetricPlan::compile(settings);
+    CHECK(plan.steps().size() == 12);
+    CHECK(plan.schema().slotCount() == MetricsData::kMaxSlots);
+    CHECK(plan.schema().slotOf("x10") == -1);
+    CHECK(plan.schema().slotOf("z9") == 29);
+    CHECK(plan.steps().back().slot == 31);
+}
+
+} // namespace
+
+int main()
+{
+    testSlots();
+    testEstimators();
+    testBones();
+    testSkipped();
+    testSlotLimit();
+    return test_check::result();
+}
@@ -0,0 +1,116 @@
+// MetricSchema: labels looked up by slot and slot by label, versions that two
+// separate compilations of the same settings agree on and that change with the
+// labels or their order, and rigid body metrics tagged with the version and
+// slot count of their sport, each value in the slot of its label.
+
+#include "rigid_body_metrics.h"
+#include "test_check.h"
+
+#include <QJsonDocument>
+
+namespace {
+
+constexpr int kBodyId = 7;
+
+const char* kTrackSettings = R"([
+    {"name": "Tilt Angle", "class": "tilt", "labels": ["tiltAngle"], "ids": []},
+    {"name": "Position", "class": "position", "labels": ["positionX", "positionY", "positionZ"], "ids": []}
+])";
+
+const char* kFieldSettings = R"([
+    {"name": "Position", "class": "position", "labels": ["positionX", "positionY", "positionZ"], "ids": []},
+    {"name": "Velocity", "class": "velocity", "labels": ["velocity"], "ids": []}
+])";
+
+QJsonArray parse(const char* json)
+{
+    return QJsonDocument::fromJson(QByteArray(json)).array();
+}
+
+FrameData makeFrame(bool tracked)
+{
+    FrameData frame;
+    frame.frameNumber = 42;
+    frame.timestamp = 1.0;
+    RigidBodyData body;
+    body.id = kBodyId;
+    body.position = QVector3D(1.5f, 2.0f, -0.5f);
+    body.tracked = tracked;
+    frame.rigidBodies.push_back(body);
+    return frame;
+}
+
+void testSlots()
+{
+    const MetricSchema schema(QStringList({ "speed", "positionX", "positionY" }));
+    CHECK(schema.slotCount() == 3);
+    CHECK(schema.slotOf("speed") == 0);
+    CHECK(schema.slotOf("positionY") == 2);
+    CHECK(schema.slotOf("positionZ") == -1);
+    CHECK(schema.labels().at(1) == "positionX");
+
+    const MetricSchema empty;
+    CHECK(empty.slotCount() == 0 && empty.version() == 0);
+    CHECK(empty.slotOf("speed") == -1);
+    CHECK(MetricSchema(QStringList()).version() == 0);
+}
+
+void testVersions()
+{
+    const QStringList labels({ "tiltAngle", "positionX", "positionY", "positionZ" });
+    const uint32_t version = MetricSchema(labels).version();
+    CHECK(version != 0);
+    CHECK(MetricSchema(labels).version() == version);
+
+    // The data thread and the UI compile the settings apart and agree
+    CHECK(MetricPlan::compile(parse(kTrackSettings)).schema().version() == version);
+
+    // Any other label list is another schema, even the same labels reordered
+    CHECK(MetricSchema(QStringList({ "positionX", "tiltAngle", "positionY", "positionZ" })).version() != version);
+    CHECK(MetricSchema(QStringList({ "tiltAngle", "positionX", "positionY" })).version() != version);
+    CHECK(MetricPlan::compile(parse(kFieldSettings)).schema().version() != version);
+}
+
+void testTaggedMetrics()
+{
+    std::unordered_map<int, std::string> names;
+    names[kBodyId] = "Ball";
+    RigidBodyMetrics metrics;
+    metrics.setRigidBodyMap(names);
+    metrics.createInverseMaps();
+
+    const FrameData frame = makeFrame(true);
+    const MetricSchema track = MetricPlan::compile(parse(kTrackSettings)).schema();
+    metrics.setMetricSettings(parse(kTrackSettings));
+    metrics.pushFrame(frame);
+    MetricsData data = metrics.computeMetricsForAsset(kBodyId, frame);
+    CHECK(data.id == 42);
+    CHECK(data.schemaVersion == track.version());
+    CHECK(data.count == track.slotCount());
+    CHECK(data.values[static_cast<size_t>(track.slotOf("positionX"))] == 1.5);
+    CHECK(data.values[static_cast<size_t>(track.slotOf("positionZ"))] == -0.5);
+
+    // Another sport moves the same labels to other slots under another version
+    const MetricSchema field = MetricPlan::compile(parse(kFieldSettings)).schema();
+    metrics.setMetricSettings(parse(kFieldSettings));
+    data = metrics.computeMetricsForAsset(kBodyId, frame);
+    CHECK(data.schemaVersion == field.version());
+    CHECK(data.count == field.slotCount());
+    CHECK(field.slotOf("positionX") != track.slotOf("positionX"));
+    CHECK(data.values[static_cast<size_t>(field.slotOf("positionX"))] == 1.5);
+    CHECK(data.values[static_cast<size_t>(field.slotOf("positionY"))] == 2.0);
+
+    // Nothing tracked: no values and no schema
+    data = metrics.computeMetricsForAsset(kBodyId, makeFrame(false));
+    CHECK(data.count == 0 && data.schemaVersion == 0);
+}
+
+} // namespace
+
+int main()
+{
+    testSlots();
+    testVersions();
+    testTaggedMetrics();
+    return test_check::result();
+}
@@ -0,0 +1,205 @@
+// MetricStatistics: exact mean, variance and extremes, P² percentiles of known
+// distributions and their exact values below five samples, starting over on a
+// new schema version, and a reader racing the writer never getting a snapshot
+// mixing two publications.
+
+#include "metric_statistics.h"
+#include "test_check.h"
+
+#include <atomic>
+#include <random>
+#include <thread>
+
+namespace {
+
+MetricsData makeMetrics(uint32_t schemaVersion, std::initializer_list<double> values)
+{
+    MetricsData metrics;
+    metrics.schemaVersion = schemaVersion;
+    for (double value : values) {
+        metrics.values[static_cast<size_t>(metrics.count++)] = value;
+    }
+    return metrics;
+}
+
+void testMoments()
+{
+    MetricStatistics statistics;
+    for (double x : { 2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0 }) {
+        statistics.add(makeMetrics(1, { x, -x }));
+    }
+
+    const MetricStatistics::Snapshot snapshot = statistics.snapshot();
+    CHECK(snapshot.schemaVersion == 1);
+    CHECK(snapshot.count == 2);
+
+    const MetricSummary& first = snapshot.summaries[0];
+    CHECK(first.count == 8);
+    CHECK_NEAR(first.mean, 5.0, 1e-12);
+    CHECK_NEAR(first.variance, 32.0 / 7.0, 1e-12);
+    CHECK(first.min == 2.0 && first.max == 9.0);
+
+    const MetricSummary& second = snapshot.summaries[1];
+    CHECK_NEAR(second.mean, -5.0, 1e-12);
+    CHECK_NEAR(second.variance, 32.0 / 7.0, 1e-12);
+    CHECK(second.min == -9.0 && second.max == -2.0);
+
+    // One sample has no spread
+    MetricStatistics single;
+    single.add(makeMetrics(1, { 3.5 }));
+    const MetricSummary one = single.snapshot().summaries[0];
+    CHECK(one.count == 1 && one.mean == 3.5 && one.variance == 0.0);
+    CHECK(one.min == 3.5 && one.max == 3.5);
+}
+
+void testSmallSamples()
+{
+    // Below five samples the percentiles are the nearest ranks of the sorted samples
+    P2Quantile median(0.5);
+    CHECK(median.value() == 0.0);
+    median.add(3.0);
+    CHECK(median.value() == 3.0);
+    median.add(1.0);
+    median.add(2.0);
+    CHECK(median.value() == 2.0);
+
+    MetricStatistics statistics;
+    for (double x : { 4.0, 1.0, 3.0, 2.0 }) {
+        statistics.add(makeMetrics(1, { x }));
+    }
+    const MetricSummary summary = statistics.snapshot().summaries[0];
+    CHECK(summary.p50 == 3.0);      // Rank round(0.5 * 3) of 1, 2, 3, 4
+    CHECK(summary.p90 == 4.0);
+    CHECK(summary.p99 == 4.0);
+
+    // The fifth sample switches to the markers: the median of five is exact
+    statistics.add(makeMetrics(1, { 5.0 }));
+    CHECK(statistics.snapshot().summaries[0].p50 == 3.0);
+}
+
+void testDistributions()
+{
+    constexpr int kSamples = 100000;
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::normal_distribution<double> normal(0.0, 1.0);
+
+    MetricStatistics statistics;
+    for (int i = 0; i < kSamples; ++i) {
+        statistics.add(makeMetrics(1, { uniform(generator), normal(generator) }));
+    }
+    const MetricStatistics::Snapshot snapshot = statistics.snapshot();
+
+    const MetricSummary& u = snapshot.summaries[0];
+    CHECK(u.count == static_cast<uint64_t>(kSamples));
+    CHECK_NEAR(u.mean, 0.5, 0.01);
+    CHECK_NEAR(u.variance, 1.0 / 12.0, 0.005);
+    CHECK_NEAR(u.p50, 0.5, 0.01);
+    CHECK_NEAR(u.p90, 0.9, 0.01);
+    CHECK_NEAR(u.p99, 0.99, 0.005);
+
+    const MetricSummary& n = snapshot.summaries[1];
+    CHECK_NEAR(n.mean, 0.0, 0.02);
+    CHECK_NEAR(n.variance, 1.0, 0.02);
+    CHECK_NEAR(n.p50, 0.0, 0.03);
+    CHECK_NEAR(n.p90, 1.2816, 0.03);
+    CHECK_NEAR(n.p99, 2.3263, 0.05);
+    CHECK(n.min < -3.0 && n.max > 3.0);
+}
+
+void testSchemaChange()
+{
+    MetricStatistics statistics;
+    for (int i = 0; i < 10; ++i) {
+        statistics.add(makeMetrics(1, { 1.0 * i, 2.0 }));
+    }
+
+    // Metrics without values leave the statistics alone
+    statistics.add(MetricsData());
+    CHECK(statistics.snapshot().summaries[0].count == 10);
+
+    // Another sport's values start over, with its own slots
+    statistics.add(makeMetrics(2, { 100.0 }));
+    MetricStatistics::Snapshot snapshot = statistics.snapshot();
+    CHECK(snapshot.schemaVersion == 2);
+    CHECK(snapshot.count == 1);
+    CHECK(snapshot.summaries[0].count == 1);
+    CHECK(snapshot.summaries[0].mean == 100.0 && snapshot.summaries[0].min == 100.0);
+
+    // Back to the first schema: nothing of it is left
+    statistics.add(makeMetrics(1, { 5.0, 6.0 }));
+    snapshot = statistics.snapshot();
+    CHECK(snapshot.count == 2);
+    CHECK(snapshot.summaries[0].count == 1 && snapshot.summaries[1].count == 1);
+    CHECK(snapshot.summaries[0].mean == 5.0);
+
+    statistics.reset();
+    snapshot = statistics.snapshot();
+    CHECK(snapshot.schemaVersion == 0 && snapshot.count == 0);
+}
+
+void testConcurrentSnapshots()
+{
+    // Sample k sets every slot to k, so a consistent snapshot has equal slots with
+    // count k, min 1, max k and mean (k + 1) / 2
+    constexpr int kSlots = MetricsData::kMaxSlots;
+    constexpr int kSamples = 50000;
+    MetricStatistics statistics;
+    std::atomic<bool> done{false};
+
+    std::thread writer([&] {
+        MetricsData metrics;
+        metrics.schemaVersion = 1;
+        metrics.count = kSlots;
+        for (int k = 1; k <= kSamples; ++k) {
+            metrics.values.fill(k);
+            statistics.add(metrics);
+        }
+        done.store(true);
+    });
+
+    int torn = 0;
+    int snapshots = 0;
+    uint64_t last = 0;
+    int backwards = 0;
+    bool finished = false;
+    while (!finished) {
+        finished = done.load();
+        const MetricStatistics::Snapshot snapshot = statistics.snapshot();
+        ++snapshots;
+        if (snapshot.count == 0) {
+            continue;
+        }
+
+        const MetricSummary& first = snapshot.summaries[0];
+        const double k = static_cast<double>(first.count);
+        bool consistent = snapshot.count == kSlots && first.min == 1.0 && first.max == k &&
+                          first.mean == (k + 1.0) / 2.0;
+        for (int i = 1; i < snapshot.count; ++i) {
+            const MetricSummary& s = snapshot.summaries[static_cast<size_t>(i)];
+            consistent = consistent && s.count == first.count && s.mean == first.mean && s.max == first.max &&
+                         s.variance == first.variance && s.p50 == first.p50 && s.p99 == first.p99;
+        }
+        torn += consistent ? 0 : 1;
+        backwards += first.count < last ? 1 : 0;
+        last = first.count;
+    }
+    writer.join();
+
+    CHECK(snapshots > 0);
+    CHECK(torn == 0);
+    CHECK(backwards == 0);
+    CHECK(statistics.snapshot().summaries[kSlots - 1].count == static_cast<uint64_t>(kSamples));
+}
+
+} // namespace
+
+int main()
+{
+    testMoments();
+    testSmallSamples();
+    testDistributions();
+    testSchemaChange();
+    testConcurrentSnapshots();
+    return test_check::result();
+}
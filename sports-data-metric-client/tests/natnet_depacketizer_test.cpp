@@ -0,0 +1,358 @@
+// Replays hand-built NatNet messages through the depacketizer: frames of data
+// and model definitions in the 3.x layout and in the 4.1 layout with section
+// sizes, the unlabeled marker split, the marker cap and truncated payloads.
+
+#include "natnet_packets.h"
+#include "test_check.h"
+
+#include <cstring>
+
+namespace {
+
+using namespace natnet_packets;
+
+constexpr int32_t kFrameNumber = 4242;
+constexpr double kTimestamp = 35.25;
+constexpr int16_t kFrameParams = 0x01;
+
+/**
+ * @brief A frame with two rigid bodies, one three-bone skeleton, two legacy
+ * unlabeled markers and four labeled markers, one of them flagged unlabeled.
+ */
+PacketWriter buildFrame(bool sections)
+{
+    PacketWriter out;
+    out.write<int32_t>(kFrameNumber);
+
+    // One marker set of one marker
+    out.write<int32_t>(1);
+    const size_t markerSets = sections ? out.beginSection() : 0;
+    out.writeString("all");
+    out.write<int32_t>(1);
+    out.write<float>(1.0f);
+    out.write<float>(1.0f);
+    out.write<float>(1.0f);
+    if (sections) {
+        out.endSection(markerSets);
+    }
+
+    // Legacy unlabeled markers
+    out.write<int32_t>(2);
+    const size_t legacy = sections ? out.beginSection() : 0;
+    for (int i = 0; i < 2; ++i) {
+        out.write<float>(5.0f + i);
+        out.write<float>(0.0f);
+        out.write<float>(0.0f);
+    }
+    if (sections) {
+        out.endSection(legacy);
+    }
+
+    out.write<int32_t>(2);
+    const size_t rigidBodies = sections ? out.beginSection() : 0;
+    writeRigidBody(out, 100, 1.5f);
+    writeRigidBody(out, 101, -1.5f);
+    if (sections) {
+        out.endSection(rigidBodies);
+    }
+
+    out.write<int32_t>(1);
+    const size_t skeletons = sections ? out.beginSection() : 0;
+    out.write<int32_t>(7);
+    out.write<int32_t>(3);
+    for (int b = 1; b <= 3; ++b) {
+        writeRigidBody(out, (7 << 16) | b, 0.25f * b);
+    }
+    if (sections) {
+        out.endSection(skeletons);
+    }
+
+    // Trained markerset assets, skipped by the decoder
+    if (sections) {
+        out.write<int32_t>(1);
+        const size_t assets = out.beginSection();
+        out.write<int32_t>(9);
+        out.write<int32_t>(0);
+        out.endSection(assets);
+    }
+
+    out.write<int32_t>(4);
+    const size_t labeled = sections ? out.beginSection() : 0;
+    for (int32_t id = 1; id <= 4; ++id) {
+        writeLabeledMarker(out, id, id == 3);
+    }
+    if (sections) {
+        out.endSection(labeled);
+    }
+
+    // One force plate of two channels, no devices
+    out.write<int32_t>(1);
+    const size_t forcePlates = sections ? out.beginSection() : 0;
+    out.write<int32_t>(1);
+    out.write<int32_t>(2);
+    for (int c = 0; c < 2; ++c) {
+        out.write<int32_t>(1);
+        out.write<float>(9.81f);
+    }
+    if (sections) {
+        out.endSection(forcePlates);
+    }
+    out.write<int32_t>(0);
+    if (sections) {
+        out.endSection(out.beginSection());
+    }
+
+    out.write<uint32_t>(0);             // Timecode
+    out.write<uint32_t>(0);             // Timecode subframe
+    out.write<double>(kTimestamp);
+    out.write<uint64_t>(1000);          // Mid exposure
+    out.write<uint64_t>(2000);          // Camera data received
+    out.write<uint64_t>(3000);          // Transmit
+    if (sections) {
+        out.write<uint32_t>(35);        // Precision timestamp
+        out.write<uint32_t>(0);
+    }
+    out.write<int16_t>(kFrameParams);
+    return out;
+}
+
+void checkFrame(const StagedFrame& frame)
+{
+    CHECK(frame.frameNumber == kFrameNumber);
+    CHECK(frame.timestamp == kTimestamp);
+    CHECK(frame.cameraMidExposureTimestamp == 1000);
+    CHECK(frame.transmitTimestamp == 3000);
+    CHECK(frame.params == kFrameParams);
+    CHECK(frame.totalLatencyMs < 0.0);
+
+    CHECK(frame.rigidBodies.size() == 2);
+    if (frame.rigidBodies.size() == 2) {
+        CHECK(frame.rigidBodies[1].ID == 101);
+        CHECK(frame.rigidBodies[1].x == -1.5f);
+        CHECK(frame.rigidBodies[1].qw == 1.0f);
+        CHECK(frame.rigidBodies[1].params == 0x01);
+    }
+
+    CHECK(frame.skeletons.size() == 1);
+    CHECK(frame.bones.size() == 3);
+    if (frame.skeletons.size() == 1 && frame.bones.size() == 3) {
+        CHECK(frame.skeletons[0].id == 7);
+        CHECK(frame.skeletons[0].firstBone == 0);
+        CHECK(frame.skeletons[0].boneCount == 3);
+        CHECK(frame.bones[2].ID == ((7 << 16) | 3));
+        CHECK(frame.bones[2].x == 0.75f);
+    }
+
+    // The flagged marker supersedes the two legacy ones
+    CHECK(frame.labeledMarkerTotal == 3);
+    CHECK(frame.unlabeledMarkerTotal == 1);
+    CHECK(frame.labeledMarkers.size() == 3);
+    CHECK(frame.unlabeledMarkers.size() == 1);
+    if (frame.unlabeledMarkers.size() == 1) {
+        CHECK(frame.unlabeledMarkers[0].ID == 3);
+        CHECK(frame.unlabeledMarkers[0].size == 0.014f);
+    }
+}
+
+void testFrame(int major, int minor)
+{
+    NatNetDepacketizer depacketizer;
+    CHECK(depacketizer.setVersion(major, minor));
+
+    const PacketWriter packet = buildFrame(major > 4 || (major == 4 && minor >= 1));
+    StagedFrame frame;
+    CHECK(depacketizer.parseFrame(packet.data(), packet.size(), frame, MAX_LABELED_MARKERS));
+    checkFrame(frame);
+
+    // Decoding into a used slot leaves nothing of the previous frame behind
+    CHECK(depacketizer.parseFrame(packet.data(), packet.size(), frame, MAX_LABELED_MARKERS));
+    checkFrame(frame);
+}
+
+void testMarkerCap()
+{
+    NatNetDepacketizer depacketizer;
+    const PacketWriter packet = buildFrame(true);
+    StagedFrame frame;
+    CHECK(depacketizer.parseFrame(packet.data(), packet.size(), frame, 2));
+    CHECK(frame.labeledMarkers.size() == 2);
+    CHECK(frame.labeledMarkerTotal == 3);
+    CHECK(frame.unlabeledMarkers.size() == 1);
+}
+
+void testLegacyUnlabeledMarkers()
+{
+    // A 3.x frame whose labeled markers carry no flags keeps the legacy list
+    PacketWriter out;
+    out.write<int32_t>(1);      // Frame number
+    out.write<int32_t>(0);      // Marker sets
+    out.write<int32_t>(2);
+    for (int i = 0; i < 2; ++i) {
+        out.write<float>(5.0f + i);
+        out.write<float>(0.0f);
+        out.write<float>(0.0f);
+    }
+    out.write<int32_t>(0);      // Rigid bodies
+    out.write<int32_t>(0);      // Skeletons
+    out.write<int32_t>(1);
+    writeLabeledMarker(out, 1, false);
+    out.write<int32_t>(0);      // Force plates
+    out.write<int32_t>(0);      // Devices
+    out.write<uint32_t>(0);
+    out.write<uint32_t>(0);
+    out.write<double>(1.0);
+    out.write<uint64_t>(0);
+    out.write<uint64_t>(0);
+    out.write<uint64_t>(0);
+    out.write<int16_t>(0);
+
+    NatNetDepacketizer depacketizer;
+    depacketizer.setVersion(3, 1);
+    StagedFrame frame;
+    CHECK(depacketizer.parseFrame(out.data(), out.size(), frame, MAX_LABELED_MARKERS));
+    CHECK(frame.labeledMarkers.size() == 1);
+    CHECK(frame.unlabeledMarkers.size() == 2);
+    if (frame.unlabeledMarkers.size() == 2) {
+        CHECK(frame.unlabeledMarkers[1].ID == -1);
+        CHECK(frame.unlabeledMarkers[1].x == 6.0f);
+    }
+}
+
+void testTruncatedFrames()
+{
+    NatNetDepacketizer depacketizer;
+    const PacketWriter packet = buildFrame(true);
+    StagedFrame frame;
+    int accepted = 0;
+    for (size_t size = 0; size < packet.size(); ++size) {
+        accepted += depacketizer.parseFrame(packet.data(), size, frame, MAX_LABELED_MARKERS) ? 1 : 0;
+    }
+    CHECK(accepted == 0);
+}
+
+void testModelDefinitions41()
+{
+    PacketWriter out;
+    out.write<int32_t>(3);
+
+    out.write<int32_t>(Descriptor_RigidBody);
+    size_t start = out.beginSection();
+    writeRigidBodyDescription(out, "Wand", 5, 3, true);
+    out.endSection(start);
+
+    // A description type this decoder does not know, skipped by its size
+    out.write<int32_t>(42);
+    start = out.beginSection();
+    out.write<int32_t>(1234);
+    out.writeString("future");
+    out.endSection(start);
+
+    out.write<int32_t>(Descriptor_Skeleton);
+    start = out.beginSection();
+    out.writeString("Runner");
+    out.write<int32_t>(2);
+    out.write<int32_t>(2);
+    writeRigidBodyDescription(out, "Hip", 1, 0, true);
+    writeRigidBodyDescription(out, "Ab", 2, 1, true);
+    out.write<int32_t>(77);     // A field newer than the decoder, skipped
+    out.endSection(start);
+
+    NatNetDepacketizer depacketizer;
+    NatNetModelDefinitions definitions;
+    CHECK(depacketizer.parseModelDefinitions(out.data(), out.size(), definitions));
+
+    const sDataDescriptions* descriptions = definitions.descriptions();
+    CHECK(descriptions->nDataDescriptions == 2);
+    if (descriptions->nDataDescriptions == 2) {
+        const sRigidBodyDescription* body = descriptions->arrDataDescriptions[0].Data.RigidBodyDescription;
+        CHECK(descriptions->arrDataDescriptions[0].type == Descriptor_RigidBody);
+        CHECK(std::strcmp(body->szName, "Wand") == 0);
+        CHECK(body->ID == 5);
+        CHECK(body->nMarkers == 3);
+        CHECK(body->MarkerPositions[2][0] == 0.02f);
+
+        const sSkeletonDescription* skeleton = descriptions->arrDataDescriptions[1].Data.SkeletonDescription;
+        CHECK(descriptions->arrDataDescriptions[1].type == Descriptor_Skeleton);
+        CHECK(std::strcmp(skeleton->szName, "Runner") == 0);
+        CHECK(skeleton->skeletonID == 2);
+        CHECK(skeleton->nRigidBodies == 2);
+        CHECK(std::strcmp(skeleton->RigidBodies[1].szName, "Ab") == 0);
+        CHECK(skeleton->RigidBodies[1].nMarkers == 1);
+    }
+
+    // A description that claims more bytes than the message holds is rejected
+    NatNetModelDefinitions truncated;
+    CHECK(!depacketizer.parseModelDefinitions(out.data(), out.size() - 8, truncated));
+}
+
+void testModelDefinitions3()
+{
+    PacketWriter out;
+    out.write<int32_t>(3);
+
+    out.write<int32_t>(Descriptor_MarkerSet);
+    out.writeString("Wand");
+    out.write<int32_t>(2);
+    out.writeString("Wand_1");
+    out.writeString("Wand_2");
+
+    out.write<int32_t>(Descriptor_RigidBody);
+    writeRigidBodyDescription(out, "Wand", 5, 2, false);
+
+    // Camera descriptions carry no size in 3.x; decoding stops here
+    out.write<int32_t>(Descriptor_Camera);
+    out.writeString("Camera");
+
+    NatNetDepacketizer depacketizer;
+    depacketizer.setVersion(3, 1);
+    NatNetModelDefinitions definitions;
+    CHECK(depacketizer.parseModelDefinitions(out.data(), out.size(), definitions));
+    CHECK(definitions.descriptions()->nDataDescriptions == 1);
+    if (definitions.descriptions()->nDataDescriptions == 1) {
+        CHECK(definitions.descriptions()->arrDataDescriptions[0].Data.RigidBodyDescription->nMarkers == 2);
+    }
+}
+
+void testMessages()
+{
+    NatNetDepacketizer depacketizer;
+    CHECK(!depacketizer.setVersion(2, 10));
+    CHECK(depacketizer.versionMajor() == 4);
+
+    char message[NatNetDepacketizer::kMaxMessageSize];
+    const char request[] = "TimelinePlay";
+    const size_t written = NatNetDepacketizer::writeRequest(NAT_REQUEST, request, sizeof(request),
+                                                            message, sizeof(message));
+    CHECK(written == NatNetDepacketizer::kHeaderSize + sizeof(request));
+    CHECK(NatNetDepacketizer::writeRequest(NAT_REQUEST, request, sizeof(request), message, 8) == 0);
+
+    uint16_t messageId = 0;
+    const char* payload = nullptr;
+    size_t payloadSize = 0;
+    CHECK(NatNetDepacketizer::readHeader(message, written, messageId, payload, payloadSize));
+    CHECK(messageId == NAT_REQUEST);
+    CHECK(payloadSize == sizeof(request));
+    CHECK(payload && std::strcmp(payload, request) == 0);
+
+    // Shorter than the header announces
+    CHECK(!NatNetDepacketizer::readHeader(message, written - 1, messageId, payload, payloadSize));
+    CHECK(!NatNetDepacketizer::readHeader(message, 3, messageId, payload, payloadSize));
+
+    CHECK(NatNetDepacketizer::writeConnectRequest(message, sizeof(message)) > NatNetDepacketizer::kHeaderSize);
+}
+
+} // namespace
+
+int main()
+{
+    testFrame(3, 1);
+    testFrame(4, 0);
+    testFrame(4, 1);
+    testMarkerCap();
+    testLegacyUnlabeledMarkers();
+    testTruncatedFrames();
+    testModelDefinitions41();
+    testModelDefinitions3();
+    testMessages();
+    return test_check::result();
+}
@@ -0,0 +1,374 @@
+// NatNet messages built by hand, and a stand-in for Motive's command and data
+// ports on the loopback interface, for the tests and benchmarks of the
+// built-in UDP receiver.
+//
+// LocalNatNetServer answers the connect and model definition requests on the
+// command port and streams frames of a NatNetScene, bitstream 4.1, to the
+// address its keep-alives come from, like Motive streaming unicast.
+
+#pragma once
+
+#include "natnet_depacketizer.h"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace natnet_packets {
+
+/**
+ * @brief Appends little-endian values to a message payload.
+ */
+class PacketWriter {
+public:
+    template <typename T>
+    void write(T value)
+    {
+        const size_t offset = m_bytes.size();
+        m_bytes.resize(offset + sizeof(T));
+        std::memcpy(m_bytes.data() + offset, &value, sizeof(T));
+    }
+
+    void writeString(const std::string& text)
+    {
+        m_bytes.insert(m_bytes.end(), text.begin(), text.end());
+        m_bytes.push_back('\0');
+    }
+
+    /**
+     * @brief Writes a placeholder section size, filled in by endSection().
+     */
+    size_t beginSection()
+    {
+        write<int32_t>(0);
+        return m_bytes.size();
+    }
+
+    void endSection(size_t start)
+    {
+        const int32_t bytes = static_cast<int32_t>(m_bytes.size() - start);
+        std::memcpy(m_bytes.data() + start - sizeof(int32_t), &bytes, sizeof(int32_t));
+    }
+
+    const char* data() const { return m_bytes.data(); }
+    size_t size() const { return m_bytes.size(); }
+
+    /**
+     * @brief The payload behind a message header with @p messageId.
+     */
+    std::vector<char> message(uint16_t messageId) const
+    {
+        std::vector<char> out(NatNetDepacketizer::kHeaderSize + m_bytes.size());
+        out.resize(NatNetDepacketizer::writeRequest(messageId, m_bytes.data(), m_bytes.size(), out.data(), out.size()));
+        return out;
+    }
+
+private:
+    std::vector<char> m_bytes;
+};
+
+inline void writeRigidBody(PacketWriter& out, int32_t id, float x)
+{
+    out.write<int32_t>(id);
+    out.write<float>(x);
+    out.write<float>(2.0f);
+    out.write<float>(3.0f);
+    out.write<float>(0.0f);     // qx qy qz qw
+    out.write<float>(0.0f);
+    out.write<float>(0.0f);
+    out.write<float>(1.0f);
+    out.write<float>(0.0005f);  // Mean error
+    out.write<int16_t>(0x01);   // Tracked
+}
+
+inline void writeLabeledMarker(PacketWriter& out, int32_t id, bool unlabeled)
+{
+    out.write<int32_t>(id);
+    out.write<float>(0.1f * id);
+    out.write<float>(0.2f);
+    out.write<float>(0.3f);
+    out.write<float>(0.014f);   // Size
+    out.write<int16_t>(unlabeled ? kMarkerParamUnlabeled : 0);
+    out.write<float>(0.0002f);  // Residual
+}
+
+inline void writeRigidBodyDescription(PacketWriter& out, const std::string& name, int32_t id, int32_t markers,
+                                      bool markerNames)
+{
+    out.writeString(name);
+    out.write<int32_t>(id);
+    out.write<int32_t>(-1);     // Parent
+    out.write<float>(0.0f);     // Offset
+    out.write<float>(0.1f);
+    out.write<float>(0.0f);
+    out.write<int32_t>(markers);
+    for (int32_t m = 0; m < markers; ++m) {
+        out.write<float>(0.01f * m);
+        out.write<float>(0.0f);
+        out.write<float>(0.0f);
+    }
+    for (int32_t m = 0; m < markers; ++m) {
+        out.write<int32_t>(0);  // Required active label
+    }
+    if (markerNames) {
+        for (int32_t m = 0; m < markers; ++m) {
+            out.writeString("Marker" + std::to_string(m));
+        }
+    }
+}
+
+/**
+ * @brief Assets streamed by LocalNatNetServer.
+ */
+struct NatNetScene {
+    int rigidBodies = 4;            // Rigid bodies with IDs 100 and up
+    int skeletons = 2;              // Skeletons with IDs 1 and up
+    int bones = 21;                 // Bones per skeleton
+    int markers = 98;               // Markers per frame; every fourth one flagged unlabeled
+    uint64_t clockFrequency = 1000000000;   // Host ticks per second
+};
+
+/**
+ * @brief NAT_MODELDEF payload describing @p scene, bitstream 4.1.
+ */
+inline PacketWriter buildModelDefinitions(const NatNetScene& scene)
+{
+    PacketWriter out;
+    out.write<int32_t>(scene.rigidBodies + scene.skeletons);
+
+    for (int i = 0; i < scene.rigidBodies; ++i) {
+        out.write<int32_t>(Descriptor_RigidBody);
+        const size_t start = out.beginSection();
+        writeRigidBodyDescription(out, "Body" + std::to_string(i), 100 + i, 4, true);
+        out.endSection(start);
+    }
+
+    for (int s = 0; s < scene.skeletons; ++s) {
+        out.write<int32_t>(Descriptor_Skeleton);
+        const size_t start = out.beginSection();
+        out.writeString("Skeleton" + std::to_string(s));
+        out.write<int32_t>(1 + s);
+        out.write<int32_t>(scene.bones);
+        for (int b = 0; b < scene.bones; ++b) {
+            writeRigidBodyDescription(out, "Bone" + std::to_string(b), 1 + b, 0, true);
+        }
+        out.endSection(start);
+    }
+    return out;
+}
+
+/**
+ * @brief NAT_FRAMEOFDATA payload of @p scene, bitstream 4.1.
+ */
+inline PacketWriter buildFrame(const NatNetScene& scene, int32_t frameNumber, double timestamp)
+{
+    PacketWriter out;
+    out.write<int32_t>(frameNumber);
+
+    out.write<int32_t>(0);                  // Marker sets
+    out.endSection(out.beginSection());
+    out.write<int32_t>(0);                  // Legacy unlabeled markers
+    out.endSection(out.beginSection());
+
+    out.write<int32_t>(scene.rigidBodies);
+    size_t start = out.beginSection();
+    for (int i = 0; i < scene.rigidBodies; ++i) {
+        writeRigidBody(out, 100 + i, 0.001f * frameNumber);
+    }
+    out.endSection(start);
+
+    out.write<int32_t>(scene.skeletons);
+    start = out.beginSection();
+    for (int s = 0; s < scene.skeletons; ++s) {
+        out.write<int32_t>(1 + s);
+        out.write<int32_t>(scene.bones);
+        for (int b = 0; b < scene.bones; ++b) {
+            writeRigidBody(out, ((1 + s) << 16) | (1 + b), 0.01f * b);
+        }
+    }
+    out.endSection(start);
+
+    out.write<int32_t>(0);                  // Trained markerset assets
+    out.endSection(out.beginSection());
+
+    out.write<int32_t>(scene.markers);
+    start = out.beginSection();
+    for (int m = 0; m < scene.markers; ++m) {
+        writeLabeledMarker(out, m, m % 4 == 3);
+    }
+    out.endSection(start);
+
+    out.write<int32_t>(0);                  // Force plates
+    out.endSection(out.beginSection());
+    out.write<int32_t>(0);                  // Devices
+    out.endSection(out.beginSection());
+
+    const uint64_t ticks = static_cast<uint64_t>(timestamp * scene.clockFrequency);
+    out.write<uint32_t>(0);                 // Timecode
+    out.write<uint32_t>(0);                 // Timecode subframe
+    out.write<double>(timestamp);
+    out.write<uint64_t>(ticks);             // Mid exposure
+    out.write<uint64_t>(ticks);             // Camera data received
+    out.write<uint64_t>(ticks);             // Transmit
+    out.write<uint32_t>(0);                 // Precision timestamp
+    out.write<uint32_t>(0);
+    out.write<int16_t>(0);                  // Frame params
+    return out;
+}
+
+/**
+ * @brief Motive's command port on 127.0.0.1, streaming frames unicast.
+ */
+class LocalNatNetServer {
+public:
+    explicit LocalNatNetServer(const NatNetScene& scene)
+        : m_scene(scene)
+    {
+    }
+
+    LocalNatNetServer(const LocalNatNetServer&) = delete;
+    LocalNatNetServer& operator=(const LocalNatNetServer&) = delete;
+
+    ~LocalNatNetServer() { stop(); }
+
+    /**
+     * @brief Binds the command port and starts answering requests.
+     * @return False if the port is unavailable.
+     */
+    bool start()
+    {
+        m_socket = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(NatNetDepacketizer::kDefaultCommandPort);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        const int enable = 1;
+        setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        if (m_socket < 0 || bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            stop();
+            return false;
+        }
+
+        m_running = true;
+        m_thread = std::thread(&LocalNatNetServer::serve, this);
+        return true;
+    }
+
+    void stop()
+    {
+        m_running = false;
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        if (m_socket >= 0) {
+            close(m_socket);
+            m_socket = -1;
+        }
+    }
+
+    /**
+     * @brief Waits until a client has sent a keep-alive from its data socket.
+     */
+    bool waitForClient(std::chrono::milliseconds timeout) const
+    {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!m_hasClient.load()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    /**
+     * @brief Sends one datagram to the client's data socket.
+     */
+    bool send(const std::vector<char>& datagram) const
+    {
+        return sendto(m_socket, datagram.data(), datagram.size(), 0,
+                      reinterpret_cast<const sockaddr*>(&m_client), sizeof(m_client))
+            == static_cast<ssize_t>(datagram.size());
+    }
+
+    /**
+     * @brief The NAT_FRAMEOFDATA message of frame @p frameNumber at @p rateHz.
+     */
+    std::vector<char> frameMessage(int32_t frameNumber, double rateHz) const
+    {
+        return buildFrame(m_scene, frameNumber, frameNumber / rateHz).message(NAT_FRAMEOFDATA);
+    }
+
+private:
+    void serve()
+    {
+        std::vector<char> datagram(NatNetDepacketizer::kMaxMessageSize);
+        while (m_running.load()) {
+            pollfd command{m_socket, POLLIN, 0};
+            if (poll(&command, 1, 20) <= 0) {
+                continue;
+            }
+
+            sockaddr_in sender{};
+            socklen_t senderSize = sizeof(sender);
+            const ssize_t received = recvfrom(m_socket, datagram.data(), datagram.size(), 0,
+                                              reinterpret_cast<sockaddr*>(&sender), &senderSize);
+            uint16_t messageId = 0;
+            const char* payload = nullptr;
+            size_t payloadSize = 0;
+            if (received <= 0
+                || !NatNetDepacketizer::readHeader(datagram.data(), static_cast<size_t>(received), messageId,
+                                                   payload, payloadSize)) {
+                continue;
+            }
+
+            std::vector<char> reply;
+            if (messageId == NAT_CONNECT) {
+                reply = serverInfo();
+            } else if (messageId == NAT_REQUEST_MODELDEF) {
+                reply = buildModelDefinitions(m_scene).message(NAT_MODELDEF);
+            } else if (messageId == NAT_KEEPALIVE && !m_hasClient.load()) {
+                m_client = sender;
+                m_hasClient = true;
+            }
+
+            if (!reply.empty()) {
+                sendto(m_socket, reply.data(), reply.size(), 0, reinterpret_cast<sockaddr*>(&sender), senderSize);
+            }
+        }
+    }
+
+    std::vector<char> serverInfo() const
+    {
+        sSender_Server server;
+        std::memset(&server, 0, sizeof(server));
+        std::strncpy(server.Common.szName, "Motive", MAX_NAMELENGTH - 1);
+        server.Common.Version[0] = 3;
+        server.Common.NatNetVersion[0] = 4;
+        server.Common.NatNetVersion[1] = 1;
+        server.HighResClockFrequency = m_scene.clockFrequency;
+        server.DataPort = NatNetDepacketizer::kDefaultDataPort;
+        server.IsMulticast = false;
+
+        std::vector<char> out(NatNetDepacketizer::kHeaderSize + sizeof(server));
+        NatNetDepacketizer::writeRequest(NAT_SERVERINFO, &server, sizeof(server), out.data(), out.size());
+        return out;
+    }
+
+    NatNetScene m_scene;
+    int m_socket = -1;
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_hasClient{false};
+    sockaddr_in m_client{};                 // Client's data socket, written before m_hasClient is set
+};
+
+} // namespace natnet_packets
@@ -0,0 +1,102 @@
+// The built-in UDP receiver against a local NatNet server: the command port
+// handshake, unicast keep-alives, frames received in batches and decoded into
+// the history, and connect() reporting a server that does not answer.
+
+#include "natnet_packets.h"
+#include "natnet_udp_source.h"
+#include "test_check.h"
+
+#include <thread>
+
+namespace {
+
+using namespace natnet_packets;
+
+constexpr int kFrames = 600;
+constexpr double kRateHz = 240.0;
+constexpr uint64_t kMaxInFlight = 8;    // Datagrams sent ahead of the receiver; stays under the staging queue
+
+/**
+ * @brief Waits until @p done holds, for at most @p timeout.
+ */
+template <typename Predicate>
+bool waitFor(Predicate done, std::chrono::milliseconds timeout)
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+void testReceiveFrames()
+{
+    NatNetScene scene;
+    LocalNatNetServer server(scene);
+    if (!server.start()) {
+        std::fprintf(stderr, "command port %u is in use; skipping the receive test\n",
+                     NatNetDepacketizer::kDefaultCommandPort);
+        return;
+    }
+
+    FrameRingBuffer<FrameData> frames(32);
+    NatNetUdpSource source(frames);
+    QString unicast = "Unicast";
+    source.setServerIP("127.0.0.1");
+    source.setClientIP("127.0.0.1");
+    source.setConnectionType(unicast);
+
+    CHECK(source.connect());
+    CHECK(source.getConnectionStatus());
+    CHECK(server.waitForClient(std::chrono::milliseconds(2000)));
+
+    const sDataDescriptions* descriptions = source.getDataDescriptions();
+    CHECK(descriptions && descriptions->nDataDescriptions == scene.rigidBodies + scene.skeletons);
+
+    for (int i = 1; i <= kFrames; ++i) {
+        CHECK(waitFor([&] { return i - source.getReceiveStats().datagrams <= kMaxInFlight; },
+                      std::chrono::milliseconds(2000)));
+        CHECK(server.send(server.frameMessage(i, kRateHz)));
+    }
+    CHECK(waitFor([&] { return source.getIngestStats().decoded == kFrames; }, std::chrono::milliseconds(2000)));
+
+    const UdpReceiveStats receive = source.getReceiveStats();
+    CHECK(receive.datagrams == kFrames);
+    CHECK(receive.frames == kFrames);
+    CHECK(receive.malformed == 0);
+    CHECK(receive.batches > 0 && receive.batches <= receive.datagrams);
+
+    const StreamStats stream = source.getStreamStats();
+    CHECK(stream.frames == kFrames);
+    CHECK(stream.gaps == 0);
+    CHECK(stream.outOfOrder == 0);
+
+    const std::shared_ptr<const FrameData> latest = frames.latest();
+    CHECK(latest != nullptr);
+    if (latest) {
+        CHECK(latest->frameNumber == kFrames);
+        CHECK(latest->rigidBodies.size() == static_cast<size_t>(scene.rigidBodies));
+        CHECK(latest->skeletons.size() == static_cast<size_t>(scene.skeletons));
+        CHECK(latest->skeletons[1].bones.size() == static_cast<size_t>(scene.bones));
+        CHECK(latest->labeledMarkers.size() + latest->unlabeledMarkers.size() == static_cast<size_t>(scene.markers));
+    }
+
+    CHECK(source.disconnect());
+    CHECK(!source.getConnectionStatus());
+
+    // Nobody on the command port any more
+    server.stop();
+    CHECK(!source.connect());
+    CHECK(!source.getConnectionStatus());
+}
+
+} // namespace
+
+int main()
+{
+    testReceiveFrames();
+    return test_check::result();
+}
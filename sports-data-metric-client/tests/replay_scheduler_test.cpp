@@ -0,0 +1,183 @@
+// ReplayScheduler on a simulated clock: pacing at 0.1x, 1x and 10x, dropping
+// frames more than kMaxLagNs behind, re-anchoring on pause, rewinds and gaps,
+// speeds clamped to their range, and as fast as possible pacing nothing.
+
+#include "replay_scheduler.h"
+#include "test_check.h"
+
+#include <cmath>
+
+namespace {
+
+constexpr double kFrameInterval = 1.0 / 240.0;
+
+/**
+ * @brief Replays @p frames frames of a 240 Hz take the way ReplayController does, sleeping exactly until each is due.
+ * @param lateNs How long after its due time each frame leaves.
+ * @return Clock time the last frame was emitted.
+ */
+int64_t replay(ReplayScheduler& scheduler, int frames, int64_t startNs, int64_t lateNs = 0)
+{
+    int64_t nowNs = startNs;
+    scheduler.start(nowNs);
+    for (int i = 0; i < frames; ++i) {
+        const double timestamp = i * kFrameInterval;
+        const int64_t untilDue = scheduler.nanosecondsUntilDue(timestamp, nowNs);
+        if (untilDue > 0) {
+            nowNs += untilDue;
+        }
+        nowNs += lateNs;
+        scheduler.frameEmitted(timestamp, nowNs);
+    }
+    return nowNs;
+}
+
+void testPacing()
+{
+    // 2 s of take time, emitted on time at each speed
+    constexpr int kFrames = 481;
+    for (double speed : { 0.1, 1.0, 10.0 }) {
+        ReplayScheduler scheduler;
+        scheduler.setSpeed(speed);
+        const int64_t startNs = 5000000000;
+        const int64_t endNs = replay(scheduler, kFrames, startNs);
+
+        CHECK(std::llabs(endNs - startNs - std::llround(2.0 / speed * 1e9)) <= 1000);
+
+        const ReplayTimingStats stats = scheduler.stats();
+        CHECK(stats.speed == speed);
+        CHECK(stats.frames == static_cast<uint64_t>(kFrames));
+        CHECK(stats.droppedFrames == 0);
+        CHECK(stats.lateness.samples == static_cast<uint64_t>(kFrames));
+        CHECK(stats.lateness.maxMs < 0.1);
+        CHECK_NEAR(stats.meanErrorMs, 0.0, 1e-3);
+        CHECK_NEAR(stats.framesPerSecond, kFrames / (2.0 / speed), 1e-3 * kFrames);
+    }
+
+    // Due times are absolute: frames leaving late do not push the next ones back
+    ReplayScheduler scheduler;
+    scheduler.start(0);
+    CHECK(scheduler.nanosecondsUntilDue(0.0, 0) == 0);
+    scheduler.frameEmitted(0.0, 3000000);
+    CHECK(scheduler.nanosecondsUntilDue(0.01, 3000000) == 7000000);
+    CHECK(scheduler.nanosecondsUntilDue(0.01, 12000000) == -2000000);
+
+    // Frames 2 ms late throughout
+    ReplayScheduler late;
+    replay(late, 240, 0, 2000000);
+    const ReplayTimingStats stats = late.stats();
+    CHECK_NEAR(stats.meanErrorMs, 2.0, 1e-3);
+    CHECK_NEAR(stats.lateness.p50Ms, 2.0, 0.1);
+}
+
+void testSpeedRange()
+{
+    ReplayScheduler scheduler;
+    scheduler.setSpeed(0.01);
+    CHECK(scheduler.speed() == ReplayScheduler::kMinSpeed);
+    scheduler.setSpeed(100.0);
+    CHECK(scheduler.speed() == ReplayScheduler::kMaxSpeed);
+    scheduler.setSpeed(2.0);
+    CHECK(scheduler.speed() == 2.0 && !scheduler.isAsFastAsPossible());
+
+    // A new speed re-anchors: the frame asked about next is due at once, the following at the new rate
+    scheduler.start(0);
+    scheduler.nanosecondsUntilDue(0.0, 0);
+    scheduler.frameEmitted(0.0, 0);
+    scheduler.setSpeed(0.5);
+    CHECK(scheduler.nanosecondsUntilDue(0.1, 1000) == 0);
+    CHECK(scheduler.nanosecondsUntilDue(0.2, 1000) == 200000000);
+}
+
+void testDropping()
+{
+    ReplayScheduler scheduler;
+    int64_t nowNs = 0;
+    scheduler.start(nowNs);
+    for (int i = 0; i < 100; ++i) {
+        const double timestamp = i * kFrameInterval;
+        nowNs += std::max<int64_t>(0, scheduler.nanosecondsUntilDue(timestamp, nowNs));
+        scheduler.frameEmitted(timestamp, nowNs);
+    }
+
+    // A 50 ms stall is caught up frame by frame
+    nowNs += 50000000;
+    int64_t untilDue = scheduler.nanosecondsUntilDue(100 * kFrameInterval, nowNs);
+    CHECK(untilDue < 0);
+    CHECK(!scheduler.isTooLate(-untilDue));
+
+    // A 200 ms stall skips to the frame due now
+    nowNs += 150000000;
+    untilDue = scheduler.nanosecondsUntilDue(100 * kFrameInterval, nowNs);
+    CHECK(scheduler.isTooLate(-untilDue));
+    CHECK(!scheduler.isTooLate(ReplayScheduler::kMaxLagNs));
+    CHECK(scheduler.isTooLate(ReplayScheduler::kMaxLagNs + 1));
+
+    const double due = scheduler.dueTimestamp(nowNs);
+    CHECK_NEAR(due, 99 * kFrameInterval + 0.2, 1e-9);
+    const int dueIndex = static_cast<int>(std::floor(due / kFrameInterval + 1e-6));
+    CHECK(dueIndex == 147);
+    scheduler.framesDropped(static_cast<uint64_t>(dueIndex - 100));
+
+    // The frame skipped to is on time again
+    CHECK(std::llabs(scheduler.nanosecondsUntilDue(dueIndex * kFrameInterval, nowNs)) < 4200000);
+    scheduler.frameEmitted(dueIndex * kFrameInterval, nowNs);
+    CHECK(scheduler.stats().droppedFrames == 47);
+    CHECK(scheduler.stats().frames == 101);
+}
+
+void testReanchoring()
+{
+    ReplayScheduler scheduler;
+    scheduler.start(0);
+    CHECK(scheduler.nanosecondsUntilDue(10.0, 0) == 0);
+    scheduler.frameEmitted(10.0, 0);
+    CHECK(scheduler.nanosecondsUntilDue(10.5, 0) == 500000000);
+
+    // A rewind is due at once, and the frames after it follow from there
+    CHECK(scheduler.nanosecondsUntilDue(2.0, 700000000) == 0);
+    scheduler.frameEmitted(2.0, 700000000);
+    CHECK(scheduler.nanosecondsUntilDue(2.1, 700000000) == 100000000);
+
+    // A jump past kMaxTimestampGap is due at once; one within it is waited for
+    CHECK(scheduler.nanosecondsUntilDue(2.1 + ReplayScheduler::kMaxTimestampGap + 0.5, 800000000) == 0);
+    CHECK(scheduler.nanosecondsUntilDue(3.6 + 0.9, 800000000) == 900000000);
+
+    // After a pause the waiting does not count against the next frame
+    scheduler.pause();
+    CHECK(scheduler.nanosecondsUntilDue(4.6, 9000000000) == 0);
+    CHECK(scheduler.nanosecondsUntilDue(4.7, 9000000000) == 100000000);
+}
+
+void testAsFastAsPossible()
+{
+    ReplayScheduler scheduler;
+    scheduler.setSpeed(ReplayScheduler::kAsFastAsPossible);
+    CHECK(scheduler.isAsFastAsPossible());
+
+    int64_t nowNs = 0;
+    scheduler.start(nowNs);
+    for (int i = 0; i < 1000; ++i) {
+        CHECK(scheduler.nanosecondsUntilDue(i * kFrameInterval, nowNs) == 0);
+        nowNs += 1000;
+        scheduler.frameEmitted(i * kFrameInterval, nowNs);
+    }
+
+    const ReplayTimingStats stats = scheduler.stats();
+    CHECK(stats.speed == 0.0);
+    CHECK(stats.frames == 1000);
+    CHECK(stats.lateness.samples == 0);
+    CHECK_NEAR(stats.framesPerSecond, 1e6, 1.0);
+}
+
+} // namespace
+
+int main()
+{
+    testPacing();
+    testSpeedRange();
+    testDropping();
+    testReanchoring();
+    testAsFastAsPossible();
+    return test_check::result();
+}
@@ -0,0 +1,221 @@
+// SkeletonMetrics bone resolution with the joint configuration of the client:
+// under each naming convention the joints resolve to the indices their bones
+// are streamed at, for bones named after the skeleton or without a prefix. A
+// skeleton named for another convention falls back to the bone IDs of the
+// settings, or leaves the metric unresolved without them, and a new frame
+// layout resolves the bones again.
+
+#include "skeleton_metrics.h"
+#include "test_check.h"
+
+#include <QJsonDocument>
+#include <algorithm>
+#include <string>
+
+namespace {
+
+constexpr int kPrefixed = 1;        // Bones named "Player_<bone>"
+constexpr int kUnprefixed = 2;      // Bones named "<bone>"
+
+// Hip, head, left thigh, left shin, right upper arm and right forearm; then two bones no joint names
+const std::vector<int> kBoneIds{11, 14, 15, 17, 20, 24, 30, 35};
+const std::vector<int> kLayout{35, 24, 11, 30, 17, 14, 20, 15};
+
+const char* kBodySettings = R"([
+    {"name": "Knee Spread", "class": "distance", "labels": ["kneeSpread"], "joint": "left_knee_angle"},
+    {"name": "Forward Tilt", "class": "distance", "labels": ["forwardTilt"], "joint": "forward_tilt"},
+    {"name": "Elbow Spread", "class": "distance", "labels": ["elbowSpread"], "joint": "right_elbow_bend",
+     "ids": [30, 35]},
+    {"name": "Tail", "class": "distance", "labels": ["tail"], "joint": "tail_wag"}
+])";
+
+/**
+ * @brief A naming convention of skeleton_config.json and the bones of kBoneIds under it.
+ */
+struct Convention {
+    const char* name;
+    std::vector<std::string> bones;
+};
+
+const std::vector<Convention> kConventions{
+    { "FBX",          { "Hips", "Head", "LeftUpLeg", "LeftLeg", "RightArm", "RightForeArm" } },
+    { "Motive",       { "Hip", "Head", "LThigh", "LShin", "RUArm", "RFArm" } },
+    { "BVH",          { "Hips", "Head", "LeftHip", "LeftKnee", "RightShoulder", "RightElbow" } },
+    { "UnrealEngine", { "pelvis", "head", "thigh_l", "calf_l", "upperarm_r", "lowerarm_r" } },
+};
+
+std::shared_ptr<AssetSlotMap> makeSlotMap(const std::vector<int>& layout)
+{
+    auto slotMap = std::make_shared<AssetSlotMap>();
+    for (int id : { kPrefixed, kUnprefixed }) {
+        slotMap->setSkeletonBones(slotMap->addSkeleton(id), layout);
+    }
+    return slotMap;
+}
+
+/**
+ * @brief A frame of @p slotMap with each bone @p id hundredths of a metre along x.
+ */
+FrameData makeFrame(const std::shared_ptr<AssetSlotMap>& slotMap, const std::vector<int>& layout)
+{
+    FrameData frame;
+    frame.frameNumber = 1;
+    frame.slotMap = slotMap;
+    for (int id : { kPrefixed, kUnprefixed }) {
+        SkeletonData skeleton;
+        skeleton.id = id;
+        for (int boneId : layout) {
+            RigidBodyData bone;
+            bone.id = boneId;
+            bone.position = QVector3D(0.01f * boneId, 1.0f, 0.0f);
+            skeleton.bones.push_back(bone);
+        }
+        frame.skeletons.push_back(skeleton);
+    }
+    return frame;
+}
+
+/**
+ * @brief Metrics with the bones of @p convention named as a session would stream them.
+ */
+void setUp(SkeletonMetrics& metrics, const Convention& convention)
+{
+    std::unordered_map<int, std::string> skeletons;
+    std::unordered_map<int, std::unordered_map<int, std::string>> bones;
+    skeletons[kPrefixed] = "Player";
+    skeletons[kUnprefixed] = "Coach";
+    for (size_t b = 0; b < kBoneIds.size(); ++b) {
+        const std::string name = b < convention.bones.size() ? convention.bones[b] : "Extra" + std::to_string(b);
+        bones[kPrefixed][kBoneIds[b]] = "Player_" + name;
+        bones[kUnprefixed][kBoneIds[b]] = name;
+    }
+    metrics.setSkeletonMap(skeletons);
+    metrics.setBoneMap(bones);
+    metrics.createInverseMaps();
+    metrics.setMetricSettings(QJsonDocument::fromJson(QByteArray(kBodySettings)).array());
+    CHECK(metrics.loadConfiguration(QStringLiteral(CLIENT_SOURCE_DIR "/src/data/skeleton_config.json")));
+}
+
+int indexOf(const std::vector<int>& layout, int boneId)
+{
+    const auto found = std::find(layout.begin(), layout.end(), boneId);
+    return found == layout.end() ? -1 : static_cast<int>(found - layout.begin());
+}
+
+bool isPair(const SkeletonMetrics::BonePair& pair, const std::vector<int>& layout, int first, int second)
+{
+    return pair.first == indexOf(layout, first) && pair.second == indexOf(layout, second);
+}
+
+bool isUnresolved(const SkeletonMetrics::BonePair& pair)
+{
+    return pair.first == -1 && pair.second == -1;
+}
+
+void checkResolved(const SkeletonMetrics& metrics, const std::vector<int>& layout)
+{
+    const SkeletonMetrics::ResolvedBones resolved = metrics.resolveBonesFor(*makeSlotMap(layout));
+    for (int id : { kPrefixed, kUnprefixed }) {
+        const auto pairs = resolved.find(id);
+        CHECK(pairs != resolved.end() && pairs->second.size() == 4);
+        if (pairs == resolved.end() || pairs->second.size() != 4) {
+            continue;
+        }
+        CHECK(isPair(pairs->second[0], layout, 15, 17));
+        CHECK(isPair(pairs->second[1], layout, 11, 14));
+        CHECK(isPair(pairs->second[2], layout, 20, 24));      // The joint over the bone IDs
+        CHECK(isUnresolved(pairs->second[3]));
+    }
+}
+
+void testConventions()
+{
+    for (size_t c = 0; c < kConventions.size(); ++c) {
+        const Convention& convention = kConventions[c];
+        SkeletonMetrics metrics;
+        setUp(metrics, convention);
+        metrics.setNamingConvention(convention.name);
+        checkResolved(metrics, kLayout);
+
+        // The live path reads the same bones: spreads of 2, 3 and 4 cm
+        const auto slotMap = makeSlotMap(kLayout);
+        metrics.setSlotMap(slotMap);
+        const FrameData frame = makeFrame(slotMap, kLayout);
+        for (int id : { kPrefixed, kUnprefixed }) {
+            const MetricsData data = metrics.computeMetricsForAsset(id, frame);
+            CHECK(data.count == 4);
+            CHECK_NEAR(data.values[0], 2.0, 1e-3);
+            CHECK_NEAR(data.values[1], 3.0, 1e-3);
+            CHECK_NEAR(data.values[2], 4.0, 1e-3);
+            CHECK_NEAR(data.values[3], 0.0, 1e-3);
+        }
+    }
+}
+
+void testOtherConvention()
+{
+    // Bones named for each convention, resolved under the next one
+    for (size_t c = 0; c < kConventions.size(); ++c) {
+        const Convention& other = kConventions[(c + 1) % kConventions.size()];
+        SkeletonMetrics metrics;
+        setUp(metrics, kConventions[c]);
+        const auto slotMap = makeSlotMap(kLayout);
+        metrics.setSlotMap(slotMap);
+        metrics.setNamingConvention(other.name);
+
+        const SkeletonMetrics::ResolvedBones resolved = metrics.resolveBonesFor(*slotMap);
+        const std::vector<SkeletonMetrics::BonePair>& pairs = resolved.at(kPrefixed);
+        CHECK(isUnresolved(pairs[0]));
+        CHECK(isUnresolved(pairs[1]));
+        CHECK(isPair(pairs[2], kLayout, 30, 35));             // Falls back to the bone IDs
+        CHECK(isUnresolved(pairs[3]));
+
+        const FrameData frame = makeFrame(slotMap, kLayout);
+        MetricsData data = metrics.computeMetricsForAsset(kPrefixed, frame);
+        CHECK_NEAR(data.values[0], 0.0, 1e-3);
+        CHECK_NEAR(data.values[2], 5.0, 1e-3);
+
+        // Switching back picks the joints again
+        metrics.setNamingConvention(kConventions[c].name);
+        data = metrics.computeMetricsForAsset(kPrefixed, frame);
+        CHECK_NEAR(data.values[0], 2.0, 1e-3);
+        CHECK_NEAR(data.values[2], 4.0, 1e-3);
+    }
+}
+
+void testNewLayout()
+{
+    SkeletonMetrics metrics;
+    setUp(metrics, kConventions[1]);
+    metrics.setNamingConvention(kConventions[1].name);
+
+    // After a reconnect the bones arrive in another order
+    std::vector<int> layout = kLayout;
+    std::reverse(layout.begin(), layout.end());
+    checkResolved(metrics, layout);
+
+    metrics.setSlotMap(makeSlotMap(kLayout));
+    const auto slotMap = makeSlotMap(layout);
+    metrics.setSlotMap(slotMap);
+    const MetricsData data = metrics.computeMetricsForAsset(kUnprefixed, makeFrame(slotMap, layout));
+    CHECK_NEAR(data.values[0], 2.0, 1e-3);
+    CHECK_NEAR(data.values[1], 3.0, 1e-3);
+    CHECK_NEAR(data.values[2], 4.0, 1e-3);
+
+    // A layout without some of the bones leaves their metrics unresolved
+    layout.erase(std::find(layout.begin(), layout.end(), 14));
+    const SkeletonMetrics::ResolvedBones resolved = metrics.resolveBonesFor(*makeSlotMap(layout));
+    const SkeletonMetrics::BonePair& tilt = resolved.at(kPrefixed)[1];
+    CHECK(tilt.first == indexOf(layout, 11) && tilt.second == -1);
+    CHECK(isPair(resolved.at(kPrefixed)[0], layout, 15, 17));
+}
+
+} // namespace
+
+int main()
+{
+    testConventions();
+    testOtherConvention();
+    testNewLayout();
+    return test_check::result();
+}
@@ -0,0 +1,80 @@
+// StreamTracker: frame classification and resyncing when the server restarts
+// its frame count.
+
+#include "stream_tracker.h"
+#include "test_check.h"
+
+namespace {
+
+constexpr double kFramePeriod = 1.0 / 120.0;
+
+void testClassification()
+{
+    StreamTracker tracker;
+    CHECK(tracker.recordFrame(100, 100 * kFramePeriod) == StreamTracker::Arrival::InOrder);
+    CHECK(tracker.recordFrame(101, 101 * kFramePeriod) == StreamTracker::Arrival::InOrder);
+    CHECK(tracker.recordFrame(101, 101 * kFramePeriod) == StreamTracker::Arrival::Duplicate);
+    CHECK(tracker.recordFrame(105, 105 * kFramePeriod) == StreamTracker::Arrival::AfterGap);
+    CHECK(tracker.recordFrame(103, 103 * kFramePeriod) == StreamTracker::Arrival::OutOfOrder);
+    CHECK(tracker.recordFrame(106, 106 * kFramePeriod) == StreamTracker::Arrival::InOrder);
+
+    const StreamStats stats = tracker.getStats();
+    CHECK(stats.frames == 6);
+    CHECK(stats.gaps == 1);
+    CHECK(stats.missingFrames == 3);
+    CHECK(stats.duplicates == 1);
+    CHECK(stats.outOfOrder == 1);
+    CHECK(stats.discontinuities == 0);
+}
+
+void testFrameNumberRestart()
+{
+    StreamTracker tracker;
+    for (int32_t frame = 5000; frame < 5010; ++frame) {
+        tracker.recordFrame(frame, frame * kFramePeriod);
+    }
+
+    // A looped take starts counting again; the frames after it are in order
+    CHECK(tracker.recordFrame(1, 1 * kFramePeriod) == StreamTracker::Arrival::Discontinuity);
+    for (int32_t frame = 2; frame < 50; ++frame) {
+        CHECK(tracker.recordFrame(frame, frame * kFramePeriod) == StreamTracker::Arrival::InOrder);
+    }
+
+    const StreamStats stats = tracker.getStats();
+    CHECK(stats.discontinuities == 1);
+    CHECK(stats.outOfOrder == 0);
+    CHECK(stats.gaps == 0);
+}
+
+void testTimestampReset()
+{
+    StreamTracker tracker;
+    for (int32_t frame = 10; frame < 20; ++frame) {
+        tracker.recordFrame(frame, 600.0 + frame * kFramePeriod);
+    }
+
+    // Frame numbers carry on but the clock went back: a restart, not reordering
+    CHECK(tracker.recordFrame(15, 0.0) == StreamTracker::Arrival::Discontinuity);
+    CHECK(tracker.recordFrame(16, kFramePeriod) == StreamTracker::Arrival::InOrder);
+
+    // A late frame within the reorder window is still out of order
+    CHECK(tracker.recordFrame(14, -kFramePeriod) == StreamTracker::Arrival::OutOfOrder);
+
+    const StreamStats stats = tracker.getStats();
+    CHECK(stats.discontinuities == 1);
+    CHECK(stats.outOfOrder == 1);
+
+    tracker.reset();
+    CHECK(tracker.getStats().discontinuities == 0);
+    CHECK(tracker.recordFrame(1, 0.0) == StreamTracker::Arrival::InOrder);
+}
+
+} // namespace
+
+int main()
+{
+    testClassification();
+    testFrameNumberRestart();
+    testTimestampReset();
+    return test_check::result();
+}
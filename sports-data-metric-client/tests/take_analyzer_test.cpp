@@ -0,0 +1,269 @@
+// TakeAnalyzer: a take computed in parallel chunks equals one sequential pass
+// of the live metrics path, value for value, including the frames right after
+// each chunk boundary whose derivatives read the halo, and a rigid body whose
+// tracking drops out across a boundary. The statistics of each series match
+// those of the sequential pass, and the live pose history is left alone.
+
+#include "take_analyzer.h"
+#include "test_check.h"
+
+#include <QJsonDocument>
+#include <cmath>
+
+namespace {
+
+constexpr int kRigidBodies = 3;
+constexpr int kSkeletons = 2;
+constexpr int kBones = 21;
+constexpr int kFrames = 1000;
+constexpr int kGapBody = 102;           // Untracked on the frames just before the second of four chunks
+constexpr int kGapFirst = 246;
+constexpr int kGapLast = 249;
+
+const char* kRigidSettings = R"([
+    {"name": "Velocity", "class": "velocity", "labels": ["velocity"], "ids": [],
+     "estimator": {"method": "savitzkyGolay", "window": 7}},
+    {"name": "Acceleration", "class": "acceleration", "labels": ["acceleration"], "ids": [],
+     "estimator": {"method": "centralDifference"}},
+    {"name": "Tilt Angle", "class": "tilt", "labels": ["tiltAngle"], "ids": []},
+    {"name": "Position", "class": "position", "labels": ["positionX", "positionY", "positionZ"], "ids": []}
+])";
+
+const char* kBodySettings = R"([
+    {"name": "Knee Bend", "class": "angle", "labels": ["kneeBend"], "ids": [14, 15]},
+    {"name": "Forward Tilt", "class": "distance", "labels": ["forwardTilt"], "ids": [1, 5]}
+])";
+
+QJsonArray parseSettings(const char* json)
+{
+    return QJsonDocument::fromJson(QByteArray(json)).array();
+}
+
+/**
+ * @brief Rigid bodies and skeletons in motion, laid out by one slot map, with the metrics set up as a session does.
+ */
+struct Scene {
+    Scene()
+    {
+        auto slotMap = std::make_shared<AssetSlotMap>();
+        std::unordered_map<int, std::string> rigidBodyNames;
+        std::unordered_map<int, std::string> skeletonNames;
+        std::unordered_map<int, std::unordered_map<int, std::string>> boneNames;
+        for (int i = 0; i < kRigidBodies; ++i) {
+            slotMap->addRigidBody(100 + i);
+            rigidBodyNames[100 + i] = "Body" + std::to_string(i);
+        }
+        for (int s = 0; s < kSkeletons; ++s) {
+            const int slot = slotMap->addSkeleton(1 + s);
+            std::vector<int> boneIds;
+            for (int b = 0; b < kBones; ++b) {
+                boneIds.push_back(1 + b);
+                boneNames[1 + s][1 + b] = "Bone" + std::to_string(b);
+            }
+            slotMap->setSkeletonBones(slot, boneIds);
+            skeletonNames[1 + s] = "Skeleton" + std::to_string(s);
+        }
+
+        for (int f = 0; f < kFrames; ++f) {
+            auto frame = std::make_shared<FrameData>();
+            frame->frameNumber = f + 1;
+            frame->timestamp = f / 240.0;
+            frame->slotMap = slotMap;
+
+            const float phase = 0.05f * f;
+            for (int i = 0; i < kRigidBodies; ++i) {
+                RigidBodyData body;
+                body.id = 100 + i;
+                body.position = QVector3D(std::sin(phase + i), 1.0f + 0.1f * std::sin(2.0f * phase), std::cos(phase));
+                body.orientation = QQuaternion::fromEulerAngles(10.0f * std::sin(phase), 5.0f * i, 3.0f);
+                body.tracked = !(body.id == kGapBody && f >= kGapFirst && f <= kGapLast);
+                frame->rigidBodies.push_back(body);
+            }
+            for (int s = 0; s < kSkeletons; ++s) {
+                SkeletonData skeleton;
+                skeleton.id = 1 + s;
+                for (int b = 0; b < kBones; ++b) {
+                    RigidBodyData bone;
+                    bone.id = 1 + b;
+                    bone.position = QVector3D(0.1f * b, 0.05f * b + std::sin(phase + s), 0.02f * b);
+                    bone.orientation = QQuaternion::fromEulerAngles(2.0f * b * std::sin(phase), 0.0f, 1.0f * b);
+                    skeleton.bones.push_back(bone);
+                }
+                frame->skeletons.push_back(skeleton);
+            }
+            frames.push_back(frame);
+        }
+
+        rigidBodyMetrics.setRigidBodyMap(rigidBodyNames);
+        rigidBodyMetrics.createInverseMaps();
+        rigidBodyMetrics.setMetricSettings(parseSettings(kRigidSettings));
+
+        skeletonMetrics.setSkeletonMap(skeletonNames);
+        skeletonMetrics.setBoneMap(boneNames);
+        skeletonMetrics.createInverseMaps();
+        skeletonMetrics.setMetricSettings(parseSettings(kBodySettings));
+        skeletonMetrics.setSlotMap(slotMap);
+    }
+
+    QVector<FramePtr> frames;
+    RigidBodyMetrics rigidBodyMetrics;
+    SkeletonMetrics skeletonMetrics;
+};
+
+const std::vector<int> kRigidBodyIds{100, 101, 102};
+const std::vector<int> kSkeletonIds{2, 1};
+
+/**
+ * @brief The metrics of every asset and frame from the live path: push each frame, then compute the batch.
+ */
+TakeMetrics sequentialPass(Scene& scene)
+{
+    TakeMetrics take;
+    std::vector<AssetMetrics> rigidBodies;
+    std::vector<AssetMetrics> skeletons;
+    for (int id : kRigidBodyIds) {
+        take.rigidBodies.push_back(AssetSeries{id, {}, {}});
+        rigidBodies.push_back(AssetMetrics{id, MetricsData()});
+    }
+    for (int id : kSkeletonIds) {
+        take.skeletons.push_back(AssetSeries{id, {}, {}});
+        skeletons.push_back(AssetMetrics{id, MetricsData()});
+    }
+
+    for (const FramePtr& frame : scene.frames) {
+        scene.rigidBodyMetrics.pushFrame(*frame);
+        scene.rigidBodyMetrics.computeMetricsForAssets(rigidBodies.data(), static_cast<int>(rigidBodies.size()), *frame);
+        scene.skeletonMetrics.computeMetricsForAssets(skeletons.data(), static_cast<int>(skeletons.size()), *frame);
+        for (size_t a = 0; a < rigidBodies.size(); ++a) {
+            take.rigidBodies[a].frames.push_back(rigidBodies[a].metrics);
+        }
+        for (size_t a = 0; a < skeletons.size(); ++a) {
+            take.skeletons[a].frames.push_back(skeletons[a].metrics);
+        }
+    }
+    return take;
+}
+
+bool sameMetrics(const MetricsData& a, const MetricsData& b)
+{
+    if (a.id != b.id || a.schemaVersion != b.schemaVersion || a.count != b.count) {
+        return false;
+    }
+    for (int slot = 0; slot < a.count; ++slot) {
+        if (a.values[slot] != b.values[slot]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void checkSameSeries(const std::vector<AssetSeries>& actual, const std::vector<AssetSeries>& expected)
+{
+    CHECK(actual.size() == expected.size());
+    for (size_t a = 0; a < actual.size() && a < expected.size(); ++a) {
+        CHECK(actual[a].assetId == expected[a].assetId);
+        CHECK(actual[a].frames.size() == expected[a].frames.size());
+        int mismatches = 0;
+        for (size_t f = 0; f < actual[a].frames.size() && f < expected[a].frames.size(); ++f) {
+            mismatches += sameMetrics(actual[a].frames[f], expected[a].frames[f]) ? 0 : 1;
+        }
+        CHECK(mismatches == 0);
+    }
+}
+
+void testChunksMatchSequentialPass()
+{
+    Scene scene;
+    QThreadPool pool;
+    pool.setMaxThreadCount(3);
+    const VectorTakeFrames frames(scene.frames);
+    const TakeAnalyzer analyzer(scene.rigidBodyMetrics, scene.skeletonMetrics, pool);
+
+    // Analyzed before the live pass, so the live history is still empty
+    const TakeMetrics one = analyzer.analyze(frames, kRigidBodyIds, kSkeletonIds, 1);
+    const TakeMetrics four = analyzer.analyze(frames, kRigidBodyIds, kSkeletonIds, 4);
+    const TakeMetrics seven = analyzer.analyze(frames, kRigidBodyIds, kSkeletonIds, 7);
+    CHECK(one.chunks == 1 && four.chunks == 4 && seven.chunks == 7);
+    CHECK(four.selectedRigidBody == -1 && four.selectedSkeleton == -1);
+
+    // The live metrics never saw the take: without history, motion reads as zero
+    const MetricsData live = scene.rigidBodyMetrics.computeMetricsForAsset(100, *scene.frames[500]);
+    CHECK(live.count > 0 && live.values[0] == 0.0);
+
+    const TakeMetrics expected = sequentialPass(scene);
+    checkSameSeries(one.rigidBodies, expected.rigidBodies);
+    checkSameSeries(one.skeletons, expected.skeletons);
+    checkSameSeries(four.rigidBodies, expected.rigidBodies);
+    checkSameSeries(four.skeletons, expected.skeletons);
+    checkSameSeries(seven.rigidBodies, expected.rigidBodies);
+    checkSameSeries(seven.skeletons, expected.skeletons);
+
+    // The frames right after a boundary read the halo: their velocity is already estimated
+    const std::vector<MetricsData>& body = four.rigidBodies[0].frames;
+    for (int first : {250, 500, 750}) {
+        CHECK(body[static_cast<size_t>(first)].values[0] != 0.0);
+        CHECK(body[static_cast<size_t>(first)].values[0] == expected.rigidBodies[0].frames[static_cast<size_t>(first)].values[0]);
+    }
+
+    // The gap ends just before a boundary: no values while untracked, and motion restarts after it
+    const std::vector<MetricsData>& gap = four.rigidBodies[2].frames;
+    CHECK(gap[kGapFirst].count == 0 && gap[kGapLast].count == 0);
+    CHECK(gap[kGapLast + 1].count > 0 && gap[kGapLast + 1].values[0] == 0.0);
+    CHECK(gap[kGapLast + 7].values[0] != 0.0);
+
+    // Skeletons are computed with the bones resolved for the take's layout
+    CHECK(four.skeletons[0].frames[400].count == 2);
+    CHECK(four.skeletons[0].frames[400].values[1] != 0.0);
+}
+
+void testStatistics()
+{
+    Scene scene;
+    QThreadPool pool;
+    pool.setMaxThreadCount(3);
+    const VectorTakeFrames frames(scene.frames);
+    const TakeMetrics take = TakeAnalyzer(scene.rigidBodyMetrics, scene.skeletonMetrics, pool)
+                                 .analyze(frames, kRigidBodyIds, kSkeletonIds, 4);
+    const TakeMetrics expected = sequentialPass(scene);
+
+    for (size_t a = 0; a < take.rigidBodies.size(); ++a) {
+        MetricStatistics statistics;
+        for (const MetricsData& metrics : expected.rigidBodies[a].frames) {
+            statistics.add(metrics);
+        }
+        const MetricStatistics::Snapshot reference = statistics.snapshot();
+        const MetricStatistics::Snapshot& actual = take.rigidBodies[a].statistics;
+        CHECK(actual.count == reference.count);
+        for (int slot = 0; slot < actual.count; ++slot) {
+            CHECK(actual.summaries[slot].count == reference.summaries[slot].count);
+            CHECK(actual.summaries[slot].mean == reference.summaries[slot].mean);
+            CHECK(actual.summaries[slot].p90 == reference.summaries[slot].p90);
+        }
+    }
+
+    // The body with a tracking gap has fewer samples
+    CHECK(take.rigidBodies[0].statistics.summaries[0].count == static_cast<uint64_t>(kFrames));
+    CHECK(take.rigidBodies[2].statistics.summaries[0].count == static_cast<uint64_t>(kFrames - (kGapLast - kGapFirst + 1)));
+}
+
+void testEmptyTake()
+{
+    Scene scene;
+    QThreadPool pool;
+    const VectorTakeFrames frames{QVector<FramePtr>()};
+    const TakeMetrics take = TakeAnalyzer(scene.rigidBodyMetrics, scene.skeletonMetrics, pool)
+                                 .analyze(frames, kRigidBodyIds, kSkeletonIds, 4);
+    CHECK(take.rigidBodies.size() == kRigidBodyIds.size());
+    CHECK(take.rigidBodies[0].frames.empty());
+    CHECK(take.chunks == 0);
+}
+
+} // namespace
+
+int main()
+{
+    testChunksMatchSequentialPass();
+    testStatistics();
+    testEmptyTake();
+    return test_check::result();
+}
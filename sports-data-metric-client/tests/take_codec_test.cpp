@@ -0,0 +1,311 @@
+// TakeWriter, TakeReader and the quantized chunk codec: takes read back
+// exactly when plain and within the stated error when quantized, q and -q kept
+// apart, the length of quantized chunks, how much smaller quantized takes are,
+// and damaged payloads rejected.
+
+#include "take_codec.h"
+#include "take_reader.h"
+#include "take_writer.h"
+#include "test_check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+const char* const kPlainPath = "take_codec_test_plain.take";
+const char* const kQuantizedPath = "take_codec_test_quantized.take";
+
+// The error of the default quantization, from take_codec.h
+constexpr double kMaxPositionError = 0.5e-4;       // Half of 0.1 mm
+constexpr double kMaxAngleError = 0.025;           // Degrees
+constexpr double kMaxTimestampError = 0.5e-6;      // Half of 1 us
+
+/**
+ * @brief @p count frames at 120 Hz of two rigid bodies and @p skeletons skeletons of 21 bones.
+ *
+ * The motion is smooth with a little tracking noise. The second rigid body
+ * loses tracking in every tenth frame and turns far enough in five seconds
+ * for its quaternion's w to change sign.
+ */
+std::vector<FramePtr> makeFrames(int count, int skeletons)
+{
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> noise(-1e-4f, 1e-4f);
+    auto slotMap = std::make_shared<AssetSlotMap>();
+
+    std::vector<FramePtr> frames;
+    for (int f = 0; f < count; ++f) {
+        auto frame = std::make_shared<FrameData>();
+        frame->frameNumber = 1000 + f;
+        frame->timestamp = 250.0 + f / 120.0;
+        frame->slotMap = slotMap;
+        const float t = static_cast<float>(f / 120.0);
+
+        for (int r = 0; r < 2; ++r) {
+            RigidBodyData rb;
+            rb.id = r + 1;
+            rb.tracked = r == 0 || f % 10 != 0;
+            rb.position = QVector3D(std::sin(t * 1.3f + r), 1.0f + 0.3f * std::sin(t * 2.0f + r), std::cos(t + r)) +
+                          QVector3D(noise(rng), noise(rng), noise(rng));
+            rb.orientation = QQuaternion::fromAxisAndAngle(QVector3D(0.3f, 0.9f, 0.3f), 45.0f * t + 90.0f * r);
+            frame->rigidBodies.push_back(rb);
+        }
+
+        for (int s = 0; s < skeletons; ++s) {
+            SkeletonData skeleton;
+            skeleton.id = s + 1;
+            for (int b = 0; b < 21; ++b) {
+                RigidBodyData bone;
+                bone.id = b + 1;
+                bone.parentId = b;
+                const float phase = s * 0.7f + b * 0.3f;
+                bone.position = QVector3D(s * 0.5f + 0.2f * std::sin(t * 2.1f + phase), 0.05f * b + 0.1f * std::sin(t * 3.0f + phase),
+                                          0.2f * std::cos(t * 1.7f + phase)) +
+                                QVector3D(noise(rng), noise(rng), noise(rng));
+                bone.orientation = (QQuaternion::fromAxisAndAngle(QVector3D(0.6f, 0.6f, 0.5f), 35.0f * std::sin(t * 2.5f + phase)) +
+                                    QQuaternion(noise(rng), noise(rng), noise(rng), noise(rng))).normalized();
+                skeleton.bones.push_back(bone);
+            }
+            frame->skeletons.push_back(skeleton);
+        }
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+bool writeTake(const char* path, const std::vector<FramePtr>& frames, const TakeEncoding& encoding)
+{
+    TakeWriter writer;
+    if (!writer.open(path, TakeHeader()) || !writer.setEncoding(encoding)) {
+        return false;
+    }
+    for (const FramePtr& frame : frames) {
+        if (!writer.writeFrame(*frame)) {
+            return false;
+        }
+    }
+    return writer.close();
+}
+
+/**
+ * @brief The footer of the take at @p path, which gives its chunk count.
+ */
+TakeFooter readFooter(const char* path)
+{
+    TakeFooter footer{};
+    FILE* file = std::fopen(path, "rb");
+    if (file) {
+        if (std::fseek(file, -static_cast<long>(sizeof(footer)), SEEK_END) != 0 ||
+            std::fread(&footer, sizeof(footer), 1, file) != 1) {
+            footer = TakeFooter{};
+        }
+        std::fclose(file);
+    }
+    return footer;
+}
+
+long fileSize(const char* path)
+{
+    FILE* file = std::fopen(path, "rb");
+    if (!file) {
+        return 0;
+    }
+    std::fseek(file, 0, SEEK_END);
+    const long size = std::ftell(file);
+    std::fclose(file);
+    return size;
+}
+
+/**
+ * @brief Degrees between two unit quaternions; a quaternion and its negation are a full turn apart.
+ *
+ * Found from the chord between them, which stays accurate for the tiny angles
+ * quantization leaves where the arccosine of their dot product does not.
+ */
+double angleBetween(const QQuaternion& a, const QQuaternion& b)
+{
+    const double dx = static_cast<double>(a.x()) - b.x();
+    const double dy = static_cast<double>(a.y()) - b.y();
+    const double dz = static_cast<double>(a.z()) - b.z();
+    const double dw = static_cast<double>(a.scalar()) - b.scalar();
+    const double chord = std::sqrt(dx * dx + dy * dy + dz * dz + dw * dw);
+    return 4.0 * std::asin(std::min(1.0, chord / 2.0)) * 180.0 / kPi;
+}
+
+/**
+ * @brief Largest errors of the poses of @p read against @p written.
+ */
+struct Errors {
+    double position = 0.0;     // Along any axis
+    double angle = 0.0;
+    double timestamp = 0.0;
+    bool matching = true;   // Frame numbers, IDs, tracked flags and bone counts all equal
+
+    void addPose(const RigidBodyData& read, const RigidBodyData& written)
+    {
+        matching = matching && read.id == written.id && read.tracked == written.tracked;
+        if (written.tracked) {
+            for (int c = 0; c < 3; ++c) {
+                position = std::max(position, std::abs(static_cast<double>(read.position[c]) - written.position[c]));
+            }
+            angle = std::max(angle, angleBetween(read.orientation, written.orientation));
+        }
+    }
+
+    void addFrame(const FrameData& read, const FrameData& written)
+    {
+        matching = matching && read.frameNumber == written.frameNumber &&
+                   read.rigidBodies.size() == written.rigidBodies.size() &&
+                   read.skeletons.size() == written.skeletons.size();
+        if (!matching) {
+            return;
+        }
+        timestamp = std::max(timestamp, std::abs(read.timestamp - written.timestamp));
+        for (size_t i = 0; i < written.rigidBodies.size(); ++i) {
+            addPose(read.rigidBodies[i], written.rigidBodies[i]);
+        }
+        for (size_t s = 0; s < written.skeletons.size(); ++s) {
+            const std::vector<RigidBodyData>& bones = written.skeletons[s].bones;
+            matching = matching && read.skeletons[s].bones.size() == bones.size();
+            for (size_t b = 0; matching && b < bones.size(); ++b) {
+                addPose(read.skeletons[s].bones[b], bones[b]);
+            }
+        }
+    }
+};
+
+Errors readBack(const char* path, const std::vector<FramePtr>& written)
+{
+    Errors errors;
+    TakeReader reader;
+    errors.matching = reader.open(path) && reader.frameCount() == written.size();
+    for (size_t i = 0; errors.matching && i < written.size(); ++i) {
+        errors.addFrame(*reader.frame(i), *written[i]);
+    }
+    return errors;
+}
+
+void testPlain()
+{
+    const std::vector<FramePtr> frames = makeFrames(600, 2);
+    CHECK(writeTake(kPlainPath, frames, TakeEncoding()));
+
+    const Errors errors = readBack(kPlainPath, frames);
+    CHECK(errors.matching);
+    CHECK(errors.position == 0.0);
+    CHECK(errors.angle == 0.0);
+    CHECK(errors.timestamp == 0.0);
+}
+
+void testQuantized()
+{
+    const std::vector<FramePtr> frames = makeFrames(600, 2);
+    CHECK(writeTake(kQuantizedPath, frames, TakeEncoding::quantized()));
+
+    const Errors errors = readBack(kQuantizedPath, frames);
+    CHECK(errors.matching);
+    CHECK(errors.position <= kMaxPositionError + 1e-6);  // And the rounding of the restored floats
+    CHECK(errors.angle <= kMaxAngleError);
+    CHECK(errors.timestamp <= kMaxTimestampError);
+    CHECK(errors.position > 0.0);
+
+    // Both signs of the same rotation survive quantization
+    FrameData negated = *frames[1];
+    negated.rigidBodies[0].orientation = -negated.rigidBodies[0].orientation;
+    CHECK(writeTake(kQuantizedPath, { frames[1], std::make_shared<FrameData>(negated) }, TakeEncoding::quantized()));
+    TakeReader reader;
+    CHECK(reader.open(kQuantizedPath) && reader.frameCount() == 2);
+    if (reader.frameCount() == 2) {
+        const QQuaternion positive = reader.frame(0)->rigidBodies[0].orientation;
+        const QQuaternion negative = reader.frame(1)->rigidBodies[0].orientation;
+        CHECK_NEAR(QQuaternion::dotProduct(positive, negative), -1.0f, 1e-5f);
+    }
+}
+
+void testChunkLength()
+{
+    constexpr int kFrames = 2000;
+
+    // Small scenes: plain chunks hold framesPerChunk frames, quantized ones up to four times as many
+    const std::vector<FramePtr> small = makeFrames(kFrames, 0);
+    CHECK(writeTake(kPlainPath, small, TakeEncoding()));
+    CHECK(writeTake(kQuantizedPath, small, TakeEncoding::quantized()));
+    const uint32_t plainChunks = (kFrames + TakeWriter::kDefaultFramesPerChunk - 1) / TakeWriter::kDefaultFramesPerChunk;
+    const int longChunk = TakeWriter::kDefaultFramesPerChunk * TakeWriter::kMaxQuantizedChunkScale;
+    CHECK(readFooter(kPlainPath).chunkCount == plainChunks);
+    CHECK(readFooter(kQuantizedPath).chunkCount == static_cast<uint32_t>((kFrames + longChunk - 1) / longChunk));
+
+    // Large scenes already fill a megabyte in framesPerChunk frames
+    const std::vector<FramePtr> large = makeFrames(kFrames / 4, 20);
+    CHECK(writeTake(kQuantizedPath, large, TakeEncoding::quantized()));
+    CHECK(readFooter(kQuantizedPath).chunkCount == (kFrames / 4 + TakeWriter::kDefaultFramesPerChunk - 1) /
+                                                       TakeWriter::kDefaultFramesPerChunk);
+    CHECK(readBack(kQuantizedPath, large).matching);
+}
+
+void testRatio()
+{
+    // Twenty skeletons for ten seconds, at the default quantization
+    const std::vector<FramePtr> frames = makeFrames(1200, 20);
+    CHECK(writeTake(kPlainPath, frames, TakeEncoding()));
+    CHECK(writeTake(kQuantizedPath, frames, TakeEncoding::quantized()));
+    const long plain = fileSize(kPlainPath);
+    const long quantized = fileSize(kQuantizedPath);
+    CHECK(quantized > 0 && plain >= quantized * 10);
+}
+
+void testDamagedPayload()
+{
+    const std::vector<FramePtr> frames = makeFrames(64, 1);
+    const TakeLayout layout = TakeLayout::fromFrame(*frames.front());
+
+    TakeChunkHeader header{};
+    header.recordSize = static_cast<uint32_t>(layout.recordSize());
+    header.frameCount = static_cast<uint32_t>(frames.size());
+    header.firstTimestamp = frames.front()->timestamp;
+    QByteArray records(static_cast<qsizetype>(header.recordSize * header.frameCount), '\0');
+    for (size_t i = 0; i < frames.size(); ++i) {
+        layout.writeRecord(*frames[i], records.data() + i * header.recordSize);
+    }
+
+    const TakeQuantization quantization = TakeEncoding::quantized().quantization;
+    const QByteArray payload = take_codec::encodeChunk(header, layout, records.constData(), quantization);
+    QByteArray decoded;
+    CHECK(take_codec::decodeChunk(header, layout, payload.constData(), static_cast<size_t>(payload.size()), decoded));
+    CHECK(decoded.size() == records.size());
+
+    // Cut short, within the quantization or within the compressed stream
+    CHECK(!take_codec::decodeChunk(header, layout, payload.constData(), sizeof(TakeQuantization) - 1, decoded));
+    CHECK(!take_codec::decodeChunk(header, layout, payload.constData(), static_cast<size_t>(payload.size()) / 2, decoded));
+
+    // A changed byte in the compressed stream
+    QByteArray changed = payload;
+    changed[changed.size() / 2] = static_cast<char>(changed[changed.size() / 2] ^ 0x5a);
+    CHECK(!take_codec::decodeChunk(header, layout, changed.constData(), static_cast<size_t>(changed.size()), decoded));
+
+    // A quantization no writer produces
+    TakeQuantization invalid = quantization;
+    invalid.orientationBits = 0;
+    QByteArray relabeled = payload;
+    std::memcpy(relabeled.data(), &invalid, sizeof(invalid));
+    CHECK(!take_codec::decodeChunk(header, layout, relabeled.constData(), static_cast<size_t>(relabeled.size()), decoded));
+}
+
+} // namespace
+
+int main()
+{
+    testPlain();
+    testQuantized();
+    testChunkLength();
+    testRatio();
+    testDamagedPayload();
+    std::remove(kPlainPath);
+    std::remove(kQuantizedPath);
+    return test_check::result();
+}
@@ -0,0 +1,171 @@
+// TakeReader: frames found by index in any order across chunks, frames found
+// by time before the first frame, within and between chunks and after the last
+// one, in plain and quantized takes, and takes without a usable trailer opened
+// by walking their chunks.
+
+#include "take_reader.h"
+#include "take_writer.h"
+#include "test_check.h"
+
+#include <cstdio>
+#include <filesystem>
+
+namespace {
+
+const char* const kPath = "take_reader_test.take";
+constexpr int kFrames = 950;
+constexpr int kFramesPerChunk = 100;
+constexpr double kFirstTimestamp = 250.0;
+constexpr double kFrameInterval = 1.0 / 120.0;
+
+double timestampOf(int index)
+{
+    return kFirstTimestamp + index * kFrameInterval;
+}
+
+bool writeTake(const TakeEncoding& encoding)
+{
+    TakeWriter writer(kFramesPerChunk);
+    if (!writer.open(kPath, TakeHeader()) || !writer.setEncoding(encoding)) {
+        return false;
+    }
+
+    auto slotMap = std::make_shared<AssetSlotMap>();
+    for (int f = 0; f < kFrames; ++f) {
+        FrameData frame;
+        frame.frameNumber = 1000 + f;
+        frame.timestamp = timestampOf(f);
+        frame.slotMap = slotMap;
+        RigidBodyData body;
+        body.id = 1;
+        body.position = QVector3D(0.001f * f, 1.0f, 0.0f);
+        frame.rigidBodies.push_back(body);
+        if (!writer.writeFrame(frame)) {
+            return false;
+        }
+    }
+    return writer.close();
+}
+
+TakeFooter readFooter()
+{
+    TakeFooter footer{};
+    FILE* file = std::fopen(kPath, "rb");
+    if (file) {
+        if (std::fseek(file, -static_cast<long>(sizeof(footer)), SEEK_END) != 0 ||
+            std::fread(&footer, sizeof(footer), 1, file) != 1) {
+            footer = TakeFooter{};
+        }
+        std::fclose(file);
+    }
+    return footer;
+}
+
+/**
+ * @brief Whether frame @p index of @p reader is the one written at that index.
+ */
+bool isFrame(const TakeReader& reader, size_t index)
+{
+    const FramePtr frame = reader.frame(index);
+    return frame && frame->frameNumber == 1000 + static_cast<int>(index) && frame->rigidBodies.size() == 1;
+}
+
+void checkSeeks(const TakeReader& reader)
+{
+    CHECK(reader.frameCount() == static_cast<size_t>(kFrames));
+    CHECK_NEAR(reader.firstTimestamp(), timestampOf(0), 1e-6);
+    CHECK_NEAR(reader.lastTimestamp(), timestampOf(kFrames - 1), 1e-6);
+
+    // By index, jumping back and forth across chunks
+    for (size_t index : { 0, 949, 100, 99, 500, 1, 899, 900, 350 }) {
+        CHECK(isFrame(reader, index));
+    }
+
+    // By time, before the first frame and after the last
+    CHECK(reader.indexAtTime(0.0) == 0);
+    CHECK(reader.indexAtTime(kFirstTimestamp - 1.0) == 0);
+    CHECK(reader.indexAtTime(timestampOf(kFrames - 1) + 10.0) == static_cast<size_t>(kFrames - 1));
+
+    // Within a chunk: the last frame at or before the time
+    CHECK(reader.indexAtTime(timestampOf(0)) == 0);
+    CHECK(reader.indexAtTime(timestampOf(42) + 0.25 * kFrameInterval) == 42);
+    CHECK(reader.indexAtTime(timestampOf(43) - 0.25 * kFrameInterval) == 42);
+
+    // Between chunks: the last frame of the earlier chunk until the next chunk starts
+    for (int first = kFramesPerChunk; first < kFrames; first += kFramesPerChunk) {
+        CHECK(reader.indexAtTime(timestampOf(first) - 0.5 * kFrameInterval) == static_cast<size_t>(first - 1));
+        CHECK(reader.indexAtTime(timestampOf(first) + 0.25 * kFrameInterval) == static_cast<size_t>(first));
+    }
+    CHECK(reader.indexAtTime(timestampOf(kFrames - 1) - 0.25 * kFrameInterval) == static_cast<size_t>(kFrames - 2));
+}
+
+void testSeekPlain()
+{
+    CHECK(writeTake(TakeEncoding()));
+    CHECK(readFooter().chunkCount == static_cast<uint32_t>((kFrames + kFramesPerChunk - 1) / kFramesPerChunk));
+
+    TakeReader reader;
+    CHECK(reader.open(kPath));
+    checkSeeks(reader);
+}
+
+void testSeekQuantized()
+{
+    CHECK(writeTake(TakeEncoding::quantized()));
+
+    TakeReader reader;
+    CHECK(reader.open(kPath));
+    checkSeeks(reader);
+}
+
+void testWithoutTrailer()
+{
+    CHECK(writeTake(TakeEncoding()));
+    const TakeFooter footer = readFooter();
+    const auto fileSize = std::filesystem::file_size(kPath);
+    CHECK(footer.indexOffset > 0 && footer.indexOffset < fileSize);
+
+    // A footer that does not match: every chunk is still found
+    {
+        FILE* file = std::fopen(kPath, "r+b");
+        CHECK(file != nullptr);
+        if (file) {
+            std::fseek(file, -static_cast<long>(sizeof(TakeFooter::kMagic)), SEEK_END);
+            std::fputc('X', file);
+            std::fclose(file);
+        }
+        TakeReader reader;
+        CHECK(reader.open(kPath));
+        checkSeeks(reader);
+    }
+
+    // Cut off after the last chunk, as when the writer never closed the take
+    std::filesystem::resize_file(kPath, footer.indexOffset);
+    {
+        TakeReader reader;
+        CHECK(reader.open(kPath));
+        checkSeeks(reader);
+    }
+
+    // Cut inside the last chunk: the complete chunks before it are recovered
+    std::filesystem::resize_file(kPath, footer.indexOffset - 10);
+    {
+        TakeReader reader;
+        CHECK(reader.open(kPath));
+        const size_t complete = (kFrames / kFramesPerChunk) * kFramesPerChunk;
+        CHECK(reader.frameCount() == complete);
+        CHECK(isFrame(reader, 0) && isFrame(reader, complete - 1));
+        CHECK(reader.indexAtTime(timestampOf(kFrames - 1)) == complete - 1);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    testSeekPlain();
+    testSeekQuantized();
+    testWithoutTrailer();
+    std::remove(kPath);
+    return test_check::result();
+}
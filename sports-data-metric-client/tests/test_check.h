@@ -0,0 +1,44 @@
+// Minimal assertions for the unit tests.
+//
+// A failed CHECK prints its location and the test carries on, so one run
+// reports every failure; main() returns test_check::result().
+
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+
+namespace test_check {
+
+inline int& failures()
+{
+    static int count = 0;
+    return count;
+}
+
+inline void fail(const char* file, int line, const char* expression)
+{
+    std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", file, line, expression);
+    ++failures();
+}
+
+/**
+ * @brief Exit code of the test: 0 if every check passed.
+ */
+inline int result()
+{
+    if (failures() > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures());
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace test_check
+
+#define CHECK(condition) \
+    do { if (!(condition)) test_check::fail(__FILE__, __LINE__, #condition); } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+    do { if (!(std::fabs((actual) - (expected)) <= (tolerance))) \
+        test_check::fail(__FILE__, __LINE__, #actual " near " #expected); } while (0)